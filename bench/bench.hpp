@@ -0,0 +1,56 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <utility>
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include "counters.hpp"
+
+namespace modal::bench {
+    /// Sample rate the benchmarked DSP is set up at, real-time factors at other rates are scaled from it
+    constexpr double sample_rate = 48000;
+    /// Sample rates real-time factors are reported at
+    constexpr double report_rates[] = {44100, 48000, 96000};
+    /// How long benchmarks are run for under hardware counters
+    constexpr std::chrono::milliseconds counted_time {20};
+
+    /** @brief Records how many samples one run of a benchmark processes, for the report's ns/sample and real-time factors.
+     *
+     * Benchmarks that aren't recorded, like coefficient updates, are reported per run only.
+     */
+    void set_samples_per_run(const std::string& name, size_t samples);
+
+    /** @brief Runs a Catch2 benchmark of `body`, which processes `samples` samples each call.
+     *
+     * Only call from a test case. Set up any state outside `body`, so only the processing is timed,
+     * and return something computed from the output so it isn't optimised away.
+     *
+     * With hardware counters enabled, `body` is then run again on its own under the counters,
+     * separately from the timing so reading them doesn't skew it.
+     */
+    template<typename F>
+    void run(const std::string& name, const size_t samples, F&& body) {
+        set_samples_per_run(name, samples);
+        BENCHMARK(std::string{name}) {
+            return body();
+        };
+
+        if (counters_enabled()) {
+            const auto begin = std::chrono::steady_clock::now();
+            Catch::Benchmark::deoptimize_value(body());
+            const auto once = std::max(std::chrono::steady_clock::now() - begin, std::chrono::steady_clock::duration{1});
+            const auto runs = static_cast<size_t>(std::clamp<decltype(once.count())>(counted_time / once, 1, 1'000'000));
+
+            start_counters();
+            for (size_t i = 0; i < runs; i++) {
+                Catch::Benchmark::deoptimize_value(body());
+            }
+            stop_counters(name, runs);
+        }
+    }
+}
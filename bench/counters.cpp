@@ -0,0 +1,213 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "counters.hpp"
+
+#include <array>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace modal::bench {
+    namespace {
+        std::optional<double> ratio(const std::optional<double>& a, const std::optional<double>& b, const double scale = 1) {
+            if (!a || !b || *b == 0) {
+                return std::nullopt;
+            }
+            return scale * *a / *b;
+        }
+
+        std::map<std::string, Counters>& stored() {
+            static std::map<std::string, Counters> counters;
+            return counters;
+        }
+
+#if defined(__linux__)
+        enum Event : size_t {
+            Cycles, Instructions, L1dMisses, LlcMisses, Branches, BranchMisses, FpAssists, num_events
+        };
+
+        constexpr uint64_t cache_event(const uint64_t cache, const uint64_t op, const uint64_t result) {
+            return cache | (op << 8) | (result << 16);
+        }
+
+        /** The counters, opened as one group on the benchmark thread so they're all counted over exactly the same code.
+         *
+         * Only the cycle counter is required, the others are left out if the CPU or kernel doesn't have them.
+         * FP assists (microcode fixing up denormals and the like) have no generic event,
+         * so are only counted if `MODAL_BENCH_FP_ASSIST` gives the CPU's raw event code.
+         */
+        class Group {
+         public:
+            Group() {
+                fds.fill(-1);
+                if (!open(Cycles, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES)) {
+                    error = std::strerror(errno);
+                    return;
+                }
+                open(Instructions, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+                open(L1dMisses, PERF_TYPE_HW_CACHE, cache_event(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ,
+                                                                 PERF_COUNT_HW_CACHE_RESULT_MISS));
+                open(LlcMisses, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+                open(Branches, PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS);
+                open(BranchMisses, PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+                if (const char* raw = std::getenv("MODAL_BENCH_FP_ASSIST")) {
+                    if (!open(FpAssists, PERF_TYPE_RAW, std::strtoull(raw, nullptr, 0))) {
+                        std::fprintf(stderr, "couldn't count FP assists with raw event %s: %s\n", raw, std::strerror(errno));
+                    }
+                }
+            }
+
+            ~Group() {
+                for (const int fd: fds) {
+                    if (fd >= 0) {
+                        close(fd);
+                    }
+                }
+            }
+
+            Group(const Group&) = delete;
+            Group& operator=(const Group&) = delete;
+
+            [[nodiscard]] bool ok() const {
+                return fds[Cycles] >= 0;
+            }
+
+            void start() const {
+                ioctl(fds[Cycles], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+                ioctl(fds[Cycles], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+            }
+
+            /// Stops counting and returns the totals, scaled up if the kernel had to share the counters with something else
+            Counters stop(const double runs) const {
+                ioctl(fds[Cycles], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+                // PERF_FORMAT_GROUP | PERF_FORMAT_ID | PERF_FORMAT_TOTAL_TIME_*: count, enabled, running, then (value, id) pairs
+                std::array<uint64_t, 3 + 2 * num_events> data {};
+                Counters c;
+                if (read(fds[Cycles], data.data(), sizeof(data)) <= 0 || data[2] == 0) {
+                    return c;
+                }
+                const double scale = static_cast<double>(data[1]) / static_cast<double>(data[2]) / runs;
+                for (size_t i = 0; i < data[0]; i++) {
+                    const auto value = static_cast<double>(data[3 + 2 * i]) * scale;
+                    const auto id = data[4 + 2 * i];
+                    for (size_t e = 0; e < num_events; e++) {
+                        if (fds[e] >= 0 && ids[e] == id) {
+                            field(c, static_cast<Event>(e)) = value;
+                        }
+                    }
+                }
+                return c;
+            }
+
+            std::string error;
+
+         private:
+            std::array<int, num_events> fds {};
+            std::array<uint64_t, num_events> ids {};
+
+            bool open(const Event e, const uint32_t type, const uint64_t config) {
+                perf_event_attr attr {};
+                attr.size = sizeof(attr);
+                attr.type = type;
+                attr.config = config;
+                attr.disabled = e == Cycles; // the rest start and stop with the group's leader
+                attr.exclude_kernel = 1;
+                attr.exclude_hv = 1;
+                attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_ID | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+                const auto fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, fds[Cycles], 0));
+                if (fd < 0) {
+                    return false;
+                }
+                fds[e] = fd;
+                ioctl(fd, PERF_EVENT_IOC_ID, &ids[e]);
+                return true;
+            }
+
+            static std::optional<double>& field(Counters& c, const Event e) {
+                switch (e) {
+                    case Cycles: return c.cycles;
+                    case Instructions: return c.instructions;
+                    case L1dMisses: return c.l1d_misses;
+                    case LlcMisses: return c.llc_misses;
+                    case Branches: return c.branches;
+                    case BranchMisses: return c.branch_misses;
+                    default: return c.fp_assists;
+                }
+            }
+        };
+
+        Group& group() {
+            static Group g;
+            return g;
+        }
+#endif
+    }
+
+    std::optional<double> Counters::ipc() const {
+        return ratio(instructions, cycles);
+    }
+
+    std::optional<double> Counters::l1d_mpki() const {
+        return ratio(l1d_misses, instructions, 1000);
+    }
+
+    std::optional<double> Counters::llc_mpki() const {
+        return ratio(llc_misses, instructions, 1000);
+    }
+
+    std::optional<double> Counters::branch_miss_rate() const {
+        return ratio(branch_misses, branches);
+    }
+
+    bool counters_enabled() {
+        static const bool enabled = [] {
+            const char* env = std::getenv("MODAL_BENCH_COUNTERS");
+            if (env == nullptr || std::strcmp(env, "0") == 0) {
+                return false;
+            }
+#if defined(__linux__)
+            if (!group().ok()) {
+                std::fprintf(stderr, "couldn't open hardware counters (%s), check /proc/sys/kernel/perf_event_paranoid\n",
+                             group().error.c_str());
+                return false;
+            }
+            return true;
+#else
+            std::fprintf(stderr, "hardware counters are only supported on Linux\n");
+            return false;
+#endif
+        }();
+        return enabled;
+    }
+
+    void start_counters() {
+#if defined(__linux__)
+        group().start();
+#endif
+    }
+
+    void stop_counters(const std::string& name, const size_t runs) {
+#if defined(__linux__)
+        stored()[name] = group().stop(static_cast<double>(runs));
+#else
+        static_cast<void>(name);
+        static_cast<void>(runs);
+#endif
+    }
+
+    const Counters* counters_for(const std::string& name) {
+        const auto found = stored().find(name);
+        return found != stored().end() ? &found->second : nullptr;
+    }
+}
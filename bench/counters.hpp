@@ -0,0 +1,43 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace modal::bench {
+    /** @brief Hardware performance counter totals for one benchmark, averaged per run.
+     *
+     * Counters the CPU, kernel or permissions don't allow are left empty.
+     */
+    struct Counters {
+        std::optional<double> cycles, instructions, l1d_misses, llc_misses, branches, branch_misses, fp_assists;
+
+        /// Instructions per cycle
+        [[nodiscard]] std::optional<double> ipc() const;
+        /// L1 data cache read misses per thousand instructions
+        [[nodiscard]] std::optional<double> l1d_mpki() const;
+        /// Last level cache misses per thousand instructions
+        [[nodiscard]] std::optional<double> llc_mpki() const;
+        /// Fraction of branches mispredicted
+        [[nodiscard]] std::optional<double> branch_miss_rate() const;
+    };
+
+    /** @brief Whether benchmarks should also be run under hardware performance counters.
+     *
+     * Set by the `MODAL_BENCH_COUNTERS` environment variable. Only supported on Linux through `perf_event_open`,
+     * which may need `/proc/sys/kernel/perf_event_paranoid` lowered. If the counters can't be opened this says why, once, and returns false.
+     */
+    bool counters_enabled();
+
+    /// Zeroes and starts the counters on this thread
+    void start_counters();
+
+    /// Stops the counters and stores their totals divided by `runs` for the benchmark `name`
+    void stop_counters(const std::string& name, size_t runs);
+
+    /// The counters stored for the benchmark `name`, if it was counted
+    const Counters* counters_for(const std::string& name);
+}
@@ -0,0 +1,97 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// whole blocks of the processors' voice loops, without the plugin wrapper around them
+
+#include "bench.hpp"
+
+#include <dsp/mini_modal_synth.hpp>
+#include <dsp/modal_synth.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <array>
+#include <string>
+#include <vector>
+
+using namespace modal::dsp;
+namespace bench = modal::bench;
+
+namespace {
+    // a typical host buffer
+    constexpr size_t host_block = 512;
+
+    std::string block_name(const char* synth, const size_t voices, const size_t modes) {
+        return std::string{synth} + " processBlock, " + std::to_string(voices) + (voices == 1 ? " voice, " : " voices, ")
+               + std::to_string(modes) + " modes";
+    }
+
+    // as `Processor::processBlock()`, every voice ticked per sample
+    template<size_t modes>
+    void modal_block(const size_t voice_count) {
+        synth::ModalPatch patch;
+        patch.set_params(modes, 0.01_nm, 1, 4, 1, 1);
+        std::vector<synth::ModalSynth<modes>> voices(voice_count);
+        for (size_t v = 0; v < voice_count; v++) {
+            voices[v].set_patch(patch);
+            voices[v].set_sample_rate(bench::sample_rate);
+            voices[v].set_env_params(0.01_nm, 0.5_nm);
+            voices[v].on(55 * static_cast<num>(1 + v % 12), 1);
+        }
+        std::array<float, host_block> out {};
+        bench::run(block_name("ModalSynth", voice_count, modes), host_block, [&] {
+            for (size_t i = 0; i < host_block; i++) {
+                num sample = 0;
+                for (auto& v : voices) {
+                    sample += v.tick();
+                }
+                out[i] = static_cast<float>(sample * 0.1_nm);
+            }
+            return out[host_block - 1];
+        });
+    }
+
+    // as `MiniProcessor::processBlock()`, every voice rendered a sub-block at a time
+    template<size_t modes>
+    void mini_block(const size_t voice_count) {
+        synth::MiniModalPatch patch;
+        patch.set_params(modes, 0.01_nm, 1, 4, 1, 1, 1);
+        std::vector<synth::MiniModalSynth<modes>> voices(voice_count);
+        for (size_t v = 0; v < voice_count; v++) {
+            voices[v].set_patch(patch);
+            voices[v].set_sample_rate(bench::sample_rate);
+            voices[v].set_env_params(0.01_nm, 0.5_nm);
+            voices[v].set_exciter(synth::MiniModalExiterKind::Impulses);
+            voices[v].set_feedback_routing(synth::MiniModalFeedbackRouting::Delayed);
+            voices[v].on(55 * static_cast<num>(1 + v % 12), 1);
+        }
+        std::array<float, host_block> out {};
+        bench::run(block_name("MiniModalSynth", voice_count, modes), host_block, [&] {
+            for (size_t start = 0; start < host_block; start += block_size) {
+                const auto n = std::min(block_size, host_block - start);
+                std::array<num, block_size> sub {};
+                for (auto& v : voices) {
+                    v.render(sub.data(), n);
+                }
+                for (size_t i = 0; i < n; i++) {
+                    out[start + i] = static_cast<float>(sub[i] * 0.1_nm);
+                }
+            }
+            return out[host_block - 1];
+        });
+    }
+
+    template<size_t modes>
+    void block_benchmarks() {
+        for (const size_t voices : {1, 16, 64}) {
+            modal_block<modes>(voices);
+            mini_block<modes>(voices);
+        }
+    }
+}
+
+TEST_CASE("Processor block benchmarks", "[benchmark][block]") {
+    block_benchmarks<10>();
+    block_benchmarks<40>();
+    block_benchmarks<256>();
+}
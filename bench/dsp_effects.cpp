@@ -0,0 +1,81 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "bench.hpp"
+
+#include <dsp/delay.hpp>
+#include <dsp/formant.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <array>
+#include <string>
+#include <utility>
+
+using namespace modal::dsp;
+namespace bench = modal::bench;
+using modal::dsp::physical::FormantArch;
+using modal::dsp::physical::FormantFilter;
+
+namespace {
+    std::array<num, block_size> saw() {
+        std::array<num, block_size> in {};
+        for (size_t i = 0; i < block_size; i++) {
+            in[i] = static_cast<num>(i) / block_size - 0.5_nm;
+        }
+        return in;
+    }
+}
+
+TEST_CASE("Formant filter benchmarks", "[benchmark][formant]") {
+    const auto in = saw();
+    for (const auto& [arch, name] : {std::pair{FormantArch::Cascade, "cascade"}, std::pair{FormantArch::Parallel, "parallel"}}) {
+        FormantFilter filter {arch};
+        filter.set_sample_rate(bench::sample_rate);
+        filter.set_vowel(0.3_nm, 0.7_nm, 0.5_nm, 0.5_nm);
+        bench::run(std::string{"formant filter tick, "} + name, block_size, [&] {
+            num sum = 0;
+            for (size_t i = 0; i < block_size; i++) {
+                sum += filter.tick(in[i]);
+            }
+            return sum;
+        });
+    }
+}
+
+TEST_CASE("Delay line benchmarks", "[benchmark][delay]") {
+    delay_line line {bench::sample_rate, 0.1_nm};
+    const auto in = saw();
+    std::array<num, block_size> out {};
+    constexpr num delay = 1000.37_nm;
+
+    bench::run("delay line push and fetch, linear", block_size, [&] {
+        num sum = 0;
+        for (size_t i = 0; i < block_size; i++) {
+            sum += line.fetch_sample(delay, DelayInterpolation::Linear);
+            line.push_sample(in[i]);
+        }
+        return sum;
+    });
+
+    for (const auto& [method, name] : {std::pair{DelayInterpolation::Linear, "linear"},
+                                       std::pair{DelayInterpolation::Cubic, "cubic"},
+                                       std::pair{DelayInterpolation::Lagrange, "lagrange"}}) {
+        // older versions of clang can't capture structured bindings
+        const auto interp = method;
+        bench::run(std::string{"delay line block, "} + name, block_size, [&] {
+            line.read_block(out.data(), block_size, delay, interp);
+            line.write_block(in.data(), block_size);
+            return out[block_size - 1];
+        });
+    }
+
+    delay_line::allpass_tap tap;
+    bench::run("delay line push and fetch, allpass", block_size, [&] {
+        num sum = 0;
+        for (size_t i = 0; i < block_size; i++) {
+            sum += line.fetch_sample_allpass(delay, tap);
+            line.push_sample(in[i]);
+        }
+        return sum;
+    });
+}
@@ -0,0 +1,70 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "bench.hpp"
+
+#include <dsp/resonator.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <array>
+#include <memory>
+#include <string>
+
+using namespace modal::dsp;
+namespace bench = modal::bench;
+using namespace modal::dsp::physical::filters;
+
+namespace {
+    // a quiet, constantly changing input, so the modes keep ringing rather than decaying into denormals
+    std::array<num, block_size> excitation() {
+        std::array<num, block_size> in {};
+        for (size_t i = 0; i < block_size; i++) {
+            in[i] = (i * 7 % 5 == 0 ? 1e-3_nm : -1e-3_nm) * static_cast<num>(1 + i % 3);
+        }
+        return in;
+    }
+
+    template<size_t modes>
+    void bank_benchmarks() {
+        auto bank = std::make_unique<PhasorResonatorBank<modes>>();
+        bank->set_sample_rate(bench::sample_rate);
+        for (size_t i = 0; i < modes; i++) {
+            bank->set_params(i, 100 + 70 * static_cast<num>(i), 1 / static_cast<num>(i + 1), 1);
+        }
+        bank->ping(modes);
+
+        const auto in = excitation();
+        std::array<num, block_size> out {};
+        const auto name = std::to_string(modes) + " modes";
+        bench::run("resonator bank tick, " + name, block_size, [&] {
+            num sum = 0;
+            for (size_t i = 0; i < block_size; i++) {
+                sum += bank->tick(in[i], modes);
+            }
+            return sum;
+        });
+        bench::run("resonator bank block, " + name, block_size, [&] {
+            bank->process_block(in.data(), out.data(), block_size, modes);
+            return out[block_size - 1];
+        });
+    }
+}
+
+TEST_CASE("Resonator benchmarks", "[benchmark][resonator]") {
+    PhasorResonator resonator;
+    resonator.set_sample_rate(bench::sample_rate);
+    resonator.set_params(440, 1, 1);
+    resonator.ping();
+    const auto in = excitation();
+    bench::run("phasor resonator tick", block_size, [&] {
+        num sum = 0;
+        for (size_t i = 0; i < block_size; i++) {
+            sum += resonator.tick(in[i]);
+        }
+        return sum;
+    });
+
+    bank_benchmarks<10>();
+    bank_benchmarks<40>();
+    bank_benchmarks<256>();
+}
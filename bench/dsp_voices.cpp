@@ -0,0 +1,139 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "bench.hpp"
+
+#include <dsp/control.hpp>
+#include <dsp/mini_modal_synth.hpp>
+#include <dsp/modal_synth.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <array>
+#include <memory>
+#include <string>
+#include <utility>
+
+using namespace modal::dsp;
+namespace bench = modal::bench;
+
+namespace {
+    constexpr std::array foldback_names {"nyquist stop", "undertones", "foldback"};
+    constexpr std::array<int, 16> chord {36, 43, 48, 52, 55, 59, 60, 62, 64, 67, 69, 71, 72, 74, 76, 79};
+}
+
+TEST_CASE("Mode coefficient update benchmarks", "[benchmark][voice]") {
+    synth::ModalPatch patch;
+    patch.set_params(40, 0.01_nm, 1, 4, 1, 1);
+    synth::ModalSynth<40> voice;
+    voice.set_patch(patch);
+    voice.set_sample_rate(bench::sample_rate);
+    voice.on(220, 1);
+
+    synth::MiniModalPatch mini_patch;
+    mini_patch.set_params(40, 0.01_nm, 1, 4, 1, 1, 1);
+    synth::MiniModalSynth<40> mini_voice;
+    mini_voice.set_patch(mini_patch);
+    mini_voice.set_sample_rate(bench::sample_rate);
+    mini_voice.on(220, 1);
+
+    for (size_t mode = 0; mode < foldback_names.size(); mode++) {
+        patch.set_foldback_settings(static_cast<synth::ModalFoldbackKind>(mode), 1600);
+        bench::run(std::string{"ModalSynth update_mode_coefficients, "} + foldback_names[mode], 0, [&] {
+            voice.update_mode_coefficients();
+            return voice.num_modes();
+        });
+
+        mini_patch.set_foldback_settings(static_cast<synth::MiniModalFoldbackKind>(mode), 1600);
+        bench::run(std::string{"MiniModalSynth update_mode_coefficients, "} + foldback_names[mode], 0, [&] {
+            mini_voice.update_mode_coefficients();
+            return mini_voice.num_modes();
+        });
+        bench::run(std::string{"MiniModalSynth update_mode_coefficients gliding, "} + foldback_names[mode], 0, [&] {
+            mini_voice.update_mode_coefficients(true);
+            return mini_voice.num_modes();
+        });
+    }
+}
+
+TEST_CASE("Note on burst benchmarks", "[benchmark][voice]") {
+    synth::ModalPatch patch;
+    auto voices = std::make_unique<std::array<synth::ModalSynth<40>, chord.size()>>();
+    PolyController<synth::ModalSynth<40>, chord.size()> controller {*voices};
+    for (auto& v : *voices) {
+        v.set_patch(patch);
+        v.set_sample_rate(bench::sample_rate);
+    }
+
+    synth::MiniModalPatch mini_patch;
+    auto mini_voices = std::make_unique<std::array<synth::MiniModalSynth<40>, chord.size()>>();
+    PolyController<synth::MiniModalSynth<40>, chord.size()> mini_controller {*mini_voices};
+    for (auto& v : *mini_voices) {
+        v.set_patch(mini_patch);
+        v.set_sample_rate(bench::sample_rate);
+    }
+
+    // each run starts the whole chord then releases it, so the next run finds every voice free
+    bench::run("ModalSynth 16 note chord", 0, [&] {
+        for (const auto note : chord) {
+            controller.key_down(note, 0.8f);
+        }
+        for (const auto note : chord) {
+            controller.key_up(note);
+        }
+        return controller.active_voices();
+    });
+    bench::run("MiniModalSynth 16 note chord", 0, [&] {
+        for (const auto note : chord) {
+            mini_controller.key_down(note, 0.8f);
+        }
+        for (const auto note : chord) {
+            mini_controller.key_up(note);
+        }
+        return mini_controller.active_voices();
+    });
+}
+
+TEST_CASE("Exciter benchmarks", "[benchmark][voice]") {
+    constexpr std::array modal_exciters {"impulse", "noise", "impulses", "square", "chirp"};
+    synth::ModalPatch patch;
+    patch.set_params(40, 0.01_nm, 1, 4, 1, 1);
+    for (size_t kind = 0; kind < modal_exciters.size(); kind++) {
+        synth::ModalSynth<40> voice;
+        voice.set_patch(patch);
+        voice.set_sample_rate(bench::sample_rate);
+        voice.set_env_params(0.01_nm, 0.5_nm);
+        voice.set_exciter(static_cast<synth::ModalExiterKind>(kind));
+        voice.on(220, 1);
+        bench::run(std::string{"ModalSynth tick, 40 modes, "} + modal_exciters[kind] + " exciter", block_size, [&] {
+            num sum = 0;
+            for (size_t i = 0; i < block_size; i++) {
+                sum += voice.tick();
+            }
+            return sum;
+        });
+    }
+
+    constexpr std::array mini_exciters {"impulse", "noise", "impulses"};
+    constexpr std::array routings {std::pair{synth::MiniModalFeedbackRouting::Immediate, "immediate"},
+                                   std::pair{synth::MiniModalFeedbackRouting::Delayed, "delayed"}};
+    synth::MiniModalPatch mini_patch;
+    mini_patch.set_params(40, 0.01_nm, 1, 4, 1, 1, 1);
+    for (size_t kind = 0; kind < mini_exciters.size(); kind++) {
+        for (const auto& routing : routings) {
+            synth::MiniModalSynth<40> voice;
+            voice.set_patch(mini_patch);
+            voice.set_sample_rate(bench::sample_rate);
+            voice.set_env_params(0.01_nm, 0.5_nm);
+            voice.set_exciter(static_cast<synth::MiniModalExiterKind>(kind));
+            voice.set_feedback_routing(routing.first);
+            voice.set_feedback_settings(0.01_nm, 1);
+            voice.on(220, 1);
+            std::array<num, block_size> out {};
+            bench::run(std::string{"MiniModalSynth render, 40 modes, "} + mini_exciters[kind] + " exciter, "
+                       + routing.second + " feedback", block_size, [&] {
+                voice.render(out.data(), block_size);
+                return out[block_size - 1];
+            });
+        }
+    }
+}
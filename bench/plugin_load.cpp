@@ -0,0 +1,330 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// Plays a plugin's processor like a host would, without a DAW, timing every block against its real-time deadline.
+// Built once per plugin, each build linked with that plugin's shared code.
+//
+// usage: <plugin>LoadTest [--rates 44100,48000,96000] [--buffers 16,64,256,1024,4096] [--seconds 10]
+//                         [--patterns chords,retrigger,cluster,sweep] [--core <n>] [--csv <path>]
+
+#include <juce_audio_processors/juce_audio_processors.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// the processor of whichever plugin this is linked with
+juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter();
+
+namespace {
+    constexpr int min_buffer = 16;
+    constexpr int max_buffer = 4096;
+    constexpr double tempo = 120;
+    // blocks run before timing starts, so caches and branch predictors are warm and the first notes have started
+    constexpr int warmup_blocks = 32;
+
+    enum class Pattern {
+        /// a 16 note chord every beat, taking every voice, released just before the next one
+        Chords,
+        /// four notes retriggered on every 32nd note, so released voices are restarted while they still ring
+        Retrigger,
+        /// 16 adjacent semitones held throughout and restruck every bar, all voices sounding at once
+        Cluster,
+        /// a held chord while every parameter, the mod wheel and aftertouch sweep up and down
+        Sweep,
+    };
+
+    constexpr Pattern all_patterns[] = {Pattern::Chords, Pattern::Retrigger, Pattern::Cluster, Pattern::Sweep};
+
+    std::string_view pattern_name(const Pattern p) {
+        switch (p) {
+            case Pattern::Chords: return "chords";
+            case Pattern::Retrigger: return "retrigger";
+            case Pattern::Cluster: return "cluster";
+            case Pattern::Sweep: return "sweep";
+        }
+        return "";
+    }
+
+    struct Options {
+        std::vector<double> rates {44100, 48000, 96000};
+        std::vector<int> buffers {16, 64, 256, 1024, 4096};
+        std::vector<Pattern> patterns {std::begin(all_patterns), std::end(all_patterns)};
+        double seconds = 10;
+        int core = -1;
+        std::string csv;
+    };
+
+    struct Result {
+        std::string pattern;
+        double rate;
+        int buffer;
+        size_t blocks;
+        double deadline_us, p50_us, p99_us, p999_us, max_us;
+        size_t misses;
+    };
+
+    template<typename T, typename F>
+    std::vector<T> parse_list(const std::string_view arg, F&& parse) {
+        std::vector<T> out;
+        size_t start = 0;
+        while (start <= arg.size()) {
+            const auto end = std::min(arg.find(',', start), arg.size());
+            out.push_back(parse(std::string{arg.substr(start, end - start)}));
+            start = end + 1;
+        }
+        return out;
+    }
+
+    [[noreturn]] void usage(const char* error) {
+        std::fprintf(stderr, "%s\nusage: LoadTest [--rates 44100,48000,96000] [--buffers 16,64,256,1024,4096] [--seconds 10]\n"
+                             "                [--patterns chords,retrigger,cluster,sweep] [--core <n>] [--csv <path>]\n", error);
+        std::exit(2);
+    }
+
+    Options parse_options(const int argc, char** argv) {
+        Options o;
+        for (int i = 1; i < argc; i++) {
+            const std::string_view flag = argv[i];
+            if (i + 1 >= argc) {
+                usage("missing value");
+            }
+            const std::string_view value = argv[++i];
+            if (flag == "--rates") {
+                o.rates = parse_list<double>(value, [](const std::string& s) { return std::atof(s.c_str()); });
+            } else if (flag == "--buffers") {
+                o.buffers = parse_list<int>(value, [](const std::string& s) { return std::atoi(s.c_str()); });
+            } else if (flag == "--patterns") {
+                o.patterns = parse_list<Pattern>(value, [](const std::string& s) {
+                    for (const auto p: all_patterns) {
+                        if (s == pattern_name(p)) {
+                            return p;
+                        }
+                    }
+                    usage("unknown pattern");
+                });
+            } else if (flag == "--seconds") {
+                o.seconds = std::atof(std::string{value}.c_str());
+            } else if (flag == "--core") {
+                o.core = std::atoi(std::string{value}.c_str());
+            } else if (flag == "--csv") {
+                o.csv = value;
+            } else {
+                usage("unknown option");
+            }
+        }
+
+        for (const auto b: o.buffers) {
+            if (b < min_buffer || b > max_buffer) {
+                usage("buffer sizes must be from 16 to 4096 samples");
+            }
+        }
+        for (const auto r: o.rates) {
+            if (r <= 0) {
+                usage("sample rates must be positive");
+            }
+        }
+        if (o.seconds <= 0) {
+            usage("seconds must be positive");
+        }
+        if (o.core >= 32) {
+            usage("only cores 0 to 31 can be pinned to");
+        }
+        return o;
+    }
+
+    /// Calls `f(time)` for each multiple of `period` samples within the block starting at `start`, with its time in the block
+    template<typename F>
+    void each(const int64_t start, const int samples, const double period, F&& f) {
+        for (auto k = static_cast<int64_t>(std::ceil(static_cast<double>(start) / period));; k++) {
+            const auto at = static_cast<int64_t>(std::llround(static_cast<double>(k) * period));
+            if (at >= start + samples) {
+                break;
+            }
+            if (at >= start) {
+                f(static_cast<int>(at - start));
+            }
+        }
+    }
+
+    /// Writes a pattern's MIDI and automation for each block, as a host playing back a project would
+    class Script {
+     public:
+        Script(const Pattern p, juce::AudioProcessor& host_processor, const double rate) :
+                pattern{p}, processor{host_processor}, beat{rate * 60 / tempo} {}
+
+        void block(juce::MidiBuffer& midi, const int64_t start, const int samples) {
+            switch (pattern) {
+                case Pattern::Chords:
+                    each(start, samples, beat, [&](const int t) {
+                        release(midi, t);
+                        const int root = 36 + random(0, 11);
+                        for (int i = 0; i < 16; i++) {
+                            hold(midi, t, root + (i / 4) * 12 + chord_shape[i % 4]);
+                        }
+                    });
+                    break;
+                case Pattern::Retrigger:
+                    each(start, samples, beat / 8, [&](const int t) {
+                        release(midi, t);
+                        for (const int note: {48, 55, 60, 64}) {
+                            hold(midi, t, note);
+                        }
+                    });
+                    break;
+                case Pattern::Cluster:
+                    each(start, samples, beat * 4, [&](const int t) {
+                        release(midi, t);
+                        for (int note = 60; note < 76; note++) {
+                            hold(midi, t, note);
+                        }
+                    });
+                    break;
+                case Pattern::Sweep:
+                    if (start == 0) {
+                        for (const int note: {36, 43, 48, 55, 60, 64, 67, 72}) {
+                            hold(midi, 0, note);
+                        }
+                    }
+                    sweep(midi, start);
+                    break;
+            }
+        }
+
+     private:
+        static constexpr int chord_shape[] = {0, 4, 7, 11};
+
+        Pattern pattern;
+        juce::AudioProcessor& processor;
+        double beat;
+        std::vector<int> held;
+        std::mt19937 rng {1234};
+
+        int random(const int lo, const int hi) {
+            return std::uniform_int_distribution{lo, hi}(rng);
+        }
+
+        void hold(juce::MidiBuffer& midi, const int time, const int note) {
+            midi.addEvent(juce::MidiMessage::noteOn(1, note, static_cast<juce::uint8>(random(64, 127))), time);
+            held.push_back(note);
+        }
+
+        void release(juce::MidiBuffer& midi, const int time) {
+            for (const int note: held) {
+                midi.addEvent(juce::MidiMessage::noteOff(1, note), time);
+            }
+            held.clear();
+        }
+
+        // every parameter follows a triangle wave, each at a slightly different rate, as if drawn in automation lanes
+        void sweep(juce::MidiBuffer& midi, const int64_t start) {
+            const auto beats = static_cast<double>(start) / beat;
+            const auto& params = processor.getParameters();
+            for (int i = 0; i < params.size(); i++) {
+                params[i]->setValueNotifyingHost(triangle(beats / (4 + i % 7)));
+            }
+            midi.addEvent(juce::MidiMessage::controllerEvent(1, 1, static_cast<int>(127 * triangle(beats / 2))), 0);
+            midi.addEvent(juce::MidiMessage::channelPressureChange(1, static_cast<int>(127 * triangle(beats / 3))), 0);
+        }
+
+        static float triangle(const double phase) {
+            return static_cast<float>(1 - std::abs(1 - 2 * (phase - std::floor(phase))));
+        }
+    };
+
+    double percentile(const std::vector<double>& sorted, const double p) {
+        const auto rank = static_cast<size_t>(std::ceil(p * static_cast<double>(sorted.size())));
+        return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+    }
+
+    Result run(const Options& options, const Pattern pattern, const double rate, const int buffer_size) {
+        std::unique_ptr<juce::AudioProcessor> processor {createPluginFilter()};
+        processor->setNonRealtime(false);
+        processor->setPlayConfigDetails(0, 2, rate, buffer_size);
+        processor->prepareToPlay(rate, buffer_size);
+
+        juce::AudioBuffer<float> buffer {2, buffer_size};
+        juce::MidiBuffer midi;
+        midi.ensureSize(4096);
+        Script script {pattern, *processor, rate};
+
+        const auto blocks = static_cast<size_t>(std::ceil(options.seconds * rate / buffer_size));
+        std::vector<double> times;
+        times.reserve(blocks);
+
+        int64_t position = 0;
+        for (size_t b = 0; b < warmup_blocks + blocks; b++) {
+            script.block(midi, position, buffer_size);
+
+            const auto begin = std::chrono::steady_clock::now();
+            processor->processBlock(buffer, midi);
+            const auto end = std::chrono::steady_clock::now();
+
+            if (b >= warmup_blocks) {
+                times.push_back(std::chrono::duration<double, std::micro>(end - begin).count());
+            }
+            midi.clear();
+            position += buffer_size;
+        }
+        processor->releaseResources();
+
+        const double deadline = 1e6 * buffer_size / rate;
+        std::sort(times.begin(), times.end());
+        return {
+            std::string{pattern_name(pattern)}, rate, buffer_size, times.size(), deadline,
+            percentile(times, 0.5), percentile(times, 0.99), percentile(times, 0.999), times.back(),
+            static_cast<size_t>(times.end() - std::upper_bound(times.begin(), times.end(), deadline))
+        };
+    }
+}
+
+int main(const int argc, char** argv) {
+    const auto options = parse_options(argc, argv);
+    juce::ScopedJuceInitialiser_GUI juce_init;
+
+    if (options.core >= 0) {
+        // not supported on macOS, where this does nothing
+        juce::Thread::setCurrentThreadAffinityMask(1u << options.core);
+    }
+
+    const std::unique_ptr<juce::AudioProcessor> named {createPluginFilter()};
+    std::printf("%s load test, %.1fs of audio per run%s\n", named->getName().toRawUTF8(), options.seconds,
+                options.core >= 0 ? (", pinned to core " + std::to_string(options.core)).c_str() : "");
+    std::printf("%-10s %7s %6s %8s %11s %10s %10s %10s %10s %8s %7s\n", "pattern", "rate", "buffer", "blocks",
+                "deadline us", "p50 us", "p99 us", "p99.9 us", "max us", "max %", "misses");
+
+    std::vector<Result> results;
+    for (const auto rate: options.rates) {
+        for (const auto buffer_size: options.buffers) {
+            for (const auto pattern: options.patterns) {
+                const auto& r = results.emplace_back(run(options, pattern, rate, buffer_size));
+                std::printf("%-10s %7.0f %6d %8zu %11.1f %10.1f %10.1f %10.1f %10.1f %7.1f%% %7zu\n",
+                            r.pattern.c_str(), r.rate, r.buffer, r.blocks, r.deadline_us,
+                            r.p50_us, r.p99_us, r.p999_us, r.max_us, 100 * r.max_us / r.deadline_us, r.misses);
+                std::fflush(stdout);
+            }
+        }
+    }
+
+    if (!options.csv.empty()) {
+        FILE* csv = std::fopen(options.csv.c_str(), "w");
+        if (csv == nullptr) {
+            std::fprintf(stderr, "couldn't write results to %s\n", options.csv.c_str());
+            return 1;
+        }
+        std::fprintf(csv, "plugin,pattern,rate,buffer,blocks,deadline_us,p50_us,p99_us,p999_us,max_us,misses\n");
+        for (const auto& r: results) {
+            std::fprintf(csv, "\"%s\",%s,%.0f,%d,%zu,%.3f,%.3f,%.3f,%.3f,%.3f,%zu\n", named->getName().toRawUTF8(),
+                         r.pattern.c_str(), r.rate, r.buffer, r.blocks, r.deadline_us,
+                         r.p50_us, r.p99_us, r.p999_us, r.max_us, r.misses);
+        }
+        std::fclose(csv);
+    }
+    return 0;
+}
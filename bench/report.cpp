@@ -0,0 +1,169 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <catch2/reporters/catch_reporter_event_listener.hpp>
+#include <catch2/reporters/catch_reporter_registrars.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#endif
+
+#include <dsp/simd.hpp>
+
+#include "bench.hpp"
+#include "counters.hpp"
+
+#define MODAL_STRINGIFY_(x) #x
+#define MODAL_STRINGIFY(x) MODAL_STRINGIFY_(x)
+
+namespace modal::bench {
+    namespace {
+        std::map<std::string, size_t>& samples_per_run() {
+            static std::map<std::string, size_t> samples;
+            return samples;
+        }
+
+        // the processors run with denormals flushed to zero through `juce::ScopedNoDenormals`, so the benchmarks do too
+        void flush_denormals() {
+#if defined(__SSE__) || defined(_M_X64)
+            _mm_setcsr(_mm_getcsr() | 0x8040); // flush to zero, denormals are zero
+#elif defined(__aarch64__)
+            uint64_t fpcr;
+            asm volatile("mrs %0, fpcr" : "=r"(fpcr));
+            asm volatile("msr fpcr, %0" : : "r"(fpcr | (uint64_t{1} << 24)));
+#endif
+        }
+
+        struct Result {
+            std::string name;
+            size_t samples;
+            double mean_ns, low_ns, high_ns, std_dev_ns;
+
+            [[nodiscard]] double ns_per_sample() const {
+                return samples > 0 ? mean_ns / static_cast<double>(samples) : 0;
+            }
+
+            // time spent processing over the length of the audio processed, below 1 keeps up with real time
+            [[nodiscard]] double real_time_factor(const double rate) const {
+                return ns_per_sample() * rate / 1e9;
+            }
+        };
+
+        // a counter formatted for the report, empty if it wasn't counted
+        std::string cell(const std::optional<double>& value, const int precision) {
+            if (!value) {
+                return "";
+            }
+            char text[32];
+            std::snprintf(text, sizeof(text), "%.*f", precision, *value);
+            return text;
+        }
+    }
+
+    void set_samples_per_run(const std::string& name, const size_t samples) {
+        samples_per_run()[name] = samples;
+    }
+
+    /** @brief Reports benchmarks as ns/sample and real-time factors, as well as Catch2's own output.
+     *
+     * Prints a table after the run, followed by one of hardware counters if they were enabled,
+     * and writes CSV to the file named by the `MODAL_BENCH_CSV` environment variable if it's set.
+     */
+    class RateReporter final : public Catch::EventListenerBase {
+     public:
+        using EventListenerBase::EventListenerBase;
+
+        void testRunStarting(Catch::TestRunInfo const&) override {
+            flush_denormals();
+        }
+
+        void benchmarkEnded(Catch::BenchmarkStats<> const& stats) override {
+            const auto found = samples_per_run().find(stats.info.name);
+            results.push_back({
+                stats.info.name,
+                found != samples_per_run().end() ? found->second : 0,
+                stats.mean.point.count(), stats.mean.lower_bound.count(), stats.mean.upper_bound.count(),
+                stats.standardDeviation.point.count()
+            });
+        }
+
+        void testRunEnded(Catch::TestRunStats const&) override {
+            const auto num_type = MODAL_STRINGIFY(MODAL_NUM_TYPE);
+            const auto isa = dsp::simd::isa_name(dsp::simd::kernels().isa);
+
+            std::printf("\nDSP benchmarks, %s, %.*s kernels\n", num_type, static_cast<int>(isa.size()), isa.data());
+            std::printf("%-56s %14s %12s %10s %10s %10s\n", "benchmark", "mean ns/run", "ns/sample", "RTF 44.1k", "RTF 48k", "RTF 96k");
+            for (const auto& r : results) {
+                if (r.samples > 0) {
+                    std::printf("%-56s %14.1f %12.3f %10.5f %10.5f %10.5f\n", r.name.c_str(), r.mean_ns, r.ns_per_sample(),
+                                r.real_time_factor(report_rates[0]), r.real_time_factor(report_rates[1]),
+                                r.real_time_factor(report_rates[2]));
+                } else {
+                    std::printf("%-56s %14.1f %12s %10s %10s %10s\n", r.name.c_str(), r.mean_ns, "-", "-", "-", "-");
+                }
+            }
+
+            if (counters_enabled()) {
+                std::printf("\nhardware counters, per run\n");
+                std::printf("%-56s %14s %12s %8s %10s %10s %10s %10s\n", "benchmark", "cycles", "cycles/smp", "IPC",
+                            "L1D MPKI", "LLC MPKI", "br miss %", "FP assists");
+                for (const auto& r : results) {
+                    if (const auto* c = counters_for(r.name)) {
+                        const auto per_sample = r.samples > 0 && c->cycles ? std::optional{*c->cycles / static_cast<double>(r.samples)}
+                                                                           : std::nullopt;
+                        const auto miss_percent = c->branch_miss_rate() ? std::optional{100 * *c->branch_miss_rate()} : std::nullopt;
+                        std::printf("%-56s %14s %12s %8s %10s %10s %10s %10s\n", r.name.c_str(), cell(c->cycles, 0).c_str(),
+                                    cell(per_sample, 2).c_str(), cell(c->ipc(), 2).c_str(), cell(c->l1d_mpki(), 2).c_str(),
+                                    cell(c->llc_mpki(), 3).c_str(), cell(miss_percent, 2).c_str(),
+                                    cell(c->fp_assists, 1).c_str());
+                    }
+                }
+            }
+
+            const char* path = std::getenv("MODAL_BENCH_CSV");
+            if (path == nullptr) {
+                return;
+            }
+            FILE* csv = std::fopen(path, "w");
+            if (csv == nullptr) {
+                std::fprintf(stderr, "couldn't write benchmark CSV to %s\n", path);
+                return;
+            }
+            std::fprintf(csv, "benchmark,num_type,isa,samples_per_run,mean_ns,mean_low_ns,mean_high_ns,std_dev_ns,"
+                              "ns_per_sample,rtf_44100,rtf_48000,rtf_96000,"
+                              "cycles,instructions,l1d_misses,llc_misses,branches,branch_misses,fp_assists,"
+                              "ipc,l1d_mpki,llc_mpki,branch_miss_rate\n");
+            for (const auto& r : results) {
+                std::fprintf(csv, "\"%s\",%s,%.*s,%zu,%.3f,%.3f,%.3f,%.3f,%.5f,%.7f,%.7f,%.7f",
+                             r.name.c_str(), num_type, static_cast<int>(isa.size()), isa.data(), r.samples,
+                             r.mean_ns, r.low_ns, r.high_ns, r.std_dev_ns, r.ns_per_sample(),
+                             r.real_time_factor(report_rates[0]), r.real_time_factor(report_rates[1]),
+                             r.real_time_factor(report_rates[2]));
+                // counters that weren't counted are left empty
+                const Counters none;
+                const auto* c = counters_for(r.name);
+                if (c == nullptr) {
+                    c = &none;
+                }
+                for (const auto& v : {c->cycles, c->instructions, c->l1d_misses, c->llc_misses, c->branches, c->branch_misses,
+                                      c->fp_assists, c->ipc(), c->l1d_mpki(), c->llc_mpki(), c->branch_miss_rate()}) {
+                    std::fprintf(csv, ",%s", cell(v, 5).c_str());
+                }
+                std::fprintf(csv, "\n");
+            }
+            std::fclose(csv);
+        }
+
+     private:
+        std::vector<Result> results;
+    };
+
+    CATCH_REGISTER_LISTENER(RateReporter)
+}
@@ -9,6 +9,7 @@
 #include <ui/BoundSlider.hpp>
 #include <ui/LookAndFeel.hpp>
 #include <ui/MacroController.hpp>
+#include <ui/PerfDisplay.hpp>
 
 #ifdef MODAL_DEBUG_UI
 #include "melatonin_inspector/melatonin_inspector.h"
@@ -47,6 +48,7 @@ namespace modal::plugin {
             ui::BoundSlider decay{Slider::RotaryHorizontalVerticalDrag};
             ui::BoundSlider fb_amount { Slider::RotaryHorizontalVerticalDrag };
             ui::BoundSlider fb_intensity {Slider::RotaryHorizontalVerticalDrag};
+            ui::BoundCombobox fb_routing;
 
             void setup(AudioProcessorValueTreeState& plug_params);
 
@@ -81,6 +83,8 @@ namespace modal::plugin {
 
             ui::BoundSlider attack{Slider::RotaryHorizontalVerticalDrag};
             ui::BoundSlider release{Slider::RotaryHorizontalVerticalDrag};
+            ui::BoundCombobox attack_curve;
+            ui::BoundCombobox release_curve;
 
             Label l{"exciter_label", "Exciter"};
 
@@ -106,7 +110,34 @@ namespace modal::plugin {
 
         MacroControls macro_controls {processorRef.macro_control_1.get_ui(), processorRef.macro_control_2.get_ui()};
 
-        MidiKeyboardComponent keyboard {processorRef.keyboard_state, juce::KeyboardComponentBase::horizontalKeyboard};
+        struct ModulationControls final : public juce::Component {
+            ui::BoundSlider lfo_1_rate{Slider::RotaryHorizontalVerticalDrag};
+            ui::BoundCombobox lfo_1_shape;
+            ui::BoundSlider lfo_2_rate{Slider::RotaryHorizontalVerticalDrag};
+            ui::BoundCombobox lfo_2_shape;
+
+            ui::BoundSlider attack{Slider::RotaryHorizontalVerticalDrag};
+            ui::BoundSlider decay{Slider::RotaryHorizontalVerticalDrag};
+            ui::BoundSlider sustain{Slider::RotaryHorizontalVerticalDrag};
+            ui::BoundSlider release{Slider::RotaryHorizontalVerticalDrag};
+
+            ui::BoundSlider random_rate{Slider::RotaryHorizontalVerticalDrag};
+            ui::BoundCombobox control_rate;
+
+            ui::MacroController::UI& routes;
+            explicit ModulationControls(ui::MacroController::UI& r) : routes{r} {}
+
+            void setup(AudioProcessorValueTreeState& plug_params);
+            void resized() override;
+        };
+
+        ModulationControls modulation_controls {processorRef.mod_control.get_ui()};
+
+        ui::PerfDisplay perf_display {[this] { return processorRef.perf_summary(); }};
+
+        juce::TabbedComponent modulation_tabs {juce::TabbedButtonBar::TabsAtTop};
+
+        MidiKeyboardComponent keyboard {processorRef.keyboard.state, juce::KeyboardComponentBase::horizontalKeyboard};
 
         JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MiniEditor)
     };
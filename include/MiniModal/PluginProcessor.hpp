@@ -6,6 +6,12 @@
 
 #include <dsp/mini_modal_synth.hpp>
 #include <dsp/control.hpp>
+#include <dsp/lockfree.hpp>
+#include <dsp/modmatrix.hpp>
+#include <dsp/perf.hpp>
+#include <dsp/preset.hpp>
+#include <dsp/rtcheck.hpp>
+#include "ui/KeyboardBridge.hpp"
 #include "ui/MacroController.hpp"
 
 namespace modal::plugin {
@@ -63,7 +69,23 @@ namespace modal::plugin {
         void valueTreePropertyChanged(juce::ValueTree& treeWhosePropertyHasChanged,
                                       const juce::Identifier& property) override;
 
-        juce::MidiKeyboardState keyboard_state;
+        /** @brief Maps a preset library, whose presets become the plugin's programs.
+         *
+         * @return `false` if the file isn't a valid library, leaving no presets
+         */
+        bool load_preset_library(const juce::File& file);
+
+        /** @brief Default preset library, loaded on construction.
+         */
+        static juce::File default_preset_library();
+
+        /** @brief Summary of the timings and event counts of recent blocks.
+         *
+         * Only call from one thread at a time, usually the editor's timer or a benchmark.
+         */
+        dsp::perf::Summary perf_summary();
+
+        ui::KeyboardBridge keyboard;
 
     private:
         //==============================================================================
@@ -72,11 +94,60 @@ namespace modal::plugin {
     public: // mediator needs to be init'd after params
         ui::MacroController macro_control_1;
         ui::MacroController macro_control_2;
+        // routes from the LFOs, envelope, random and MIDI sources
+        ui::MacroController mod_control;
 
     private:
-
+        // macros and the other sources modulate the patch through this, rather than setting host parameters
+        std::vector<juce::AudioParameterFloat*> mod_targets;
+        dsp::mod::ModEngine modulation;
+
+        // mod matrix target indices of the parameters read in `processBlock`
+        struct TargetIndices {
+            size_t even_gain, foldback_point, exciter_rate, attack, release,
+                   detune, exponent, falloff, decay, fb_amt, fb_ins,
+                   lfo_1_rate, lfo_2_rate, mod_attack, mod_decay, mod_sustain, mod_release, random_rate;
+        } target_idx {};
+
+        // parameters read in `processBlock` that aren't mod matrix targets,
+        // looked up once as looking them up by ID constructs strings
+        struct ParamPointers {
+            juce::AudioParameterChoice *exciter, *foldback_mode, *fb_route,
+                                       *lfo_1_shape, *lfo_2_shape, *control_rate,
+                                       *attack_curve, *release_curve;
+            juce::AudioParameterInt* modes;
+            juce::AudioParameterFloat *macro_control_1, *macro_control_2;
+        } param {};
+
+        size_t target_index(const juce::String& id) const;
+        float modulated(size_t target) const;
+        void apply_params();
+        void start_note(int note, float velocity);
+        void stop_note(int note);
+
+        // ramp time of host parameter changes, so dragging a slider changes the patch smoothly
+        static constexpr float parameter_smoothing_time = 0.05f;
+        // most voices whose mode coefficients are updated per control period, 16 voices take 4 periods
+        static constexpr size_t voices_per_update = 4;
+
+        dsp::synth::MiniModalPatch patch;
         std::array<dsp::synth::MiniModalSynth<40>, 16> modal_synths;
         dsp::PolyController<dsp::synth::MiniModalSynth<40>, 16> controller;
+        dsp::CoefficientScheduler<16> coefficients {voices_per_update};
+
+        // presets are decoded on the message thread into `state_scratch`, then handed to the audio thread,
+        // which switches to them at the start of its next block
+        dsp::preset::PresetLibrary presets;
+        int current_preset = 0;
+        dsp::preset::PatchState state_scratch;
+        dsp::TripleBuffer<dsp::preset::PatchState> preset_snapshot;
+        std::atomic_bool preset_pending = false;
+        // `dsp::preset::param_id()` of each mod matrix target
+        std::vector<uint32_t> target_ids;
+
+        dsp::perf::Monitor perf;
+
+        void apply_state(const dsp::preset::PatchState& state);
 
         JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MiniProcessor)
     };
@@ -8,6 +8,8 @@
 #include <ui/BoundCombobox.hpp>
 #include <ui/BoundSlider.hpp>
 #include <ui/LookAndFeel.hpp>
+#include <ui/MacroController.hpp>
+#include <ui/PerfDisplay.hpp>
 
 #ifdef MODAL_DEBUG_UI
 #include "melatonin_inspector/melatonin_inspector.h"
@@ -47,6 +49,9 @@ namespace modal::plugin {
             ui::BoundSlider exponent{Slider::RotaryHorizontalVerticalDrag};
             ui::BoundSlider falloff{Slider::RotaryHorizontalVerticalDrag};
             ui::BoundSlider decay{Slider::RotaryHorizontalDrag};
+            ui::BoundSlider damping{Slider::RotaryHorizontalVerticalDrag};
+            ui::BoundCombobox quality;
+            ui::BoundCombobox mpe;
 
             void setup(AudioProcessorValueTreeState& plug_params);
 
@@ -83,6 +88,8 @@ namespace modal::plugin {
 
             ui::BoundSlider attack{Slider::RotaryHorizontalVerticalDrag};
             ui::BoundSlider release{Slider::RotaryHorizontalVerticalDrag};
+            ui::BoundCombobox attack_curve;
+            ui::BoundCombobox release_curve;
 
             Label l{"exciter_label", "Exciter"};
 
@@ -112,7 +119,33 @@ namespace modal::plugin {
 
         FormantControls formant_controls;
 
-        MidiKeyboardComponent keyboard {processorRef.keyboard_state, juce::KeyboardComponentBase::horizontalKeyboard};
+        struct ModulationControls final : public juce::Component {
+            ui::BoundSlider lfo_1_rate{Slider::RotaryHorizontalVerticalDrag};
+            ui::BoundCombobox lfo_1_shape;
+            ui::BoundSlider lfo_2_rate{Slider::RotaryHorizontalVerticalDrag};
+            ui::BoundCombobox lfo_2_shape;
+
+            ui::BoundSlider attack{Slider::RotaryHorizontalVerticalDrag};
+            ui::BoundSlider decay{Slider::RotaryHorizontalVerticalDrag};
+            ui::BoundSlider sustain{Slider::RotaryHorizontalVerticalDrag};
+            ui::BoundSlider release{Slider::RotaryHorizontalVerticalDrag};
+
+            ui::BoundSlider random_rate{Slider::RotaryHorizontalVerticalDrag};
+
+            ui::MacroController::UI& routes;
+            explicit ModulationControls(ui::MacroController::UI& r) : routes{r} {}
+
+            void setup(AudioProcessorValueTreeState& plug_params);
+            void resized() override;
+        };
+
+        ModulationControls modulation_controls {processorRef.mod_control.get_ui()};
+
+        ui::PerfDisplay perf_display {[this] { return processorRef.perf_summary(); }};
+
+        juce::TabbedComponent modulation_tabs {juce::TabbedButtonBar::TabsAtTop};
+
+        MidiKeyboardComponent keyboard {processorRef.keyboard.state, juce::KeyboardComponentBase::horizontalKeyboard};
 
         JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Editor)
     };
@@ -4,8 +4,11 @@
 
 #include <juce_audio_processors/juce_audio_processors.h>
 
-#include <dsp/modal_synth.hpp>
-#include <dsp/control.hpp>
+#include <dsp/modal_engine.hpp>
+#include <dsp/perf.hpp>
+#include <dsp/rtcheck.hpp>
+#include "ui/KeyboardBridge.hpp"
+#include "ui/MacroController.hpp"
 
 namespace modal::plugin {
 //==============================================================================
@@ -62,15 +65,36 @@ namespace modal::plugin {
         void valueTreePropertyChanged(juce::ValueTree& treeWhosePropertyHasChanged,
                                       const juce::Identifier& property) override;
 
-        juce::MidiKeyboardState keyboard_state;
+        /** @brief Summary of the timings and event counts of recent blocks.
+         *
+         * Only call from one thread at a time, usually the editor's timer or a benchmark.
+         */
+        dsp::perf::Summary perf_summary();
+
+        ui::KeyboardBridge keyboard;
 
      private:
         //==============================================================================
         juce::AudioProcessorValueTreeState params;
         std::atomic_bool params_changed = true;
-
-        std::array<dsp::synth::ModalSynth<40>, 16> modal_synths;
-        dsp::PolyController<dsp::synth::ModalSynth<40>, 16> controller;
+    public: // mediator needs to be init'd after params
+        // routes from the LFOs, envelope, random and MIDI sources to the engine's continuous settings
+        ui::MacroController mod_control;
+
+    private:
+        // parameters read in `processBlock`, looked up once as looking them up by ID constructs strings
+        struct ParamPointers {
+            juce::AudioParameterChoice *exciter, *foldback_mode, *quality, *mpe, *lfo_1_shape, *lfo_2_shape,
+                                       *attack_curve, *release_curve;
+            std::atomic<float> *modes, *detune, *exponent, *exciter_rate, *decay, *falloff,
+                               *dial1, *dial2, *slider1, *slider2, *foldback_point, *attack, *release,
+                               *formant_x, *formant_y, *formant_len, *formant_mix, *damping,
+                               *lfo_1_rate, *lfo_2_rate, *mod_attack, *mod_decay, *mod_sustain, *mod_release, *random_rate;
+        } param {};
+
+        // leaves the rest of the deadline to the host and other plugins
+        static constexpr double realtime_load_target = 0.7;
+        dsp::synth::ModalEngine engine;
 
         JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Processor)
     };
@@ -2,6 +2,8 @@
 
 #pragma once
 
+#include <cstdint>
+
 #include <dsp/dsp.hpp>
 
 namespace modal::dsp::bonus {
@@ -35,4 +37,52 @@ namespace modal::dsp::bonus {
      * \f$ gain = 10^{0.05db} \f$
      */
     modal::dsp::num db2gain(modal::dsp::num db);
-}
\ No newline at end of file
+
+    /** @brief Fast rational approximation of `tanh()`.
+     *
+     * Calculated as \f$ x(27 + x^2) / (27 + 9x^2) \f$, clamped to \f$ \pm 1 \f$ for \f$ |x| \geq 3 \f$,
+     * which is within about 0.03 of the true value and has no branches apart from the clamp.
+     */
+    inline modal::dsp::num fast_tanh(const modal::dsp::num x) {
+        const modal::dsp::num clamped = x < -3 ? -3 : (x > 3 ? 3 : x);
+        const modal::dsp::num x2 = clamped * clamped;
+        return clamped * (27 + x2) / (27 + 9 * x2);
+    }
+
+    /** @brief Small, fast pseudo-random number generator for noise.
+     *
+     * A 32-bit [xorshift](https://www.jstatsoft.org/article/view/v008i14) generator,
+     * so it's only 4 bytes of state and a few instructions per number.
+     * Nowhere near good enough for anything but audio noise.
+     */
+    class FastRng {
+     public:
+        /** @brief Constructor.
+         *
+         * @param seed Seed, by default a different one for every generator in the process
+         */
+        explicit FastRng(std::uint32_t seed = next_seed()) : state{seed != 0 ? seed : 1} {}
+
+        /** @brief Next raw 32-bit number
+         */
+        std::uint32_t next() {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            return state;
+        }
+
+        /** @brief Uniformly distributed number in `[lo, hi)`
+         */
+        modal::dsp::num uniform(const modal::dsp::num lo, const modal::dsp::num hi) {
+            // top 24 bits, so every value is exactly representable as a float
+            const auto unit = static_cast<modal::dsp::num>(next() >> 8) * (1 / 16777216.0_nm);
+            return lo + (hi - lo) * unit;
+        }
+
+     private:
+        static std::uint32_t next_seed();
+
+        std::uint32_t state;
+    };
+}
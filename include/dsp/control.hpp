@@ -3,19 +3,31 @@
 #pragma once
 
 #include <dsp/bonus.hpp>
+#include <algorithm>
 #include <array>
+#include <cstdint>
+#include <optional>
 
 namespace modal::dsp {
 
     /**
      * @brief Round-robin polyphony controller for [instrument classes](docs/DSP Coding Standards.md)
      *
+     * New notes go to voices that have died away, see `finished()`, before voices still ringing after their release.
+     *
+     * Remembers the MIDI channel each voice was played on, so per-note controllers like MPE's
+     * can be sent to the voices playing on a channel, see `for_channel()`.
+     *
      * @tparam T [Instrument class](docs/DSP Coding Standards.md) to be controlled
      * @tparam count Number of voices
      */
-    template <typename T, int count>
+    template <typename T, size_t count>
     class PolyController {
         std::array<std::optional<int>, count> notes;
+        // channel each voice was last played on, or -1 once another voice is played on it
+        std::array<int, count> channels;
+        // played, and not yet `finished()`
+        std::array<bool, count> sounding {};
         std::array<T, count>& voices;
         size_t last_on_voice = 0;
      public:
@@ -25,6 +37,7 @@ namespace modal::dsp {
          */
         explicit PolyController(std::array<T, count>& v) : voices(v) {
             notes.fill(std::nullopt);
+            channels.fill(-1);
         }
 
         /** @brief Note on
@@ -34,17 +47,85 @@ namespace modal::dsp {
          *
          * @param note Note to play, as MIDI note number
          * @param velocity Velocity of note, in range 0-1
+         * @param channel MIDI channel the note was played on
+         * @return Index of the voice playing the note, or nothing if it was dropped
          */
-        void key_down(int note, float velocity) {
-            for (size_t i = 0; i < notes.size(); i++) {
-                size_t idx = (i + last_on_voice + 1) % notes.size();
-                if (!notes[idx]) {
-                    notes[idx] = note;
-                    voices[idx].on(modal::dsp::bonus::midi2freq(static_cast<num>(note)), velocity);
-                    last_on_voice = idx;
-                    return;
+        std::optional<size_t> key_down(int note, float velocity, int channel = 0) {
+            const auto idx = next_voice();
+            if (idx) {
+                // released voices still ringing on the channel stop following it
+                for (size_t i = 0; i < channels.size(); i++) {
+                    if (!notes[i] && channels[i] == channel) {
+                        channels[i] = -1;
+                    }
+                }
+                notes[*idx] = note;
+                channels[*idx] = channel;
+                sounding[*idx] = true;
+                voices[*idx].on(modal::dsp::bonus::midi2freq(static_cast<num>(note)), velocity);
+                last_on_voice = *idx;
+            }
+            return idx;
+        }
+
+        /** @brief The voice the next note on will be played by, or nothing if it would be dropped.
+         */
+        [[nodiscard]] std::optional<size_t> next_voice() const {
+            // silent voices first, so ringing ones are only cut off when there are none
+            for (const bool ringing: {false, true}) {
+                for (size_t i = 0; i < notes.size(); i++) {
+                    size_t idx = (i + last_on_voice + 1) % notes.size();
+                    if (!notes[idx] && sounding[idx] == ringing) {
+                        return idx;
+                    }
                 }
             }
+            return std::nullopt;
+        }
+
+        /** @brief Marks a released voice as having died away, so it's played before voices still ringing.
+         */
+        void finished(size_t voice) {
+            if (!notes[voice]) {
+                sounding[voice] = false;
+            }
+        }
+
+        /** @brief Whether a voice is held or still ringing after its release, rather than `finished()` or never played.
+         */
+        [[nodiscard]] bool is_sounding(size_t voice) const {
+            return sounding[voice];
+        }
+
+        /** @brief Whether a voice is playing a held note.
+         */
+        [[nodiscard]] bool is_active(size_t voice) const {
+            return notes[voice].has_value();
+        }
+
+        /** @brief Number of voices playing held notes.
+         */
+        [[nodiscard]] size_t active_voices() const {
+            return static_cast<size_t>(std::count_if(notes.begin(), notes.end(), [](const auto& n) { return n.has_value(); }));
+        }
+
+        /** @brief Calls `f` with the index of every voice following a channel.
+         *
+         * A voice follows the channel it was played on, through its release until another note is played on the channel.
+         */
+        template<typename F>
+        void for_channel(const int channel, F&& f) const {
+            for (size_t i = 0; i < channels.size(); i++) {
+                if (channels[i] == channel) {
+                    f(i);
+                }
+            }
+        }
+
+        /** @brief MIDI channel a voice is following, or -1.
+         */
+        [[nodiscard]] int channel(size_t voice) const {
+            return channels[voice];
         }
 
         /** @brief Note off
@@ -53,10 +134,11 @@ namespace modal::dsp {
          * does nothing if no voices are playing that note.
          *
          * @param note Note to release, as MIDI note number
+         * @param channel MIDI channel the note was played on
          */
-        void key_up(int note) {
+        void key_up(int note, int channel = 0) {
             for (size_t i = 0; i < notes.size(); i++) {
-                if (notes[i] == note) {
+                if (notes[i] == note && channels[i] == channel) {
                     voices[i].off();
                     notes[i] = std::nullopt;
                     return;
@@ -64,4 +146,220 @@ namespace modal::dsp {
             }
         }
     };
-}
\ No newline at end of file
+
+    /** @brief Coalesces and rate-limits updates of voices' mode coefficients.
+     *
+     * A change to the patch the voices share only marks every voice as out of date, however many changes there are.
+     * `run()` is called once per control period, and updates at most a few out of date voices, round-robin.
+     * A burst of changes, like a slider being dragged, costs at most one update per voice,
+     * and the cost of updating every voice is spread over several control periods rather than landing in one.
+     *
+     * @tparam count Number of voices
+     */
+    template <size_t count>
+    class CoefficientScheduler {
+        std::array<uint32_t, count> voice_generation {};
+        uint32_t generation = 0;
+        size_t next_voice = 0;
+        size_t per_run;
+     public:
+        /** @brief Constructor
+         *
+         * @param voices_per_run Most voices updated by each `run()`
+         */
+        explicit CoefficientScheduler(const size_t voices_per_run = count) : per_run(std::clamp<size_t>(voices_per_run, 1, count)) {}
+
+        /** @brief Sets the most voices updated by each `run()`, between 1 and `count`.
+         */
+        void set_voices_per_run(const size_t voices) {
+            per_run = std::clamp<size_t>(voices, 1, count);
+        }
+
+        /** @brief Marks every voice as out of date, after a change to the patch.
+         */
+        void invalidate() {
+            generation++;
+        }
+
+        /** @brief Marks a voice as up to date, after it has updated itself, such as on note on.
+         */
+        void updated(const size_t voice) {
+            voice_generation[voice] = generation;
+        }
+
+        /** @brief Whether any voice is out of date.
+         */
+        [[nodiscard]] bool pending() const {
+            return std::any_of(voice_generation.begin(), voice_generation.end(),
+                               [this](const uint32_t g) { return g != generation; });
+        }
+
+        /** @brief Updates the next out of date voices, up to the voices per run.
+         *
+         * @param update Called with the index of each voice to update
+         * @return Number of voices updated
+         */
+        template <typename F>
+        size_t run(F&& update) {
+            size_t done = 0;
+            size_t last = next_voice;
+            for (size_t i = 0; i < count && done < per_run; i++) {
+                const size_t v = (next_voice + i) % count;
+                if (voice_generation[v] != generation) {
+                    update(v);
+                    voice_generation[v] = generation;
+                    last = v;
+                    done++;
+                }
+            }
+            // carry on after the last voice updated, so every voice gets its turn under constant changes
+            if (done > 0) {
+                next_voice = (last + 1) % count;
+            }
+            return done;
+        }
+    };
+
+    /** @brief Settings of a `ModeGovernor`.
+     */
+    struct GovernorSettings {
+        /// load above which the budget shrinks
+        double target_load = 0.7;
+        /// load below which the budget grows back
+        double recover_load = 0.4;
+        /// share of the budget kept each block over the target load
+        double shrink = 0.75;
+        /// blocks in a row under the recovery load before each step of growth
+        uint32_t recover_blocks = 32;
+        /// modes every sounding voice gets before any gets more, if the budget allows
+        size_t min_voice_modes = 4;
+        /// voices whose notes started this recently are served first, in seconds
+        modal::dsp::num recent_seconds = 0.05_nm;
+        /// level below which a voice that isn't held or recent is silent
+        modal::dsp::num silent_level = 1e-4_nm;
+    };
+
+    /** @brief Bounds the CPU time of a set of voices by sharing a budget of resonator modes between them.
+     *
+     * After each block, `update()` is given the block's load, the time it took over its duration.
+     * Above the target load the budget shrinks at once, so the next blocks are cheaper. Only once the load has stayed
+     * below a lower recovery load for a while does it grow back, a step at a time, so it settles rather than
+     * swinging around the load where blocks start to miss their deadline.
+     *
+     * `allocate()` shares the budget out once per control period: voices whose notes just started come first,
+     * newest first, then the rest from loudest to quietest. Every voice gets a few modes before any gets all it wants,
+     * and voices that have fallen silent get none. Voices synthesise their first modes, so the ones dropped are
+     * the highest and, with any falloff, the weakest.
+     *
+     * @tparam count Number of voices
+     */
+    template <size_t count>
+    class ModeGovernor {
+     public:
+        using Settings = GovernorSettings;
+
+        /** @brief What `allocate()` knows of a voice.
+         */
+        struct Voice {
+            /// level of the voice's recent output, such as its peak
+            modal::dsp::num level = 0;
+            /// time since the voice's note started, in seconds
+            modal::dsp::num age = 0;
+            /// whether the voice's note is held
+            bool held = false;
+        };
+
+        /** @brief Constructor
+         *
+         * @param max_voice_modes Most modes a voice plays, the budget is at most this for every voice
+         * @param s Settings
+         */
+        explicit ModeGovernor(const size_t max_voice_modes, const Settings& s = {})
+            : settings(s), max_budget(max_voice_modes * count),
+              min_budget(std::min(max_budget, s.min_voice_modes * count)), current(max_budget) {}
+
+        /** @brief Sets the target and recovery loads.
+         */
+        void set_loads(const double target, const double recover) {
+            settings.target_load = target;
+            settings.recover_load = std::min(recover, target);
+        }
+
+        [[nodiscard]] const Settings& get_settings() const {
+            return settings;
+        }
+
+        /** @brief Adjusts the budget after a block.
+         *
+         * @param load Time the block took over its duration, 1 when it only just met its deadline
+         */
+        void update(const double load) {
+            if (load > settings.target_load) {
+                current = std::max(min_budget, static_cast<size_t>(static_cast<double>(current) * settings.shrink));
+                calm_blocks = 0;
+            } else if (load < settings.recover_load) {
+                if (++calm_blocks >= settings.recover_blocks) {
+                    current = std::min(max_budget, current + std::max<size_t>(max_budget / 16, 1));
+                    calm_blocks = 0;
+                }
+            } else {
+                calm_blocks = 0;
+            }
+        }
+
+        /** @brief Puts the budget back to its most.
+         */
+        void reset() {
+            current = max_budget;
+            calm_blocks = 0;
+        }
+
+        /** @brief Total modes the voices can currently play.
+         */
+        [[nodiscard]] size_t budget() const {
+            return current;
+        }
+
+        /** @brief Shares the budget between the voices.
+         *
+         * @param voices State of each voice
+         * @param wanted Modes each voice would play without a budget
+         * @param limits Set to the most modes each voice can play
+         */
+        void allocate(const std::array<Voice, count>& voices, const size_t wanted, std::array<size_t, count>& limits) const {
+            std::array<size_t, count> order;
+            size_t sounding = 0;
+            for (size_t v = 0; v < count; v++) {
+                limits[v] = 0;
+                const auto& voice = voices[v];
+                if (voice.held || voice.age < settings.recent_seconds || voice.level > settings.silent_level) {
+                    order[sounding++] = v;
+                }
+            }
+            std::sort(order.begin(), order.begin() + static_cast<std::ptrdiff_t>(sounding), [&](const size_t a, const size_t b) {
+                const bool recent_a = voices[a].age < settings.recent_seconds, recent_b = voices[b].age < settings.recent_seconds;
+                if (recent_a != recent_b) {
+                    return recent_a;
+                }
+                return recent_a ? voices[a].age < voices[b].age : voices[a].level > voices[b].level;
+            });
+
+            size_t left = current;
+            for (size_t i = 0; i < sounding; i++) {
+                const auto given = std::min({wanted, settings.min_voice_modes, left});
+                limits[order[i]] = given;
+                left -= given;
+            }
+            for (size_t i = 0; i < sounding; i++) {
+                const auto more = std::min(wanted - limits[order[i]], left);
+                limits[order[i]] += more;
+                left -= more;
+            }
+        }
+
+     private:
+        Settings settings;
+        size_t max_budget, min_budget, current;
+        uint32_t calm_blocks = 0;
+    };
+}
@@ -7,31 +7,153 @@
 #include <dsp/bonus.hpp>
 
 namespace modal::dsp {
+    /** @brief Fractional delay interpolation methods supported by `delay_line`
+     */
+    enum class DelayInterpolation {
+        /// Linear interpolation between the 2 nearest samples
+        Linear,
+        /// Catmull-Rom cubic Hermite interpolation over the 4 nearest samples
+        Cubic,
+        /// 3rd order Lagrange interpolation over the 4 nearest samples
+        Lagrange,
+        /// 1st order allpass interpolation, flat magnitude response but needs per-tap state, see `delay_line::allpass_tap`
+        Allpass
+    };
+
+    /** @brief Delay line using a power-of-two ring buffer.
+     *
+     * Delays are measured in samples backwards from the write position,
+     * so reading a delay of `d` before pushing the current sample gives exactly `d` samples of delay.
+     * Interpolated reads need some samples either side of the read position,
+     * so `Linear` needs a delay of at least 1 sample, `Allpass` at least 1.5, and `Cubic` and `Lagrange` at least 2.
+     *
+     * Memory is only allocated by the constructor and `reserve()`, so the other methods are safe to call on the audio thread.
+     * `set_sample_rate()` and `set_max_time()` clamp the delay to the reserved capacity rather than growing it.
+     */
     class delay_line {
         public:
+            /** @brief State for reading one tap with allpass interpolation.
+             *
+             * The allpass interpolator is recursive, so each tap needs its own state and must be read once per sample.
+             */
+            struct allpass_tap {
+                /// @private
+                modal::dsp::num y_del1 = 0;
+            };
+
+            /** @brief Constructor.
+             *
+             * Reserves enough capacity for `mt` seconds at `sr`.
+             * @param sr Sample rate, in Hz
+             * @param mt Maximum delay time, in seconds
+             */
             delay_line(num sr, num mt);
 
+            /** @brief Allocates enough capacity for a maximum delay at a maximum sample rate.
+             *
+             * Never shrinks the buffer. Allocates, so don't call on the audio thread.
+             * @param max_sr Highest sample rate the delay will be used at, in Hz
+             * @param max_delay_time Longest delay time that will be used, in seconds
+             */
+            void reserve(num max_sr, num max_delay_time);
+
+            /** @brief Writes a single sample to the delay line.
+             */
             void push_sample(num s);
 
+            /** @brief Writes a block of samples to the delay line.
+             *
+             * Equivalent to calling `push_sample()` for each sample.
+             */
+            void write_block(const num* in, size_t n);
+
+            /** @brief Reads the delay line with linear interpolation.
+             *
+             * @param time_backwards Delay time, in seconds
+             */
             [[nodiscard]] num fetch_sample_s(num time_backwards) const;
 
-            // with -O1 and better this optimises smaller than `(i % len + len) % len` on x64 and ARM - https://godbolt.org/z/aj1GsTovM
-            [[nodiscard]] num fetch_sample_sm(int samps_backwards) const;
+            /** @brief Reads the delay line at a whole number of samples.
+             *
+             * @param samps_backwards Delay, in samples
+             */
+            [[nodiscard]] num fetch_sample_sm(int samps_backwards) const {
+                return buffer[(write_idx - static_cast<unsigned long>(samps_backwards)) & mask];
+            }
+
+            /** @brief Reads the delay line at a fractional number of samples.
+             *
+             * @param samps_backwards Delay, in samples
+             * @param interp Interpolation method, `Allpass` falls back to `Lagrange` as it needs state
+             */
+            [[nodiscard]] num fetch_sample(num samps_backwards, DelayInterpolation interp) const;
 
+            /** @brief Reads the delay line at a fractional number of samples with allpass interpolation.
+             *
+             * @param samps_backwards Delay, in samples, which should change slowly for the allpass to stay smooth
+             * @param tap State of the tap being read
+             */
+            [[nodiscard]] num fetch_sample_allpass(num samps_backwards, allpass_tap& tap) const;
+
+            /** @brief Reads several taps from the delay line at once.
+             *
+             * @param samps_backwards Array of `count` delays, in samples
+             * @param out Array of `count` outputs
+             * @param count Number of taps
+             * @param interp Interpolation method, `Allpass` falls back to `Lagrange` as it needs state
+             */
+            void fetch_taps(const num* samps_backwards, num* out, size_t count, DelayInterpolation interp) const;
+
+            /** @brief Reads a block from the delay line at a fixed delay.
+             *
+             * Reads as if it was called before `write_block()` for the same `n` samples,
+             * so `out[i]` is the sample `samps_backwards` samples before the `i`th sample of the next block.
+             * This means `samps_backwards` must be at least `n` (plus the interpolation's margin) for every sample to already be in the buffer,
+             * which is what allows feedback loops to be processed a block at a time.
+             *
+             * @param out Array of `n` outputs
+             * @param n Number of samples
+             * @param samps_backwards Delay, in samples
+             * @param interp Interpolation method, `Allpass` falls back to `Lagrange` as it needs state
+             */
+            void read_block(num* out, size_t n, num samps_backwards, DelayInterpolation interp) const;
+
+            /** @brief Sets the sample rate, clamped to the reserved capacity.
+             */
             void set_sample_rate(num sr);
 
+            /** @brief Sets the maximum delay time, clamped to the reserved capacity.
+             *
+             * @param new_max_time Maximum delay time, in seconds
+             */
             void set_max_time(num new_max_time);
 
+            /** @brief Fills the delay line with silence.
+             */
+            void clear();
+
+            /** @brief Maximum delay time at the current sample rate, in seconds.
+             */
             [[nodiscard]] num get_max_time() const;
 
+            /** @brief Maximum delay at the current sample rate, in samples.
+             */
             [[nodiscard]] unsigned long get_max_samples() const;
 
+            /** @brief Number of samples the buffer can hold, always a power of two.
+             */
+            [[nodiscard]] unsigned long get_capacity() const {
+                return buffer.size();
+            }
+
         private:
-            void resize_buffer();
+            // samples either side of the read position needed by the widest interpolator
+            static constexpr unsigned long interp_margin = 3;
 
             num sample_rate = 0;
             num max_time = 0;
-            unsigned long idx = 0;
+            unsigned long write_idx = 0;
+            unsigned long mask = 0;
             std::vector<num> buffer;
     };
-}
\ No newline at end of file
+}
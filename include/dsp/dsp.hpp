@@ -3,6 +3,7 @@
 # pragma once
 
 #include <complex>
+#include <cstddef>
 
 namespace modal::dsp {
     /** @brief Floating point type used in DSP calculations
@@ -22,6 +23,12 @@ namespace modal::dsp {
     constexpr num operator ""_nm(const long double d) {
         return static_cast<num>(d);
     }
+
+    /** @brief Largest number of samples processed in one go by block-based DSP methods
+     *
+     * Callers with longer buffers should split them into sub-blocks of at most this size.
+     */
+    constexpr size_t block_size = 32;
 }
 
 namespace modal::dsp::nums {
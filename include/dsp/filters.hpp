@@ -4,6 +4,7 @@
 
 #include <array>
 #include <cmath>
+#include <cstddef>
 #include <dsp/dsp.hpp>
 
 namespace modal::dsp::filters {
@@ -47,6 +48,14 @@ namespace modal::dsp::filters {
             b0 = _b0; b1 = _b1; b2 = _b2;
         }
 
+        /** @brief Coefficients divided through by a0
+         *
+         * @return `{b0, b1, b2, a1, a2}`, as used in `tick()`
+         */
+        [[nodiscard]] std::array<modal::dsp::num, 5> normalised_coeffs() const {
+            return {b0 / a0, b1 / a0, b2 / a0, a1 / a0, a2 / a0};
+        }
+
         /** @brief Sets the internal sample rate of the filter.
          *
          * Behaves as described in [the DSP coding standards](docs/DSP Coding Standards.md)
@@ -117,4 +126,30 @@ namespace modal::dsp::filters {
         modal::dsp::num sample_rate = 48000;
         modal::dsp::num x[2] = {0, 0}, y[2] = {0, 0};
     };
+    /** @brief Fourth order Butterworth low-pass, as two biquads, for decimating an oversampled signal.
+     *
+     * Is a [DSP class](docs/DSP Coding Standards.md).
+     * Run at the oversampled rate, it cuts off just below the Nyquist frequency of the rate the signal is decimated to,
+     * so that keeping every `factor`th sample folds little back into the audible band.
+     * Its coefficients depend only on the oversampling factor, so it has no sample rate.
+     */
+    struct DecimationFilter {
+        /** @brief Processes a single audio sample, at the oversampled rate.
+         *
+         * Behaves as described in [the DSP coding standards](docs/DSP Coding Standards.md)
+         */
+        modal::dsp::num tick(modal::dsp::num in);
+
+        /** @brief Sets how many times the input is oversampled, which clears the filter.
+         *
+         * @param factor Ratio of the input's sample rate to the output's, at least 1
+         */
+        void set_factor(size_t factor);
+
+     private:
+        // per section: {b0, b1, b2, a1, a2}, normalised by a0
+        std::array<std::array<modal::dsp::num, 5>, 2> coeffs {};
+        // per section, transposed direct form 2
+        std::array<std::array<modal::dsp::num, 2>, 2> state {};
+    };
 }
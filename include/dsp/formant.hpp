@@ -4,6 +4,7 @@
 
 #include <dsp/dsp.hpp>
 #include <dsp/filters.hpp>
+#include <dsp/simd.hpp>
 
 namespace modal::dsp::physical {
     /** @brief Architecture of the filters used in phsycial::FormantFilter
@@ -20,6 +21,9 @@ namespace modal::dsp::physical {
      * Uses [formant frequencies as described by Kevin Russel](https://home.cc.umanitoba.ca/~krussll/phonetics/acoustic/formants.html)
      */
     class FormantFilter {
+        // parallel filters, with coefficients mirrored from `filters` and linear gains
+        // first, as it's all that the parallel architecture touches per sample
+        simd::BiquadBank bank;
         FormantArch arch;
         std::array<modal::dsp::filters::RBJbiquad, 4> filters;
         std::array<modal::dsp::num, 4> Fcs {0, 0, 0, 0};
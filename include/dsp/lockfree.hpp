@@ -0,0 +1,126 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace modal::dsp {
+    /** @brief Wait-free snapshot of a value, published by one thread and read by another.
+     *
+     * Keeps three copies of the value. The writer fills its back copy and swaps it with the middle one by atomic
+     * pointer exchange, flagging it as fresh. The reader swaps a fresh middle copy with its front one.
+     * Neither side waits or allocates, and the reader always sees a complete snapshot, so it's safe for
+     * handing settings edited on the message thread to the audio thread.
+     *
+     * @tparam T Trivially copyable type of the value
+     */
+    template <typename T>
+    class TripleBuffer {
+        static_assert(std::is_trivially_copyable_v<T>);
+
+     public:
+        /** @brief Constructor.
+         *
+         * @param initial Value seen by the reader until the first `publish()`
+         */
+        explicit TripleBuffer(const T& initial = {}) {
+            for (auto& s : slots) {
+                s.value = initial;
+            }
+        }
+
+        TripleBuffer(const TripleBuffer&) = delete;
+        TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+        /** @brief Publishes a new value. Only call from the writing thread.
+         */
+        void publish(const T& value) {
+            back->value = value;
+            const auto old = middle.exchange(reinterpret_cast<uintptr_t>(back) | fresh, std::memory_order_acq_rel);
+            back = reinterpret_cast<Slot*>(old & ~fresh);
+        }
+
+        /** @brief Latest published value. Only call from the reading thread.
+         *
+         * The reference is valid until the next call.
+         */
+        const T& acquire() {
+            if (middle.load(std::memory_order_relaxed) & fresh) {
+                const auto old = middle.exchange(reinterpret_cast<uintptr_t>(front), std::memory_order_acq_rel);
+                front = reinterpret_cast<Slot*>(old & ~fresh);
+            }
+            return front->value;
+        }
+
+     private:
+        // each copy on its own cache line, so the writer filling one doesn't slow down the reader
+        struct alignas(64) Slot {
+            T value;
+        };
+        // slots are aligned, so the bottom bit of the middle pointer is free to flag it
+        static constexpr uintptr_t fresh = 1;
+
+        std::array<Slot, 3> slots;
+        Slot* back = &slots[0];
+        std::atomic<uintptr_t> middle {reinterpret_cast<uintptr_t>(&slots[1])};
+        Slot* front = &slots[2];
+    };
+
+    /** @brief Wait-free single-producer single-consumer queue of fixed capacity.
+     *
+     * One thread pushes and another pops, neither waits or allocates.
+     * When the queue is full, new values are dropped rather than overwriting ones the reader hasn't seen,
+     * so the writer never touches a slot the reader may be copying.
+     *
+     * @tparam T Trivially copyable type of the values
+     * @tparam capacity Number of slots, a power of two
+     */
+    template <typename T, size_t capacity>
+    class SpscRing {
+        static_assert(std::is_trivially_copyable_v<T>);
+        static_assert(capacity > 0 && (capacity & (capacity - 1)) == 0, "capacity must be a power of two");
+
+     public:
+        SpscRing() = default;
+        SpscRing(const SpscRing&) = delete;
+        SpscRing& operator=(const SpscRing&) = delete;
+
+        /** @brief Queues a value. Only call from the writing thread.
+         *
+         * @return `false` if the queue was full and the value was dropped
+         */
+        bool push(const T& value) {
+            const auto w = write.load(std::memory_order_relaxed);
+            if (w - read.load(std::memory_order_acquire) == capacity) {
+                return false;
+            }
+            items[w & (capacity - 1)] = value;
+            write.store(w + 1, std::memory_order_release);
+            return true;
+        }
+
+        /** @brief Takes the oldest queued value. Only call from the reading thread.
+         *
+         * @return `false` if the queue was empty, leaving `out` unchanged
+         */
+        bool pop(T& out) {
+            const auto r = read.load(std::memory_order_relaxed);
+            if (r == write.load(std::memory_order_acquire)) {
+                return false;
+            }
+            out = items[r & (capacity - 1)];
+            read.store(r + 1, std::memory_order_release);
+            return true;
+        }
+
+     private:
+        std::array<T, capacity> items {};
+        // indices only ever increase, and wrap around the slots, on their own cache lines so they don't contend
+        alignas(64) std::atomic<size_t> write {0};
+        alignas(64) std::atomic<size_t> read {0};
+    };
+}
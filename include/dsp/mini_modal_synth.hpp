@@ -2,14 +2,18 @@
 
 #pragma once
 
+#include <algorithm>
 #include <array>
+#include <limits>
+#include <optional>
 
 #include <dsp/dsp.hpp>
 #include "resonator.hpp"
 #include <dsp/mod.hpp>
-#include <randutils.hpp>
+#include <dsp/bonus.hpp>
 #include <dsp/osc.hpp>
 #include <dsp/delay.hpp>
+#include <dsp/perf.hpp>
 
 namespace modal::dsp::synth {
     /// @brief Kinds of exciter for the modal synth
@@ -32,52 +36,137 @@ namespace modal::dsp::synth {
         Foldback = 2
     };
 
-    /// @private
-    struct FoldbackSettings {
-        MiniModalFoldbackKind mode = MiniModalFoldbackKind::NyquistStop;
+    /// @brief Routing of the output back into the exciter for the modal synth
+    enum class MiniModalFeedbackRouting {
+        /// Fed back after a single sample, so the voice has to be processed a sample at a time
+        Immediate = 0,
+        /// Fed back through a delay line of at least `dsp::block_size` samples, so the voice can be processed a block at a time
+        Delayed = 1
+    };
+
+    /** @brief Parameters of the mini modal synth's spectrum, shared by all of a processor's voices.
+     *
+     * Holds everything `MiniModalSynth::update_mode_coefficients()` reads apart from the note being played,
+     * so that the voices only keep the state they touch per sample.
+     * Setters return if the voices' coefficients need to be updated.
+     */
+    struct MiniModalPatch {
+        /// Number of modes to synthesise, clamped to each voice's `maxModes`
+        size_t modes = std::numeric_limits<size_t>::max();
+        /// Linear inharmonicity factor
+        modal::dsp::num inharmonicity = 0;
+        /// Exponential inharmonicity factor
+        modal::dsp::num exponent = 0;
+        /// Rate or pitch of exciter, as a divisor of the note frequency
+        modal::dsp::num exciter_rate = 20;
+        /// Decay time, in seconds
+        modal::dsp::num decay = 1;
+        /// Exponential falloff of increasing modes
+        modal::dsp::num falloff = 1;
+        /// Gain of the even modes
+        modal::dsp::num even_gain = 1;
+        /// Foldback mode for the spectrum
+        MiniModalFoldbackKind foldback = MiniModalFoldbackKind::NyquistStop;
+        /// Point to mirror the spectrum around with `MiniModalFoldbackKind::Foldback`, in Hz
         modal::dsp::num foldback_point = 1600;
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wfloat-equal"
+        /** @brief Sets coefficients related to the spectrum of modes.
+         *
+         * @param num_modes Number of modes to synthesise
+         * @param inharm Linear inharmonicity factor, usually between -0.06 and 2
+         * @param expo Exponential inharmonicity factor, usually between 0.1 and 10
+         * @param e_rate Rate or pitch of exciter, in Hz
+         * @param dcy Decay time, in seconds
+         * @param flof Exponential falloff of increasing modes, usually between 0 and 3
+         * @param eg Gain of the even modes
+         * @return If coefficients need to be updated
+         */
+        bool set_params(size_t num_modes, modal::dsp::num inharm, modal::dsp::num expo, modal::dsp::num e_rate, modal::dsp::num dcy, modal::dsp::num flof, modal::dsp::num eg) {
+            bool changed = false;
+            if (num_modes != modes || inharm != inharmonicity
+                || expo != exponent || e_rate != exciter_rate
+                || dcy != decay || flof != falloff || eg != even_gain) {
+                changed = true;
+            }
+            modes = num_modes;
+            inharmonicity = inharm;
+            exponent = expo;
+            exciter_rate = e_rate;
+            decay = dcy;
+            falloff = flof;
+            even_gain = eg;
+            return changed;
+        }
+
+        /** @brief Set foldback mode.
+         *
+         * @param mode `MiniModalFoldbackKind`, foldback mode for the spectrum
+         * @param point Point to mirror the spectrum when set to `Foldback`, in Hz
+         * @return If coefficients need to be updated
+         */
+        bool set_foldback_settings(const MiniModalFoldbackKind mode, const modal::dsp::num point) {
+            const bool changed = foldback != mode || foldback_point != point;
+            foldback = mode;
+            foldback_point = point;
+            return changed;
+        }
+#pragma GCC diagnostic pop
     };
 
     /**
      * @brief Modal synthesiser
      *
      * This is the implementation of the main synthesiser in the plugin.
-     * Has a set of `physical::filters::PhasorResonator` modes, `osc::Phasor` exciters,
+     * Has a `physical::filters::PhasorResonatorBank` of modes, `osc::Phasor` exciters,
      * an `mod::AHREnv` envelope, and a `physical::FormantFilter` filter.
      *
-     * Some member functions require the mode coefficients to be updated after they are called.
+     * The spectrum's parameters live in a `MiniModalPatch` shared between voices, see `set_patch()`.
+     * Some member functions, and changes to the patch, require the mode coefficients to be updated after.
      * This is an expensive operation, so these functions do not update the coefficients themselves,
      * and require the caller to update the coefficients using `update_mode_coefficients()` after.
      * This is noted in the documentation of those functions.
      *
+     * Members are laid out so that everything touched per sample is contiguous,
+     * with the rarely used parameters before and after it.
+     *
      * Is an [instrument class](docs/DSP Coding Standards.md).
      * @tparam maxModes Maximum number of modes to synthesise
      */
     template<size_t maxModes>
     class MiniModalSynth {
-        std::array<physical::filters::PhasorResonator, maxModes> modes;
-        size_t currentModes = maxModes;
-        modal::dsp::num inharmonicity = 0;
-        modal::dsp::num exponent = 0;
-        modal::dsp::num freq = 0;
-        modal::dsp::num velocity = 1;
-        modal::dsp::num decay = 1;
-        modal::dsp::num falloff = 1;
-        modal::dsp::num even_gain = 1;
+        inline static const MiniModalPatch default_patch {};
 
+        // per-mode parameters, then the per-sample arrays
+        physical::filters::PhasorResonatorBank<maxModes> modes;
+
+        // per-sample state
+        size_t currentModes = maxModes;
+        modal::dsp::num gain = 1;
         MiniModalExiterKind exciter = MiniModalExiterKind::Noise;
-        modal::dsp::num exciter_rate = 20;
+        modal::dsp::bonus::FastRng noise;
         modal::dsp::osc::Phasor osc_exciter {48000};
-        FoldbackSettings foldback;
-
+        modal::dsp::mod::AHREnv env;
         modal::dsp::num feedback_reg = 0;
         modal::dsp::num feedback_amount = 0;
         modal::dsp::num feedback_intensity = 0;
+        // 1 / fast_tanh(feedback_intensity), normalises the saturator to unity gain at full scale
+        modal::dsp::num feedback_norm = 0;
+        MiniModalFeedbackRouting feedback_routing = MiniModalFeedbackRouting::Immediate;
+        size_t feedback_delay = block_size;
+        // sample rate of 1, so that times are in samples
+        modal::dsp::delay_line feedback_line {1, static_cast<modal::dsp::num>(max_feedback_delay)};
 
-        modal::dsp::mod::AHREnv env;
-        randutils::default_rng noise;
+        // only touched when notes start or parameters change
+        const MiniModalPatch* patch = &default_patch;
+        modal::dsp::num freq = 0;
+        modal::dsp::num velocity = 1;
 
      public:
+        /// Longest delay for `MiniModalFeedbackRouting::Delayed`, in samples
+        static constexpr size_t max_feedback_delay = 4 * block_size;
+
         /** @brief Note on.
          *
          * Behaves as described in [the DSP coding standards](docs/DSP Coding Standards.md).
@@ -90,6 +179,7 @@ namespace modal::dsp::synth {
         void on(modal::dsp::num key_freq, modal::dsp::num vel) {
             freq = key_freq;
             velocity = vel;
+            gain = vel * vel;
             update_mode_coefficients();
             switch (exciter) {
                 case MiniModalExiterKind::Impulse:
@@ -141,24 +231,85 @@ namespace modal::dsp::synth {
 
             to_mode *= env.tick();
 
-            const auto fb_sat = std::tanh(fb_out * feedback_intensity) / std::tanh(feedback_intensity);
-
-            to_mode += fb_sat * feedback_amount;
+            to_mode += saturate_feedback(fb_out);
 
-            modal::dsp::num modes_out = 0;
-            for (size_t i = 0; i < currentModes; i++) {
-                modes_out += modes[i].tick(to_mode);
-            }
+            modal::dsp::num modes_out = modes.tick(to_mode, currentModes);
 
             modal::dsp::num out = modes_out;
 
-            out *= (velocity * velocity);
+            out *= gain;
 
             feedback_reg = out;
 
             return out;
         }
 
+        /** @brief Synthesises a block of audio, adding it to `out`.
+         *
+         * With `MiniModalFeedbackRouting::Delayed` the whole block goes through the block kernels,
+         * otherwise this is equivalent to calling `tick()` for each sample.
+         * @param out Array of `n` samples to add the output to
+         * @param n Number of samples, at most `dsp::block_size`
+         * @param perf Monitor to time the exciter, modes and output stages with, or `nullptr`
+         */
+        void render(modal::dsp::num* out, size_t n, perf::Monitor* perf = nullptr) {
+            if (feedback_routing == MiniModalFeedbackRouting::Immediate) {
+                const perf::ScopedStage timer {perf, perf::Stage::Modes};
+                for (size_t i = 0; i < n; i++) {
+                    out[i] += tick();
+                }
+                return;
+            }
+
+            std::array<modal::dsp::num, block_size> to_mode;
+            std::array<modal::dsp::num, block_size> voice_out;
+
+            std::optional<perf::ScopedStage> timer;
+            timer.emplace(perf, perf::Stage::Exciter);
+            // the feedback delay is at least a block long, so the whole block of feedback is already in the delay line
+            feedback_line.read_block(to_mode.data(), n, static_cast<modal::dsp::num>(feedback_delay), DelayInterpolation::Linear);
+            for (size_t i = 0; i < n; i++) {
+                to_mode[i] = saturate_feedback(to_mode[i]);
+            }
+
+            std::array<modal::dsp::num, block_size> envelope;
+            env.process_block(envelope.data(), n);
+
+            for (size_t i = 0; i < n; i++) {
+                osc_exciter.tick();
+                modal::dsp::num exc = 0;
+                switch (exciter) {
+                    case MiniModalExiterKind::Noise:
+                        exc = noise.uniform(-0.05_nm, 0.05_nm);
+                        break;
+                    case MiniModalExiterKind::Impulses:
+                        exc = osc::impulse_train(osc_exciter) * 0.6_nm;
+                        break;
+                    case MiniModalExiterKind::Impulse:
+                        break;
+                }
+                to_mode[i] += exc * envelope[i];
+            }
+
+            timer.emplace(perf, perf::Stage::Modes);
+            modes.process_block(to_mode.data(), voice_out.data(), n, currentModes);
+
+            timer.emplace(perf, perf::Stage::Output);
+            for (size_t i = 0; i < n; i++) {
+                voice_out[i] *= gain;
+                out[i] += voice_out[i];
+            }
+
+            feedback_line.write_block(voice_out.data(), n);
+            feedback_reg = voice_out[n - 1];
+        }
+
+        /** @brief Number of modes synthesised.
+         */
+        [[nodiscard]] size_t num_modes() const {
+            return currentModes;
+        }
+
         /** @brief Sets the exciter.
          *
          * @param new_exciter New exciter type
@@ -170,40 +321,39 @@ namespace modal::dsp::synth {
             exciter = new_exciter;
         }
 
-#pragma clang diagnostic push
-#pragma clang diagnostic ignored "-Wfloat-equal"
-        /** @brief Sets coefficients related to the spectrum of modes.
+        /** @brief Sets the patch the voice takes its spectrum from.
          *
+         * The patch must outlive the voice, and is shared with every other voice playing it.
          * Requires updating coefficients.
-         * @param num_modes Number of modes to synthesise (must be equal or less than `NumModes`)
-         * @param inharm Linear inharmonicity factor, usually between -0.06 and 2
-         * @param expo Exponential inharmonicity factor, usually between 0.1 and 10
-         * @param e_rate Rate or pitch of exciter, in Hz
-         * @param dcy Decay time, in seconds
-         * @param flof Exponential falloff of increasing modes, usually between 0 and 3
-         * @return If coefficients need to be updated
          */
-        bool set_params(size_t num_modes, modal::dsp::num inharm, modal::dsp::num expo, modal::dsp::num e_rate, modal::dsp::num dcy, modal::dsp::num flof, modal::dsp::num eg) {
-            bool changed = false;
-            if (num_modes != currentModes || inharm != inharmonicity
-                || expo != exponent || e_rate != exciter_rate
-                || dcy != decay || flof != falloff || eg != even_gain) {
-                changed = true;
-            }
-            currentModes = num_modes;
-            inharmonicity = inharm;
-            exponent = expo;
-            exciter_rate = e_rate;
-            decay = dcy;
-            falloff = flof;
-            even_gain = eg;
-            return changed;
+        void set_patch(const MiniModalPatch& new_patch) {
+            patch = &new_patch;
         }
-#pragma clang diagnostic pop
 
+        /** @brief Sets the amount and saturation of the output fed back into the exciter.
+         *
+         * @param amt Amount of output fed back
+         * @param time Intensity of the saturation of the feedback, must be above 0
+         */
         void set_feedback_settings(const modal::dsp::num amt, const modal::dsp::num time) {
             feedback_amount = amt;
             feedback_intensity = time;
+            feedback_norm = 1 / bonus::fast_tanh(feedback_intensity);
+        }
+
+        /** @brief Sets how the output is fed back into the exciter.
+         *
+         * @param routing `MiniModalFeedbackRouting`, immediate or delayed
+         * @param delay Feedback delay for `MiniModalFeedbackRouting::Delayed`, in samples,
+         * clamped to between `dsp::block_size` and `max_feedback_delay`
+         */
+        void set_feedback_routing(const MiniModalFeedbackRouting routing, const size_t delay = block_size) {
+            if (routing != feedback_routing) {
+                feedback_line.clear();
+                feedback_reg = 0;
+            }
+            feedback_routing = routing;
+            feedback_delay = std::clamp(delay, block_size, max_feedback_delay);
         }
 
         /** @brief Sets the timings for the envelope of the exciter.
@@ -214,51 +364,53 @@ namespace modal::dsp::synth {
             env.set_params(attack, release);
         }
 
-#pragma clang diagnostic push
-#pragma clang diagnostic ignored "-Wfloat-equal"
-        /** @brief Set foldback mode.
-         *
-         * Requires updating coefficients.
-         * @param mode `ModalFoldbackKind`, foldback mode for the spectrum
-         * @param foldback_point Point to mirror the spectrum when set to `Foldback`, in Hz
-         * @return If coefficients need to be updated
+        /** @brief Sets the shapes of the envelope of the exciter.
+         * @param attack Shape of the attack
+         * @param release Shape of the release
          */
-        bool set_foldback_settings(const MiniModalFoldbackKind mode, modal::dsp::num foldback_point) {
-            const bool changed = foldback.mode != mode || foldback.foldback_point != foldback_point;
-            foldback.mode = mode;
-            foldback.foldback_point = foldback_point;
-            return changed;
+        void set_env_curves(const modal::dsp::mod::EnvCurve attack, const modal::dsp::mod::EnvCurve release) {
+            env.set_curves(attack, release);
         }
-#pragma clang diagnostic pop
 
         /** @brief Sets the internal sample rate of the synthesiser.
          *
          * Behaves as described in [the DSP coding standards](docs/DSP Coding Standards.md)
          */
         void set_sample_rate(modal::dsp::num sr) {
-            for (auto& m : modes) {
-                m.set_sample_rate(sr);
-            }
+            modes.set_sample_rate(sr);
             env.set_sample_rate(sr);
             osc_exciter.set_sample_rate(sr);
         }
 
+        /** @brief Sets how long coefficient updates with `glide` take to glide in with `MiniModalFeedbackRouting::Immediate`.
+         *
+         * Usually the control period, `dsp::block_size` unless set. Block rendering glides over the next block.
+         * @param samples Glide time, in samples
+         */
+        void set_glide_time(const size_t samples) {
+            modes.set_glide_length(samples);
+        }
+
         /** @brief Update the internal coefficients of the modal filters
          * to use the updated parameters.
          *
          * Can be expensive, so don't call unnecessarily.
+         * @param glide Glide the coefficients to their new values over the next rendered block, or the glide time
+         * when ticked, rather than jumping, for parameters changed at control rate
          */
-        void update_mode_coefficients() {
-            switch (foldback.mode) {
+        void update_mode_coefficients(const bool glide = false) {
+            const auto& p = *patch;
+            currentModes = std::min(p.modes, maxModes);
+            switch (p.foldback) {
                 case MiniModalFoldbackKind::NyquistStop: {
                     for (size_t i = 0; i < currentModes; i++) {
                         num mode_idx = static_cast<num>(i); // i
                         num mode_idx_p1 = mode_idx + 1; // k
-                        num mode_gain = i % 2 == 1 ? even_gain : 1_nm;
-                        modal::dsp::num overtone = mode_idx_p1 * (1 + mode_idx * (inharmonicity));
-                        modal::dsp::num mode_freq = freq * std::pow(overtone, exponent);
-                        modal::dsp::num distance = (2.0_nm / std::pow((mode_idx + 1.0_nm), falloff)) * mode_gain;
-                        modes[i].set_params(mode_freq, distance, distance * decay);
+                        num mode_gain = i % 2 == 1 ? p.even_gain : 1_nm;
+                        modal::dsp::num overtone = mode_idx_p1 * (1 + mode_idx * (p.inharmonicity));
+                        modal::dsp::num mode_freq = freq * std::pow(overtone, p.exponent);
+                        modal::dsp::num distance = (2.0_nm / std::pow((mode_idx + 1.0_nm), p.falloff)) * mode_gain;
+                        set_mode(i, mode_freq, distance, distance * p.decay, glide);
                     }
                     break;
                 }
@@ -266,11 +418,11 @@ namespace modal::dsp::synth {
                     for (size_t i = 0; i < currentModes; i++) {
                         num mode_idx = static_cast<num>(i); // i
                         num mode_idx_p1 = mode_idx + 1; // k
-                        num mode_gain = i % 2 == 1 ? even_gain : 1_nm;
-                        modal::dsp::num overtone = mode_idx_p1 * (1 + mode_idx * (inharmonicity));
-                        modal::dsp::num mode_freq = freq / std::pow(overtone, exponent);
-                        modal::dsp::num distance = (2.0_nm / std::pow((mode_idx + 1.0_nm), falloff)) * mode_gain;
-                        modes[i].set_params(mode_freq, distance, distance * decay);
+                        num mode_gain = i % 2 == 1 ? p.even_gain : 1_nm;
+                        modal::dsp::num overtone = mode_idx_p1 * (1 + mode_idx * (p.inharmonicity));
+                        modal::dsp::num mode_freq = freq / std::pow(overtone, p.exponent);
+                        modal::dsp::num distance = (2.0_nm / std::pow((mode_idx + 1.0_nm), p.falloff)) * mode_gain;
+                        set_mode(i, mode_freq, distance, distance * p.decay, glide);
                     }
                     break;
                 }
@@ -278,26 +430,36 @@ namespace modal::dsp::synth {
                     for (size_t i = 0; i < currentModes; i++) {
                         num mode_idx = static_cast<num>(i); // i
                         num mode_idx_p1 = mode_idx + 1; // k
-                        num mode_gain = i % 2 == 1 ? even_gain : 1_nm;
-                        modal::dsp::num overtone = mode_idx_p1 * (1 + mode_idx * (inharmonicity));
-                        modal::dsp::num mode_freq = freq * std::pow(overtone, exponent);
+                        num mode_gain = i % 2 == 1 ? p.even_gain : 1_nm;
+                        modal::dsp::num overtone = mode_idx_p1 * (1 + mode_idx * (p.inharmonicity));
+                        modal::dsp::num mode_freq = freq * std::pow(overtone, p.exponent);
                         // see https://www.desmos.com/calculator/2kbqwfyvjn
-                        if (mode_freq > foldback.foldback_point) {
-                            mode_freq = (2 * foldback.foldback_point) - mode_freq;
+                        if (mode_freq > p.foldback_point) {
+                            mode_freq = (2 * p.foldback_point) - mode_freq;
                         }
-                        modal::dsp::num distance = (2.0_nm / std::pow((mode_idx + 1.0_nm), falloff)) * mode_gain;
-                        modes[i].set_params(mode_freq, distance, distance * decay);
+                        modal::dsp::num distance = (2.0_nm / std::pow((mode_idx + 1.0_nm), p.falloff)) * mode_gain;
+                        set_mode(i, mode_freq, distance, distance * p.decay, glide);
                     }
                     break;
                 }
             }
-            osc_exciter.set_freq(freq / exciter_rate);
+            osc_exciter.set_freq(freq / p.exciter_rate);
         }
 
      private:
+        [[nodiscard]] modal::dsp::num saturate_feedback(const modal::dsp::num fb) const {
+            return bonus::fast_tanh(fb * feedback_intensity) * feedback_norm * feedback_amount;
+        }
+
         void ping() {
-            for (size_t i = 0; i < currentModes; i++) {
-                modes[i].ping();
+            modes.ping(currentModes);
+        }
+
+        void set_mode(const size_t i, const modal::dsp::num f, const modal::dsp::num a, const modal::dsp::num t, const bool glide) {
+            if (glide) {
+                modes.glide_params(i, f, a, t);
+            } else {
+                modes.set_params(i, f, a, t);
             }
         }
     };
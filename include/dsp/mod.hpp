@@ -2,6 +2,11 @@
 
 #pragma once
 
+#include <array>
+#include <cstdint>
+#include <span>
+
+#include <dsp/bonus.hpp>
 #include <dsp/dsp.hpp>
 
 namespace modal::dsp::mod {
@@ -43,7 +48,20 @@ namespace modal::dsp::mod {
         modal::dsp::num sample_rate;
     };
 
+    /// @brief Shape of a segment of an `AHREnv`
+    enum class EnvCurve : uint8_t {
+        /// Constant rate
+        Linear = 0,
+        /// Exponential approach to a target past the end of the segment, like an analog envelope's RC charge.
+        /// Fast to start for attacks, and fast to start with a long tail for releases
+        Exponential = 1
+    };
+
     /** @brief Attack-hold-release envelope.
+     *
+     * Every segment is an affine recurrence, so its values over a block are an arithmetic (linear segments)
+     * or geometric (exponential segments) sequence, and the sample it ends on can be solved for.
+     * `process_block()` uses this to render whole blocks without a branch per sample.
      *
      * Is a [DSP class](docs/DSP Coding Standards.md).
      */
@@ -55,6 +73,13 @@ namespace modal::dsp::mod {
          * @return The value of the envelope, between 0-1
          */
         modal::dsp::num tick();
+        /** @brief Advances the envelope by a block of samples.
+         *
+         * Equivalent to calling `tick()` `n` times, up to rounding.
+         * @param out Array of `n` samples to write the envelope's values to
+         * @param n Number of samples
+         */
+        void process_block(modal::dsp::num* out, size_t n);
         /** @brief Begins the envelope's attack state
          */
         void on();
@@ -64,17 +89,34 @@ namespace modal::dsp::mod {
         /** @brief Sets the envelope value to 0 and sets it to off.
          */
         void reset();
+        /** @brief Whether the envelope is at rest, finished its release or never started.
+         */
+        [[nodiscard]] bool resting() const {
+            return state == AHRState::Rest;
+        }
         /** @brief Sets the envelope attack and release times.
          *
          * @param atk Attack time, in seconds
          * @param rel Release time, in seconds
          */
         void set_params(modal::dsp::num atk, modal::dsp::num rel);
+        /** @brief Sets the shapes of the attack and release.
+         *
+         * The segments take the same time with either shape.
+         * @param attack Shape of the attack
+         * @param release Shape of the release
+         */
+        void set_curves(EnvCurve attack, EnvCurve release);
         /** @brief Sets the internal sample rate of the envelope.
          *
          * Behaves as described in [the DSP coding standards](docs/DSP Coding Standards.md)
          */
         void set_sample_rate(modal::dsp::num sr);
+
+        /// Distance past 1 of the target of an exponential attack, smaller is more curved
+        static constexpr modal::dsp::num attack_overshoot = 0.3_nm;
+        /// Distance below 0 of the target of an exponential release, smaller is more curved
+        static constexpr modal::dsp::num release_overshoot = 0.001_nm;
      private:
         enum class AHRState {
             Rest,
@@ -85,6 +127,211 @@ namespace modal::dsp::mod {
         modal::dsp::num val = 0;
         modal::dsp::num attack_time = 0, release_time = 0;
         modal::dsp::num attack_inc = 0, release_inc = 0;
+        // per-sample factor of the distance to the target, for exponential segments
+        modal::dsp::num attack_coeff = 0, release_coeff = 0;
         modal::dsp::num sample_rate = 0;
+        EnvCurve attack_curve = EnvCurve::Linear, release_curve = EnvCurve::Linear;
+    };
+
+    /** @brief Value that ramps linearly to each new target over a fixed time, for smoothing parameter changes.
+     *
+     * Each new target restarts the ramp from the current value, so a stream of changes,
+     * such as a dragged slider, is followed smoothly rather than stepped through.
+     *
+     * Is a [DSP class](docs/DSP Coding Standards.md), apart from advancing by a control period at a time.
+     */
+    class SmoothedValue {
+     public:
+        /** @brief Advances the ramp by a number of samples.
+         *
+         * @param samples Number of samples to advance by, usually a control period
+         * @return The value after advancing
+         */
+        modal::dsp::num advance(size_t samples);
+        /** @brief Sets the value to ramp to.
+         *
+         * Restarts the ramp, unless the target is unchanged. Jumps straight to it if the ramp time is 0.
+         */
+        void set_target(modal::dsp::num value);
+        /** @brief Jumps to the target, ending the ramp.
+         */
+        void skip();
+        /** @brief Sets the ramp time.
+         *
+         * @param seconds Ramp time, in seconds, 0 for no smoothing
+         */
+        void set_time(modal::dsp::num seconds);
+        /** @brief Sets the internal sample rate used to work out the ramp length.
+         *
+         * Behaves as described in [the DSP coding standards](docs/DSP Coding Standards.md)
+         */
+        void set_sample_rate(modal::dsp::num sr);
+        /** @brief Current value.
+         */
+        [[nodiscard]] modal::dsp::num value() const {
+            return current;
+        }
+        /** @brief Whether the value is still ramping to its target.
+         */
+        [[nodiscard]] bool smoothing() const {
+            return remaining > 0;
+        }
+     private:
+        modal::dsp::num current = 0, target = 0, step = 0;
+        size_t remaining = 0, length = 0;
+        modal::dsp::num time = 0;
+        modal::dsp::num sample_rate = 48000;
+    };
+
+    /// @brief Waveforms of an `Lfo`
+    enum class LfoShape {
+        /// Raised cosine, starting at 0
+        Sine = 0,
+        /// Rises for the first half of the cycle, falls for the second
+        Triangle = 1,
+        /// Rises over the whole cycle, then drops
+        Saw = 2,
+        /// 1 for the first half of the cycle, 0 for the second
+        Square = 3
+    };
+
+    /** @brief Low frequency oscillator, run at control rate.
+     *
+     * Output is unipolar, between 0-1, to match `ModMatrix` sources.
+     *
+     * Is a [DSP class](docs/DSP Coding Standards.md), apart from advancing by a control period at a time.
+     */
+    class Lfo {
+     public:
+        /** @brief Advances the LFO by a number of samples.
+         *
+         * @param samples Number of samples to advance by, usually a control period
+         * @return The value of the LFO at the new phase, between 0-1
+         */
+        modal::dsp::num advance(size_t samples);
+        /** @brief Sets the rate and waveform.
+         *
+         * @param rate Rate, in Hz
+         * @param s Waveform
+         */
+        void set_params(modal::dsp::num rate, LfoShape s);
+        /** @brief Restarts the cycle.
+         */
+        void reset();
+        /** @brief Sets the internal sample rate of the LFO.
+         *
+         * Behaves as described in [the DSP coding standards](docs/DSP Coding Standards.md)
+         */
+        void set_sample_rate(modal::dsp::num sr);
+     private:
+        modal::dsp::num phase = 0;
+        modal::dsp::num frequency = 1;
+        modal::dsp::num inc = 0;
+        LfoShape shape = LfoShape::Sine;
+        modal::dsp::num sample_rate = 48000;
+    };
+
+    /** @brief Multi-segment envelope, run at control rate.
+     *
+     * Each segment moves linearly from the current value to its level over its time.
+     * While a note is held the envelope stops at the end of the sustain segment,
+     * and on release skips straight to the segment after it.
+     *
+     * Is a [DSP class](docs/DSP Coding Standards.md), apart from advancing by a control period at a time.
+     */
+    class SegmentEnv {
+     public:
+        /// Largest number of segments
+        static constexpr size_t max_segments = 8;
+        /// Sustain segment index for an envelope that never holds
+        static constexpr size_t no_sustain = max_segments;
+
+        /// @brief A segment of a `SegmentEnv`
+        struct Segment {
+            /// Level at the end of the segment
+            modal::dsp::num level;
+            /// Length of the segment, in seconds
+            modal::dsp::num time;
+        };
+
+        /** @brief Advances the envelope by a number of samples.
+         *
+         * @param samples Number of samples to advance by, usually a control period
+         * @return The value of the envelope
+         */
+        modal::dsp::num advance(size_t samples);
+        /** @brief Begins the first segment, from the current value.
+         */
+        void on();
+        /** @brief Begins the segment after the sustain segment, from the current value.
+         */
+        void off();
+        /** @brief Sets the envelope value to 0 and sets it to off.
+         */
+        void reset();
+        /** @brief Sets the segments.
+         *
+         * @param segs Segments, at most `max_segments`
+         * @param sustain Index of the segment the envelope holds at the end of, or `no_sustain`
+         */
+        void set_segments(std::span<const Segment> segs, size_t sustain);
+        /** @brief Sets up the envelope as attack-decay-sustain-release.
+         *
+         * @param attack Attack time, in seconds
+         * @param decay Decay time, in seconds
+         * @param sustain Sustain level, between 0-1
+         * @param release Release time, in seconds
+         */
+        void set_adsr(modal::dsp::num attack, modal::dsp::num decay, modal::dsp::num sustain, modal::dsp::num release);
+        /** @brief Sets the internal sample rate of the envelope.
+         *
+         * Behaves as described in [the DSP coding standards](docs/DSP Coding Standards.md)
+         */
+        void set_sample_rate(modal::dsp::num sr);
+     private:
+        void enter(size_t s);
+
+        std::array<Segment, max_segments> segments {};
+        size_t count = 0;
+        size_t sustain_segment = no_sustain;
+        size_t stage = max_segments; // at or past `count` when finished
+        bool held = false;
+        modal::dsp::num val = 0;
+        modal::dsp::num from = 0;
+        modal::dsp::num elapsed = 0; // seconds into the current segment
+        modal::dsp::num sample_rate = 48000;
+    };
+
+    /** @brief Random sample and hold, run at control rate.
+     *
+     * Picks a new uniformly distributed value between 0-1 at a set rate.
+     *
+     * Is a [DSP class](docs/DSP Coding Standards.md), apart from advancing by a control period at a time.
+     */
+    class SampleAndHold {
+     public:
+        /** @brief Advances by a number of samples.
+         *
+         * @param samples Number of samples to advance by, usually a control period
+         * @return The held value, between 0-1
+         */
+        modal::dsp::num advance(size_t samples);
+        /** @brief Sets the rate new values are picked at.
+         *
+         * @param rate Rate, in Hz
+         */
+        void set_params(modal::dsp::num rate);
+        /** @brief Sets the internal sample rate.
+         *
+         * Behaves as described in [the DSP coding standards](docs/DSP Coding Standards.md)
+         */
+        void set_sample_rate(modal::dsp::num sr);
+     private:
+        modal::dsp::bonus::FastRng rng;
+        modal::dsp::num phase = 0;
+        modal::dsp::num frequency = 1;
+        modal::dsp::num inc = 0;
+        modal::dsp::num held = 0;
+        modal::dsp::num sample_rate = 48000;
     };
-}
\ No newline at end of file
+}
@@ -0,0 +1,218 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+
+/*
+ * C API of the modal_dsp library: the ModalSynth plugin's instrument, without JUCE or the plugin around it,
+ * for embedding in other audio engines. See `modal::dsp::synth::ModalEngine` for how it plays.
+ *
+ * An engine is not thread safe: apart from `modal_engine_stats()`, call its functions from the thread that renders,
+ * or while it isn't rendering. Rendering never allocates or locks.
+ */
+
+#ifndef MODAL_DSP_H
+#define MODAL_DSP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(MODAL_DSP_SHARED)
+#  if defined(_WIN32)
+#    if defined(MODAL_DSP_BUILDING)
+#      define MODAL_DSP_API __declspec(dllexport)
+#    else
+#      define MODAL_DSP_API __declspec(dllimport)
+#    endif
+#  else
+#    define MODAL_DSP_API __attribute__((visibility("default")))
+#  endif
+#else
+#  define MODAL_DSP_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief An instance of the synth, with its own voices. */
+typedef struct modal_engine modal_engine;
+
+/** @brief Kinds of exciter, as the plugin's "Exciter" parameter. */
+typedef enum modal_exciter {
+    MODAL_EXCITER_IMPULSE = 0,
+    MODAL_EXCITER_NOISE = 1,
+    MODAL_EXCITER_IMPULSES = 2,
+    MODAL_EXCITER_SQUARE = 3,
+    MODAL_EXCITER_CHIRP = 4
+} modal_exciter;
+
+/** @brief Spectrum foldback modes, as the plugin's "Foldback Mode" parameter. */
+typedef enum modal_foldback {
+    MODAL_FOLDBACK_NYQUIST = 0,
+    MODAL_FOLDBACK_UNDERTONES = 1,
+    MODAL_FOLDBACK_FOLDBACK = 2
+} modal_foldback;
+
+/** @brief Quality tiers, trading fidelity for CPU. */
+typedef enum modal_quality {
+    /** Half the modes, and patch changes reach playing voices more slowly */
+    MODAL_QUALITY_ECO = 0,
+    MODAL_QUALITY_NORMAL = 1,
+    MODAL_QUALITY_HIGH = 2,
+    /** Patch changes reach every voice at once and continuous exciters are oversampled, for rendering faster or slower than realtime */
+    MODAL_QUALITY_OFFLINE = 3
+} modal_quality;
+
+/** @brief Every setting of the synth, in the units of the plugin's parameters. */
+typedef struct modal_patch {
+    /** Number of modes, 1-2048, patches of more than 40 play on large voices with a spectral backend */
+    uint32_t modes;
+    /** Linear inharmonicity, the plugin's "Mode Detune Linear" */
+    float inharmonicity;
+    /** Exponential inharmonicity, the plugin's "Mode Detune Exponent" */
+    float exponent;
+    /** Rate or pitch of the exciter, as a divisor of the note frequency */
+    float exciter_rate;
+    /** Decay time, in seconds */
+    float decay;
+    /** Exponential falloff of increasing modes */
+    float falloff;
+    /** Positions of every 2nd and every 3rd mode */
+    float mode_freqs[2];
+    /** Amplitudes of every 2nd and every 3rd mode */
+    float mode_gains[2];
+    modal_foldback foldback;
+    /** Point the spectrum is mirrored around with `MODAL_FOLDBACK_FOLDBACK`, in Hz */
+    float foldback_point;
+    modal_exciter exciter;
+    /** Exciter envelope attack, in seconds */
+    float attack;
+    /** Exciter envelope release, in seconds */
+    float release;
+    /** Formant filter vowel position, 0-1 */
+    float formant_x;
+    /** Formant filter vowel position, 0-1 */
+    float formant_y;
+    /** Formant filter throat length, 0-1 */
+    float formant_length;
+    /** Blend between the unfiltered and formant filtered sound, 0-1 */
+    float formant_mix;
+    /** How strongly note off damps the modes, 0 to let them ring out, up to 1 */
+    float damping;
+} modal_patch;
+
+/** @brief Timings and counts of recent renders, from `modal_engine_stats()`. */
+typedef struct modal_stats {
+    /** Number of renders summarised */
+    uint64_t blocks;
+    /** Time spent rendering over time rendered, 1 is a full core's worth of real time */
+    double load;
+    /** Mean time per render, in nanoseconds */
+    double mean_ns;
+    /** 99th percentile time per render, in nanoseconds */
+    double p99_ns;
+    /** Longest time per render, in nanoseconds */
+    double peak_ns;
+    /** Voices playing held notes, after the latest render */
+    uint32_t active_voices;
+    /** Modes of the voices playing held notes, after the latest render */
+    uint32_t active_modes;
+    /** Notes dropped because every voice was busy or the queue was full, since the engine was created */
+    uint64_t note_drops;
+    /** Voices that had their mode coefficients recomputed, since the engine was created */
+    uint64_t coefficient_updates;
+    /** Modes the voices can play between them, lowered by the governor under load */
+    uint32_t mode_budget;
+} modal_stats;
+
+/** @brief Creates an engine playing the default patch, or returns NULL if it couldn't be allocated. */
+MODAL_DSP_API modal_engine* modal_engine_create(double sample_rate);
+
+MODAL_DSP_API void modal_engine_destroy(modal_engine* engine);
+
+MODAL_DSP_API void modal_engine_set_sample_rate(modal_engine* engine, double sample_rate);
+
+/**
+ * @brief Bounds the time each render takes, by lowering the number of modes the voices play under load.
+ *
+ * The loudest and newest voices keep their modes longest, quiet ones lose their highest modes first.
+ * @param target Time a render should take over its duration, e.g. 0.7, or 0 to turn the governor off (the default)
+ */
+MODAL_DSP_API void modal_engine_set_load_target(modal_engine* engine, double target);
+
+/** @brief Sets the quality tier, `MODAL_QUALITY_NORMAL` unless set. */
+MODAL_DSP_API void modal_engine_set_quality(modal_engine* engine, modal_quality quality);
+
+/** @brief Fills a patch with the plugin's default settings. */
+MODAL_DSP_API void modal_patch_defaults(modal_patch* patch);
+
+/** @brief Sets every setting of the engine. Out of range values are clamped to the plugin's ranges. */
+MODAL_DSP_API void modal_engine_set_patch(modal_engine* engine, const modal_patch* patch);
+
+/** @brief Reads the engine's settings. */
+MODAL_DSP_API void modal_engine_get_patch(const modal_engine* engine, modal_patch* patch);
+
+/**
+ * @brief Sets the engine's settings from a state saved by the ModalSynth plugin, in its binary format.
+ *
+ * Settings the state doesn't have are set to their defaults.
+ * @return 1 if the state was read, 0 if it wasn't a state or was damaged, leaving the settings unchanged
+ */
+MODAL_DSP_API int modal_engine_load_state(modal_engine* engine, const void* data, size_t size);
+
+/**
+ * @brief Queues a note on, to start `offset` samples into the next render.
+ *
+ * @param note MIDI note number
+ * @param velocity 0-1
+ * @return 1 if queued, 0 if too many notes are queued
+ */
+MODAL_DSP_API int modal_engine_note_on(modal_engine* engine, int note, float velocity, uint32_t offset);
+
+/**
+ * @brief Queues a note off, to release the note `offset` samples into the next render.
+ *
+ * @return 1 if queued, 0 if too many notes are queued
+ */
+MODAL_DSP_API int modal_engine_note_off(modal_engine* engine, int note, uint32_t offset);
+
+/**
+ * @brief Turns MPE on or off, with channel 0 as the master channel of its lower zone.
+ *
+ * With MPE on, each note played on channels 1-15 has its own pitch bend and pressure.
+ * @param note_semitones Bend range of member channels, 48 in MPE's default
+ * @param master_semitones Bend range of the master channel, or of every channel with MPE off, 2 by default
+ */
+MODAL_DSP_API void modal_engine_set_mpe(modal_engine* engine, int enabled, float note_semitones, float master_semitones);
+
+/** @brief As `modal_engine_note_on()`, on a MIDI channel 0-15. */
+MODAL_DSP_API int modal_engine_channel_note_on(modal_engine* engine, int channel, int note, float velocity, uint32_t offset);
+
+/** @brief As `modal_engine_note_off()`, on a MIDI channel 0-15. */
+MODAL_DSP_API int modal_engine_channel_note_off(modal_engine* engine, int channel, int note, uint32_t offset);
+
+/**
+ * @brief Queues a pitch bend on a MIDI channel 0-15.
+ *
+ * @param amount -1 to 1, as a fraction of the channel's bend range
+ * @return 1 if queued, 0 if too many events are queued
+ */
+MODAL_DSP_API int modal_engine_pitch_bend(modal_engine* engine, int channel, float amount, uint32_t offset);
+
+/**
+ * @brief Queues a channel pressure change on a MIDI channel 0-15, driving the exciters harder.
+ *
+ * @param amount 0-1
+ * @return 1 if queued, 0 if too many events are queued
+ */
+MODAL_DSP_API int modal_engine_pressure(modal_engine* engine, int channel, float amount, uint32_t offset);
+
+/** @brief Renders mono output into `out`, overwriting `samples` samples. */
+MODAL_DSP_API void modal_engine_render(modal_engine* engine, float* out, size_t samples);
+
+/** @brief Summarises recent renders. Can be called from another thread than the one rendering, but only one. */
+MODAL_DSP_API void modal_engine_stats(modal_engine* engine, modal_stats* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
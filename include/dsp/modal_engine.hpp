@@ -0,0 +1,438 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include <dsp/dsp.hpp>
+#include <dsp/control.hpp>
+#include <dsp/mod.hpp>
+#include <dsp/modal_params.hpp>
+#include <dsp/modmatrix.hpp>
+#include <dsp/modal_synth.hpp>
+#include <dsp/perf.hpp>
+
+namespace modal::dsp::synth {
+    /** @brief How much CPU the engine spends on fidelity.
+     */
+    enum class Quality {
+        /// half the modes, and patch changes reach playing voices more slowly, for many instances on a weak machine
+        Eco,
+        /// the usual sound
+        Normal,
+        /// patch changes and the mode budget follow playing more closely
+        High,
+        /// patch changes reach every voice at once and continuous exciters are oversampled, for bounces where time doesn't matter
+        Offline,
+    };
+
+    /** @brief What a `Quality` sets.
+     */
+    struct QualitySettings {
+        /// most modes per voice
+        size_t max_modes;
+        /// samples between control periods, where coefficients are updated and the mode budget shared out
+        size_t control_period;
+        /// most voices whose coefficients are updated per control period after a patch change
+        size_t voices_per_update;
+        /// times faster than the voices their continuous exciters are run, see `ModalSynth::set_exciter_oversampling()`
+        size_t exciter_oversampling;
+    };
+
+    /** @brief The settings of a quality tier.
+     */
+    constexpr QualitySettings quality_settings(const Quality q) {
+        switch (q) {
+            case Quality::Eco:
+                return {20, 2 * block_size, 2, 1};
+            case Quality::High:
+                return {40, block_size / 2, 8, 1};
+            case Quality::Offline:
+                return {40, block_size / 2, 16, 4};
+            case Quality::Normal:
+            default:
+                return {40, block_size, 4, 1};
+        }
+    }
+
+    /** @brief The ModalSynth plugin's instrument, without the plugin around it.
+     *
+     * Plays `voice_count` voices of `ModalSynth` sharing one patch, allocating notes to them with a `PolyController`,
+     * ramping patch changes with a `mod::SmoothedValue` per setting and spreading the coefficient updates they need
+     * with a `CoefficientScheduler`, and times itself with a `perf::Monitor`.
+     * Notes are queued with an offset into the next `render()`, and start and stop on that sample.
+     * With a load target set, a `ModeGovernor` bounds the time each render takes by limiting the modes the voices play.
+     * Its `Quality` caps the modes per voice, sets how often coefficients are updated and, offline, oversamples exciters.
+     *
+     * Notes of patches with up to `max_modes` modes are played by 40 mode voices. Those of patches with more, up to
+     * `max_patch_modes`, such as bells, plates and gongs, are played by `LargeModalSynth` voices, which switch to their
+     * spectral backend above its threshold and then sound `spectral::SpectralModalBank::latency()` samples late.
+     * The quality tiers and governor give these voices the same share of their most modes as they give the others,
+     * but never so few that they leave the spectral backend, whose cost hardly depends on its number of modes.
+     *
+     * Pitch bend and channel pressure apply to every voice, or with MPE on, those on a member channel only to the voices
+     * playing on it. Bends are smoothed and reach the voices once per control period, as a rotation of their mode
+     * coefficients rather than a recomputed spectrum.
+     *
+     * Released voices are damped, with the patch's damping, and stop being rendered once they've died away.
+     *
+     * A `mod::ModEngine` modulates the continuous settings, with its LFOs, envelope, sample and hold and the notes played,
+     * running at least once per control period. See `modulation()`.
+     *
+     * Everything but `stats()` must be called from the thread that renders, or while it isn't rendering.
+     * Nothing allocates after construction.
+     */
+    class ModalEngine {
+     public:
+        /// Number of voices
+        static constexpr size_t voice_count = 16;
+        /// Most modes per voice of the voices playing most patches, and the scale of the mode budget
+        static constexpr size_t max_modes = 40;
+        /// Most modes of a patch, those of more than `max_modes` are played by large voices
+        static constexpr size_t max_patch_modes = LargeModalSynth::max_modes;
+        /// Most notes queued at once, later ones are dropped
+        static constexpr size_t max_events = 512;
+        /// MIDI channels, numbered from 0
+        static constexpr int channel_count = 16;
+        /// Time constant bends and pressure are smoothed with, in seconds, hiding the steps of MIDI controllers
+        static constexpr modal::dsp::num expression_smoothing = 0.005_nm;
+        /// Time continuous settings ramp to new values over while voices are sounding, in seconds, unless set
+        static constexpr modal::dsp::num default_param_smoothing = 0.05_nm;
+        /// Most modulation routes at once
+        static constexpr size_t max_mod_routes = 16;
+
+        ModalEngine();
+
+        // the voices are controlled by reference, and the large ones allocated in the constructor
+        ModalEngine(const ModalEngine&) = delete;
+        ModalEngine& operator=(const ModalEngine&) = delete;
+
+        /** @brief Sets the sample rate of every voice.
+         */
+        void set_sample_rate(modal::dsp::num sr);
+
+        [[nodiscard]] modal::dsp::num sample_rate() const {
+            return rate;
+        }
+
+        /** @brief Sets the patch, the spectrum and every voice's exciter, envelope and formants.
+         *
+         * While voices are sounding, the continuous settings ramp to their new values over the smoothing time,
+         * the mode count, foldback and exciter change at once. Playing voices keep their old spectrum until their
+         * coefficients are updated, a few voices per control period, then glide to the new one over the control period.
+         */
+        void set_params(const ModalParams& p);
+
+        /** @brief The settings last set, which the patch may still be ramping to.
+         */
+        [[nodiscard]] const ModalParams& params() const {
+            return requested;
+        }
+
+        /** @brief Sets the time continuous settings take to ramp to new values.
+         *
+         * @param seconds Ramp time, in seconds, `default_param_smoothing` unless set, or 0 to jump to them
+         */
+        void set_param_smoothing(modal::dsp::num seconds);
+
+        /** @brief Sets the load above which the mode budget shrinks, or turns the governor off.
+         *
+         * The budget grows back once the load stays below 60% of the target.
+         * @param target Time a render should take over its duration, e.g. 0.7, or 0 to play every mode of every voice
+         */
+        void set_load_target(double target);
+
+        [[nodiscard]] double load_target() const {
+            return governed ? governor.get_settings().target_load : 0;
+        }
+
+        /** @brief Sets the quality tier, `Quality::Normal` unless set.
+         *
+         * Voices playing more modes than the tier allows drop the rest at once.
+         */
+        void set_quality(Quality q);
+
+        [[nodiscard]] Quality quality() const {
+            return tier;
+        }
+
+        /** @brief Modes the voices can currently play between them, from any thread.
+         *
+         * Counted in `max_modes` voices, a large voice gets the same share of its modes.
+         */
+        [[nodiscard]] uint32_t mode_budget() const {
+            return budget.load(std::memory_order_relaxed);
+        }
+
+        /** @brief Turns MPE on or off.
+         *
+         * With MPE on, as its lower zone, channel 0 is the master channel, whose bend and pressure apply to every voice,
+         * and each note played on channels 1-15 has its own bend and pressure.
+         * With it off, bend and pressure on any channel apply to every voice.
+         */
+        void set_mpe(bool enabled);
+
+        [[nodiscard]] bool mpe() const {
+            return mpe_enabled;
+        }
+
+        /** @brief Sets the range of a full pitch bend.
+         *
+         * @param note_semitones Range of member channels with MPE on, 48 by default
+         * @param master_semitones Range of the master channel, or every channel with MPE off, 2 by default
+         */
+        void set_bend_ranges(float note_semitones, float master_semitones);
+
+        /** @brief Queues a note on.
+         *
+         * @param note Note to play, as MIDI note number
+         * @param velocity Velocity of note, in range 0-1
+         * @param offset Sample of the next `render()` to start on, or of a later one if it's past the end
+         * @param channel MIDI channel, 0-15, whose bend and pressure the note follows with MPE on
+         * @return `false` if the queue is full and the note was dropped
+         */
+        bool note_on(int note, float velocity, uint32_t offset = 0, int channel = 0);
+
+        /** @brief Queues a note off, releasing the voice playing the note.
+         *
+         * @param note Note to release, as MIDI note number
+         * @param offset Sample of the next `render()` to release on, or of a later one if it's past the end
+         * @param channel MIDI channel the note was played on
+         * @return `false` if the queue is full and the release was dropped
+         */
+        bool note_off(int note, uint32_t offset = 0, int channel = 0);
+
+        /** @brief Queues a pitch bend.
+         *
+         * @param channel MIDI channel, 0-15
+         * @param amount Bend, in range -1 to 1, as a fraction of the channel's bend range
+         * @param offset Sample of the next `render()` to bend from, or of a later one if it's past the end
+         * @return `false` if the queue is full and the bend was dropped
+         */
+        bool pitch_bend(int channel, float amount, uint32_t offset = 0);
+
+        /** @brief Queues a channel pressure change, driving the exciters of the voices on the channel harder.
+         *
+         * @param channel MIDI channel, 0-15
+         * @param amount Pressure, in range 0-1
+         * @param offset Sample of the next `render()` to apply it from, or of a later one if it's past the end
+         * @return `false` if the queue is full and the change was dropped
+         */
+        bool pressure(int channel, float amount, uint32_t offset = 0);
+
+        /** @brief Renders the sum of the voices, playing queued notes on their samples.
+         *
+         * @param out Buffer to overwrite
+         * @param samples Number of samples to render
+         */
+        void render(float* out, size_t samples);
+
+        /** @brief Number of voices held or still ringing after their release.
+         */
+        [[nodiscard]] size_t sounding_voices() const {
+            size_t n = 0;
+            for (size_t v = 0; v < voice_count; v++) {
+                n += controller.is_sounding(v);
+            }
+            return n;
+        }
+
+        /** @brief The modulation of the continuous settings.
+         *
+         * Its targets are the settings by their `ModalParams::continuous()` index, normalised over
+         * `ModalParams::continuous_range()`, and their base values are the settings as ramped to so far.
+         * The engine plays its notes on it, with their velocity, and sets its aftertouch from the latest pressure
+         * on any channel. Set the sources' settings, the other sources and the routes between renders, from the thread
+         * that renders. Routed settings follow it from the next control period, the others are left exactly as set.
+         */
+        mod::ModEngine& modulation() {
+            return mod_engine;
+        }
+
+        /** @brief Summary of the timings and event counts of recent renders.
+         *
+         * Can be called from another thread than the one rendering, but only one at a time.
+         */
+        perf::Summary stats() {
+            return perf.collect();
+        }
+
+     private:
+        enum class EventKind : uint8_t {
+            NoteOn,
+            NoteOff,
+            Bend,
+            Pressure,
+        };
+
+        struct Event {
+            uint32_t offset;
+            EventKind kind;
+            uint8_t channel;
+            int note;
+            /// velocity, bend or pressure
+            float value;
+        };
+
+        /* A voice slot, playing each note on a `max_modes` voice, or on a large voice if the patch has more modes.
+         *
+         * Settings reach both, so either can play the next note, everything else only the one playing.
+         * Is an [instrument class](docs/DSP Coding Standards.md).
+         */
+        class Voice {
+         public:
+            Voice(): large {std::make_unique<LargeModalSynth>()} {}
+
+            // calls `f` with both voices
+            template<typename F>
+            void configure(F&& f) {
+                f(small);
+                f(*large);
+            }
+
+            // calls `f` with the voice playing, or that last played
+            template<typename F>
+            decltype(auto) playing(F&& f) {
+                return is_large ? f(*large) : f(small);
+            }
+
+            template<typename F>
+            decltype(auto) playing(F&& f) const {
+                return is_large ? f(std::as_const(*large)) : f(small);
+            }
+
+            // picks the voice the next note plays on, for a patch of `modes` modes
+            void choose(const size_t modes) {
+                is_large = modes > max_modes;
+            }
+
+            void on(const modal::dsp::num key_freq, const modal::dsp::num vel) {
+                playing([&](auto& v) { v.on(key_freq, vel); });
+            }
+
+            void off() {
+                playing([](auto& v) { v.off(); });
+            }
+
+            modal::dsp::num render(modal::dsp::num* out, const size_t n, perf::Monitor* perf) {
+                return is_large ? large->render(out, n, perf) : small.render(out, n, perf);
+            }
+
+            void bend(const modal::dsp::num ratio) {
+                playing([ratio](auto& v) { v.bend(ratio); });
+            }
+
+            void set_pressure(const modal::dsp::num pressure) {
+                playing([pressure](auto& v) { v.set_pressure(pressure); });
+            }
+
+            void damp(const size_t samples) {
+                playing([samples](auto& v) { v.damp(samples); });
+            }
+
+            [[nodiscard]] bool silent() const {
+                return playing([](const auto& v) { return v.silent(); });
+            }
+
+            [[nodiscard]] size_t num_modes() const {
+                return playing([](const auto& v) { return v.num_modes(); });
+            }
+
+            void update_mode_coefficients(const bool glide = false) {
+                playing([glide](auto& v) { v.update_mode_coefficients(glide); });
+            }
+
+            // as `ModalSynth::set_mode_limit()`, in `max_modes` voices, which large voices play the same share of
+            bool set_mode_limit(const size_t limit, const size_t patch_modes) {
+                const bool small_moved = small.set_mode_limit(limit);
+                auto share = limit >= max_modes ? max_patch_modes : limit * max_patch_modes / max_modes;
+                if (patch_modes > large->spectral_threshold()) {
+                    share = std::max(share, large->spectral_threshold() + 1);
+                }
+                const bool large_moved = large->set_mode_limit(share);
+                return is_large ? large_moved : small_moved;
+            }
+
+         private:
+            ModalSynth<max_modes> small;
+            std::unique_ptr<LargeModalSynth> large;
+            bool is_large = false;
+        };
+
+        // the settings as set, and as ramped to them so far, which the patch and voices play
+        ModalParams requested, current;
+        std::array<mod::SmoothedValue, ModalParams::num_continuous> smoothers;
+        mod::ModEngine mod_engine {ModalParams::num_continuous, max_mod_routes};
+        ModalPatch patch;
+        std::array<Voice, voice_count> voices;
+        PolyController<Voice, voice_count> controller {voices};
+        // at most `voices_per_update` voices' coefficients are updated per control period
+        CoefficientScheduler<voice_count> coefficients {quality_settings(Quality::Normal).voices_per_update};
+        modal::dsp::num rate = 48000;
+        Quality tier = Quality::Normal;
+        // most modes per voice, whether governed or not
+        size_t mode_cap = quality_settings(Quality::Normal).max_modes;
+        size_t control_period = quality_settings(Quality::Normal).control_period;
+        // samples left until the next control period
+        size_t until_control = 0;
+        // samples rendered so far
+        uint64_t clock = 0;
+
+        bool governed = false;
+        ModeGovernor<voice_count> governor {max_modes};
+        std::array<ModeGovernor<voice_count>::Voice, voice_count> governed_voices {};
+        // peak of each voice's output this control period
+        std::array<modal::dsp::num, voice_count> peaks {};
+        std::array<uint64_t, voice_count> started {};
+        std::atomic<uint32_t> budget {voice_count * max_modes};
+
+        bool mpe_enabled = false;
+        float note_bend_range = 48;
+        float master_bend_range = 2;
+        // latest bend and pressure of each channel, the master channel's apply to every voice
+        std::array<float, channel_count> channel_bend {};
+        std::array<float, channel_count> channel_pressure {};
+        float master_bend = 0;
+        float master_pressure = 0;
+        // each voice's bend in semitones and pressure, smoothed towards their targets once per control period
+        std::array<modal::dsp::num, voice_count> bend_target {}, bend_now {};
+        std::array<modal::dsp::num, voice_count> pressure_target {}, pressure_now {};
+
+        // sorted by offset, in the order they were queued for equal offsets
+        std::array<Event, max_events> events {};
+        size_t queued = 0;
+
+        perf::Monitor perf;
+
+        bool queue(Event e);
+
+        void play(const Event& e, uint64_t time);
+
+        // shares the mode budget out, with voices' levels as of the last control period
+        void allocate_modes(uint64_t time);
+
+        // limits every voice to `limit` modes, ungoverned
+        void limit_modes(size_t limit);
+
+        // sets a voice's targets from the bend and pressure of the channel it follows
+        void retarget(size_t voice, int channel);
+
+        // moves the voices' bend and pressure towards their targets
+        void smooth_expression();
+
+        // moves the continuous settings a control period along their ramps, and runs the modulation
+        void smooth_params();
+
+        // a continuous setting as ramped to so far, or as modulated if it's routed
+        modal::dsp::num modulated(size_t index) const;
+
+        // sets up the patch and voices from `current`
+        void apply_params();
+    };
+}
@@ -0,0 +1,86 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+#include <dsp/dsp.hpp>
+#include <dsp/modal_synth.hpp>
+#include <dsp/preset.hpp>
+
+namespace modal::dsp::synth {
+    /** @brief Every setting of the ModalSynth plugin, in its parameters' own units.
+     *
+     * Sets up a `ModalPatch` and the voices playing it the same way wherever the synth is played,
+     * whether by the plugin or by the offline renderer. Defaults are the plugin's parameter defaults.
+     */
+    struct ModalParams {
+        size_t modes = 40;
+        modal::dsp::num inharmonicity = 0;
+        modal::dsp::num exponent = 1;
+        modal::dsp::num exciter_rate = 4;
+        modal::dsp::num decay = 1;
+        modal::dsp::num falloff = 1;
+        std::array<modal::dsp::num, 2> mode_freqs {1, 1};
+        std::array<modal::dsp::num, 2> mode_gains {1, 1};
+        ModalFoldbackKind foldback = ModalFoldbackKind::NyquistStop;
+        modal::dsp::num foldback_point = 1600;
+        ModalExiterKind exciter = ModalExiterKind::Impulse;
+        modal::dsp::num attack = 0.5;
+        modal::dsp::num release = 0.5;
+        modal::dsp::mod::EnvCurve attack_curve = modal::dsp::mod::EnvCurve::Linear;
+        modal::dsp::mod::EnvCurve release_curve = modal::dsp::mod::EnvCurve::Linear;
+        modal::dsp::num formant_x = 0.5;
+        modal::dsp::num formant_y = 0.5;
+        modal::dsp::num formant_length = 0.5;
+        modal::dsp::num formant_mix = 0.5;
+        modal::dsp::num damping = 0;
+
+        /// Number of settings that change continuously, every one but the mode count, foldback, exciter and envelope curves
+        static constexpr size_t num_continuous = 17;
+
+        /** @brief Reads the settings from a state saved by the plugin.
+         *
+         * Parameters the state doesn't have keep their defaults.
+         */
+        static ModalParams from_state(const preset::PatchState& state);
+
+        /** @brief A setting that changes continuously, by index, so they can all be smoothed alike.
+         *
+         * @param index From 0 up to `num_continuous`, in the order they're declared in
+         */
+        modal::dsp::num& continuous(size_t index);
+
+        [[nodiscard]] modal::dsp::num continuous(const size_t index) const {
+            return const_cast<ModalParams&>(*this).continuous(index);
+        }
+
+        /** @brief Lowest and highest values of a continuous setting, the range of its plugin parameter.
+         *
+         * Settings are modulated normalised over their range, as the plugin's parameters are.
+         * @param index From 0 up to `num_continuous`, as in `continuous()`
+         * @return `{lowest, highest}`
+         */
+        static std::array<modal::dsp::num, 2> continuous_range(size_t index);
+
+        /** @brief Sets the spectrum of a patch.
+         *
+         * @return If the voices playing the patch need their coefficients updated
+         */
+        bool apply(ModalPatch& patch) const;
+
+        /** @brief Sets the settings a voice keeps itself, the exciter, its envelope, the formant filter and damping.
+         *
+         * Doesn't set the voice's patch, or update its coefficients.
+         */
+        template<size_t maxModes>
+        void apply(ModalSynth<maxModes>& voice) const {
+            voice.set_env_params(attack, release);
+            voice.set_env_curves(attack_curve, release_curve);
+            voice.set_exciter(exciter);
+            voice.set_formant_params(formant_x, formant_y, formant_length, formant_mix);
+            voice.set_damping(damping);
+        }
+    };
+}
@@ -2,21 +2,29 @@
 
 #pragma once
 
+#include <algorithm>
 #include <array>
+#include <cmath>
+#include <limits>
+#include <optional>
+#include <type_traits>
+#include <variant>
 
 #include <dsp/dsp.hpp>
 #include "resonator.hpp"
 #include <dsp/mod.hpp>
-#include <randutils.hpp>
+#include <dsp/bonus.hpp>
 #include <dsp/osc.hpp>
+#include <dsp/filters.hpp>
+#include <dsp/perf.hpp>
 
 #include <dsp/formant.hpp>
+#include <dsp/spectral.hpp>
 
 namespace modal::dsp::synth {
     /// @private
     class ModalControls {
-        template <size_t>
-        friend class ModalSynth;
+        friend struct ModalPatch;
         std::array<modal::dsp::num, 2> freq_params = {};
         std::array<modal::dsp::num, 2> gain_params = {};
      public:
@@ -83,50 +91,187 @@ namespace modal::dsp::synth {
         Foldback = 2
     };
 
-    /// @private
-    struct FoldbackSettings {
-        ModalFoldbackKind mode = ModalFoldbackKind::NyquistStop;
+    /** @brief Parameters of the modal synth's spectrum, shared by all of a processor's voices.
+     *
+     * Holds everything `ModalSynth::update_mode_coefficients()` reads apart from the note being played,
+     * so that the voices only keep the state they touch per sample.
+     * Setters return if the voices' coefficients need to be updated.
+     */
+    struct ModalPatch {
+        /// @private
+        ModalControls controls;
+        /// Number of modes to synthesise, clamped to each voice's `maxModes`
+        size_t modes = std::numeric_limits<size_t>::max();
+        /// Linear inharmonicity factor
+        modal::dsp::num inharmonicity = 0;
+        /// Exponential inharmonicity factor
+        modal::dsp::num exponent = 0;
+        /// Rate or pitch of exciter, as a divisor of the note frequency
+        modal::dsp::num exciter_rate = 20;
+        /// Decay time, in seconds
+        modal::dsp::num decay = 1;
+        /// Exponential falloff of increasing modes
+        modal::dsp::num falloff = 1;
+        /// Foldback mode for the spectrum
+        ModalFoldbackKind foldback = ModalFoldbackKind::NyquistStop;
+        /// Point to mirror the spectrum around with `ModalFoldbackKind::Foldback`, in Hz
         modal::dsp::num foldback_point = 1600;
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wfloat-equal"
+        /** @brief Sets coefficients related to the spectrum of modes.
+         *
+         * @param num_modes Number of modes to synthesise
+         * @param inharm Linear inharmonicity factor, usually between -0.06 and 2
+         * @param expo Exponential inharmonicity factor, usually between 0.1 and 10
+         * @param e_rate Rate or pitch of exciter, in Hz
+         * @param dcy Decay time, in seconds
+         * @param flof Exponential falloff of increasing modes, usually between 0 and 3
+         * @return If coefficients need to be updated
+         */
+        bool set_params(size_t num_modes, modal::dsp::num inharm, modal::dsp::num expo, modal::dsp::num e_rate, modal::dsp::num dcy, modal::dsp::num flof) {
+            bool changed = false;
+            if (num_modes != modes || inharm != inharmonicity
+                || expo != exponent || e_rate != exciter_rate
+                || dcy != decay || flof != falloff) {
+                changed = true;
+            }
+            modes = num_modes;
+            inharmonicity = inharm;
+            exponent = expo;
+            exciter_rate = e_rate;
+            decay = dcy;
+            falloff = flof;
+            return changed;
+        }
+
+        /** @brief Set foldback mode.
+         *
+         * @param mode `ModalFoldbackKind`, foldback mode for the spectrum
+         * @param point Point to mirror the spectrum when set to `Foldback`, in Hz
+         * @return If coefficients need to be updated
+         */
+        bool set_foldback_settings(const ModalFoldbackKind mode, const modal::dsp::num point) {
+            const bool changed = foldback != mode || foldback_point != point;
+            foldback = mode;
+            foldback_point = point;
+            return changed;
+        }
+#pragma GCC diagnostic pop
+
+        /** @brief Update frequency shift of every 2nd and every 3rd mode.
+         *
+         * @param new_freqs Frequency shift, like `ModalControls`
+         * @return If coefficients need to be updated
+         */
+        bool set_mode_freqs(const std::array<modal::dsp::num, 2>& new_freqs) {
+            bool changed = controls.freq_params != new_freqs;
+            controls.set_freqs(new_freqs);
+            return changed;
+        }
+
+        /** @brief Update gain of every 2nd and every 3rd mode.
+         *
+         * @param new_gains Gain, like `ModalControls`
+         * @return If coefficients need to be updated
+         */
+        bool set_mode_gains(const std::array<modal::dsp::num, 2>& new_gains) {
+            bool changed = controls.gain_params != new_gains;
+            controls.set_gains(new_gains);
+            return changed;
+        }
     };
 
     /**
      * @brief Modal synthesiser
      *
      * This is the implementation of the main synthesiser in the plugin.
-     * Has a set of `physical::filters::PhasorResonator` modes, `osc::Phasor` exciters,
+     * Has a `physical::filters::PhasorResonatorBank` of modes, `osc::Phasor` exciters,
      * an `mod::AHREnv` envelope, and a `physical::FormantFilter` filter.
      *
-     * Some member functions require the mode coefficients to be updated after they are called.
+     * The spectrum's parameters live in a `ModalPatch` shared between voices, see `set_patch()`.
+     * Some member functions, and changes to the patch, require the mode coefficients to be updated after.
      * This is an expensive operation, so these functions do not update the coefficients themselves,
      * and require the caller to update the coefficients using `update_mode_coefficients()` after.
      * This is noted in the documentation of those functions.
      *
+     * Members are laid out so that everything touched per sample is contiguous,
+     * with the rarely used parameters before and after it.
+     *
+     * With `maxModes` of at least `spectral_min_modes`, also has a `spectral::SpectralModalBank`,
+     * which is used instead of the recursive bank when more than `spectral_threshold()` modes are playing.
+     * It is much cheaper per mode, but adds `spectral::SpectralModalBank::latency()` samples of latency
+     * and is only an approximation, see its documentation.
+     *
      * Is an [instrument class](docs/DSP Coding Standards.md).
      * @tparam maxModes Maximum number of modes to synthesise
      */
     template<size_t maxModes>
     class ModalSynth {
-        std::array<physical::filters::PhasorResonator, maxModes> modes;
-        ModalControls controls;
-        size_t currentModes = maxModes;
-        modal::dsp::num inharmonicity = 0;
-        modal::dsp::num exponent = 0;
-        modal::dsp::num freq = 0;
-        modal::dsp::num velocity = 1;
-        modal::dsp::num decay = 1;
-        modal::dsp::num falloff = 1;
+     public:
+        /// Most modes the voice can synthesise
+        static constexpr size_t max_modes = maxModes;
+        /// Smallest `maxModes` that includes the spectral backend
+        static constexpr size_t spectral_min_modes = 128;
+        /// Default number of modes above which the spectral backend is used
+        static constexpr size_t default_spectral_threshold = 256;
+        /// Time the damper takes to bring the modes to their release decay after note off, in seconds
+        static constexpr modal::dsp::num damper_time = 0.02_nm;
+        /// How much faster the damper releases higher modes, see `physical::filters::PhasorResonatorBank::damp()`
+        static constexpr modal::dsp::num damper_tilt = 3;
+        /// Shortest release decay at the fundamental, with full damping, in seconds
+        static constexpr modal::dsp::num min_release_decay = 0.05_nm;
+        /// Output level below which a released voice is `silent()`, about -100dB
+        static constexpr modal::dsp::num silence_level = 1e-5_nm;
 
+     private:
+        static constexpr bool has_spectral_backend = maxModes >= spectral_min_modes;
+        using SpectralBackend = std::conditional_t<has_spectral_backend, spectral::SpectralModalBank, std::monostate>;
+
+        static SpectralBackend make_spectral_backend() {
+            if constexpr (has_spectral_backend) {
+                return spectral::SpectralModalBank {maxModes};
+            } else {
+                return {};
+            }
+        }
+
+        inline static const ModalPatch default_patch {};
+
+        // per-mode parameters, then the per-sample arrays
+        physical::filters::PhasorResonatorBank<maxModes> modes;
+
+        // per-sample state
+        size_t currentModes = maxModes;
+        size_t spectral_modes_above = default_spectral_threshold;
+        modal::dsp::num gain = 1;
+        // exciter gain from pressure
+        modal::dsp::num drive = 1;
+        modal::dsp::num formant_mix = 0.5;
         ModalExiterKind exciter = ModalExiterKind::Noise;
-        modal::dsp::num exciter_rate = 20;
+        modal::dsp::bonus::FastRng noise;
         modal::dsp::osc::Phasor osc_exciter {48000};
         modal::dsp::osc::Chirper chirp_exciter;
-        FoldbackSettings foldback;
-
+        // continuous exciters run this many times faster than the voice, then are filtered and decimated
+        size_t exciter_oversampling = 1;
+        modal::dsp::filters::DecimationFilter decimator;
         modal::dsp::mod::AHREnv env;
-        randutils::default_rng noise;
-
+        // per-sample filter bank first, then its parameters
         modal::dsp::physical::FormantFilter formants {physical::FormantArch::Parallel};
-        modal::dsp::num formant_mix = 0.5;
+
+        // only touched when notes start or parameters change
+        const ModalPatch* patch = &default_patch;
+        // modes the patch asks for, of which the first `mode_limit` are synthesised
+        size_t patch_modes = maxModes;
+        size_t mode_limit = maxModes;
+        modal::dsp::num freq = 0;
+        modal::dsp::num bend_ratio = 1;
+        modal::dsp::num velocity = 1;
+        modal::dsp::num sample_rate = 48000;
+        modal::dsp::num damping = 0;
+        // per-sample radius loss of the release decay at 0Hz while released, 0 when not damping
+        modal::dsp::num release_loss = 0;
+        SpectralBackend spectral_modes = make_spectral_backend();
 
      public:
         /** @brief Note on.
@@ -141,6 +286,8 @@ namespace modal::dsp::synth {
         void on(modal::dsp::num key_freq, modal::dsp::num vel) {
             freq = key_freq;
             velocity = vel;
+            gain = vel * vel;
+            release_loss = 0;
             update_mode_coefficients();
             switch (exciter) {
                 case ModalExiterKind::Impulse:
@@ -160,6 +307,12 @@ namespace modal::dsp::synth {
          * Behaves as described in [the DSP coding standards](docs/DSP Coding Standards.md)
          */
         void off() {
+            if (damping > 0) {
+                // the fundamental's decay time, from `update_mode_coefficients()`, shortened on a log scale
+                const auto decay = 2 * patch->decay;
+                const auto release = decay * std::pow(min_release_decay / decay, damping);
+                release_loss = 6.9077553_nm / (release * sample_rate);
+            }
             switch (exciter) {
                 case ModalExiterKind::Impulse:
                     break;
@@ -177,43 +330,152 @@ namespace modal::dsp::synth {
          * Behaves as described in [the DSP coding standards](docs/DSP Coding Standards.md)
          */
         modal::dsp::num tick() {
-            // modal::dsp::num to_mode =  * env.tick();
-            modal::dsp::num to_mode = 0;
+            modal::dsp::num to_mode = exciter_sample();
 
-            osc_exciter.tick();
-            modal::dsp::num chirp_sig = chirp_exciter.tick();
+            to_mode *= env.tick() * drive;
 
-            switch (exciter) {
-                case ModalExiterKind::Noise:
-                    to_mode = noise.uniform(-0.05_nm, 0.05_nm);
-                    break;
-                case ModalExiterKind::Impulses:
-                    to_mode = osc::impulse_train(osc_exciter) * 0.6_nm;
-                    break;
-                case ModalExiterKind::Square:
-                    to_mode = osc::aa_rect(osc_exciter, 0.5_nm) * 0.2_nm;
-                    break;
-                case ModalExiterKind::Chirp:
-                    to_mode = chirp_sig * 0.2_nm;
-                    break;
-                case ModalExiterKind::Impulse:
-                    break;
+            modal::dsp::num modes_out = modes_tick(to_mode);
+
+            modal::dsp::num formant_out = formants.tick(modes_out);
+
+            modal::dsp::num out = bonus::lerp(modes_out, formant_out, formant_mix);
+
+            out *= gain;
+
+            return out;
+        }
+
+        /** @brief Synthesises a block of audio, adding it to `out`.
+         *
+         * Equivalent to calling `tick()` for each sample, up to rounding, but runs the exciter and envelope,
+         * the modes and the formant filter over the whole block in turn, so each can be timed.
+         * @param out Array of `n` samples to add the output to
+         * @param n Number of samples, at most `dsp::block_size`
+         * @param perf Monitor to time the exciter, modes and formant stages with, or `nullptr`
+         * @return Peak level of the voice's output over the block
+         */
+        modal::dsp::num render(modal::dsp::num* out, const size_t n, perf::Monitor* perf = nullptr) {
+            std::array<modal::dsp::num, block_size> to_mode;
+            std::array<modal::dsp::num, block_size> voice_out;
+
+            std::optional<perf::ScopedStage> timer;
+            timer.emplace(perf, perf::Stage::Exciter);
+            env.process_block(to_mode.data(), n);
+            for (size_t i = 0; i < n; i++) {
+                to_mode[i] = exciter_sample() * (to_mode[i] * drive);
             }
 
-            to_mode *= env.tick();
+            timer.emplace(perf, perf::Stage::Modes);
+            if (uses_spectral_backend() || modes.gliding()) {
+                // the spectral backend runs per sample, and a glide can be longer than the block
+                for (size_t i = 0; i < n; i++) {
+                    voice_out[i] = modes_tick(to_mode[i]);
+                }
+            } else {
+                modes.process_block(to_mode.data(), voice_out.data(), n, currentModes);
+            }
 
-            modal::dsp::num modes_out = 0;
-            for (size_t i = 0; i < currentModes; i++) {
-                modes_out += modes[i].tick(to_mode);
+            timer.emplace(perf, perf::Stage::Formant);
+            modal::dsp::num peak = 0;
+            for (size_t i = 0; i < n; i++) {
+                const auto formant_out = formants.tick(voice_out[i]);
+                const auto sample = bonus::lerp(voice_out[i], formant_out, formant_mix) * gain;
+                peak = std::max(peak, std::abs(sample));
+                out[i] += sample;
             }
+            return peak;
+        }
 
-            modal::dsp::num formant_out = formants.tick(modes_out);
+        /** @brief Sets how many times faster than the voice its continuous exciters are run.
+         *
+         * Oversampled, the impulse train, square and chirp exciters are low-pass filtered and decimated,
+         * so fold back less of what they have above the Nyquist frequency, at the cost of generating them `factor` times
+         * per sample. Noise isn't oversampled. 1, the default, runs them at the voice's rate.
+         * @param factor Oversampling factor, at least 1
+         */
+        void set_exciter_oversampling(const size_t factor) {
+            exciter_oversampling = std::max<size_t>(factor, 1);
+            decimator.set_factor(exciter_oversampling);
+            set_exciter_rate();
+        }
 
-            modal::dsp::num out = bonus::lerp(modes_out, formant_out, formant_mix);
+        /** @brief Sets how strongly note off damps the modes.
+         *
+         * @param amount 0 to let the modes ring for their own decay, up to 1 to release the fundamental
+         *               in `min_release_decay`, higher modes faster
+         */
+        void set_damping(const modal::dsp::num amount) {
+            damping = amount;
+        }
 
-            out *= (velocity * velocity);
+        /** @brief Advances the damper, once per control period.
+         *
+         * After note off, with damping set, moves every mode's decay towards its release decay over `damper_time`,
+         * with a scale of its coefficient per call. Coefficient updates during the release undo the damping so far,
+         * which then starts again. The spectral backend's modes take on their new decay at its next hop.
+         * @param samples Samples since the last call
+         */
+        void damp(const size_t samples) {
+            // no loss without damping
+            if (release_loss <= 0) {
+                return;
+            }
+            const auto step = static_cast<modal::dsp::num>(samples) / (damper_time * sample_rate);
+            if constexpr (has_spectral_backend) {
+                if (uses_spectral_backend()) {
+                    spectral_modes.damp(release_loss, damper_tilt, step, currentModes);
+                    return;
+                }
+            }
+            modes.damp(release_loss, damper_tilt, step, currentModes);
+        }
 
-            return out;
+        /** @brief Whether the voice has died away, with its exciter finished and its modes below `silence_level`.
+         *
+         * The spectral backend's modes are measured at its hops, so it can be found silent up to a hop later.
+         */
+        [[nodiscard]] bool silent() const {
+            if (!env.resting()) {
+                return false;
+            }
+            const auto limit = silence_level / (gain * (1 + formant_mix));
+            modal::dsp::num energy;
+            if constexpr (has_spectral_backend) {
+                energy = uses_spectral_backend() ? spectral_modes.energy(currentModes) : modes.energy(currentModes);
+            } else {
+                energy = modes.energy(currentModes);
+            }
+            return energy * static_cast<modal::dsp::num>(currentModes) < limit * limit;
+        }
+
+        /** @brief Bends the pitch of the note, and of notes played after, without recomputing the spectrum.
+         *
+         * Rotates the mode coefficients, a few multiplies per mode, so can follow a pitch bend or an MPE slide
+         * every control period. The spectrum bends as a whole, folded modes included.
+         * The spectral backend turns its modes to the bent frequencies at its next hop instead, see
+         * `spectral::SpectralModalBank::bend()`.
+         * @param ratio Frequency ratio to the note's frequency, e.g. 2 for an octave up
+         */
+        void bend(const modal::dsp::num ratio) {
+            bend_ratio = ratio;
+            if constexpr (has_spectral_backend) {
+                // the backend not in use still bends modes it's set to later
+                const bool spectral = uses_spectral_backend();
+                spectral_modes.bend(ratio, spectral ? patch_modes : 0);
+                modes.bend(ratio, spectral ? 0 : patch_modes);
+            } else {
+                modes.bend(ratio, patch_modes);
+            }
+            osc_exciter.set_freq(freq * bend_ratio / patch->exciter_rate);
+            chirp_exciter.set_freq(freq * bend_ratio / patch->exciter_rate);
+        }
+
+        /** @brief Sets how hard the note is pressed, driving continuous exciters harder.
+         *
+         * @param pressure Pressure, in range 0-1, from playing as without pressure to exciting the modes twice as hard
+         */
+        void set_pressure(const modal::dsp::num pressure) {
+            drive = 1 + pressure;
         }
 
         /** @brief Sets the exciter.
@@ -227,58 +489,80 @@ namespace modal::dsp::synth {
             exciter = new_exciter;
         }
 
-#pragma clang diagnostic push
-#pragma clang diagnostic ignored "-Wfloat-equal"
-        /** @brief Sets coefficients related to the spectrum of modes.
+        /** @brief Restarts the noise exciter's sequence from a seed, for reproducible renders.
          *
-         * Requires updating coefficients.
-         * @param num_modes Number of modes to synthesise (must be equal or less than `NumModes`)
-         * @param inharm Linear inharmonicity factor, usually between -0.06 and 2
-         * @param expo Exponential inharmonicity factor, usually between 0.1 and 10
-         * @param e_rate Rate or pitch of exciter, in Hz
-         * @param dcy Decay time, in seconds
-         * @param flof Exponential falloff of increasing modes, usually between 0 and 3
-         * @return If coefficients need to be updated
+         * Each voice otherwise gets its own seed when it's constructed.
          */
-        bool set_params(size_t num_modes, modal::dsp::num inharm, modal::dsp::num expo, modal::dsp::num e_rate, modal::dsp::num dcy, modal::dsp::num flof) {
-            bool changed = false;
-            if (num_modes != currentModes || inharm != inharmonicity
-                || expo != exponent || e_rate != exciter_rate
-                || dcy != decay || flof != falloff) {
-                changed = true;
-            }
-            currentModes = num_modes;
-            inharmonicity = inharm;
-            exponent = expo;
-            exciter_rate = e_rate;
-            decay = dcy;
-            falloff = flof;
-            return changed;
+        void seed_noise(const std::uint32_t seed) {
+            noise = bonus::FastRng {seed};
         }
-#pragma clang diagnostic pop
 
-        /** @brief Update frequency shift of every 2nd and every 3rd mode.
+        /** @brief Sets the patch the voice takes its spectrum from.
          *
+         * The patch must outlive the voice, and is shared with every other voice playing it.
          * Requires updating coefficients.
-         * @param new_freqs Frequency shift, like `ModalControls`
-         * @return If coefficients need to be updated
          */
-        bool set_mode_freqs(const std::array<modal::dsp::num, 2>& new_freqs) {
-            bool changed = controls.freq_params != new_freqs;
-            controls.set_freqs(new_freqs);
-            return changed;
+        void set_patch(const ModalPatch& new_patch) {
+            patch = &new_patch;
         }
 
-        /** @brief Update frequency shift of every 2nd and every 3rd mode.
+        /** @brief Sets the number of modes above which the spectral backend is used.
          *
+         * Has no effect unless `maxModes` is at least `spectral_min_modes`.
          * Requires updating coefficients.
-         * @param new_gains
+         * @param threshold Number of modes, the spectral backend is used when more than this are playing
          * @return If coefficients need to be updated
          */
-        bool set_mode_gains(const std::array<modal::dsp::num, 2>& new_gains) {
-            bool changed = controls.gain_params != new_gains;
-            controls.set_gains(new_gains);
-            return changed;
+        bool set_spectral_threshold(const size_t threshold) {
+            const bool was_spectral = uses_spectral_backend();
+            spectral_modes_above = threshold;
+            return was_spectral != uses_spectral_backend();
+        }
+
+        /** @brief Number of modes above which the spectral backend is used.
+         */
+        [[nodiscard]] size_t spectral_threshold() const {
+            return spectral_modes_above;
+        }
+
+        /** @brief If the spectral backend is currently synthesising the modes, rather than the recursive bank.
+         */
+        [[nodiscard]] bool uses_spectral_backend() const {
+            return has_spectral_backend && currentModes > spectral_modes_above;
+        }
+
+        /** @brief Delay of the output, in samples, the spectral backend's while it's in use.
+         */
+        [[nodiscard]] size_t latency() const {
+            if constexpr (has_spectral_backend) {
+                return uses_spectral_backend() ? spectral_modes.latency() : 0;
+            } else {
+                return 0;
+            }
+        }
+
+        /** @brief Number of modes synthesised.
+         */
+        [[nodiscard]] size_t num_modes() const {
+            return currentModes;
+        }
+
+        /** @brief Limits the number of modes synthesised, dropping the highest, and weakest, of the patch's modes.
+         *
+         * Takes effect immediately, as the coefficients of every mode of the patch are kept up to date.
+         * Modes brought back by raising the limit start from silence.
+         * @param limit Most modes to synthesise
+         * @return If coefficients need to be updated, when the limit moves the voice between backends
+         */
+        bool set_mode_limit(const size_t limit) {
+            const bool was_spectral = uses_spectral_backend();
+            const size_t before = currentModes;
+            mode_limit = limit;
+            currentModes = std::min(patch_modes, mode_limit);
+            if (currentModes > before) {
+                modes.silence(before, currentModes);
+            }
+            return was_spectral != uses_spectral_backend();
         }
 
         /** @brief Sets the timings for the envelope of the exciter.
@@ -289,22 +573,13 @@ namespace modal::dsp::synth {
             env.set_params(attack, release);
         }
 
-#pragma clang diagnostic push
-#pragma clang diagnostic ignored "-Wfloat-equal"
-        /** @brief Set foldback mode.
-         *
-         * Requires updating coefficients.
-         * @param mode `ModalFoldbackKind`, foldback mode for the spectrum
-         * @param foldback_point Point to mirror the spectrum when set to `Foldback`, in Hz
-         * @return If coefficients need to be updated
+        /** @brief Sets the shapes of the envelope of the exciter.
+         * @param attack Shape of the attack
+         * @param release Shape of the release
          */
-        bool set_foldback_settings(const ModalFoldbackKind mode, modal::dsp::num foldback_point) {
-            const bool changed = foldback.mode != mode || foldback.foldback_point != foldback_point;
-            foldback.mode = mode;
-            foldback.foldback_point = foldback_point;
-            return changed;
+        void set_env_curves(const modal::dsp::mod::EnvCurve attack, const modal::dsp::mod::EnvCurve release) {
+            env.set_curves(attack, release);
         }
-#pragma clang diagnostic pop
 
         /** @brief Sets the formant filter to a particular vowel sound.
          * @param x First formant position, as 0-1
@@ -323,70 +598,161 @@ namespace modal::dsp::synth {
          * Behaves as described in [the DSP coding standards](docs/DSP Coding Standards.md)
          */
         void set_sample_rate(modal::dsp::num sr) {
-            for (auto& m : modes) {
-                m.set_sample_rate(sr);
+            sample_rate = sr;
+            modes.set_sample_rate(sr);
+            if constexpr (has_spectral_backend) {
+                spectral_modes.set_sample_rate(sr);
             }
             env.set_sample_rate(sr);
-            osc_exciter.set_sample_rate(sr);
-            chirp_exciter.set_sample_rate(sr);
+            set_exciter_rate();
             formants.set_sample_rate(sr);
         }
 
+        /** @brief Sets how long coefficient updates with `glide` take to glide in, in samples.
+         *
+         * Usually the control period coefficients are updated at, `dsp::block_size` unless set.
+         */
+        void set_glide_time(const size_t samples) {
+            modes.set_glide_length(samples);
+        }
+
         /** @brief Update the internal coefficients of the modal filters
          * to use the updated parameters.
          *
          * Can be expensive, so don't call unnecessarily.
+         * @param glide Glide the coefficients to their new values over the glide time, rather than jumping,
+         * for a voice playing through a patch change. The spectral backend always jumps.
          */
-        void update_mode_coefficients() {
-            switch (foldback.mode) {
+        void update_mode_coefficients(const bool glide = false) {
+            const auto& p = *patch;
+            patch_modes = std::min(p.modes, maxModes);
+            currentModes = std::min(patch_modes, mode_limit);
+            switch (p.foldback) {
                 case ModalFoldbackKind::NyquistStop: {
-                    for (size_t i = 0; i < currentModes; i++) {
+                    for (size_t i = 0; i < patch_modes; i++) {
                         num mode_idx = static_cast<num>(i); // i
                         num mode_idx_p1 = mode_idx + 1; // k
-                        modal::dsp::num overtone = mode_idx_p1 * (1 + mode_idx * (inharmonicity * controls.freq_param_for_mode(i)));
-                        modal::dsp::num mode_freq = freq * std::pow(overtone, exponent);
-                        modal::dsp::num distance = (2.0_nm / std::pow((mode_idx + 1.0_nm), falloff)) * controls.gain_param_for_mode(
+                        modal::dsp::num overtone = mode_idx_p1 * (1 + mode_idx * (p.inharmonicity * p.controls.freq_param_for_mode(i)));
+                        modal::dsp::num mode_freq = freq * std::pow(overtone, p.exponent);
+                        modal::dsp::num distance = (2.0_nm / std::pow((mode_idx + 1.0_nm), p.falloff)) * p.controls.gain_param_for_mode(
                                 i);
-                        modes[i].set_params(mode_freq, distance, distance * decay);
+                        set_mode(i, mode_freq, distance, distance * p.decay, glide);
                     }
                     break;
                 }
                 case ModalFoldbackKind::Undertones: {
-                    for (size_t i = 0; i < currentModes; i++) {
+                    for (size_t i = 0; i < patch_modes; i++) {
                         num mode_idx = static_cast<num>(i); // i
                         num mode_idx_p1 = mode_idx + 1; // k
-                        modal::dsp::num overtone = mode_idx_p1 * (1 + mode_idx * (inharmonicity * controls.freq_param_for_mode(i)));
-                        modal::dsp::num mode_freq = freq / std::pow(overtone, exponent);
-                        modal::dsp::num distance = (2.0_nm / std::pow((mode_idx + 1.0_nm), falloff)) * controls.gain_param_for_mode(i);
-                        modes[i].set_params(mode_freq, distance, distance * decay);
+                        modal::dsp::num overtone = mode_idx_p1 * (1 + mode_idx * (p.inharmonicity * p.controls.freq_param_for_mode(i)));
+                        modal::dsp::num mode_freq = freq / std::pow(overtone, p.exponent);
+                        modal::dsp::num distance = (2.0_nm / std::pow((mode_idx + 1.0_nm), p.falloff)) * p.controls.gain_param_for_mode(i);
+                        set_mode(i, mode_freq, distance, distance * p.decay, glide);
                     }
                     break;
                 }
                 case ModalFoldbackKind::Foldback: {
-                    for (size_t i = 0; i < currentModes; i++) {
+                    for (size_t i = 0; i < patch_modes; i++) {
                         num mode_idx = static_cast<num>(i); // i
                         num mode_idx_p1 = mode_idx + 1; // k
-                        modal::dsp::num overtone = mode_idx_p1 * (1 + mode_idx * (inharmonicity * controls.freq_param_for_mode(i)));
-                        modal::dsp::num mode_freq = freq * std::pow(overtone, exponent);
+                        modal::dsp::num overtone = mode_idx_p1 * (1 + mode_idx * (p.inharmonicity * p.controls.freq_param_for_mode(i)));
+                        modal::dsp::num mode_freq = freq * std::pow(overtone, p.exponent);
                         // see https://www.desmos.com/calculator/2kbqwfyvjn
-                        if (mode_freq > foldback.foldback_point) {
-                            mode_freq = (2 * foldback.foldback_point) - mode_freq;
+                        if (mode_freq > p.foldback_point) {
+                            mode_freq = (2 * p.foldback_point) - mode_freq;
                         }
-                        modal::dsp::num distance = (2.0_nm / std::pow((mode_idx + 1.0_nm), falloff)) * controls.gain_param_for_mode(i);
-                        modes[i].set_params(mode_freq, distance, distance * decay);
+                        modal::dsp::num distance = (2.0_nm / std::pow((mode_idx + 1.0_nm), p.falloff)) * p.controls.gain_param_for_mode(i);
+                        set_mode(i, mode_freq, distance, distance * p.decay, glide);
                     }
                     break;
                 }
             }
-            osc_exciter.set_freq(freq / exciter_rate);
-            chirp_exciter.set_freq(freq / exciter_rate);
+            osc_exciter.set_freq(freq * bend_ratio / p.exciter_rate);
+            chirp_exciter.set_freq(freq * bend_ratio / p.exciter_rate);
         }
 
      private:
+        void set_mode(const size_t i, const modal::dsp::num mode_freq, const modal::dsp::num amplitude, const modal::dsp::num mode_decay,
+                      const bool glide) {
+            if constexpr (has_spectral_backend) {
+                if (uses_spectral_backend()) {
+                    spectral_modes.set_params(i, mode_freq, amplitude, mode_decay);
+                    return;
+                }
+            }
+            if (glide) {
+                modes.glide_params(i, mode_freq, amplitude, mode_decay);
+            } else {
+                modes.set_params(i, mode_freq, amplitude, mode_decay);
+            }
+        }
+
+        // one sample of the exciter, before its envelope, decimated when oversampled
+        modal::dsp::num exciter_sample() {
+            // noise doesn't alias, and a ping isn't generated per sample
+            if (exciter_oversampling > 1 && exciter != ModalExiterKind::Noise && exciter != ModalExiterKind::Impulse) {
+                // an impulse's weight is in one oversampled sample, so would be spread thinner by the decimator
+                const auto scale = exciter == ModalExiterKind::Impulses ? static_cast<modal::dsp::num>(exciter_oversampling)
+                                                                        : 1_nm;
+                modal::dsp::num out = 0;
+                for (size_t i = 0; i < exciter_oversampling; i++) {
+                    out = decimator.tick(excite() * scale);
+                }
+                return out;
+            }
+            return excite();
+        }
+
+        modal::dsp::num modes_tick(const modal::dsp::num in) {
+            if constexpr (has_spectral_backend) {
+                if (uses_spectral_backend()) {
+                    return spectral_modes.tick(in, currentModes);
+                }
+            }
+            return modes.tick(in, currentModes);
+        }
+
+        // one sample of the exciter, at the exciter's rate
+        modal::dsp::num excite() {
+            osc_exciter.tick();
+            const modal::dsp::num chirp_sig = chirp_exciter.tick();
+
+            switch (exciter) {
+                case ModalExiterKind::Noise:
+                    return noise.uniform(-0.05_nm, 0.05_nm);
+                case ModalExiterKind::Impulses:
+                    return osc::impulse_train(osc_exciter) * 0.6_nm;
+                case ModalExiterKind::Square:
+                    return osc::aa_rect(osc_exciter, 0.5_nm) * 0.2_nm;
+                case ModalExiterKind::Chirp:
+                    return chirp_sig * 0.2_nm;
+                case ModalExiterKind::Impulse:
+                    break;
+            }
+            return 0;
+        }
+
+        void set_exciter_rate() {
+            const auto rate = sample_rate * static_cast<modal::dsp::num>(exciter_oversampling);
+            osc_exciter.set_sample_rate(rate);
+            chirp_exciter.set_sample_rate(rate);
+        }
+
         void ping() {
-            for (size_t i = 0; i < currentModes; i++) {
-                modes[i].ping();
+            if constexpr (has_spectral_backend) {
+                if (uses_spectral_backend()) {
+                    spectral_modes.ping(currentModes);
+                    return;
+                }
             }
+            modes.ping(currentModes);
         }
     };
+
+    /** @brief Voice for bells, gongs and other spectra of hundreds to thousands of modes.
+     *
+     * Plays more than its `spectral_threshold()` modes on the spectral backend, so costs little more per sample
+     * than a 40 mode voice, but is large, so is made on the heap.
+     */
+    using LargeModalSynth = ModalSynth<2048>;
 }
@@ -0,0 +1,316 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <dsp/dsp.hpp>
+#include <dsp/mod.hpp>
+
+namespace modal::dsp::mod {
+    /** @brief Response curve applied to a source before it moves a target.
+     */
+    enum class ModCurve : uint8_t {
+        Linear,      ///< \f$ x \f$
+        Exponential, ///< \f$ x^2 \f$, slow to start
+        Logarithmic, ///< \f$ 1 - (1 - x)^2 \f$, fast to start
+        SCurve,      ///< \f$ 3x^2 - 2x^3 \f$, slow at both ends
+    };
+
+    /** @brief Applies a response curve to a value between 0-1.
+     */
+    modal::dsp::num apply_curve(ModCurve curve, modal::dsp::num x);
+
+    /** @brief A single connection from a modulation source to a target in a `ModMatrix`.
+     */
+    struct ModRoute {
+        /// Index of the source
+        size_t source;
+        /// Index of the target
+        size_t target;
+        /// Normalised target value with the source at 0
+        modal::dsp::num lo;
+        /// Normalised target value with the source at 1
+        modal::dsp::num hi;
+        /// Response to the source
+        ModCurve curve = ModCurve::Linear;
+    };
+
+    /** @brief One target of a macro, in a `MacroMap`.
+     */
+    struct MacroSlot {
+        /// `target` of an unused slot
+        static constexpr uint32_t unmapped = std::numeric_limits<uint32_t>::max();
+
+        /// Index of the target, or `unmapped`
+        uint32_t target = unmapped;
+        /// Index of the source, relative to the first source the map is added with
+        uint8_t source = 0;
+        /// Response to the macro
+        ModCurve curve = ModCurve::Linear;
+        /// Normalised target value with the macro at 0
+        float lo = 0;
+        /// Normalised target value with the macro at 1
+        float hi = 1;
+    };
+
+    /** @brief Fixed size table of a macro's (or other modulation source's) targets.
+     *
+     * Plain data, so it can be edited on the message thread and handed to the audio thread in a `TripleBuffer`.
+     */
+    struct MacroMap {
+        /// Number of targets a macro can have
+        static constexpr size_t max_slots = 4;
+
+        std::array<MacroSlot, max_slots> slots {};
+    };
+
+    /** @brief Start and per-sample step of a linear ramp, see `ModMatrix::ramp()`.
+     */
+    struct ModRamp {
+        /// Value at the start of the ramp
+        modal::dsp::num start;
+        /// Change per sample
+        modal::dsp::num step;
+    };
+
+    /** @brief Control-rate modulation matrix.
+     *
+     * Sources and targets are normalised to 0-1. Each target has a base value, usually a host parameter's.
+     * A route moves its target to `lerp(lo, hi, source)` in place of its base value.
+     * Offsets from the base of several routes to the same target add up.
+     *
+     * Routed values, and fading between them and the base values as routes are added and removed,
+     * are smoothed with a one-pole lowpass run once per control period by `process()`,
+     * so the modulated values can be applied to a patch without zipper noise or touching host state.
+     * Base values are only smoothed if given a smoothing time with `set_base_smoothing_time()`,
+     * ramping linearly to each new value, to turn a stream of parameter changes into one smooth change.
+     *
+     * Allocates all of its memory in the constructor, so can be used from the audio thread.
+     */
+    class ModMatrix {
+     public:
+        /// Default smoothing time constant, in seconds
+        static constexpr modal::dsp::num default_smoothing_time = 0.02_nm;
+
+        /** @brief Constructor.
+         *
+         * @param source_count Number of sources
+         * @param targets Number of targets
+         * @param route_limit Largest number of routes at once
+         */
+        ModMatrix(size_t source_count, size_t targets, size_t route_limit);
+
+        /** @brief Sets the sample rate used to work out the smoothing coefficient.
+         */
+        void set_sample_rate(modal::dsp::num sr);
+
+        /** @brief Sets the time constant of the offset smoothing.
+         *
+         * @param seconds Time constant, in seconds, 0 for no smoothing
+         */
+        void set_smoothing_time(modal::dsp::num seconds);
+
+        /** @brief Sets the ramp time of changes to base values.
+         *
+         * @param seconds Ramp time, in seconds, 0 for base values to change immediately
+         */
+        void set_base_smoothing_time(modal::dsp::num seconds);
+
+        /** @brief Jumps every base value to its latest value, ending their ramps.
+         */
+        void skip_base_smoothing();
+
+        /** @brief Sets the value of a source, between 0-1.
+         */
+        void set_source(size_t source, modal::dsp::num value);
+
+        /** @brief Sets the unmodulated value of a target, between 0-1.
+         *
+         * Takes effect from the next `process()`, ramped if base values are smoothed.
+         */
+        void set_base(size_t target, modal::dsp::num value);
+
+        /** @brief Removes every route.
+         *
+         * Targets that were routed smoothly return to their base values.
+         */
+        void clear_routes();
+
+        /** @brief Adds a route.
+         *
+         * @return `false` if the route was out of range or the matrix already had `max_routes` routes
+         */
+        bool add_route(const ModRoute& route);
+
+        /** @brief Adds a route for each mapped slot of a macro.
+         *
+         * Each slot's source is `source` plus the slot's own source index.
+         * @return `false` if any route couldn't be added, see `add_route()`
+         */
+        bool add_routes(const MacroMap& map, size_t source);
+
+        /** @brief Advances the smoothing by a control period.
+         *
+         * @param samples Length of the control period, in samples
+         * @return `true` if any target's value has changed since the last call
+         */
+        bool process(size_t samples);
+
+        /** @brief Modulated value of a target, between 0-1, as of the last `process()`.
+         */
+        [[nodiscard]] modal::dsp::num value(size_t target) const {
+            return values[target];
+        }
+
+        /** @brief Whether a target's value is, or is still fading back from, a routed value, as of the last `process()`.
+         *
+         * Targets that aren't are exactly at their base value.
+         */
+        [[nodiscard]] bool modulated(const size_t target) const {
+            return amount[target] > 0;
+        }
+
+        /** @brief Linear ramp of a target over the last control period, for targets read per sample.
+         *
+         * @param target Index of the target
+         * @param samples Length of the control period, in samples
+         */
+        [[nodiscard]] ModRamp ramp(size_t target, size_t samples) const {
+            return {previous[target], (values[target] - previous[target]) / static_cast<modal::dsp::num>(samples)};
+        }
+
+        /** @brief Number of targets.
+         */
+        [[nodiscard]] size_t num_targets() const {
+            return values.size();
+        }
+
+     private:
+        modal::dsp::num sample_rate = 48000;
+        modal::dsp::num smoothing_time = default_smoothing_time;
+
+        std::vector<modal::dsp::num> sources;
+        std::vector<ModRoute> routes;
+        size_t max_routes;
+
+        // per target
+        std::vector<modal::dsp::num> base;
+        std::vector<SmoothedValue> base_ramps;
+        std::vector<modal::dsp::num> goal;     // sum of routes' offsets from base
+        std::vector<modal::dsp::num> smoothed; // routed value
+        std::vector<modal::dsp::num> amount;   // 0 for the base value, to 1 for the routed value
+        std::vector<modal::dsp::num> values, previous;
+        std::vector<bool> routed;
+    };
+
+    /** @brief Control-rate modulation engine.
+     *
+     * Owns the modulation sources and a `ModMatrix` from them to a set of targets,
+     * and runs them once every control period rather than every sample.
+     * Sources are global rather than per voice: the envelope restarts on every note on,
+     * and releases when the last held key is released. Keys are tracked by note number, so a repeated note on
+     * of a held key doesn't need a note off of its own.
+     *
+     * Callers render at most `samples_until_update()` samples at a time, then call `advance()`,
+     * and apply the matrix's values to the patch when it returns `true`.
+     * Targets read per sample can use `ModMatrix::ramp()` to interpolate between control periods.
+     */
+    class ModEngine {
+     public:
+        /// Modulation sources, indices into the engine's `ModMatrix`
+        enum Source : size_t {
+            Macro1,
+            Macro2,
+            Lfo1,
+            Lfo2,
+            Envelope,
+            Random,
+            ModWheel,
+            Aftertouch,
+            Velocity,
+            Note,
+            num_sources
+        };
+
+        /// Shortest control period, in samples
+        static constexpr size_t min_control_period = 16;
+        /// Longest control period, in samples
+        static constexpr size_t max_control_period = 64;
+        /// Default control period, in samples
+        static constexpr size_t default_control_period = 32;
+
+        /** @brief Constructor.
+         *
+         * @param targets Number of targets
+         * @param max_routes Largest number of routes at once
+         */
+        ModEngine(size_t targets, size_t max_routes);
+
+        /** @brief Sets the internal sample rate of the sources and matrix.
+         */
+        void set_sample_rate(modal::dsp::num sr);
+
+        /** @brief Sets how often the sources and matrix are run.
+         *
+         * @param samples Control period, in samples, clamped to between `min_control_period` and `max_control_period`
+         */
+        void set_control_period(size_t samples);
+
+        /** @brief Control period, in samples.
+         */
+        [[nodiscard]] size_t control_period() const {
+            return period;
+        }
+
+        /** @brief Sets the value of an externally driven source (a macro or MIDI controller), between 0-1.
+         */
+        void set_source(Source source, modal::dsp::num value);
+
+        /** @brief Note on, sets the note and velocity sources and restarts the envelope.
+         *
+         * @param note MIDI note number, 0-127
+         * @param velocity Velocity, between 0-1
+         */
+        void note_on(int note, modal::dsp::num velocity);
+
+        /** @brief Note off, releases the envelope when no keys are held.
+         *
+         * @param note MIDI note number, 0-127
+         */
+        void note_off(int note);
+
+        /** @brief Number of samples until the sources and matrix are next run.
+         */
+        [[nodiscard]] size_t samples_until_update() const {
+            return period - elapsed;
+        }
+
+        /** @brief Advances by a number of samples, running the sources and matrix at the end of a control period.
+         *
+         * @param samples Number of samples, at most `samples_until_update()`
+         * @return `true` if the matrix ran and any target's value changed
+         */
+        bool advance(size_t samples);
+
+        /// @brief First LFO
+        Lfo lfo_1;
+        /// @brief Second LFO
+        Lfo lfo_2;
+        /// @brief Envelope
+        SegmentEnv envelope;
+        /// @brief Random sample and hold
+        SampleAndHold random;
+        /// @brief Matrix from the sources to the targets
+        ModMatrix matrix;
+
+     private:
+        size_t period = default_control_period;
+        size_t elapsed = 0;
+        std::bitset<128> held;
+    };
+}
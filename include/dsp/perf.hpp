@@ -0,0 +1,185 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <dsp/dsp.hpp>
+#include <dsp/lockfree.hpp>
+
+namespace modal::dsp::perf {
+    /// @brief Stages of a processed block, timed separately by a `Monitor`
+    enum class Stage : uint8_t {
+        /// MIDI, parameters, modulation and coefficient updates
+        Params = 0,
+        /// Exciters and envelopes
+        Exciter = 1,
+        /// Mode banks, along with the exciters when they run interleaved per sample
+        Modes = 2,
+        /// Formant filters
+        Formant = 3,
+        /// Mixing and writing the output buffer
+        Output = 4,
+    };
+    /// Number of `Stage`s
+    constexpr size_t num_stages = 5;
+
+    /// @brief Events counted by a `Monitor`
+    enum class Counter : uint8_t {
+        /// Voices that had their mode coefficients recomputed
+        CoefficientUpdates = 0,
+        /// Notes dropped because every voice was busy
+        NoteDrops = 1,
+    };
+    /// Number of `Counter`s
+    constexpr size_t num_counters = 2;
+
+    /** @brief Timings and counts of one processed block.
+     */
+    struct BlockStats {
+        /// Length of the block, in samples
+        uint32_t samples = 0;
+        /// Voices playing at the end of the block
+        uint32_t active_voices = 0;
+        /// Modes of the voices playing at the end of the block
+        uint32_t active_modes = 0;
+        /// Sample rate the block was processed at
+        float sample_rate = 0;
+        /// Time taken by the whole block, in nanoseconds
+        uint64_t total_ns = 0;
+        /// Time taken by each `Stage`, in nanoseconds
+        std::array<uint64_t, num_stages> stage_ns {};
+        /// Events of each `Counter` during the block
+        std::array<uint32_t, num_counters> counters {};
+    };
+
+    /** @brief Summary of recent blocks, from `Monitor::collect()`.
+     */
+    struct Summary {
+        /// Number of blocks summarised
+        size_t blocks = 0;
+        /// Time spent processing over time processed, 1 is a full core's worth of real time
+        double load = 0;
+        /// Mean block time, in nanoseconds
+        double mean_ns = 0;
+        /// 99th percentile block time, in nanoseconds
+        double p99_ns = 0;
+        /// Longest block time, in nanoseconds
+        double peak_ns = 0;
+        /// Share of the processing time spent in each `Stage`, between 0-1
+        std::array<double, num_stages> stage_share {};
+        /// Events of each `Counter`, since the monitor was created
+        std::array<uint64_t, num_counters> counters {};
+        /// Voices playing at the end of the latest block
+        uint32_t active_voices = 0;
+        /// Modes of the voices playing at the end of the latest block
+        uint32_t active_modes = 0;
+    };
+
+    /** @brief Times processed blocks by stage and counts events, for measuring the cost of an instance.
+     *
+     * The audio thread brackets each block with `begin_block()` and `end_block()`, attributing time to stages
+     * in between, and each finished block is queued in an `SpscRing` without waiting or allocating.
+     * Another thread, like an editor's timer or a benchmark, calls `collect()` to drain the queue
+     * and summarise the most recent `window` blocks.
+     */
+    class Monitor {
+     public:
+        /// Number of blocks queued between calls to `collect()`, later blocks are dropped
+        static constexpr size_t queue_size = 1024;
+        /// Number of recent blocks summarised by `collect()`
+        static constexpr size_t window = 1024;
+
+        Monitor();
+
+        /** @brief Current time of the monitor's clock, in nanoseconds.
+         */
+        static uint64_t now();
+
+        /** @brief Starts timing a block. Only call from the audio thread.
+         *
+         * @param samples Length of the block, in samples
+         * @param sample_rate Sample rate the block is processed at
+         */
+        void begin_block(size_t samples, modal::dsp::num sample_rate);
+
+        /** @brief Attributes the time since the last lap, or the start of the block, to a stage.
+         */
+        void lap(Stage stage);
+
+        /** @brief Restarts the lap without attributing the time since the last one,
+         * after code that timed its own stages with `add()`.
+         */
+        void skip_lap();
+
+        /** @brief Adds time to a stage.
+         *
+         * @param stage Stage to add to
+         * @param ns Time, in nanoseconds
+         */
+        void add(Stage stage, uint64_t ns) {
+            current.stage_ns[static_cast<size_t>(stage)] += ns;
+        }
+
+        /** @brief Counts events.
+         */
+        void count(Counter counter, uint32_t n = 1) {
+            current.counters[static_cast<size_t>(counter)] += n;
+        }
+
+        /** @brief Sets the number of voices and modes playing.
+         */
+        void set_active(size_t voices, size_t modes);
+
+        /** @brief Finishes timing a block and queues its stats.
+         */
+        void end_block();
+
+        /** @brief Drains queued blocks and summarises the most recent ones.
+         *
+         * Only call from one thread at a time, other than the audio thread.
+         * Allocates nothing after construction.
+         */
+        Summary collect();
+
+     private:
+        BlockStats current;
+        uint64_t block_start = 0, lap_start = 0;
+        std::unique_ptr<SpscRing<BlockStats, queue_size>> queue;
+
+        // reader side
+        std::vector<BlockStats> history;
+        size_t history_next = 0, history_count = 0;
+        std::vector<uint64_t> sorted;
+        std::array<uint64_t, num_counters> totals {};
+    };
+
+    /** @brief Adds the time until it's destroyed to a stage of a `Monitor`, or does nothing without one.
+     */
+    class ScopedStage {
+     public:
+        /** @brief Constructor.
+         *
+         * @param m Monitor to add to, can be `nullptr`
+         * @param s Stage to add to
+         */
+        ScopedStage(Monitor* m, const Stage s) : monitor{m}, stage{s}, start{m != nullptr ? Monitor::now() : 0} {}
+
+        ~ScopedStage() {
+            if (monitor != nullptr) {
+                monitor->add(stage, Monitor::now() - start);
+            }
+        }
+
+        ScopedStage(const ScopedStage&) = delete;
+        ScopedStage& operator=(const ScopedStage&) = delete;
+
+     private:
+        Monitor* monitor;
+        Stage stage;
+        uint64_t start;
+    };
+}
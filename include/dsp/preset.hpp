@@ -0,0 +1,153 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <dsp/modmatrix.hpp>
+
+namespace modal::dsp::preset {
+    /** @brief Identifier of a parameter in a `PatchState`, the 32 bit FNV-1a hash of its ID.
+     */
+    constexpr uint32_t param_id(const std::string_view id) {
+        uint32_t hash = 2166136261u;
+        for (const char c : id) {
+            hash = (hash ^ static_cast<uint8_t>(c)) * 16777619u;
+        }
+        return hash;
+    }
+
+    /** @brief Value of one parameter in a `PatchState`.
+     */
+    struct ParamValue {
+        /// `param_id()` of the parameter's ID
+        uint32_t id;
+        /// Value, in the parameter's own units rather than normalised, so it survives range changes
+        float value;
+    };
+
+    /** @brief Every setting of a plugin, as plain fixed size data.
+     *
+     * Trivially copyable and never allocates, so a preset can be decoded into preallocated storage
+     * and handed to the audio thread in a `TripleBuffer`.
+     * Macro slot targets are indices into `params`, so the state doesn't depend on the plugin's parameter order.
+     */
+    struct PatchState {
+        /// Most parameters a state holds
+        static constexpr size_t max_params = 64;
+        /// Most macro maps a state holds
+        static constexpr size_t max_macros = 4;
+
+        std::array<ParamValue, max_params> params {};
+        uint32_t num_params = 0;
+        std::array<modal::dsp::mod::MacroMap, max_macros> macros {};
+        uint32_t num_macros = 0;
+
+        /** @brief Sets the value of a parameter, adding it if it isn't in the state yet.
+         *
+         * @return `false` if the state already had `max_params` parameters
+         */
+        bool set(uint32_t id, float value);
+
+        /** @brief Index of a parameter in `params`, or nothing if it isn't in the state.
+         */
+        [[nodiscard]] std::optional<size_t> find(uint32_t id) const;
+    };
+
+    /// Version written by `encode()`
+    constexpr uint16_t format_version = 1;
+
+    /** @brief Appends the binary encoding of a state to `out`.
+     *
+     * The encoding is little endian, starts with a magic number and `format_version`,
+     * and records the number of slots per macro, so it can be read back by later versions.
+     */
+    void encode(const PatchState& state, std::vector<uint8_t>& out);
+
+    /** @brief Whether `data` starts like an encoded state, of any version.
+     */
+    bool is_encoded(std::span<const uint8_t> data);
+
+    /** @brief Decodes a state, without allocating.
+     *
+     * Reads every format version up to `format_version`. Macro maps saved with fewer slots than
+     * `mod::MacroMap::max_slots` are padded with unmapped slots, and extra slots are dropped.
+     * @return `false` if the data is truncated, from a later format version, or not a state at all,
+     * in which case `out` is unspecified
+     */
+    bool decode(std::span<const uint8_t> data, PatchState& out);
+
+    /** @brief A named state, for writing a `PresetLibrary`.
+     */
+    struct Preset {
+        std::string name;
+        PatchState state;
+    };
+
+    /** @brief Read-only library of presets, stored in a single memory-mapped file.
+     *
+     * The file starts with an index of fixed size entries holding each preset's name, offset and size,
+     * followed by the encoded states. Opening a library only maps and checks the index,
+     * so browsing names is as cheap as reading memory, and states are only decoded when loaded.
+     */
+    class PresetLibrary {
+     public:
+        /// Longest preset name, in bytes
+        static constexpr size_t max_name = 55;
+
+        PresetLibrary() = default;
+        ~PresetLibrary();
+        PresetLibrary(PresetLibrary&& other) noexcept;
+        PresetLibrary& operator=(PresetLibrary&& other) noexcept;
+        PresetLibrary(const PresetLibrary&) = delete;
+        PresetLibrary& operator=(const PresetLibrary&) = delete;
+
+        /** @brief Writes a library file, replacing any existing file.
+         *
+         * Names longer than `max_name` are truncated.
+         * @return `false` if the file couldn't be written
+         */
+        static bool write(const std::string& path, std::span<const Preset> presets);
+
+        /** @brief Maps a library file, closing any library already open.
+         *
+         * @return `false` if the file couldn't be mapped or isn't a valid library, leaving the library empty
+         */
+        bool open(const std::string& path);
+
+        /** @brief Unmaps the file, leaving the library empty.
+         */
+        void close();
+
+        /** @brief Number of presets.
+         */
+        [[nodiscard]] size_t size() const {
+            return count;
+        }
+
+        /** @brief Name of a preset, valid until the library is closed.
+         */
+        [[nodiscard]] std::string_view name(size_t index) const;
+
+        /** @brief Index of the first preset with a name, or nothing if there isn't one.
+         */
+        [[nodiscard]] std::optional<size_t> find(std::string_view preset_name) const;
+
+        /** @brief Decodes a preset's state, without allocating.
+         *
+         * @return `false` if the index is out of range or the state is invalid
+         */
+        bool load(size_t index, PatchState& out) const;
+
+     private:
+        const uint8_t* data = nullptr;
+        size_t length = 0;
+        size_t count = 0;
+    };
+}
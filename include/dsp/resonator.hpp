@@ -1,10 +1,24 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 
 #pragma once
+#include <algorithm>
+#include <array>
+#include <cmath>
 #include <complex>
+#include <cstdint>
 #include "dsp.hpp"
+#include "simd.hpp"
 
 namespace modal::dsp::physical::filters {
+    /** @brief Recursion coefficient of a modal resonator
+     *
+     * @param freq Frequency, in Hz
+     * @param decay Decay time (to -60dB), in seconds
+     * @param sample_rate Sample rate, in Hz
+     * @return Complex coefficient, whose angle sets the frequency and magnitude sets the decay
+     */
+    std::complex<modal::dsp::num> phasor_coeff(modal::dsp::num freq, modal::dsp::num decay, modal::dsp::num sample_rate);
+
     /** @brief Modal resonator
      *
      * This implements a modal resonator, which resonates when excited
@@ -55,4 +69,291 @@ namespace modal::dsp::physical::filters {
         std::complex<modal::dsp::num> filter_coeff;
         bool play = true;
     };
+
+    /** @brief Bank of modal resonators, processed together
+     *
+     * Equivalent to an array of `PhasorResonator`s whose outputs are summed,
+     * but stores its state as aligned structure-of-arrays so the whole bank can be
+     * ticked by one of the vectorised `simd::Kernels`.
+     *
+     * Modes above Nyquist (or at or below 0Hz) are silenced by zeroing their coefficients.
+     * The whole bank can be bent in pitch by rotating its coefficients, without recomputing them, see `bend()`.
+     *
+     * Is a [DSP class](docs/DSP Coding Standards.md).
+     * @tparam maxModes Maximum number of modes in the bank
+     */
+    template <size_t maxModes>
+    class PhasorResonatorBank {
+        // padded to a whole number of the widest vectors so kernels never need a scalar tail
+        static constexpr size_t padded = (maxModes + 15) / 16 * 16;
+
+        // parameters only used when setting coefficients come first,
+        // so the per-sample arrays sit at the end, next to whatever the owner keeps after the bank
+        std::array<modal::dsp::num, maxModes> f {}, t {}, a {};
+        modal::dsp::num sample_rate = 48000;
+        modal::dsp::num bend_ratio = 1;
+        // bends by rotation since the coefficients were last computed, each drifts their decay by a rounding error
+        uint32_t rotations = 0;
+        static constexpr uint32_t max_rotations = 64;
+        // smallest change of bend ratio that rotates the modes, under a fiftieth of a cent
+        static constexpr modal::dsp::num min_shift = 1e-5_nm;
+
+        // samples `tick()` glides over, and left of the glide in progress, 0 unless gliding
+        uint32_t glide_length = block_size;
+        uint32_t glide_left = 0;
+
+        // coefficients set by `glide_params()`, only read while gliding to them
+        alignas(64) std::array<modal::dsp::num, padded> target_re {};
+        alignas(64) std::array<modal::dsp::num, padded> target_im {};
+        alignas(64) std::array<modal::dsp::num, padded> target_amp {};
+
+        alignas(64) std::array<modal::dsp::num, padded> coeff_re {};
+        alignas(64) std::array<modal::dsp::num, padded> coeff_im {};
+        alignas(64) std::array<modal::dsp::num, padded> amp {};
+        alignas(64) std::array<modal::dsp::num, padded> y_re {};
+        alignas(64) std::array<modal::dsp::num, padded> y_im {};
+
+     public:
+        /** @brief Sets the internal sample rate of the bank.
+         *
+         * Behaves as described in [the DSP coding standards](docs/DSP Coding Standards.md)
+         */
+        void set_sample_rate(modal::dsp::num sr) {
+            sample_rate = sr;
+            for (size_t i = 0; i < maxModes; i++) {
+                set_params(i, f[i], a[i], t[i]);
+            }
+        }
+
+        /** @brief Set the parameters of a single mode
+         *
+         * @param mode Index of the mode to set
+         * @param freq Frequency, in Hz
+         * @param amplitude Initial amplitude
+         * @param decay Decay time, in seconds.
+         */
+        void set_params(size_t mode, modal::dsp::num freq, modal::dsp::num amplitude, modal::dsp::num decay) {
+            coefficients(mode, freq, amplitude, decay, coeff_re[mode], coeff_im[mode], amp[mode]);
+            target_re[mode] = coeff_re[mode];
+            target_im[mode] = coeff_im[mode];
+            target_amp[mode] = amp[mode];
+        }
+
+        /** @brief Set the parameters of a single mode, gliding to them over the next block.
+         *
+         * As `set_params()`, but the coefficients move linearly to the new values, so parameters changed at control
+         * rate don't step: over the next `process_block()`, or over the next `set_glide_length()` samples of `tick()`.
+         * Setting more modes mid-glide restarts it, from wherever the coefficients have got to.
+         */
+        void glide_params(size_t mode, modal::dsp::num freq, modal::dsp::num amplitude, modal::dsp::num decay) {
+            coefficients(mode, freq, amplitude, decay, target_re[mode], target_im[mode], target_amp[mode]);
+            glide_left = glide_length;
+        }
+
+        /** @brief Sets the number of samples `tick()` glides to coefficients set by `glide_params()` over.
+         *
+         * Usually the control period, so each glide ends as the next change arrives. `dsp::block_size` unless set.
+         */
+        void set_glide_length(const size_t samples) {
+            glide_length = static_cast<uint32_t>(std::max<size_t>(samples, 1));
+        }
+
+        /** @brief Bends the frequency of every mode by a ratio, keeping their decay times.
+         *
+         * Rotates each mode's coefficient by the change in its angle since the last bend, a few multiplies per mode,
+         * rather than recomputing it, so it can follow a pitch bend every control period.
+         * Modes bent across Nyquist are recomputed, as is every mode once in `max_rotations` bends, before rounding
+         * errors add up. The bend also applies to modes set after it, and to a glide in progress.
+         * Changes too small to hear are held back until the bends add up to more.
+         * @param ratio Frequency ratio to the frequencies the modes were set to, e.g. 2 for an octave up
+         * @param count Number of modes to bend, the others are bent when they're next set
+         */
+        void bend(const modal::dsp::num ratio, const size_t count) {
+            const auto shift = ratio - bend_ratio;
+            // smaller changes are held back until they add up to one worth rotating for
+            if (std::abs(shift) < min_shift) {
+                return;
+            }
+            bend_ratio = ratio;
+            const bool recompute = ++rotations > max_rotations;
+            if (recompute) {
+                rotations = 0;
+            }
+            const auto angle_per_hz = nums::tau * shift / sample_rate;
+            for (size_t i = 0; i < count; i++) {
+                const auto bent = f[i] * ratio;
+                // silenced modes are zeroed, so have no angle to rotate, while every mode playing has a radius near 1
+                const bool silent = coeff_re[i] * coeff_re[i] + coeff_im[i] * coeff_im[i] < 0.25_nm;
+                if (recompute || silent || bent <= 0 || bent >= sample_rate / 2) {
+                    // gliding modes carry on from where they are, to their recomputed targets
+                    coefficients(i, f[i], a[i], t[i], target_re[i], target_im[i], target_amp[i]);
+                    if (glide_left == 0) {
+                        coeff_re[i] = target_re[i];
+                        coeff_im[i] = target_im[i];
+                        amp[i] = target_amp[i];
+                    }
+                } else {
+                    rotate(i, f[i] * angle_per_hz);
+                }
+            }
+        }
+
+        /** @brief Moves the decay of the first `count` modes a step towards a release decay, shorter for higher modes.
+         *
+         * Each call scales the radius of each mode's coefficient, and of its glide target, until it's no longer than
+         * the release decay's.
+         * The release decay is approximated from the coefficient itself, as a per-sample loss of
+         * `rate * (1 + tilt * (1 - cos(angle)))`, so costs a few multiplies per mode.
+         * @param rate Per-sample loss of radius of the release decay at 0Hz, e.g. 6.9 / (decay time * sample rate)
+         * @param tilt How much faster higher modes are released, up to `1 + 2 * tilt` times at Nyquist
+         * @param step Fraction of the way to move, from the mode's own decay to the release decay
+         */
+        void damp(const modal::dsp::num rate, const modal::dsp::num tilt, const modal::dsp::num step, const size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                const auto re = coeff_re[i], im = coeff_im[i];
+                // the coefficient's radius is close to 1, so its real part stands in for the cosine of its angle
+                const auto loss = std::min(rate * (1 + tilt * (1 - re)), 0.5_nm);
+                const auto target = 1 - loss;
+                const auto scale = 1 - loss * step;
+                if ((re * re + im * im) * scale * scale > target * target) {
+                    coeff_re[i] = re * scale;
+                    coeff_im[i] = im * scale;
+                    target_re[i] *= scale;
+                    target_im[i] *= scale;
+                }
+            }
+        }
+
+        /** @brief Sum of the squared magnitudes of the first `count` modes' states.
+         *
+         * The output of the modes is at most the square root of `count` times this.
+         */
+        [[nodiscard]] modal::dsp::num energy(const size_t count) const {
+            modal::dsp::num sum = 0;
+            for (size_t i = 0; i < count; i++) {
+                sum += y_re[i] * y_re[i] + y_im[i] * y_im[i];
+            }
+            return sum;
+        }
+
+        /** @brief Excite the first `count` modes so they will ring out, using the set parameters
+         */
+        void ping(size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                y_re[i] = amp[i];
+                y_im[i] = 0;
+            }
+        }
+
+        /** @brief Stops modes `from` up to `to` ringing, so they start from silence when they're next processed.
+         */
+        void silence(size_t from, size_t to) {
+            for (size_t i = from; i < to; i++) {
+                y_re[i] = 0;
+                y_im[i] = 0;
+            }
+        }
+
+        /** @brief Whether a glide set by `glide_params()` is in progress.
+         */
+        [[nodiscard]] bool gliding() const {
+            return glide_left > 0;
+        }
+
+        /** @brief Processes a single audio sample through the first `count` modes.
+         *
+         * Behaves as described in [the DSP coding standards](docs/DSP Coding Standards.md)
+         */
+        modal::dsp::num tick(modal::dsp::num in, size_t count) {
+            if (glide_left > 0) {
+                glide_step(count);
+            }
+            return simd::kernels().resonator_bank(coeff_re.data(), coeff_im.data(), amp.data(),
+                                                  y_re.data(), y_im.data(), count, in);
+        }
+
+        /** @brief Processes a block of audio through the first `count` modes.
+         *
+         * Equivalent to calling `tick()` for every sample, but faster.
+         * @param in Array of `n` input samples
+         * @param out Array of `n` output samples, overwritten
+         * @param n Number of samples, at most `dsp::block_size`
+         * @param count Number of modes
+         */
+        void process_block(const modal::dsp::num* in, modal::dsp::num* out, size_t n, size_t count) {
+            if (glide_left > 0) {
+                simd::kernels().resonator_bank_block_glide(coeff_re.data(), coeff_im.data(), amp.data(),
+                                                           target_re.data(), target_im.data(), target_amp.data(),
+                                                           y_re.data(), y_im.data(), count, in, out, n);
+                // modes past `count` aren't running, so can jump
+                finish_glide();
+                return;
+            }
+            simd::kernels().resonator_bank_block(coeff_re.data(), coeff_im.data(), amp.data(),
+                                                 y_re.data(), y_im.data(), count, in, out, n);
+        }
+
+     private:
+        void coefficients(size_t mode, modal::dsp::num freq, modal::dsp::num amplitude, modal::dsp::num decay,
+                          modal::dsp::num& re, modal::dsp::num& im, modal::dsp::num& gain) {
+            f[mode] = freq;
+            a[mode] = amplitude;
+            t[mode] = decay;
+
+            // don't generate sound if we've above nyquist
+            const auto bent = freq * bend_ratio;
+            if (bent > 0 && bent < sample_rate / 2) {
+                const auto c = phasor_coeff(bent, decay, sample_rate);
+                re = c.real();
+                im = c.imag();
+                gain = amplitude;
+            } else {
+                re = 0;
+                im = 0;
+                gain = 0;
+            }
+        }
+
+        void rotate(const size_t mode, const modal::dsp::num angle) {
+            modal::dsp::num c, s;
+            // bends arrive in small steps, where a short series is exact to well within rounding
+            if (std::abs(angle) < 0.05_nm) {
+                const auto a2 = angle * angle;
+                c = 1 - a2 * (0.5_nm - a2 * (1 / 24.0_nm));
+                s = angle * (1 - a2 * (1 / 6.0_nm - a2 * (1 / 120.0_nm)));
+            } else {
+                c = std::cos(angle);
+                s = std::sin(angle);
+            }
+            const auto re = coeff_re[mode] * c - coeff_im[mode] * s;
+            coeff_im[mode] = coeff_re[mode] * s + coeff_im[mode] * c;
+            coeff_re[mode] = re;
+            // a glide in progress bends with it, rotating both ends of a line rotates every point along it
+            const auto target = target_re[mode] * c - target_im[mode] * s;
+            target_im[mode] = target_re[mode] * s + target_im[mode] * c;
+            target_re[mode] = target;
+        }
+
+        // moves the first `count` modes' coefficients a sample of the way along their glide,
+        // modes past `count` aren't running, so jump at the end
+        void glide_step(const size_t count) {
+            if (--glide_left == 0) {
+                finish_glide();
+                return;
+            }
+            const auto fraction = 1 / static_cast<modal::dsp::num>(glide_left + 1);
+            for (size_t i = 0; i < count; i++) {
+                coeff_re[i] += (target_re[i] - coeff_re[i]) * fraction;
+                coeff_im[i] += (target_im[i] - coeff_im[i]) * fraction;
+                amp[i] += (target_amp[i] - amp[i]) * fraction;
+            }
+        }
+
+        void finish_glide() {
+            coeff_re = target_re;
+            coeff_im = target_im;
+            amp = target_amp;
+            glide_left = 0;
+        }
+    };
 }
\ No newline at end of file
@@ -0,0 +1,64 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace modal::dsp::rt {
+    /// @brief Kinds of realtime-unsafe calls caught on a thread marked by `ScopedRealtime`
+    enum class Violation : uint8_t {
+        /// `operator new`, `malloc` and friends
+        Allocation = 0,
+        /// `operator delete` and `free`
+        Deallocation = 1,
+        /// Acquiring a mutex, which can wait on a lower priority thread
+        Lock = 2,
+    };
+    /// Number of `Violation`s
+    constexpr size_t num_violations = 3;
+
+    /** @brief Marks the current thread as running realtime code until the scope ends.
+     *
+     * Processors open one for the whole of `processBlock()`. Scopes nest.
+     * Nothing is checked unless the binary is linked with the realtime check hooks, as the test suites are,
+     * so outside of those this only costs a thread local increment per block.
+     */
+    class ScopedRealtime {
+     public:
+        ScopedRealtime();
+        ~ScopedRealtime();
+
+        ScopedRealtime(const ScopedRealtime&) = delete;
+        ScopedRealtime& operator=(const ScopedRealtime&) = delete;
+    };
+
+    /** @brief Whether the current thread is inside a `ScopedRealtime`, and not already reporting a violation.
+     */
+    bool in_realtime();
+
+    /** @brief Records a realtime-unsafe call if the current thread is inside a `ScopedRealtime`.
+     *
+     * Called by the check hooks. The first few violations print their kind and a stack trace to stderr,
+     * the rest are only counted. Calls made while reporting, like the stack trace's own allocations, are ignored.
+     */
+    void check(Violation kind);
+
+    /** @brief Number of violations of a kind since the last `reset()`, from every thread.
+     */
+    size_t violations(Violation kind);
+
+    /** @brief Number of violations of every kind since the last `reset()`, from every thread.
+     */
+    size_t violations();
+
+    /** @brief Zeroes the violation counts.
+     */
+    void reset();
+
+    /** @brief Sets whether violations print stack traces, on by default.
+     *
+     * Tests that cause violations on purpose turn this off to keep their output clean.
+     */
+    void set_reporting(bool enabled);
+}
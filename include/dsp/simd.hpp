@@ -0,0 +1,118 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string_view>
+
+#include <dsp/dsp.hpp>
+
+namespace modal::dsp::simd {
+    /** @brief Instruction set levels that the hot DSP kernels are compiled for.
+     *
+     * Every level is compiled into the same binary, and one is picked at runtime by `kernels()`.
+     * On non-x86 targets (e.g. the arm64 half of a universal build) only `Generic` is available.
+     */
+    enum class Isa {
+        /// Plain C++, whatever the compiler targets by default
+        Generic = 0,
+        /// x86-64 baseline, 128-bit vectors
+        SSE2 = 1,
+        /// 256-bit vectors with fused multiply-add
+        AVX2 = 2,
+        /// 512-bit vectors
+        AVX512 = 3
+    };
+
+    /** @brief Coefficients and state for a bank of four parallel biquads.
+     *
+     * Stored as structure-of-arrays so that the four filters can be processed as one vector.
+     * Coefficients are normalised (divided through by a0).
+     */
+    struct alignas(64) BiquadBank {
+        /// Number of filters in the bank
+        static constexpr size_t size = 4;
+        /// @private
+        modal::dsp::num b0[size] = {}, b1[size] = {}, b2[size] = {}, a1[size] = {}, a2[size] = {};
+        /// @private
+        modal::dsp::num gain[size] = {};
+        /// @private
+        modal::dsp::num x1[size] = {}, x2[size] = {}, y1[size] = {}, y2[size] = {};
+    };
+
+    /** @brief Table of the hot DSP kernels for one instruction set.
+     *
+     * All kernels have identical behaviour across instruction sets,
+     * apart from the rounding differences that come from vectorised summation and FMA.
+     */
+    struct Kernels {
+        /// Instruction set these kernels were compiled for
+        Isa isa;
+
+        /** @brief Ticks a bank of `physical::filters::PhasorResonator`-style modes by a single sample.
+         *
+         * Each mode computes \f$ y_k = a_k x + c_k y_k \f$ with complex \f$ c_k \f$ and \f$ y_k \f$.
+         *
+         * @return Sum of the imaginary parts of every mode
+         */
+        modal::dsp::num (*resonator_bank)(const modal::dsp::num* coeff_re, const modal::dsp::num* coeff_im,
+                                          const modal::dsp::num* amp, modal::dsp::num* y_re, modal::dsp::num* y_im,
+                                          size_t count, modal::dsp::num in);
+
+        /** @brief Processes a block through a bank of modes, as `resonator_bank` but a block at a time.
+         *
+         * Keeps each mode's state in registers for the whole block.
+         * `out[i]` is set to the sum of every mode's output for `in[i]`, `n` must be at most `dsp::block_size`.
+         */
+        void (*resonator_bank_block)(const modal::dsp::num* coeff_re, const modal::dsp::num* coeff_im,
+                                     const modal::dsp::num* amp, modal::dsp::num* y_re, modal::dsp::num* y_im,
+                                     size_t count, const modal::dsp::num* in, modal::dsp::num* out, size_t n);
+
+        /** @brief As `resonator_bank_block`, with the coefficients gliding linearly to new values over the block.
+         *
+         * Each sample steps `coeff_re`, `coeff_im` and `amp` a further \f$ 1/n \f$ of the way to the targets,
+         * reaching them on the last sample, and they're left set to the targets after.
+         * Linear interpolation between two stable poles stays inside the unit circle, so glides are always stable.
+         */
+        void (*resonator_bank_block_glide)(modal::dsp::num* coeff_re, modal::dsp::num* coeff_im, modal::dsp::num* amp,
+                                           const modal::dsp::num* target_re, const modal::dsp::num* target_im,
+                                           const modal::dsp::num* target_amp, modal::dsp::num* y_re,
+                                           modal::dsp::num* y_im, size_t count, const modal::dsp::num* in,
+                                           modal::dsp::num* out, size_t n);
+
+        /** @brief Ticks a `BiquadBank` by a single sample, with all filters fed the same input.
+         *
+         * @return Gain-weighted sum of the filter outputs
+         */
+        modal::dsp::num (*biquad_bank)(BiquadBank& bank, modal::dsp::num in);
+    };
+
+    /** @brief Kernels selected for this process.
+     *
+     * Selected once, on first call, from the best instruction set the CPU supports
+     * or from the `MODAL_SIMD` environment variable if it is set (see `isa_from_name()`).
+     * An override for an instruction set the CPU lacks falls back to the detected one.
+     */
+    const Kernels& kernels();
+
+    /** @brief Kernels for a specific instruction set, regardless of CPU support.
+     *
+     * Used for testing and benchmarking, calling kernels the CPU doesn't support will crash.
+     */
+    const Kernels& kernels_for(Isa isa);
+
+    /** @brief Best instruction set supported by the CPU running this process.
+     */
+    Isa detect_isa();
+
+    /** @brief Human-readable name of an instruction set, e.g. `"avx2"`.
+     */
+    std::string_view isa_name(Isa isa);
+
+    /** @brief Parses an instruction set name, as used in the `MODAL_SIMD` environment variable.
+     *
+     * Accepts `generic`, `sse2`, `avx2` and `avx512`.
+     */
+    std::optional<Isa> isa_from_name(std::string_view name);
+}
@@ -0,0 +1,179 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <complex>
+#include <vector>
+
+#include <dsp/dsp.hpp>
+
+namespace modal::dsp::spectral {
+    /** @brief Radix-2 complex FFT of a fixed size.
+     *
+     * Twiddles and the bit reversal table are calculated in the constructor,
+     * so transforms don't allocate.
+     */
+    class FFT {
+     public:
+        /** @brief Constructor.
+         *
+         * @param points Size of the transform, must be a power of two
+         */
+        explicit FFT(size_t points);
+
+        /** @brief In-place forward transform, \f$ X_b = \sum_n x_n e^{-j 2 \pi b n / N} \f$
+         */
+        void forward(std::complex<modal::dsp::num>* data) const;
+
+        /** @brief In-place inverse transform, including the \f$ 1/N \f$ scaling
+         */
+        void inverse(std::complex<modal::dsp::num>* data) const;
+
+        /** @brief Size of the transform
+         */
+        [[nodiscard]] size_t size() const {
+            return n;
+        }
+
+     private:
+        void transform(std::complex<modal::dsp::num>* data, bool invert) const;
+
+        size_t n;
+        std::vector<std::complex<modal::dsp::num>> twiddles;
+        std::vector<size_t> bit_reversed;
+    };
+
+    /** @brief Bank of modes synthesised by overlap-add inverse FFT.
+     *
+     * A drop-in alternative to `physical::filters::PhasorResonatorBank` for very large numbers of modes.
+     * Rather than running every mode's recursion each sample, each mode's state is advanced once per hop,
+     * and the modes are synthesised together by adding each one's windowed spectrum (a few bins around its frequency)
+     * into a single frame, which is inverse-FFTed and overlap-added with 50% overlap.
+     * The cost per sample is then roughly \f$ (7 \cdot modes + 2 N \log N) / H \f$ instead of \f$ 4 \cdot modes \f$.
+     *
+     * Input (from an exciter) is FFTed a hop at a time and each mode is driven by the bin nearest its frequency.
+     * The whole bank can be bent in pitch without setting its modes again, see `bend()`.
+     * Approximations compared to the recursive bank:
+     * - output is delayed by `latency()` samples, and `ping()` is quantised to the next hop
+     * - a mode's amplitude is held over a frame and crossfaded to the next, so modes decaying much faster than a hop are smeared
+     * - the window's spectrum is truncated to `lobe_width` bins, so each mode has about -40dB of sidelobe error
+     *
+     * Is a [DSP class](docs/DSP Coding Standards.md).
+     */
+    class SpectralModalBank {
+     public:
+        /// Default hop size, in samples
+        static constexpr size_t default_hop = 128;
+        /// Number of bins of each mode's window spectrum that are synthesised
+        static constexpr size_t lobe_width = 7;
+
+        /** @brief Constructor.
+         *
+         * Allocates all of the bank's memory.
+         * @param max_modes Maximum number of modes in the bank
+         * @param hop_size Hop size, in samples, must be a power of two. The frame is twice this.
+         */
+        explicit SpectralModalBank(size_t max_modes = 0, size_t hop_size = default_hop);
+
+        /** @brief Sets the internal sample rate of the bank.
+         *
+         * Behaves as described in [the DSP coding standards](docs/DSP Coding Standards.md)
+         */
+        void set_sample_rate(modal::dsp::num sr);
+
+        /** @brief Set the parameters of a single mode
+         *
+         * @param mode Index of the mode to set
+         * @param freq Frequency, in Hz
+         * @param amplitude Initial amplitude
+         * @param decay Decay time, in seconds.
+         */
+        void set_params(size_t mode, modal::dsp::num freq, modal::dsp::num amplitude, modal::dsp::num decay);
+
+        /** @brief Bends the frequency of every mode by a ratio, keeping their decay times.
+         *
+         * Takes effect at the start of the next hop, where each mode's coefficients are turned to the bent frequency
+         * from the decay kept when it was set, a few sines and cosines per mode, so it can follow a pitch bend.
+         * The bend also applies to modes set after it.
+         * @param ratio Frequency ratio to the frequencies the modes were set to, e.g. 2 for an octave up
+         * @param count Number of modes to bend, the others are bent when they're next set
+         */
+        void bend(modal::dsp::num ratio, size_t count);
+
+        /** @brief Moves the decay of the first `count` modes a step towards a release decay, shorter for higher modes.
+         *
+         * As `physical::filters::PhasorResonatorBank::damp()`, scaling the radii of each mode's per-sample and per-hop
+         * coefficients, which bends keep. The per-hop scale is the per-sample one raised to the hop size by squaring,
+         * so costs a few more multiplies per mode. Setting a mode again undoes its damping.
+         * @param rate Per-sample loss of radius of the release decay at 0Hz, e.g. 6.9 / (decay time * sample rate)
+         * @param tilt How much faster higher modes are released, up to `1 + 2 * tilt` times at Nyquist
+         * @param step Fraction of the way to move, from the mode's own decay to the release decay
+         */
+        void damp(modal::dsp::num rate, modal::dsp::num tilt, modal::dsp::num step, size_t count);
+
+        /** @brief Excite the first `count` modes at the start of the next hop, using the set parameters
+         */
+        void ping(size_t count);
+
+        /** @brief Processes a single audio sample through the first `count` modes.
+         *
+         * Behaves as described in [the DSP coding standards](docs/DSP Coding Standards.md),
+         * apart from the output being delayed by `latency()` samples.
+         */
+        modal::dsp::num tick(modal::dsp::num in, size_t count);
+
+        /** @brief Sum of the squared magnitudes of the first `count` modes' states, as of the latest hop.
+         *
+         * Modes waiting for a `ping()` count with their amplitude. While input from the hop in progress hasn't reached
+         * the modes, there's no telling, so it's infinite.
+         */
+        [[nodiscard]] modal::dsp::num energy(size_t count) const;
+
+        /** @brief Silences every mode and clears the overlap-add buffers.
+         */
+        void reset();
+
+        /** @brief Delay of the output, in samples.
+         */
+        [[nodiscard]] size_t latency() const {
+            return hop;
+        }
+
+     private:
+        void process_hop(size_t count);
+
+        // sets a mode's coefficients from its frequency, bent, and its radii
+        void tune(size_t mode);
+
+        size_t hop;
+        FFT fft;
+        modal::dsp::num sample_rate = 48000;
+        size_t position = 0;
+        size_t pending_ping = 0;
+        bool input_silent = true;
+        modal::dsp::num bend_ratio = 1;
+        // modes to bend at the start of the next hop
+        size_t bend_pending = 0;
+
+        // per mode, as structure-of-arrays so the per-hop updates vectorise
+        std::vector<modal::dsp::num> f, t, a;
+        std::vector<modal::dsp::num> amp;                // zero for silenced modes
+        std::vector<modal::dsp::num> radius, hop_radius; // of the coefficients, per sample and per hop, which bends keep
+        std::vector<modal::dsp::num> coeff_re, coeff_im; // per sample
+        std::vector<modal::dsp::num> hop_re, hop_im;     // per hop, coeff^hop
+        std::vector<modal::dsp::num> in_re, in_im;       // aligns the input spectrum to the end of the hop
+        std::vector<modal::dsp::num> state_re, state_im; // at the latest hop boundary
+        std::vector<modal::dsp::num> y_re, y_im;         // a sample after the latest hop boundary
+        std::vector<size_t> nearest_bin;
+        std::vector<modal::dsp::num> lobe;               // lobe_width window spectrum weights per mode
+
+        // per hop
+        std::vector<modal::dsp::num> in_block, out_block, overlap;
+        std::vector<std::complex<modal::dsp::num>> frame;
+
+        // window spectrum around its peak, see `window_spectrum()`
+        std::vector<modal::dsp::num> window_table;
+
+        [[nodiscard]] modal::dsp::num window_spectrum(modal::dsp::num offset_bins) const;
+    };
+}
@@ -0,0 +1,72 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <cstdint>
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_events/juce_events.h>
+
+#include "dsp/lockfree.hpp"
+
+namespace modal::ui {
+    /** @brief On-screen keyboard state, shared with the audio thread without locking.
+     *
+     * `juce::MidiKeyboardState::processNextMidiBuffer()` takes a lock on the audio thread. Instead, keys played
+     * on the on-screen keyboard are queued for the audio thread to `drain()`, and notes from the host
+     * are queued back with `show()`, then shown on the keyboard by a timer on the message thread.
+     * A full queue drops notes rather than waiting.
+     */
+    class KeyboardBridge final : private juce::MidiKeyboardState::Listener, private juce::Timer {
+     public:
+        /** @brief A note on or off, queued between threads.
+         */
+        struct NoteEvent {
+            /// MIDI channel, 1-16
+            uint8_t channel;
+            /// MIDI note number
+            uint8_t note;
+            /// Whether the note starts or ends
+            bool on;
+            /// Velocity, in range 0-1
+            float velocity;
+        };
+
+        /// Number of notes queued in each direction
+        static constexpr size_t queue_size = 256;
+
+        KeyboardBridge();
+        ~KeyboardBridge() override;
+
+        /// State for a `juce::MidiKeyboardComponent`, only use it on the message thread
+        juce::MidiKeyboardState state;
+
+        /** @brief Calls `handle` with each note played on the keyboard since the last call.
+         *
+         * Only call from the audio thread.
+         */
+        template<typename F>
+        void drain(F&& handle) {
+            NoteEvent e {};
+            while (played.pop(e)) {
+                handle(e);
+            }
+        }
+
+        /** @brief Queues a note on or off from the host to be shown on the keyboard, ignoring other messages.
+         *
+         * Only call from the audio thread.
+         */
+        void show(const juce::MidiMessage& m);
+
+     private:
+        void handleNoteOn(juce::MidiKeyboardState* source, int channel, int note, float velocity) override;
+        void handleNoteOff(juce::MidiKeyboardState* source, int channel, int note, float velocity) override;
+        void timerCallback() override;
+
+        modal::dsp::SpscRing<NoteEvent, queue_size> played;
+        modal::dsp::SpscRing<NoteEvent, queue_size> shown;
+        // set while showing host notes, so they aren't queued back to the audio thread as played
+        bool showing = false;
+    };
+}
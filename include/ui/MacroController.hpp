@@ -8,9 +8,12 @@
 #include <juce_gui_basics/juce_gui_basics.h>
 
 #include "dsp/dsp.hpp"
+#include "dsp/lockfree.hpp"
+#include "dsp/modmatrix.hpp"
+#include "dsp/preset.hpp"
 
 namespace modal::ui {
-    class MacroController final : public juce::ComboBox::Listener {
+    class MacroController final : public juce::ComboBox::Listener, public juce::Slider::Listener {
         struct ParamInfo {
             juce::String id;
             juce::String name;
@@ -18,14 +21,50 @@ namespace modal::ui {
         };
 
         std::vector<ParamInfo> params;
+        // names of the sources each setting can pick from, empty for a single macro
+        juce::StringArray sources;
+
+        // edited on the message thread, and read by the audio thread through `published`
+        modal::dsp::mod::MacroMap map;
+        modal::dsp::TripleBuffer<modal::dsp::mod::MacroMap> published;
+
+        void update_slot(size_t i);
+        void update_widgets(size_t i);
 
         public:
-            explicit MacroController(const juce::AudioProcessor& processor);
-            void set_values(modal::dsp::num n) const;
+            /// Number of parameters each macro can be mapped to
+            static constexpr size_t num_settings = modal::dsp::mod::MacroMap::max_slots;
+
+            /** @brief Constructor.
+             *
+             * @param processor Processor whose parameters can be mapped to
+             * @param source_names Names of modulation sources each setting picks from,
+             * in the order of their mod matrix indices. Empty for a single macro.
+             */
+            explicit MacroController(const juce::AudioProcessor& processor, const juce::StringArray& source_names = {});
+
+            /** @brief Constructor, for mapping to some of a processor's parameters.
+             *
+             * @param target_params Parameters that can be mapped to, in the order of their mod matrix target indices
+             * @param source_names Names of modulation sources each setting picks from, as above
+             */
+            MacroController(const std::vector<juce::AudioParameterFloat*>& target_params, const juce::StringArray& source_names);
+
+            /** @brief Parameters that macros can be mapped to, in the order used for mod matrix target indices.
+             */
+            static std::vector<juce::AudioParameterFloat*> targets(const juce::AudioProcessor& processor);
+
+            /** @brief Adds a route to `matrix` from `source` for each parameter this macro is mapped to.
+             *
+             * With a list of source names, `source` is the mod matrix index of the first source.
+             * Target indices are as in `targets()`. Only call from the audio thread,
+             * reads the latest mapping published by the UI without locking.
+             */
+            void add_routes(modal::dsp::mod::ModMatrix& matrix, size_t source);
 
             class MacroSettings final : public juce::Component {
                 friend class MacroController;
-                juce::ComboBox options;
+                juce::ComboBox source, options, curve;
                 juce::Slider lo {"mod_low"}, hi {"mod_high"};
                 MacroController& parent;
                 explicit MacroSettings(MacroController& p) : parent{p} {}
@@ -38,9 +77,9 @@ namespace modal::ui {
 
             class UI final : public juce::Component {
                 friend class MacroController;
-                std::array<MacroSettings, 3> settingses;
+                std::array<MacroSettings, num_settings> settingses;
                 MacroController& parent;
-                explicit UI(MacroController& p) : settingses {MacroSettings{p}, MacroSettings{p}, MacroSettings{p}},
+                explicit UI(MacroController& p) : settingses {MacroSettings{p}, MacroSettings{p}, MacroSettings{p}, MacroSettings{p}},
                                                   parent {p} {}
                 public:
                     UI(const UI& old) : settingses{old.settingses}, parent{old.parent} {}
@@ -56,6 +95,23 @@ namespace modal::ui {
             juce::ValueTree dump_state() const;
             void load_state(const juce::ValueTree& state);
 
+            /** @brief Stores the mapping as one of the macro maps of a patch state.
+             *
+             * Targets are stored as indices into the state's parameters, so capture the parameters first.
+             * @param state State to store in
+             * @param macro Index of the state's macro map to store in
+             */
+            void dump_state(modal::dsp::preset::PatchState& state, size_t macro) const;
+
+            /** @brief Loads the mapping from one of the macro maps of a patch state.
+             *
+             * Missing maps, and slots whose parameters no longer exist, are left unmapped.
+             * @param state State to load from
+             * @param macro Index of the state's macro map to load from
+             */
+            void load_state(const modal::dsp::preset::PatchState& state, size_t macro);
+
             void comboBoxChanged(juce::ComboBox* comboBoxThatHasChanged) override;
+            void sliderValueChanged(juce::Slider* sliderThatHasChanged) override;
     };
 }
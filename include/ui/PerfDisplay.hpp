@@ -0,0 +1,34 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <functional>
+
+#include <juce_gui_basics/juce_gui_basics.h>
+
+#include "dsp/perf.hpp"
+
+namespace modal::ui {
+    /** @brief Shows DSP load, block times, stage breakdown and event counts from a `dsp::perf::Monitor`.
+     *
+     * Polls its source a few times a second while visible.
+     */
+    class PerfDisplay final : public juce::Component, private juce::Timer {
+     public:
+        /** @brief Constructor.
+         *
+         * @param source Called on the message thread to collect the latest summary, such as a processor's `perf_summary()`
+         */
+        explicit PerfDisplay(std::function<modal::dsp::perf::Summary()> source);
+
+        void paint(juce::Graphics& g) override;
+
+        void visibilityChanged() override;
+
+     private:
+        void timerCallback() override;
+
+        std::function<modal::dsp::perf::Summary()> source;
+        modal::dsp::perf::Summary summary;
+    };
+}
@@ -0,0 +1,25 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+
+#include "dsp/preset.hpp"
+
+namespace modal::ui {
+    /** @brief Stores the value of every parameter of a processor in a patch state.
+     *
+     * @param processor Processor to read the parameters of
+     * @param state State to store in, whose parameters are replaced
+     */
+    void capture_params(const juce::AudioProcessor& processor, modal::dsp::preset::PatchState& state);
+
+    /** @brief Sets every parameter of a processor from a patch state, notifying the host.
+     *
+     * Parameters missing from the state, such as ones added since it was saved, are reset to their defaults.
+     * Values the state has for parameters that no longer exist are ignored.
+     * @param processor Processor to set the parameters of
+     * @param state State to load from
+     */
+    void restore_params(juce::AudioProcessor& processor, const modal::dsp::preset::PatchState& state);
+}
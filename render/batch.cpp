@@ -0,0 +1,144 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "batch.hpp"
+
+#include <dsp/bonus.hpp>
+#include <dsp/modal_engine.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+namespace modal::render {
+    namespace {
+        // the plugin's output gain for the sum of its voices
+        constexpr float voice_gain = 0.1f;
+        // silence is checked a window at a time, so a single quiet sample doesn't end the note
+        constexpr size_t silence_window = 1024;
+        constexpr double fade_seconds = 0.005;
+
+        // plays a one-shot on a voice set up for it
+        template<size_t maxModes>
+        std::vector<float> play_one_shot(dsp::synth::ModalSynth<maxModes>& voice, const dsp::synth::ModalPatch& patch,
+                                         const dsp::synth::ModalParams& params, const OneShot& shot,
+                                         const double sample_rate, const BatchSettings& batch) {
+            voice.set_patch(patch);
+            voice.set_sample_rate(static_cast<dsp::num>(sample_rate));
+            params.apply(voice);
+            voice.seed_noise(shot.seed());
+
+            const auto release_at = static_cast<size_t>(std::llround(batch.hold_seconds * sample_rate));
+            const auto max_length = static_cast<size_t>(std::llround(batch.max_seconds * sample_rate));
+            const auto threshold = static_cast<float>(std::pow(10, batch.threshold_db / 20));
+            // a struck note can die away while it's held, other exciters play until they're released
+            const size_t check_from = params.exciter == dsp::synth::ModalExiterKind::Impulse ? 0 : release_at;
+
+            std::vector<float> out;
+            out.reserve(std::min<size_t>(max_length, static_cast<size_t>(10 * sample_rate)));
+            voice.on(dsp::bonus::midi2freq(static_cast<dsp::num>(shot.note)), static_cast<dsp::num>(shot.velocity) / 127);
+            size_t played = 0;
+            const auto next = [&] {
+                if (played == release_at) {
+                    voice.off();
+                }
+                // at the engine's control rate, so a damped release sounds as it does played
+                if (played % dsp::block_size == 0) {
+                    voice.damp(dsp::block_size);
+                }
+                played++;
+                return static_cast<float>(voice.tick()) * voice_gain;
+            };
+            // the spectral backend's delay is dropped, leaving only its strikes' quantisation to a hop
+            for (const auto delay = voice.latency(); played < delay;) {
+                next();
+            }
+
+            size_t last_loud = 0;
+            while (out.size() < max_length) {
+                float loudest = 0;
+                for (size_t i = 0; i < silence_window && out.size() < max_length; i++) {
+                    const auto sample = next();
+                    out.push_back(sample);
+                    if (std::abs(sample) >= threshold) {
+                        last_loud = out.size();
+                    }
+                    loudest = std::max(loudest, std::abs(sample));
+                }
+                if (out.size() >= check_from + silence_window && loudest < threshold) {
+                    break;
+                }
+            }
+
+            out.resize(std::max<size_t>(last_loud, 1));
+            const auto fade = std::min(out.size(), static_cast<size_t>(fade_seconds * sample_rate));
+            for (size_t i = 0; i < fade; i++) {
+                out[out.size() - 1 - i] *= static_cast<float>(i) / static_cast<float>(fade);
+            }
+            return out;
+        }
+    }
+
+    juce::Result validate(const BatchSettings& batch) {
+        if (batch.lowest_note < 0 || batch.highest_note > 127 || batch.lowest_note > batch.highest_note) {
+            return juce::Result::fail("notes must be a range within 0-127");
+        }
+        if (batch.velocity_layers < 1 || batch.velocity_layers > 127) {
+            return juce::Result::fail("there must be from 1 to 127 velocity layers");
+        }
+        if (batch.round_robins < 1) {
+            return juce::Result::fail("there must be at least one round robin");
+        }
+        if (batch.hold_seconds < 0 || batch.max_seconds <= 0) {
+            return juce::Result::fail("the hold time can't be negative, and the maximum length must be positive");
+        }
+        if (batch.threshold_db >= 0) {
+            return juce::Result::fail("the silence threshold must be below 0dBFS");
+        }
+        constexpr auto most_modes = static_cast<int>(dsp::synth::LargeModalSynth::max_modes);
+        if (batch.modes < 0 || batch.modes > most_modes) {
+            return juce::Result::fail("there must be from 1 to " + juce::String {most_modes} + " modes, or 0 for the patch's");
+        }
+        if (batch.spectral_threshold < 0) {
+            return juce::Result::fail("the spectral threshold can't be negative");
+        }
+        return juce::Result::ok();
+    }
+
+    juce::String OneShot::name(const juce::String& prefix) const {
+        return prefix + "_" + juce::String {note}.paddedLeft('0', 3) + "_v" + juce::String {velocity}.paddedLeft('0', 3)
+               + "_rr" + juce::String {round_robin};
+    }
+
+    std::uint32_t OneShot::seed() const {
+        // never 0, which the noise generator would be stuck at
+        const auto key = static_cast<std::uint32_t>((note * 128 + velocity) * 4096 + round_robin);
+        return (key * 0x9e3779b9u) | 1u;
+    }
+
+    std::vector<OneShot> one_shots(const BatchSettings& batch) {
+        std::vector<OneShot> shots;
+        for (int note = batch.lowest_note; note <= batch.highest_note; note++) {
+            for (int layer = 0; layer < batch.velocity_layers; layer++) {
+                const int low = 127 * layer / batch.velocity_layers + 1;
+                const int high = 127 * (layer + 1) / batch.velocity_layers;
+                for (int rr = 1; rr <= batch.round_robins; rr++) {
+                    shots.push_back({note, high, low, rr});
+                }
+            }
+        }
+        return shots;
+    }
+
+    std::vector<float> render_one_shot(const dsp::synth::ModalPatch& patch, const dsp::synth::ModalParams& params,
+                                       const OneShot& shot, const double sample_rate,
+                                       const BatchSettings& batch) {
+        // a new voice for each one-shot, so nothing is left ringing from the one before
+        if (params.modes > dsp::synth::ModalEngine::max_modes) {
+            auto voice = std::make_unique<dsp::synth::LargeModalSynth>();
+            voice->set_spectral_threshold(static_cast<size_t>(batch.spectral_threshold));
+            return play_one_shot(*voice, patch, params, shot, sample_rate, batch);
+        }
+        auto voice = std::make_unique<dsp::synth::ModalSynth<dsp::synth::ModalEngine::max_modes>>();
+        return play_one_shot(*voice, patch, params, shot, sample_rate, batch);
+    }
+}
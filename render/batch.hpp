@@ -0,0 +1,81 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// Batch rendering of one-shots for multisampled instruments, each note on its own voice of the modal synth.
+
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+
+#include <dsp/modal_params.hpp>
+
+#include <cstdint>
+#include <vector>
+
+#include "render.hpp"
+
+namespace modal::render {
+    /** @brief Which one-shots are rendered, and when they're cut off.
+     */
+    struct BatchSettings {
+        int lowest_note = 0;
+        int highest_note = 127;
+        /// the velocity range is split evenly into this many layers, each rendered at its top velocity
+        int velocity_layers = 4;
+        /// renders per note and layer, which differ in the noise exciter's sequence
+        int round_robins = 1;
+        /// time from note on to note off
+        double hold_seconds = 1;
+        /// level, in dBFS, below which a released note is silent and cut off
+        double threshold_db = -80;
+        /// longest a one-shot can be, if it doesn't fall silent before
+        double max_seconds = 30;
+        /// modes to play instead of the patch's, up to `dsp::synth::LargeModalSynth`'s, or 0 to play the patch's
+        int modes = 0;
+        /// with more modes than the plugin plays, number of modes above which the spectral backend plays them
+        int spectral_threshold = static_cast<int>(dsp::synth::LargeModalSynth::default_spectral_threshold);
+    };
+
+    /** @brief Checks batch settings are ones that can be rendered.
+     */
+    juce::Result validate(const BatchSettings& batch);
+
+    /** @brief One note of a multisample.
+     */
+    struct OneShot {
+        int note;
+        /// velocity rendered at, the top of its layer
+        int velocity;
+        /// lowest velocity of its layer
+        int low_velocity;
+        /// from 1
+        int round_robin;
+
+        /** @brief File name, without the extension, e.g. `bell_060_v127_rr1`.
+         */
+        [[nodiscard]] juce::String name(const juce::String& prefix) const;
+
+        /** @brief Seed of the noise exciter, the same for the same note, velocity and round robin in any batch.
+         */
+        [[nodiscard]] std::uint32_t seed() const;
+    };
+
+    /** @brief Every one-shot in a batch, in order of note, layer then round robin.
+     */
+    std::vector<OneShot> one_shots(const BatchSettings& batch);
+
+    /** @brief Renders a one-shot on a voice of its own, until it falls silent after its release.
+     *
+     * Patches with more modes than the plugin plays are played on a `dsp::synth::LargeModalSynth`.
+     * The trailing silence is trimmed, ending with a short fade so the cut doesn't click,
+     * and the output is scaled as the plugin scales its voices.
+     * @param patch Spectrum to play, set up from `params`
+     * @param params Settings of the patch, for the voice
+     * @param shot Note to play
+     * @param sample_rate Sample rate to render at
+     * @param batch When to release the note and cut it off
+     * @return Mono samples
+     */
+    std::vector<float> render_one_shot(const dsp::synth::ModalPatch& patch, const dsp::synth::ModalParams& params,
+                                       const OneShot& shot, double sample_rate,
+                                       const BatchSettings& batch);
+}
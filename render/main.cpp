@@ -0,0 +1,321 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// Renders MIDI files through a plugin's processor to audio files, without a DAW or GUI.
+// Built once per plugin, each build linked with that plugin's shared code.
+//
+// usage: <plugin>Render --patch <file> [--rate 48000] [--bits 24] [--format wav|flac] [--block 512] [--tail 2]
+//                       [--jobs <n>] [--out <dir>] <midi files...>
+//
+// ModalRender can also render one-shots for a multisampled instrument, instead of MIDI files:
+//        ModalRender --patch <file> --batch [--notes 0-127] [--velocities 4] [--round-robins 1] [--hold 1]
+//                    [--threshold -80] [--max-length 30] [--modes <n>] [--spectral-threshold 256] [--rate 48000] [--bits 24]
+//                    [--format wav|flac] [--jobs <n>] [--out <dir>]
+
+#include <juce_audio_processors/juce_audio_processors.h>
+
+#include <dsp/simd.hpp>
+#include <ui/PresetState.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "pool.hpp"
+#include "render.hpp"
+#ifdef MODAL_RENDER_BATCH
+#include "batch.hpp"
+#endif
+
+// the processor of whichever plugin this is linked with
+juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter();
+
+namespace {
+    struct Options {
+        modal::render::Settings settings;
+        juce::File patch;
+        juce::File out_dir = juce::File::getCurrentWorkingDirectory();
+        int jobs = static_cast<int>(std::max(std::thread::hardware_concurrency(), 1u));
+        std::vector<juce::File> midi;
+#ifdef MODAL_RENDER_BATCH
+        bool batch = false;
+        modal::render::BatchSettings batch_settings;
+#endif
+    };
+
+    [[noreturn]] void usage(const char* error) {
+        std::fprintf(stderr, "%s\nusage: Render --patch <file> [--rate 48000] [--bits 24] [--format wav|flac] [--block 512] [--tail 2]\n"
+                             "              [--jobs <n>] [--out <dir>] <midi files...>\n", error);
+#ifdef MODAL_RENDER_BATCH
+        std::fprintf(stderr, "       Render --patch <file> --batch [--notes 0-127] [--velocities 4] [--round-robins 1] [--hold 1]\n"
+                             "              [--threshold -80] [--max-length 30] [--modes <n>] [--spectral-threshold 256]\n"
+                             "              [--rate 48000] [--bits 24] [--format wav|flac] [--jobs <n>] [--out <dir>]\n");
+#endif
+        std::exit(2);
+    }
+
+    juce::File file_arg(const std::string_view arg) {
+        return juce::File::getCurrentWorkingDirectory().getChildFile(juce::String {arg.data(), arg.size()});
+    }
+
+    Options parse_options(const int argc, char** argv) {
+        Options o;
+        for (int i = 1; i < argc; i++) {
+            const std::string_view flag = argv[i];
+            if (!flag.starts_with("--")) {
+                o.midi.push_back(file_arg(flag));
+                continue;
+            }
+#ifdef MODAL_RENDER_BATCH
+            if (flag == "--batch") {
+                o.batch = true;
+                continue;
+            }
+#endif
+            if (i + 1 >= argc) {
+                usage("missing value");
+            }
+            const std::string value = argv[++i];
+            if (flag == "--patch") {
+                o.patch = file_arg(value);
+            } else if (flag == "--rate") {
+                o.settings.sample_rate = std::atof(value.c_str());
+            } else if (flag == "--bits") {
+                o.settings.bits = std::atoi(value.c_str());
+            } else if (flag == "--format") {
+                if (value != "wav" && value != "flac") {
+                    usage("formats are wav or flac");
+                }
+                o.settings.format = value == "flac" ? modal::render::Format::Flac : modal::render::Format::Wav;
+            } else if (flag == "--block") {
+                o.settings.block_size = std::atoi(value.c_str());
+            } else if (flag == "--tail") {
+                o.settings.tail_seconds = std::atof(value.c_str());
+            } else if (flag == "--jobs") {
+                o.jobs = std::atoi(value.c_str());
+            } else if (flag == "--out") {
+                o.out_dir = file_arg(value);
+#ifdef MODAL_RENDER_BATCH
+            } else if (flag == "--notes") {
+                const auto dash = value.find('-', 1);
+                o.batch_settings.lowest_note = std::atoi(value.c_str());
+                o.batch_settings.highest_note = dash == std::string::npos ? o.batch_settings.lowest_note
+                                                                          : std::atoi(value.c_str() + dash + 1);
+            } else if (flag == "--velocities") {
+                o.batch_settings.velocity_layers = std::atoi(value.c_str());
+            } else if (flag == "--round-robins") {
+                o.batch_settings.round_robins = std::atoi(value.c_str());
+            } else if (flag == "--hold") {
+                o.batch_settings.hold_seconds = std::atof(value.c_str());
+            } else if (flag == "--threshold") {
+                o.batch_settings.threshold_db = std::atof(value.c_str());
+            } else if (flag == "--max-length") {
+                o.batch_settings.max_seconds = std::atof(value.c_str());
+            } else if (flag == "--modes") {
+                o.batch_settings.modes = std::atoi(value.c_str());
+            } else if (flag == "--spectral-threshold") {
+                o.batch_settings.spectral_threshold = std::atoi(value.c_str());
+#endif
+            } else {
+                usage("unknown option");
+            }
+        }
+
+        if (const auto valid = modal::render::validate(o.settings); valid.failed()) {
+            usage(valid.getErrorMessage().toRawUTF8());
+        }
+        if (o.patch == juce::File {}) {
+            usage("a patch is needed");
+        }
+#ifdef MODAL_RENDER_BATCH
+        if (o.batch) {
+            if (const auto valid = modal::render::validate(o.batch_settings); valid.failed()) {
+                usage(valid.getErrorMessage().toRawUTF8());
+            }
+            if (!o.midi.empty()) {
+                usage("batches don't play MIDI files");
+            }
+        } else
+#endif
+        if (o.midi.empty()) {
+            usage("no MIDI files to render");
+        }
+        if (o.jobs < 1) {
+            usage("jobs must be at least 1");
+        }
+        return o;
+    }
+
+    struct Outcome {
+        juce::Result result = juce::Result::ok();
+        juce::File output;
+        double audio_seconds = 0, wall_seconds = 0;
+    };
+
+    // each file gets its own processor, so nothing rings on from the file before, created on the thread rendering it
+    Outcome render_file(const Options& options, const juce::File& midi) {
+        Outcome o;
+        const auto begin = std::chrono::steady_clock::now();
+        o.output = options.out_dir.getChildFile(midi.getFileNameWithoutExtension() + modal::render::extension(options.settings.format));
+
+        const std::unique_ptr<juce::AudioProcessor> processor {createPluginFilter()};
+        modal::render::prepare(*processor, options.settings);
+        juce::MidiMessageSequence events;
+        std::unique_ptr<juce::AudioFormatWriter> writer;
+        juce::int64 samples = 0;
+
+        o.result = modal::render::load_patch(*processor, options.patch);
+        if (o.result.wasOk()) {
+            o.result = modal::render::load_midi(midi, events);
+        }
+        if (o.result.wasOk()) {
+            o.result = modal::render::create_writer(o.output, options.settings, writer);
+        }
+        if (o.result.wasOk()) {
+            o.result = modal::render::render(*processor, events, options.settings, *writer, samples);
+        }
+
+        // the file is only finished once the writer is destroyed
+        writer.reset();
+        o.audio_seconds = static_cast<double>(samples) / options.settings.sample_rate;
+        o.wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        return o;
+    }
+
+#ifdef MODAL_RENDER_BATCH
+    // each one-shot plays on a voice of its own rather than a whole processor, so only needs the patch's settings
+    int render_batch(const Options& options) {
+        const auto& batch = options.batch_settings;
+        const std::unique_ptr<juce::AudioProcessor> processor {createPluginFilter()};
+        if (const auto loaded = modal::render::load_patch(*processor, options.patch); loaded.failed()) {
+            std::fprintf(stderr, "%s\n", loaded.getErrorMessage().toRawUTF8());
+            return 1;
+        }
+        modal::dsp::preset::PatchState state;
+        modal::ui::capture_params(*processor, state);
+        auto params = modal::dsp::synth::ModalParams::from_state(state);
+        if (batch.modes > 0) {
+            params.modes = static_cast<size_t>(batch.modes);
+        }
+        modal::dsp::synth::ModalPatch patch;
+        params.apply(patch);
+
+        struct Written {
+            juce::Result result = juce::Result::ok();
+            juce::File file;
+            size_t samples = 0;
+            float peak = 0;
+        };
+        const auto shots = modal::render::one_shots(batch);
+        const auto prefix = options.patch.getFileNameWithoutExtension();
+        std::vector<Written> written(shots.size());
+        std::printf("%s: rendering %zu one-shots at %.0fHz, %d bit, on %d threads with %s kernels\n",
+                    processor->getName().toRawUTF8(), shots.size(), options.settings.sample_rate, options.settings.bits,
+                    options.jobs, modal::dsp::simd::isa_name(modal::dsp::simd::kernels().isa).data());
+
+        const auto begin = std::chrono::steady_clock::now();
+        modal::render::parallel_for(static_cast<uint32_t>(shots.size()), options.jobs, [&](const uint32_t i) {
+            auto& w = written[i];
+            const auto samples = modal::render::render_one_shot(patch, params, shots[i], options.settings.sample_rate, batch);
+            w.file = options.out_dir.getChildFile(shots[i].name(prefix) + modal::render::extension(options.settings.format));
+            w.samples = samples.size();
+            for (const auto s: samples) {
+                w.peak = std::max(w.peak, std::abs(s));
+            }
+
+            std::unique_ptr<juce::AudioFormatWriter> writer;
+            w.result = modal::render::create_writer(w.file, options.settings, writer, 1);
+            const float* channels[] = {samples.data()};
+            if (w.result.wasOk() && !writer->writeFromFloatArrays(channels, 1, static_cast<int>(samples.size()))) {
+                w.result = juce::Result::fail("couldn't write " + w.file.getFullPathName());
+            }
+            if (w.result.failed()) {
+                std::fprintf(stderr, "%s\n", w.result.getErrorMessage().toRawUTF8());
+            }
+        });
+        const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+        // what a sampler needs to map the files, in the order they were listed
+        const auto manifest = options.out_dir.getChildFile(prefix + "_manifest.csv");
+        FILE* csv = std::fopen(manifest.getFullPathName().toRawUTF8(), "w");
+        if (csv == nullptr) {
+            std::fprintf(stderr, "couldn't write %s\n", manifest.getFullPathName().toRawUTF8());
+            return 1;
+        }
+        std::fprintf(csv, "file,note,velocity,low_velocity,high_velocity,round_robin,samples,seconds,peak_db\n");
+        double audio = 0;
+        size_t failed = 0;
+        for (size_t i = 0; i < shots.size(); i++) {
+            const auto& w = written[i];
+            if (w.result.failed()) {
+                failed++;
+                continue;
+            }
+            const double seconds = static_cast<double>(w.samples) / options.settings.sample_rate;
+            audio += seconds;
+            std::fprintf(csv, "\"%s\",%d,%d,%d,%d,%d,%zu,%.4f,%.2f\n", w.file.getFileName().toRawUTF8(),
+                         shots[i].note, shots[i].velocity, shots[i].low_velocity, shots[i].velocity, shots[i].round_robin,
+                         w.samples, seconds, 20 * std::log10(std::max(w.peak, 1e-10f)));
+        }
+        std::fclose(csv);
+
+        std::printf("rendered %.1fs of audio in %.2fs (%.0fx real time), manifest in %s%s\n", audio, wall, audio / wall,
+                    manifest.getFullPathName().toRawUTF8(),
+                    failed > 0 ? (", " + std::to_string(failed) + " failed").c_str() : "");
+        return failed > 0 ? 1 : 0;
+    }
+#endif
+}
+
+int main(const int argc, char** argv) {
+    const auto options = parse_options(argc, argv);
+    juce::ScopedJuceInitialiser_GUI juce_init;
+
+    if (options.out_dir.createDirectory().failed()) {
+        std::fprintf(stderr, "couldn't create %s\n", options.out_dir.getFullPathName().toRawUTF8());
+        return 1;
+    }
+#ifdef MODAL_RENDER_BATCH
+    if (options.batch) {
+        return render_batch(options);
+    }
+#endif
+
+    const std::unique_ptr<juce::AudioProcessor> named {createPluginFilter()};
+    const auto jobs = std::min(options.jobs, static_cast<int>(options.midi.size()));
+    std::printf("%s: rendering %zu files at %.0fHz, %d bit, on %d threads with %s kernels\n",
+                named->getName().toRawUTF8(), options.midi.size(), options.settings.sample_rate, options.settings.bits,
+                jobs, modal::dsp::simd::isa_name(modal::dsp::simd::kernels().isa).data());
+
+    const auto begin = std::chrono::steady_clock::now();
+    std::vector<Outcome> outcomes(options.midi.size());
+    modal::render::parallel_for(static_cast<uint32_t>(options.midi.size()), jobs, [&](const uint32_t i) {
+        const auto& o = outcomes[i] = render_file(options, options.midi[i]);
+        if (o.result.wasOk()) {
+            std::printf("%s -> %s, %.1fs in %.2fs (%.0fx real time)\n",
+                        options.midi[i].getFileName().toRawUTF8(), o.output.getFullPathName().toRawUTF8(),
+                        o.audio_seconds, o.wall_seconds, o.audio_seconds / o.wall_seconds);
+        } else {
+            std::fprintf(stderr, "%s: %s\n", options.midi[i].getFileName().toRawUTF8(),
+                         o.result.getErrorMessage().toRawUTF8());
+        }
+        std::fflush(stdout);
+    });
+    const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    double audio = 0;
+    size_t failed = 0;
+    for (const auto& o: outcomes) {
+        audio += o.audio_seconds;
+        failed += o.result.failed() ? 1 : 0;
+    }
+    std::printf("rendered %.1fs of audio in %.2fs (%.0fx real time)%s\n", audio, wall, audio / wall,
+                failed > 0 ? (", " + std::to_string(failed) + " failed").c_str() : "");
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,113 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace modal::render {
+    /// @private
+    namespace detail {
+        /** @brief A thread's share of the indices, taken from the front by its owner and split from the back by thieves.
+         *
+         * Both ends are packed into one word so either can be moved with a single compare-and-swap.
+         * Aligned to a cache line so threads working on their own shares don't slow each other down.
+         */
+        class alignas(64) Share {
+         public:
+            void set(const uint32_t begin, const uint32_t end) {
+                range.store(pack(begin, end));
+            }
+
+            [[nodiscard]] uint32_t size() const {
+                const auto r = range.load(std::memory_order_relaxed);
+                return end_of(r) - begin_of(r);
+            }
+
+            std::optional<uint32_t> take_front() {
+                auto r = range.load();
+                while (begin_of(r) < end_of(r)) {
+                    if (range.compare_exchange_weak(r, pack(begin_of(r) + 1, end_of(r)))) {
+                        return begin_of(r);
+                    }
+                }
+                return std::nullopt;
+            }
+
+            /// Takes the back half, or the last index if only one is left
+            std::optional<std::pair<uint32_t, uint32_t>> steal_back() {
+                auto r = range.load();
+                while (begin_of(r) < end_of(r)) {
+                    const uint32_t mid = begin_of(r) + (end_of(r) - begin_of(r)) / 2;
+                    if (range.compare_exchange_weak(r, pack(begin_of(r), mid))) {
+                        return std::pair {mid, end_of(r)};
+                    }
+                }
+                return std::nullopt;
+            }
+
+         private:
+            std::atomic<uint64_t> range {0};
+
+            static uint64_t pack(const uint32_t begin, const uint32_t end) {
+                return static_cast<uint64_t>(end) << 32 | begin;
+            }
+
+            static uint32_t begin_of(const uint64_t r) {
+                return static_cast<uint32_t>(r);
+            }
+
+            static uint32_t end_of(const uint64_t r) {
+                return static_cast<uint32_t>(r >> 32);
+            }
+        };
+    }
+
+    /** @brief Calls `f(i)` for every `i` from 0 to `count`, on `threads` threads, returning once all calls have.
+     *
+     * Each thread starts with an equal run of indices and works through it in order,
+     * and a thread that runs out steals the back half of the largest run left, so uneven tasks
+     * don't leave threads idle, and threads only contend with each other when they steal.
+     * Calls for neighbouring indices mostly run on the same thread, one after another.
+     */
+    template<typename F>
+    void parallel_for(const uint32_t count, const int threads, F&& f) {
+        const auto n = static_cast<uint32_t>(std::clamp<int64_t>(threads, 1, std::max<uint32_t>(count, 1)));
+        std::vector<detail::Share> shares(n);
+        for (uint32_t t = 0; t < n; t++) {
+            shares[t].set(static_cast<uint32_t>(uint64_t {count} * t / n), static_cast<uint32_t>(uint64_t {count} * (t + 1) / n));
+        }
+
+        const auto work = [&](const uint32_t self) {
+            while (true) {
+                while (const auto i = shares[self].take_front()) {
+                    f(*i);
+                }
+
+                // steal from whoever has the most left, finishing once every share is empty
+                std::optional<std::pair<uint32_t, uint32_t>> stolen;
+                while (!stolen) {
+                    const auto victim = std::max_element(shares.begin(), shares.end(), [](const auto& a, const auto& b) {
+                        return a.size() < b.size();
+                    });
+                    if (victim->size() == 0) {
+                        return;
+                    }
+                    stolen = victim->steal_back();
+                }
+                shares[self].set(stolen->first, stolen->second);
+            }
+        };
+
+        std::vector<std::jthread> pool;
+        for (uint32_t t = 1; t < n; t++) {
+            pool.emplace_back(work, t);
+        }
+        work(0);
+    }
+}
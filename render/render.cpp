@@ -0,0 +1,141 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "render.hpp"
+
+#include <dsp/preset.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <span>
+
+namespace modal::render {
+    juce::Result validate(const Settings& settings) {
+        if (settings.sample_rate < 8000 || settings.sample_rate > 768000) {
+            return juce::Result::fail("sample rates must be from 8000 to 768000Hz");
+        }
+        if (settings.format == Format::Flac ? settings.bits != 16 && settings.bits != 24
+                                            : settings.bits != 16 && settings.bits != 24 && settings.bits != 32) {
+            return juce::Result::fail("WAV files can be 16, 24 or 32 (float) bit, FLAC files 16 or 24 bit");
+        }
+        if (settings.block_size < min_block_size || settings.block_size > max_block_size) {
+            return juce::Result::fail("block sizes must be from 16 to 4096 samples");
+        }
+        if (settings.tail_seconds < 0) {
+            return juce::Result::fail("the tail can't be negative");
+        }
+        return juce::Result::ok();
+    }
+
+    juce::String extension(const Format format) {
+        return format == Format::Flac ? ".flac" : ".wav";
+    }
+
+    juce::Result load_patch(juce::AudioProcessor& processor, const juce::File& file) {
+        juce::MemoryBlock data;
+        if (!file.loadFileAsData(data)) {
+            return juce::Result::fail("couldn't read " + file.getFullPathName());
+        }
+
+        // XML as text, e.g. a state saved by hand or by another tool, is wrapped as the processor stores it
+        if (data.toString().trimStart().startsWithChar('<')) {
+            const auto xml = juce::parseXML(data.toString());
+            if (xml == nullptr) {
+                return juce::Result::fail(file.getFullPathName() + " isn't valid XML");
+            }
+            data.reset();
+            juce::AudioProcessor::copyXmlToBinary(*xml, data);
+        }
+
+        // the processor ignores states it can't read, so they're checked here to report them
+        const std::span bytes {static_cast<const uint8_t*>(data.getData()), data.getSize()};
+        dsp::preset::PatchState state;
+        const bool readable = dsp::preset::is_encoded(bytes)
+                ? dsp::preset::decode(bytes, state)
+                : juce::AudioProcessor::getXmlFromBinary(data.getData(), static_cast<int>(data.getSize())) != nullptr;
+        if (!readable) {
+            return juce::Result::fail(file.getFullPathName() + " isn't a patch");
+        }
+
+        processor.setStateInformation(data.getData(), static_cast<int>(data.getSize()));
+        return juce::Result::ok();
+    }
+
+    juce::Result load_midi(const juce::File& file, juce::MidiMessageSequence& events) {
+        juce::FileInputStream in {file};
+        juce::MidiFile midi;
+        if (!in.openedOk() || !midi.readFrom(in)) {
+            return juce::Result::fail("couldn't read " + file.getFullPathName() + " as a MIDI file");
+        }
+
+        midi.convertTimestampTicksToSeconds();
+        for (int t = 0; t < midi.getNumTracks(); t++) {
+            events.addSequence(*midi.getTrack(t), 0);
+        }
+        events.sort();
+        return juce::Result::ok();
+    }
+
+    juce::Result create_writer(const juce::File& file, const Settings& settings,
+                               std::unique_ptr<juce::AudioFormatWriter>& writer, const int channels) {
+        writer.reset();
+        if (!file.deleteFile()) {
+            return juce::Result::fail("couldn't replace " + file.getFullPathName());
+        }
+        auto out = file.createOutputStream();
+        if (out == nullptr) {
+            return juce::Result::fail("couldn't write " + file.getFullPathName());
+        }
+
+        juce::WavAudioFormat wav;
+        juce::FlacAudioFormat flac;
+        juce::AudioFormat& format = settings.format == Format::Flac ? static_cast<juce::AudioFormat&>(flac) : wav;
+        // takes ownership of the stream if it succeeds
+        writer.reset(format.createWriterFor(out.get(), settings.sample_rate, static_cast<unsigned int>(channels), settings.bits, {}, 0));
+        if (writer == nullptr) {
+            return juce::Result::fail("couldn't write " + file.getFullPathName() + " at this sample rate and bit depth");
+        }
+        out.release();
+        return juce::Result::ok();
+    }
+
+    void prepare(juce::AudioProcessor& processor, const Settings& settings) {
+        processor.setNonRealtime(true);
+        processor.setPlayConfigDetails(0, 2, settings.sample_rate, settings.block_size);
+        processor.prepareToPlay(settings.sample_rate, settings.block_size);
+    }
+
+    juce::Result render(juce::AudioProcessor& processor, const juce::MidiMessageSequence& events,
+                        const Settings& settings, juce::AudioFormatWriter& writer, juce::int64& samples) {
+        const auto length = static_cast<juce::int64>(std::ceil((events.getEndTime() + settings.tail_seconds) * settings.sample_rate));
+
+        juce::AudioBuffer<float> buffer {2, settings.block_size};
+        juce::MidiBuffer midi;
+        int next = 0;
+
+        samples = 0;
+        while (samples < length) {
+            const auto block = static_cast<int>(std::min<juce::int64>(settings.block_size, length - samples));
+            midi.clear();
+            for (; next < events.getNumEvents(); next++) {
+                const auto& message = events.getEventPointer(next)->message;
+                const auto at = static_cast<juce::int64>(std::llround(message.getTimeStamp() * settings.sample_rate));
+                if (at >= samples + block) {
+                    break;
+                }
+                if (!message.isMetaEvent()) {
+                    midi.addEvent(message, static_cast<int>(std::max<juce::int64>(at - samples, 0)));
+                }
+            }
+
+            buffer.setSize(2, block, false, false, true);
+            buffer.clear();
+            processor.processBlock(buffer, midi);
+            if (!writer.writeFromAudioSampleBuffer(buffer, 0, block)) {
+                return juce::Result::fail("couldn't write the render");
+            }
+            samples += block;
+        }
+        processor.releaseResources();
+        return juce::Result::ok();
+    }
+}
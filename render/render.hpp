@@ -0,0 +1,86 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// Offline rendering of a plugin's processor, as a host bouncing a track would, for the render tools.
+
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+
+#include <memory>
+
+namespace modal::render {
+    enum class Format {
+        Wav,
+        Flac,
+    };
+
+    /** @brief How files are rendered and written.
+     */
+    struct Settings {
+        double sample_rate = 48000;
+        /// 16 or 24 bit integer, or 32 bit float, which only WAV supports
+        int bits = 24;
+        Format format = Format::Wav;
+        /// samples passed to each `processBlock()` call, at most `max_block_size`
+        int block_size = 512;
+        /// time rendered after the last MIDI event, so released notes can ring out
+        double tail_seconds = 2;
+    };
+
+    constexpr int min_block_size = 16;
+    constexpr int max_block_size = 4096;
+
+    /** @brief Checks settings are ones that can be rendered and written.
+     *
+     * @return Failure describing the first setting that isn't
+     */
+    juce::Result validate(const Settings& settings);
+
+    /** @brief File extension for a format, including the dot.
+     */
+    juce::String extension(Format format);
+
+    /** @brief Loads a patch file into a processor.
+     *
+     * Accepts the processor's own state, in the binary patch format or the legacy XML wrapped by
+     * `juce::AudioProcessor::copyXmlToBinary()`, or that XML as plain text.
+     * @param processor Processor to load into
+     * @param file Patch file to read
+     */
+    juce::Result load_patch(juce::AudioProcessor& processor, const juce::File& file);
+
+    /** @brief Reads a Standard MIDI File, merging its tracks into one sequence timed in seconds.
+     *
+     * @param file MIDI file to read
+     * @param events Sequence to add the events to
+     */
+    juce::Result load_midi(const juce::File& file, juce::MidiMessageSequence& events);
+
+    /** @brief Creates a writer for a new file, replacing any existing file.
+     *
+     * @param file File to write
+     * @param settings Format, sample rate and bit depth to write
+     * @param writer Set to the writer, or `nullptr` on failure
+     * @param channels Number of channels to write
+     */
+    juce::Result create_writer(const juce::File& file, const Settings& settings,
+                               std::unique_ptr<juce::AudioFormatWriter>& writer, int channels = 2);
+
+    /** @brief Puts a processor in a state to render offline with, as a host does before playing.
+     */
+    void prepare(juce::AudioProcessor& processor, const Settings& settings);
+
+    /** @brief Plays a MIDI sequence through a prepared processor, writing its output.
+     *
+     * Events are placed at their sample within each block. Meta events, such as tempo changes, are skipped,
+     * as they're already accounted for in the sequence's timestamps.
+     * @param processor Processor to play, prepared with `prepare()`
+     * @param events Events to play, timed in seconds
+     * @param settings Settings the processor was prepared with
+     * @param writer Writer to write the whole render to
+     * @param samples Set to the number of samples written
+     */
+    juce::Result render(juce::AudioProcessor& processor, const juce::MidiMessageSequence& events,
+                        const Settings& settings, juce::AudioFormatWriter& writer, juce::int64& samples);
+}
@@ -0,0 +1,140 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "client.hpp"
+
+#include <dsp/preset.hpp>
+
+#include <array>
+#include <cerrno>
+#include <cstring>
+
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#ifndef MSG_NOSIGNAL
+// macOS has no flag for it, sockets are set to SO_NOSIGPIPE instead
+#define MSG_NOSIGNAL 0
+#endif
+
+namespace modal::server {
+    Client::~Client() {
+        disconnect();
+    }
+
+    void Client::disconnect() {
+        if (memory != nullptr) {
+            munmap(memory, hello.ring_bytes);
+            memory = nullptr;
+        }
+        if (fd >= 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+
+    bool Client::connect(const std::string& socket_path, std::string& error) {
+        disconnect();
+        sockaddr_un address {};
+        if (socket_path.empty() || socket_path.size() >= sizeof(address.sun_path)) {
+            error = "socket path must be 1-103 characters";
+            return false;
+        }
+        address.sun_family = AF_UNIX;
+        std::memcpy(address.sun_path, socket_path.c_str(), socket_path.size() + 1);
+
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0 || ::connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+            error = std::string {"couldn't connect: "} + std::strerror(errno);
+            disconnect();
+            return false;
+        }
+#ifdef SO_NOSIGPIPE
+        const int on = 1;
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+
+        // the hello arrives with the ring's descriptor
+        iovec data {&hello, sizeof(hello)};
+        alignas(cmsghdr) std::array<char, CMSG_SPACE(sizeof(int))> control {};
+        msghdr message {};
+        message.msg_iov = &data;
+        message.msg_iovlen = 1;
+        message.msg_control = control.data();
+        message.msg_controllen = control.size();
+        const auto got = recvmsg(fd, &message, MSG_WAITALL);
+        const auto* header = CMSG_FIRSTHDR(&message);
+        int ring_fd = -1;
+        if (header != nullptr && header->cmsg_level == SOL_SOCKET && header->cmsg_type == SCM_RIGHTS) {
+            std::memcpy(&ring_fd, CMSG_DATA(header), sizeof(int));
+        }
+        if (got != static_cast<ssize_t>(sizeof(hello)) || ring_fd < 0 || hello.magic != magic || hello.version != version) {
+            if (ring_fd >= 0) {
+                close(ring_fd);
+            }
+            error = got == 0 ? "the server turned the connection away" : "not a render server, or a different version";
+            disconnect();
+            return false;
+        }
+
+        // read only, the server is the only writer
+        memory = mmap(nullptr, hello.ring_bytes, PROT_READ, MAP_SHARED, ring_fd, 0);
+        close(ring_fd);
+        if (memory == MAP_FAILED) {
+            memory = nullptr;
+            error = std::string {"couldn't map the ring: "} + std::strerror(errno);
+            disconnect();
+            return false;
+        }
+        ring = Ring {memory};
+        return true;
+    }
+
+    bool Client::send(const Message& m) {
+        const auto* bytes = reinterpret_cast<const std::byte*>(&m);
+        for (size_t sent = 0; sent < sizeof(m);) {
+            const auto n = ::send(fd, bytes + sent, sizeof(m) - sent, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                return false;
+            }
+            sent += static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    bool Client::note_on(const uint64_t time, const int note, const float velocity, const int channel) {
+        return send({time, MessageKind::NoteOn, static_cast<uint32_t>(note), velocity, static_cast<uint32_t>(channel)});
+    }
+
+    bool Client::note_off(const uint64_t time, const int note, const int channel) {
+        return send({time, MessageKind::NoteOff, static_cast<uint32_t>(note), 0, static_cast<uint32_t>(channel)});
+    }
+
+    bool Client::pitch_bend(const uint64_t time, const int channel, const float amount) {
+        return send({time, MessageKind::PitchBend, static_cast<uint32_t>(channel), amount, 0});
+    }
+
+    bool Client::pressure(const uint64_t time, const int channel, const float amount) {
+        return send({time, MessageKind::Pressure, static_cast<uint32_t>(channel), amount, 0});
+    }
+
+    bool Client::set_param(const uint64_t time, const std::string_view id, const float value) {
+        return send({time, MessageKind::Param, dsp::preset::param_id(id), value, 0});
+    }
+
+    Client::ReadResult Client::read(const uint64_t block, float* out) const {
+        if (block >= written()) {
+            return ReadResult::NotYet;
+        }
+        const float* samples = ring.read(block);
+        if (samples == nullptr) {
+            return ReadResult::Overwritten;
+        }
+        std::memcpy(out, samples, hello.block_size * sizeof(float));
+        return ring.still_valid(block) ? ReadResult::Ok : ReadResult::Overwritten;
+    }
+}
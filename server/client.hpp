@@ -0,0 +1,101 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// The client side of the render server, for tools that play it.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "protocol.hpp"
+
+namespace modal::server {
+    /** @brief A connection to a render server, sending it events and reading its output from the ring.
+     *
+     * Sending blocks if the server falls behind reading events, reading never does.
+     */
+    class Client {
+     public:
+        enum class ReadResult {
+            Ok,
+            /// the block isn't rendered yet
+            NotYet,
+            /// the client fell more than the ring's slots behind, and the block was overwritten
+            Overwritten,
+        };
+
+        Client() = default;
+        ~Client();
+
+        Client(const Client&) = delete;
+        Client& operator=(const Client&) = delete;
+
+        /** @brief Connects to a server and maps its ring.
+         *
+         * @param socket_path Socket the server listens on
+         * @param error Set to why, if it couldn't
+         * @return `false` if it couldn't
+         */
+        bool connect(const std::string& socket_path, std::string& error);
+
+        /** @brief The server's sample rate and ring layout, once connected.
+         */
+        [[nodiscard]] const Hello& info() const {
+            return hello;
+        }
+
+        /** @brief Blocks the server has rendered so far.
+         */
+        [[nodiscard]] uint64_t written() const {
+            return ring.written();
+        }
+
+        /** @brief Earliest time, in samples, an event can be sent for and still be played on its sample.
+         */
+        [[nodiscard]] uint64_t next_time() const {
+            return written() * hello.block_size;
+        }
+
+        /** @brief Sends an event.
+         *
+         * @return `false` if the server has gone
+         */
+        bool send(const Message& m);
+
+        bool note_on(uint64_t time, int note, float velocity, int channel = 0);
+
+        bool note_off(uint64_t time, int note, int channel = 0);
+
+        /** @brief Bends a MIDI channel, by -1 to 1 of its bend range.
+         */
+        bool pitch_bend(uint64_t time, int channel, float amount);
+
+        /** @brief Sets the pressure of a MIDI channel, 0-1.
+         */
+        bool pressure(uint64_t time, int channel, float amount);
+
+        /** @brief Sets a parameter of the patch, by the ID the plugin saves it under.
+         */
+        bool set_param(uint64_t time, std::string_view id, float value);
+
+        /** @brief Copies a rendered block of `info().block_size` samples.
+         */
+        ReadResult read(uint64_t block, float* out) const;
+
+        /** @brief The ring itself, for reading blocks in place without copying them.
+         */
+        [[nodiscard]] const Ring& shared() const {
+            return ring;
+        }
+
+     private:
+        int fd = -1;
+        void* memory = nullptr;
+        Hello hello {};
+        Ring ring;
+
+        void disconnect();
+    };
+}
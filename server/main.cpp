@@ -0,0 +1,150 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// Runs the modal synth as a render server for local tools, without a DAW or GUI, until interrupted.
+//
+// usage: ModalServer [--socket /tmp/modal-synth.sock] [--patch <file>] [--rate 48000] [--block 128] [--slots 64]
+//                    [--lead 4] [--clients 16] [--load-target 0.7] [--quality eco|normal|high|offline]
+//                    [--mpe on|off]
+
+#include <dsp/preset.hpp>
+#include <dsp/simd.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "server.hpp"
+
+namespace {
+    std::atomic<bool> stop {false};
+
+    void interrupt(int) {
+        stop.store(true);
+    }
+
+    [[noreturn]] void usage(const char* error) {
+        std::fprintf(stderr, "%s\nusage: ModalServer [--socket /tmp/modal-synth.sock] [--patch <file>] [--rate 48000] [--block 128]\n"
+                             "                   [--slots 64] [--lead 4] [--clients 16] [--load-target 0.7]\n"
+                             "                   [--quality eco|normal|high|offline] [--mpe on|off]\n", error);
+        std::exit(2);
+    }
+
+    uint32_t number(const std::string& value) {
+        return static_cast<uint32_t>(std::strtoul(value.c_str(), nullptr, 10));
+    }
+
+    bool quality(const std::string_view name, modal::dsp::synth::Quality& q) {
+        using enum modal::dsp::synth::Quality;
+        constexpr std::array<std::pair<std::string_view, modal::dsp::synth::Quality>, 4> tiers {{
+            {"eco", Eco}, {"normal", Normal}, {"high", High}, {"offline", Offline},
+        }};
+        for (const auto& [n, tier]: tiers) {
+            if (name == n) {
+                q = tier;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // the plugin's binary state, the XML formats need JUCE to read
+    bool load_patch(const std::string& path, modal::dsp::preset::PatchState& state) {
+        std::ifstream file {path, std::ios::binary};
+        const std::vector<uint8_t> bytes {std::istreambuf_iterator<char> {file}, std::istreambuf_iterator<char> {}};
+        return file.good() || file.eof() ? modal::dsp::preset::decode(bytes, state) : false;
+    }
+}
+
+int main(const int argc, char** argv) {
+    modal::server::Settings settings;
+    std::string patch;
+    for (int i = 1; i < argc; i++) {
+        const std::string_view flag = argv[i];
+        if (i + 1 >= argc) {
+            usage("missing value");
+        }
+        const std::string value = argv[++i];
+        if (flag == "--socket") {
+            settings.socket_path = value;
+        } else if (flag == "--patch") {
+            patch = value;
+        } else if (flag == "--rate") {
+            settings.sample_rate = number(value);
+        } else if (flag == "--block") {
+            settings.block_size = number(value);
+        } else if (flag == "--slots") {
+            settings.slots = number(value);
+        } else if (flag == "--lead") {
+            settings.lead = number(value);
+        } else if (flag == "--clients") {
+            settings.max_clients = number(value);
+        } else if (flag == "--load-target") {
+            settings.load_target = std::atof(value.c_str());
+        } else if (flag == "--mpe") {
+            if (value != "on" && value != "off") {
+                usage("mpe must be on or off");
+            }
+            settings.mpe = value == "on";
+        } else if (flag == "--quality") {
+            if (!quality(value, settings.quality)) {
+                usage("quality must be eco, normal, high or offline");
+            }
+        } else {
+            usage("unknown option");
+        }
+    }
+    if (const char* invalid = modal::server::validate(settings)) {
+        usage(invalid);
+    }
+
+    modal::server::Server server {settings};
+    if (!patch.empty()) {
+        modal::dsp::preset::PatchState state;
+        if (!load_patch(patch, state)) {
+            std::fprintf(stderr, "%s isn't a patch saved by the plugin in its binary format\n", patch.c_str());
+            return 1;
+        }
+        server.set_state(state);
+    }
+    if (std::string error; !server.open(error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+
+    std::signal(SIGINT, interrupt);
+    std::signal(SIGTERM, interrupt);
+    std::printf("DSP kernels: %s\nserving on %s, %u Hz, %u sample blocks, %.1fms latency\n",
+                modal::dsp::simd::isa_name(modal::dsp::simd::kernels().isa).data(), settings.socket_path.c_str(),
+                settings.sample_rate, settings.block_size, 1000.0 * settings.lead * settings.block_size / settings.sample_rate);
+    std::fflush(stdout);
+
+    // the engine only queues so many blocks' timings, so they're collected as it runs rather than once at the end
+    modal::dsp::perf::Summary engine;
+    std::thread collector {[&] {
+        while (!stop.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(250));
+            engine = server.engine_stats();
+        }
+    }};
+    server.run(stop);
+    collector.join();
+
+    const auto& s = server.stats();
+    std::printf("%llu blocks (%llu late), %llu clients, %llu late and %llu dropped events, load %.3f, p99 block %.1fus, %u mode budget\n",
+                static_cast<unsigned long long>(s.blocks), static_cast<unsigned long long>(s.late_blocks),
+                static_cast<unsigned long long>(s.clients), static_cast<unsigned long long>(s.late_events),
+                static_cast<unsigned long long>(s.dropped_events), engine.load, engine.p99_ns / 1000,
+                server.mode_budget());
+    return 0;
+}
@@ -0,0 +1,185 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// What the render server and its clients share: the messages sent over the socket,
+// and the layout of the shared memory ring the rendered audio is streamed through.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+
+namespace modal::server {
+    constexpr uint32_t magic = 0x4d4f4453; // "MODS"
+    constexpr uint32_t version = 1;
+
+    enum class MessageKind : uint32_t {
+        NoteOn = 1,
+        NoteOff = 2,
+        /// sets the parameter `id`, a `preset::param_id()`, to `value` in the plugin's units
+        Param = 3,
+        /// bends MIDI channel `id` by `value`, -1 to 1 of its bend range
+        PitchBend = 4,
+        /// sets the pressure of MIDI channel `id` to `value`, 0-1
+        Pressure = 5,
+    };
+
+    /** @brief An event sent by a client, played at `time`.
+     *
+     * Times are in samples on the server's timeline, which starts at 0 when the server starts and is shared by every client.
+     * Events earlier than the block being rendered are played at its start. Parameter changes apply from the start
+     * of the block they fall in.
+     */
+    struct Message {
+        uint64_t time;
+        MessageKind kind;
+        /// MIDI note number for notes, parameter ID for parameters, MIDI channel 0-15 for bends and pressure
+        uint32_t id;
+        /// velocity 0-1 for note ons, parameter value for parameters
+        float value;
+        /// MIDI channel 0-15 of notes, for MPE
+        uint32_t channel;
+    };
+
+    static_assert(std::is_trivially_copyable_v<Message> && sizeof(Message) == 24);
+
+    /** @brief Sent by the server to each client as it connects, along with the ring's file descriptor.
+     */
+    struct Hello {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t sample_rate;
+        /// samples per block in the ring
+        uint32_t block_size;
+        /// blocks the ring holds
+        uint32_t slots;
+        /// blocks the server renders ahead of real time
+        uint32_t lead;
+        /// size of the ring's shared memory
+        uint64_t ring_bytes;
+    };
+
+    static_assert(std::is_trivially_copyable_v<Hello>);
+
+    // the ring is shared between processes, so its atomics can't be lock based
+    static_assert(std::atomic<uint64_t>::is_always_lock_free);
+
+    /** @brief Start of the ring's shared memory, followed by `slots` blocks of samples.
+     */
+    struct RingHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t sample_rate;
+        uint32_t block_size;
+        uint32_t slots;
+        uint32_t lead;
+        /// blocks published so far, the next block is rendered from sample `written * block_size`
+        alignas(64) std::atomic<uint64_t> written;
+    };
+
+    /** @brief A ring of rendered blocks in shared memory, written by the server and read in place by every client.
+     *
+     * Each slot holds a block of mono samples and the index of the block it holds, which the writer clears while
+     * it renders into the slot, like a seqlock. Readers never block the writer: a reader falling more than
+     * `slots` blocks behind finds its blocks overwritten, and can check whether a block changed while it was reading it.
+     */
+    class Ring {
+     public:
+        /** @brief Bytes of shared memory a ring needs.
+         */
+        static size_t bytes(const uint32_t block_size, const uint32_t slots) {
+            return header_bytes + static_cast<size_t>(slots) * stride(block_size);
+        }
+
+        Ring() = default;
+
+        /** @brief Views a ring in memory laid out by `init()`, or another process.
+         */
+        explicit Ring(void* memory) : base {static_cast<std::byte*>(memory)} {}
+
+        /** @brief Lays out a new, empty ring. Only call from the writing process.
+         */
+        void init(const uint32_t sample_rate, const uint32_t block_size, const uint32_t slots, const uint32_t lead) {
+            auto* h = new(base) RingHeader {magic, version, sample_rate, block_size, slots, lead, {}};
+            h->written.store(0, std::memory_order_relaxed);
+            for (uint32_t s = 0; s < slots; s++) {
+                new(base + header_bytes + s * stride(block_size)) std::atomic<uint64_t> {empty};
+            }
+            std::atomic_thread_fence(std::memory_order_release);
+        }
+
+        [[nodiscard]] const RingHeader& header() const {
+            return *reinterpret_cast<const RingHeader*>(base);
+        }
+
+        /** @brief Blocks published so far.
+         */
+        [[nodiscard]] uint64_t written() const {
+            return header().written.load(std::memory_order_acquire);
+        }
+
+        /** @brief Starts writing the next block, returning where to render its samples. Only call from the writer.
+         */
+        float* begin_write() {
+            const auto block = written();
+            auto& held = slot_block(block);
+            held.store(empty, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            return samples(block);
+        }
+
+        /** @brief Publishes the block started by `begin_write()`. Only call from the writer.
+         */
+        void end_write() {
+            auto& h = *reinterpret_cast<RingHeader*>(base);
+            const auto block = h.written.load(std::memory_order_relaxed);
+            slot_block(block).store(block, std::memory_order_release);
+            h.written.store(block + 1, std::memory_order_release);
+        }
+
+        /** @brief Samples of a published block, to read in place, or `nullptr` if it isn't written yet or was overwritten.
+         *
+         * The writer may overwrite the block while it's read, so check `still_valid()` after reading it.
+         */
+        [[nodiscard]] const float* read(const uint64_t block) const {
+            if (slot_block(block).load(std::memory_order_acquire) != block) {
+                return nullptr;
+            }
+            return samples(block);
+        }
+
+        /** @brief Whether a block read with `read()` wasn't overwritten while it was read.
+         */
+        [[nodiscard]] bool still_valid(const uint64_t block) const {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return slot_block(block).load(std::memory_order_relaxed) == block;
+        }
+
+     private:
+        static constexpr uint64_t empty = ~uint64_t {0};
+        static constexpr size_t line = 64;
+        static constexpr size_t header_bytes = (sizeof(RingHeader) + line - 1) / line * line;
+
+        // each slot's block index on its own cache line, then its samples
+        static size_t stride(const uint32_t block_size) {
+            return line + (block_size * sizeof(float) + line - 1) / line * line;
+        }
+
+        std::byte* base = nullptr;
+
+        [[nodiscard]] std::byte* slot(const uint64_t block) const {
+            const auto& h = header();
+            return base + header_bytes + (block % h.slots) * stride(h.block_size);
+        }
+
+        [[nodiscard]] std::atomic<uint64_t>& slot_block(const uint64_t block) const {
+            return *reinterpret_cast<std::atomic<uint64_t>*>(slot(block));
+        }
+
+        [[nodiscard]] float* samples(const uint64_t block) const {
+            return reinterpret_cast<float*>(slot(block) + line);
+        }
+    };
+}
@@ -0,0 +1,321 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "server.hpp"
+
+#include <dsp/modal_params.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#ifndef MSG_NOSIGNAL
+// macOS has no flag for it, sockets are set to SO_NOSIGPIPE instead
+#define MSG_NOSIGNAL 0
+#endif
+
+namespace modal::server {
+    const char* validate(const Settings& settings) {
+        if (settings.socket_path.empty() || settings.socket_path.size() >= sizeof(sockaddr_un::sun_path)) {
+            return "socket path must be 1-103 characters";
+        }
+        if (settings.sample_rate < 8000 || settings.sample_rate > 768000) {
+            return "sample rate must be 8000-768000";
+        }
+        if (settings.block_size < min_block_size || settings.block_size > max_block_size) {
+            return "block size must be 16-4096";
+        }
+        if (settings.lead < 1) {
+            return "lead must be at least 1 block";
+        }
+        // leaves clients reading in real time as many blocks again to fall behind by before they're overwritten
+        if (settings.slots < 2 * settings.lead) {
+            return "slots must be at least twice the lead";
+        }
+        if (settings.max_clients < 1 || settings.max_pending < 1) {
+            return "clients and pending events must be at least 1";
+        }
+        if (settings.load_target < 0 || settings.load_target > 1) {
+            return "load target must be 0-1";
+        }
+        return nullptr;
+    }
+
+    namespace {
+        void set_no_sigpipe([[maybe_unused]] const int fd) {
+#ifdef SO_NOSIGPIPE
+            const int on = 1;
+            setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+        }
+
+        int channel(const uint32_t c) {
+            return static_cast<int>(std::min<uint32_t>(c, dsp::synth::ModalEngine::channel_count - 1));
+        }
+
+        std::string describe(const char* what) {
+            return std::string {what} + ": " + std::strerror(errno);
+        }
+    }
+
+    Server::Server(const Settings& s) : settings {s}, engine {std::make_unique<dsp::synth::ModalEngine>()} {
+        engine->set_sample_rate(static_cast<dsp::num>(settings.sample_rate));
+        engine->set_load_target(settings.load_target);
+        engine->set_quality(settings.quality);
+        engine->set_mpe(settings.mpe);
+        connections.reserve(settings.max_clients);
+        pending.reserve(settings.max_pending);
+    }
+
+    Server::~Server() {
+        close_all();
+    }
+
+    void Server::set_state(const dsp::preset::PatchState& s) {
+        state = s;
+        state_changed = true;
+    }
+
+    bool Server::open(std::string& error) {
+        if (const char* invalid = validate(settings)) {
+            error = invalid;
+            return false;
+        }
+
+        // the ring is shared by passing its descriptor, so its name is only needed until it's opened
+        static std::atomic<uint32_t> rings {0};
+        const auto name = "/modal-synth-" + std::to_string(getpid()) + "-" + std::to_string(rings++);
+        ring_fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (ring_fd < 0) {
+            error = describe("couldn't create the ring");
+            return false;
+        }
+        shm_unlink(name.c_str());
+        ring_bytes = Ring::bytes(settings.block_size, settings.slots);
+        if (ftruncate(ring_fd, static_cast<off_t>(ring_bytes)) != 0) {
+            error = describe("couldn't size the ring");
+            return false;
+        }
+        ring_memory = mmap(nullptr, ring_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, ring_fd, 0);
+        if (ring_memory == MAP_FAILED) {
+            ring_memory = nullptr;
+            error = describe("couldn't map the ring");
+            return false;
+        }
+        ring = Ring {ring_memory};
+        ring.init(settings.sample_rate, settings.block_size, settings.slots, settings.lead);
+
+        listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listen_fd < 0) {
+            error = describe("couldn't create the socket");
+            return false;
+        }
+        sockaddr_un address {};
+        address.sun_family = AF_UNIX;
+        std::memcpy(address.sun_path, settings.socket_path.c_str(), settings.socket_path.size() + 1);
+        // a socket left behind by a server that didn't shut down cleanly
+        unlink(settings.socket_path.c_str());
+        if (bind(listen_fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+            error = describe("couldn't bind the socket");
+            return false;
+        }
+        if (listen(listen_fd, static_cast<int>(settings.max_clients)) != 0) {
+            error = describe("couldn't listen on the socket");
+            return false;
+        }
+        return true;
+    }
+
+    void Server::run(const std::atomic<bool>& stop) {
+        using clock = std::chrono::steady_clock;
+        const std::chrono::duration<double> block_time {static_cast<double>(settings.block_size) / settings.sample_rate};
+        // a block after now, leaving time to render the first `lead` blocks
+        const auto start = clock::now() + std::chrono::duration_cast<clock::duration>(block_time);
+        std::vector<pollfd> polled;
+        polled.reserve(settings.max_clients + 1);
+
+        while (!stop.load(std::memory_order_relaxed)) {
+            // each block is rendered `lead` blocks before it's heard
+            const auto block = static_cast<double>(ring.written());
+            const auto due = start + std::chrono::duration_cast<clock::duration>(block_time * (block - settings.lead));
+            const auto heard = start + std::chrono::duration_cast<clock::duration>(block_time * block);
+
+            // rounded up, as the lead covers waking late, at most 100ms so `stop` is seen
+            const auto wait = std::chrono::duration<double, std::milli>(due - clock::now()).count();
+            const int timeout = static_cast<int>(std::clamp(std::ceil(wait), 0.0, 100.0));
+
+            polled.clear();
+            polled.push_back({listen_fd, POLLIN, 0});
+            for (const auto& c: connections) {
+                polled.push_back({c.fd, POLLIN, 0});
+            }
+            if (poll(polled.data(), static_cast<nfds_t>(polled.size()), timeout) > 0) {
+                // connections only change below, so still line up with `polled`
+                for (size_t i = connections.size(); i > 0; i--) {
+                    if (polled[i].revents != 0 && !receive(connections[i - 1])) {
+                        close(connections[i - 1].fd);
+                        connections.erase(connections.begin() + static_cast<std::ptrdiff_t>(i - 1));
+                    }
+                }
+                if (polled[0].revents & POLLIN) {
+                    accept_client();
+                }
+            }
+
+            const auto now = clock::now();
+            if (now >= due) {
+                if (now > heard) {
+                    counts.late_blocks++;
+                }
+                render_block();
+            }
+        }
+    }
+
+    void Server::accept_client() {
+        const int fd = accept(listen_fd, nullptr, nullptr);
+        if (fd < 0) {
+            return;
+        }
+        if (connections.size() == settings.max_clients) {
+            close(fd);
+            return;
+        }
+        set_no_sigpipe(fd);
+
+        const Hello hello {magic, version, settings.sample_rate, settings.block_size, settings.slots, settings.lead, ring_bytes};
+        iovec data {const_cast<Hello*>(&hello), sizeof(hello)};
+        alignas(cmsghdr) std::array<char, CMSG_SPACE(sizeof(int))> control {};
+        msghdr message {};
+        message.msg_iov = &data;
+        message.msg_iovlen = 1;
+        message.msg_control = control.data();
+        message.msg_controllen = control.size();
+        auto* header = CMSG_FIRSTHDR(&message);
+        header->cmsg_level = SOL_SOCKET;
+        header->cmsg_type = SCM_RIGHTS;
+        header->cmsg_len = CMSG_LEN(sizeof(int));
+        std::memcpy(CMSG_DATA(header), &ring_fd, sizeof(int));
+
+        if (sendmsg(fd, &message, MSG_NOSIGNAL) != static_cast<ssize_t>(sizeof(hello))
+            || fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) != 0) {
+            close(fd);
+            return;
+        }
+        connections.push_back({fd});
+        counts.clients++;
+    }
+
+    bool Server::receive(Connection& c) {
+        std::array<std::byte, sizeof(Message) * 64> buffer;
+        std::memcpy(buffer.data(), c.partial.data(), c.have);
+        const auto got = recv(c.fd, buffer.data() + c.have, buffer.size() - c.have, 0);
+        if (got == 0) {
+            return false;
+        }
+        if (got < 0) {
+            return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+        }
+
+        const size_t total = c.have + static_cast<size_t>(got);
+        const size_t whole = total / sizeof(Message);
+        for (size_t i = 0; i < whole; i++) {
+            Message m;
+            std::memcpy(&m, buffer.data() + i * sizeof(Message), sizeof(Message));
+            queue(m);
+        }
+        c.have = total - whole * sizeof(Message);
+        std::memcpy(c.partial.data(), buffer.data() + whole * sizeof(Message), c.have);
+        return true;
+    }
+
+    void Server::queue(const Message& m) {
+        if (m.kind < MessageKind::NoteOn || m.kind > MessageKind::Pressure) {
+            return;
+        }
+        if (pending.size() == settings.max_pending) {
+            counts.dropped_events++;
+            return;
+        }
+        if (m.time < ring.written() * settings.block_size) {
+            counts.late_events++;
+        }
+        // usually sent in order, so this rarely moves anything
+        pending.push_back(m);
+        for (auto at = pending.size() - 1; at > 0 && pending[at - 1].time > m.time; at--) {
+            std::swap(pending[at], pending[at - 1]);
+        }
+    }
+
+    void Server::render_block() {
+        const uint64_t start = ring.written() * settings.block_size;
+        const uint64_t end = start + settings.block_size;
+
+        size_t played = 0;
+        for (; played < pending.size() && pending[played].time < end; played++) {
+            const auto& m = pending[played];
+            const auto offset = static_cast<uint32_t>(m.time > start ? m.time - start : 0);
+            bool queued = true;
+            switch (m.kind) {
+                case MessageKind::NoteOn:
+                    queued = engine->note_on(static_cast<int>(m.id), std::clamp(m.value, 0.0f, 1.0f), offset, channel(m.channel));
+                    break;
+                case MessageKind::NoteOff:
+                    queued = engine->note_off(static_cast<int>(m.id), offset, channel(m.channel));
+                    break;
+                case MessageKind::PitchBend:
+                    queued = engine->pitch_bend(channel(m.id), m.value, offset);
+                    break;
+                case MessageKind::Pressure:
+                    queued = engine->pressure(channel(m.id), m.value, offset);
+                    break;
+                case MessageKind::Param:
+                    queued = state.set(m.id, m.value);
+                    state_changed = true;
+                    break;
+            }
+            if (!queued) {
+                counts.dropped_events++;
+            }
+        }
+        pending.erase(pending.begin(), pending.begin() + static_cast<std::ptrdiff_t>(played));
+
+        if (state_changed) {
+            state_changed = false;
+            engine->set_params(dsp::synth::ModalParams::from_state(state));
+        }
+
+        engine->render(ring.begin_write(), settings.block_size);
+        ring.end_write();
+        counts.blocks++;
+    }
+
+    void Server::close_all() {
+        for (const auto& c: connections) {
+            close(c.fd);
+        }
+        connections.clear();
+        if (listen_fd >= 0) {
+            close(listen_fd);
+            unlink(settings.socket_path.c_str());
+            listen_fd = -1;
+        }
+        // clients keep their own mappings of the ring
+        if (ring_memory != nullptr) {
+            munmap(ring_memory, ring_bytes);
+            ring_memory = nullptr;
+        }
+        if (ring_fd >= 0) {
+            close(ring_fd);
+            ring_fd = -1;
+        }
+    }
+}
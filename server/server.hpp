@@ -0,0 +1,155 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// A render server: one modal synth engine, played by local clients over a UNIX domain socket,
+// streaming its output to all of them through a ring in shared memory.
+
+#pragma once
+
+#include <dsp/modal_engine.hpp>
+#include <dsp/preset.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "protocol.hpp"
+
+namespace modal::server {
+    /** @brief How the server listens, renders and streams.
+     */
+    struct Settings {
+        /// path of the socket to listen on, replacing any socket already there
+        std::string socket_path = "/tmp/modal-synth.sock";
+        uint32_t sample_rate = 48000;
+        /// samples per block rendered and published to the ring
+        uint32_t block_size = 128;
+        /// blocks the ring holds, how far behind a client can fall before its blocks are overwritten
+        uint32_t slots = 64;
+        /// blocks rendered ahead of real time, the latency of an event sent for the next block
+        uint32_t lead = 4;
+        /// most clients connected at once, later ones are turned away
+        uint32_t max_clients = 16;
+        /// most events waiting for their block, later ones are dropped
+        uint32_t max_pending = 4096;
+        /// time a block should take to render over its duration, above which voices play fewer modes, 0 for no limit
+        double load_target = 0.7;
+        /// quality tier of the engine
+        dsp::synth::Quality quality = dsp::synth::Quality::Normal;
+        /// whether notes on MIDI channels 1-15 have their own bend and pressure, see `ModalEngine::set_mpe()`
+        bool mpe = false;
+    };
+
+    constexpr uint32_t min_block_size = 16;
+    constexpr uint32_t max_block_size = 4096;
+
+    /** @brief Checks settings are ones the server can run with.
+     *
+     * @return Description of the first setting that isn't, or `nullptr` if they're fine
+     */
+    const char* validate(const Settings& settings);
+
+    /** @brief Counts of what the server did, since it started.
+     */
+    struct Stats {
+        uint64_t blocks = 0;
+        /// blocks rendered later than `lead` blocks ahead, so clients may have run out of audio
+        uint64_t late_blocks = 0;
+        /// events received after their block was rendered, played at the start of the next one
+        uint64_t late_events = 0;
+        /// events dropped because `max_pending` were waiting, or the engine's queue was full
+        uint64_t dropped_events = 0;
+        uint64_t clients = 0;
+    };
+
+    /** @brief Renders one `synth::ModalEngine` in real time for every connected client.
+     *
+     * Clients connect to the socket and are sent a `Hello` and the ring's file descriptor. They send timestamped
+     * `Message`s, which wait until the block they fall in, and read the blocks from the ring in place.
+     * Every client plays the same voices on the same timeline, so the voice pool and its coefficients stay warm
+     * between clients, and clients hear each other's notes.
+     *
+     * The server runs on the thread calling `run()`: between blocks it accepts clients and reads their events,
+     * so no locks are taken, and nothing is allocated once the clients are connected.
+     */
+    class Server {
+     public:
+        explicit Server(const Settings& settings);
+        ~Server();
+
+        Server(const Server&) = delete;
+        Server& operator=(const Server&) = delete;
+
+        /** @brief Sets the patch played, from a state saved by the ModalSynth plugin. Call before `run()`.
+         */
+        void set_state(const dsp::preset::PatchState& state);
+
+        /** @brief Creates the ring and starts listening on the socket.
+         *
+         * @param error Set to why, if it couldn't
+         * @return `false` if it couldn't
+         */
+        bool open(std::string& error);
+
+        /** @brief Renders and serves clients until `stop` is set. Call after `open()`.
+         */
+        void run(const std::atomic<bool>& stop);
+
+        /** @brief What the server did. Only call from the thread running it, or once it's stopped.
+         */
+        [[nodiscard]] const Stats& stats() const {
+            return counts;
+        }
+
+        /** @brief The engine's timings. Can be called from another thread while the server runs.
+         */
+        dsp::perf::Summary engine_stats() {
+            return engine->stats();
+        }
+
+        /** @brief Modes the voices can currently play between them, from any thread.
+         */
+        [[nodiscard]] uint32_t mode_budget() const {
+            return engine->mode_budget();
+        }
+
+     private:
+        struct Connection {
+            int fd = -1;
+            // a partly received message
+            std::array<std::byte, sizeof(Message)> partial {};
+            size_t have = 0;
+        };
+
+        Settings settings;
+        // large, so kept off the stack of whoever creates the server
+        std::unique_ptr<dsp::synth::ModalEngine> engine;
+        dsp::preset::PatchState state;
+        bool state_changed = false;
+
+        int listen_fd = -1;
+        int ring_fd = -1;
+        void* ring_memory = nullptr;
+        size_t ring_bytes = 0;
+        Ring ring;
+
+        std::vector<Connection> connections;
+        // sorted by time, in the order they arrived for equal times
+        std::vector<Message> pending;
+        Stats counts;
+
+        void accept_client();
+
+        // false once the client has disconnected
+        bool receive(Connection& c);
+
+        void queue(const Message& m);
+
+        void render_block();
+
+        void close_all();
+    };
+}
@@ -24,10 +24,15 @@ namespace modal::plugin {
         spectrum_controls.setup(params);
         exciter_controls.setup(params);
         macro_controls.setup(params);
+        modulation_controls.setup(params);
+        const auto tab_colour = laf.findColour(juce::ResizableWindow::backgroundColourId);
+        modulation_tabs.addTab("Macros", tab_colour, &macro_controls, false);
+        modulation_tabs.addTab("Modulation", tab_colour, &modulation_controls, false);
+        modulation_tabs.addTab("Performance", tab_colour, &perf_display, false);
         addAndMakeVisible(controls);
         addAndMakeVisible(spectrum_controls);
         addAndMakeVisible(exciter_controls);
-        addAndMakeVisible(macro_controls);
+        addAndMakeVisible(modulation_tabs);
 
         if (JUCEApplicationBase::isStandaloneApp()) {
             addAndMakeVisible(keyboard);
@@ -61,7 +66,7 @@ namespace modal::plugin {
 
         grid.items = {
             Item{controls}.withColumn({1, 3}),
-            Item{macro_controls}.withColumn({3, 4}).withRow({1, 3}),
+            Item{modulation_tabs}.withColumn({3, 4}).withRow({1, 3}),
             Item{exciter_controls}, Item{spectrum_controls}
         };
 
@@ -85,6 +90,7 @@ namespace modal::plugin {
         decay.setup(plug_params, "decay");
         fb_amount.setup(plug_params, "fb_amt");
         fb_intensity.setup(plug_params, "fb_ins");
+        fb_routing.setup(plug_params, "fb_route");
 
         addAndMakeVisible(foldback_mode);
         addAndMakeVisible(foldback_point);
@@ -92,6 +98,7 @@ namespace modal::plugin {
         addAndMakeVisible(decay);
         addAndMakeVisible(fb_amount);
         addAndMakeVisible(fb_intensity);
+        addAndMakeVisible(fb_routing);
     }
 
     void MiniEditor::Controls::paint(juce::Graphics& g) {
@@ -110,7 +117,8 @@ namespace modal::plugin {
                 FlexItem(foldback_point).withFlex(1),
                 FlexItem(decay).withFlex(1),
                 FlexItem(fb_amount).withFlex(1),
-                FlexItem(fb_intensity).withFlex(1)
+                FlexItem(fb_intensity).withFlex(1),
+                FlexItem(fb_routing).withFlex(1).withHeight(40).withAlignSelf(FlexItem::AlignSelf::center)
         };
 
         fb.performLayout(getLocalBounds().reduced(10));
@@ -168,6 +176,8 @@ namespace modal::plugin {
 
         attack.setup(plug_params, "attack");
         release.setup(plug_params, "release");
+        attack_curve.setup(plug_params, "attack_curve");
+        release_curve.setup(plug_params, "release_curve");
 
         l.setJustificationType(Justification::centred);
         l.setFont(Font{FontOptions{24}});
@@ -176,6 +186,8 @@ namespace modal::plugin {
         addAndMakeVisible(exciter_rate);
         addAndMakeVisible(attack);
         addAndMakeVisible(release);
+        addAndMakeVisible(attack_curve);
+        addAndMakeVisible(release_curve);
         addAndMakeVisible(l);
     }
 
@@ -190,13 +202,15 @@ namespace modal::plugin {
         using Fr = Grid::Fr;
         using Item = GridItem;
 
-        grid.templateRows = {Track{Fr{1}}, Track{Fr{4}}, Track{Fr{4}}};
+        grid.templateRows = {Track{Fr{1}}, Track{Fr{4}}, Track{Fr{4}}, Track{Fr{1}}};
         grid.templateColumns = {Track{Fr{1}}, Track{Fr{1}}};
 
         grid.items = {
                 Item{l}.withColumn({1, 3}),
                 Item{exciter_mode}.withHeight(40).withAlignSelf(GridItem::AlignSelf::center), Item{exciter_rate},
-                Item{attack}, Item{release}
+                Item{attack}, Item{release},
+                Item{attack_curve}.withHeight(30).withAlignSelf(GridItem::AlignSelf::center),
+                Item{release_curve}.withHeight(30).withAlignSelf(GridItem::AlignSelf::center)
         };
 
         grid.performLayout(getLocalBounds().reduced(10));
@@ -231,4 +245,52 @@ namespace modal::plugin {
 
         fb.performLayout(getLocalBounds().reduced(10));
     }
+
+    void MiniEditor::ModulationControls::setup(AudioProcessorValueTreeState& plug_params) {
+        lfo_1_rate.setup(plug_params, "lfo_1_rate");
+        lfo_1_shape.setup(plug_params, "lfo_1_shape");
+        lfo_2_rate.setup(plug_params, "lfo_2_rate");
+        lfo_2_shape.setup(plug_params, "lfo_2_shape");
+        attack.setup(plug_params, "mod_attack");
+        decay.setup(plug_params, "mod_decay");
+        sustain.setup(plug_params, "mod_sustain");
+        release.setup(plug_params, "mod_release");
+        random_rate.setup(plug_params, "random_rate");
+        control_rate.setup(plug_params, "control_rate");
+        routes.setup();
+
+        addAndMakeVisible(lfo_1_rate);
+        addAndMakeVisible(lfo_1_shape);
+        addAndMakeVisible(lfo_2_rate);
+        addAndMakeVisible(lfo_2_shape);
+        addAndMakeVisible(attack);
+        addAndMakeVisible(decay);
+        addAndMakeVisible(sustain);
+        addAndMakeVisible(release);
+        addAndMakeVisible(random_rate);
+        addAndMakeVisible(control_rate);
+        addAndMakeVisible(routes);
+    }
+
+    void MiniEditor::ModulationControls::resized() {
+        Grid grid;
+
+        using Track = Grid::TrackInfo;
+        using Fr = Grid::Fr;
+        using Item = GridItem;
+
+        grid.templateRows = {Track{Fr{2}}, Track{Fr{2}}, Track{Fr{2}}, Track{Fr{5}}};
+        grid.templateColumns = {Track{Fr{1}}, Track{Fr{1}}, Track{Fr{1}}, Track{Fr{1}}};
+
+        grid.items = {
+                Item{lfo_1_rate}, Item{lfo_1_shape}.withHeight(40).withAlignSelf(GridItem::AlignSelf::center),
+                Item{lfo_2_rate}, Item{lfo_2_shape}.withHeight(40).withAlignSelf(GridItem::AlignSelf::center),
+                Item{attack}, Item{decay}, Item{sustain}, Item{release},
+                Item{random_rate}, Item{control_rate}.withHeight(40).withAlignSelf(GridItem::AlignSelf::center),
+                Item{}, Item{},
+                Item{routes}.withColumn({1, 5})
+        };
+
+        grid.performLayout(getLocalBounds().reduced(10));
+    }
 }
@@ -2,6 +2,7 @@
 
 #include <MiniModal/PluginProcessor.hpp>
 #include <MiniModal/PluginEditor.hpp>
+#include <ui/PresetState.hpp>
 
 namespace modal::plugin {
 //==============================================================================
@@ -23,6 +24,10 @@ namespace modal::plugin {
             std::make_unique<juce::AudioParameterFloat>("exciter_rate", "Exciter Rate Divider", 1, 100, 4),
             std::make_unique<juce::AudioParameterFloat>("attack", "Attack", 0, 5, 0.5),
             std::make_unique<juce::AudioParameterFloat>("release", "Release", 0, 5, 0.5),
+            std::make_unique<juce::AudioParameterChoice>("attack_curve", "Attack Curve",
+                                                         juce::StringArray{"Linear", "Exponential"}, 0),
+            std::make_unique<juce::AudioParameterChoice>("release_curve", "Release Curve",
+                                                         juce::StringArray{"Linear", "Exponential"}, 0),
             std::make_unique<juce::AudioParameterInt>("modes", "Mode Count", 1, 40, 40),
             std::make_unique<juce::AudioParameterFloat>("detune", "Mode Detune Linear", -0.06, 2, 0),
             std::make_unique<juce::AudioParameterFloat>("exponent", "Mode Detune Exponent", 0.1, 10, 1),
@@ -30,10 +35,59 @@ namespace modal::plugin {
             std::make_unique<juce::AudioParameterFloat>("decay", "Decay", NormalisableRange<float>{0.1f, 5.f}, 1.f),
             std::make_unique<juce::AudioParameterFloat>("fb_amt", "Feedback Amount", NormalisableRange<float>{0.0f, 0.02f}, 0.f),
             std::make_unique<juce::AudioParameterFloat>("fb_ins", "Feedback Intensity", NormalisableRange<float>{0.001f, 5.f}, 0.001f),
+            std::make_unique<juce::AudioParameterChoice>("fb_route", "Feedback Routing",
+                                                         juce::StringArray{"Immediate", "Delayed"}, 0),
             std::make_unique<juce::AudioParameterFloat>("macro_control_1", "Macro Control 1", NormalisableRange<float>{0.f, 1.f}, 0.5f, AudioParameterFloatAttributes().withMeta(true)),
-            std::make_unique<juce::AudioParameterFloat>("macro_control_2", "Macro Control 2", NormalisableRange<float>{0.f, 1.f}, 0.5f, AudioParameterFloatAttributes().withMeta(true))
-    }},  macro_control_1 { *this }, macro_control_2 { *this }, controller{ modal_synths } {
+            std::make_unique<juce::AudioParameterFloat>("macro_control_2", "Macro Control 2", NormalisableRange<float>{0.f, 1.f}, 0.5f, AudioParameterFloatAttributes().withMeta(true)),
+            // modulation sources, after the macros so existing macro mappings keep their target indices
+            std::make_unique<juce::AudioParameterFloat>("lfo_1_rate", "LFO 1 Rate", NormalisableRange<float>{0.01f, 20.f, 0.f, 0.3f}, 1.f),
+            std::make_unique<juce::AudioParameterChoice>("lfo_1_shape", "LFO 1 Shape",
+                                                         juce::StringArray{"Sine", "Triangle", "Saw", "Square"}, 0),
+            std::make_unique<juce::AudioParameterFloat>("lfo_2_rate", "LFO 2 Rate", NormalisableRange<float>{0.01f, 20.f, 0.f, 0.3f}, 0.25f),
+            std::make_unique<juce::AudioParameterChoice>("lfo_2_shape", "LFO 2 Shape",
+                                                         juce::StringArray{"Sine", "Triangle", "Saw", "Square"}, 1),
+            std::make_unique<juce::AudioParameterFloat>("mod_attack", "Mod Envelope Attack", NormalisableRange<float>{0.001f, 5.f, 0.f, 0.4f}, 0.01f),
+            std::make_unique<juce::AudioParameterFloat>("mod_decay", "Mod Envelope Decay", NormalisableRange<float>{0.001f, 5.f, 0.f, 0.4f}, 0.3f),
+            std::make_unique<juce::AudioParameterFloat>("mod_sustain", "Mod Envelope Sustain", 0, 1, 0.5),
+            std::make_unique<juce::AudioParameterFloat>("mod_release", "Mod Envelope Release", NormalisableRange<float>{0.001f, 5.f, 0.f, 0.4f}, 0.5f),
+            std::make_unique<juce::AudioParameterFloat>("random_rate", "Random Rate", NormalisableRange<float>{0.01f, 20.f, 0.f, 0.3f}, 2.f),
+            std::make_unique<juce::AudioParameterChoice>("control_rate", "Modulation Control Rate",
+                                                         juce::StringArray{"16 Samples", "32 Samples", "64 Samples"}, 1)
+    }},  macro_control_1 { *this }, macro_control_2 { *this },
+         mod_control { *this, {"LFO 1", "LFO 2", "Envelope", "Random", "Mod Wheel", "Aftertouch", "Velocity", "Note"} },
+         mod_targets { ui::MacroController::targets(*this) },
+         modulation { mod_targets.size(), 3 * ui::MacroController::num_settings },
+         controller{ modal_synths } {
         params.state.addListener(this);
+        target_idx = {
+            target_index("even_gain"), target_index("foldback_point"), target_index("exciter_rate"),
+            target_index("attack"), target_index("release"), target_index("detune"), target_index("exponent"),
+            target_index("falloff"), target_index("decay"), target_index("fb_amt"), target_index("fb_ins"),
+            target_index("lfo_1_rate"), target_index("lfo_2_rate"), target_index("mod_attack"), target_index("mod_decay"),
+            target_index("mod_sustain"), target_index("mod_release"), target_index("random_rate")
+        };
+        for (const auto* t : mod_targets) {
+            target_ids.push_back(dsp::preset::param_id(t->getParameterID().toRawUTF8()));
+        }
+        const auto choice = [this](const char* id) {
+            return dynamic_cast<juce::AudioParameterChoice*>(params.getParameter(id));
+        };
+        const auto real = [this](const char* id) {
+            return dynamic_cast<juce::AudioParameterFloat*>(params.getParameter(id));
+        };
+        param = {
+            choice("exciter"), choice("foldback_mode"), choice("fb_route"),
+            choice("lfo_1_shape"), choice("lfo_2_shape"), choice("control_rate"),
+            choice("attack_curve"), choice("release_curve"),
+            dynamic_cast<juce::AudioParameterInt*>(params.getParameter("modes")),
+            real("macro_control_1"), real("macro_control_2")
+        };
+        for (auto& m: modal_synths) {
+            m.set_patch(patch);
+        }
+        load_preset_library(default_preset_library());
+        // pick the DSP kernels for this CPU at load, rather than on the first audio block
+        dsp::simd::kernels();
     }
 
     MiniProcessor::~MiniProcessor() = default;
@@ -72,21 +126,25 @@ namespace modal::plugin {
     }
 
     int MiniProcessor::getNumPrograms() {
-        return 1;   // NB: some hosts don't cope very well if you tell them there are 0 programs,
+        // NB: some hosts don't cope very well if you tell them there are 0 programs,
         // so this should be at least 1, even if you're not really implementing programs.
+        return std::max(1, static_cast<int>(presets.size()));
     }
 
     int MiniProcessor::getCurrentProgram() {
-        return 0;
+        return current_preset;
     }
 
     void MiniProcessor::setCurrentProgram(int index) {
-        juce::ignoreUnused(index);
+        if (index >= 0 && presets.load(static_cast<size_t>(index), state_scratch)) {
+            current_preset = index;
+            apply_state(state_scratch);
+        }
     }
 
     const juce::String MiniProcessor::getProgramName(int index) {
-        juce::ignoreUnused(index);
-        return {};
+        const auto name = index >= 0 ? presets.name(static_cast<size_t>(index)) : std::string_view{};
+        return juce::String::fromUTF8(name.data(), static_cast<int>(name.size()));
     }
 
     void MiniProcessor::changeProgramName(int index, const juce::String& newName) {
@@ -98,6 +156,13 @@ namespace modal::plugin {
         for (auto& m: modal_synths) {
             m.set_sample_rate(static_cast<dsp::num>(sampleRate));
         }
+        modulation.set_sample_rate(static_cast<dsp::num>(sampleRate));
+        modulation.matrix.set_base_smoothing_time(parameter_smoothing_time);
+        // start from the current settings, rather than ramping to them
+        for (size_t t = 0; t < mod_targets.size(); t++) {
+            modulation.matrix.set_base(t, mod_targets[t]->convertTo0to1(mod_targets[t]->get()));
+        }
+        modulation.matrix.skip_base_smoothing();
         juce::ignoreUnused(samplesPerBlock);
     }
 
@@ -131,54 +196,78 @@ namespace modal::plugin {
 
     void MiniProcessor::processBlock(juce::AudioBuffer<float>& buffer,
                                                  juce::MidiBuffer& midiMessages) {
-
-        keyboard_state.processNextMidiBuffer(midiMessages, 0, buffer.getNumSamples(), true);
+        const dsp::rt::ScopedRealtime realtime;
+        perf.begin_block(static_cast<size_t>(buffer.getNumSamples()), static_cast<dsp::num>(getSampleRate()));
+
+        // notes played on the on-screen keyboard start at the beginning of the block
+        keyboard.drain([this](const ui::KeyboardBridge::NoteEvent& e) {
+            if (e.on) {
+                start_note(e.note, e.velocity);
+            } else {
+                stop_note(e.note);
+            }
+        });
 
         for (const auto& metadata: midiMessages) {
             auto m = metadata.getMessage();
+            keyboard.show(m);
             if (m.isNoteOn()) {
-                params_changed = true;
-                controller.key_down(m.getNoteNumber(), m.getFloatVelocity());
+                start_note(m.getNoteNumber(), m.getFloatVelocity());
             } else if (m.isNoteOff()) {
-                controller.key_up(m.getNoteNumber());
+                stop_note(m.getNoteNumber());
+            } else if (m.isControllerOfType(1)) {
+                modulation.set_source(dsp::mod::ModEngine::ModWheel, static_cast<dsp::num>(m.getControllerValue()) / 127);
+            } else if (m.isChannelPressure()) {
+                modulation.set_source(dsp::mod::ModEngine::Aftertouch, static_cast<dsp::num>(m.getChannelPressureValue()) / 127);
             }
         }
 
-        macro_control_1.set_values(*params.getRawParameterValue("macro_control_1"));
-        macro_control_2.set_values(*params.getRawParameterValue("macro_control_2"));
-
-        if (params_changed) {
-            params_changed = false;
-            auto exciter_mode = static_cast<dsp::synth::MiniModalExiterKind>(dynamic_cast<juce::AudioParameterChoice*>(params.getParameter(
-                    "exciter"))->
-                    getIndex());
-            auto foldback_mode = static_cast<dsp::synth::MiniModalFoldbackKind>(
-                    dynamic_cast<juce::AudioParameterChoice*>(params.getParameter("foldback_mode"))->getIndex());
-
-            for (auto& m: modal_synths) {
-                m.set_env_params(
-                        *params.getRawParameterValue("attack"),
-                        *params.getRawParameterValue("release")
-                );
-                bool changed = m.set_params(
-                        (size_t) *params.getRawParameterValue("modes"),
-                        *params.getRawParameterValue("detune"),
-                        *params.getRawParameterValue("exponent"),
-                        *params.getRawParameterValue("exciter_rate"),
-                        *params.getRawParameterValue("decay"),
-                        *params.getRawParameterValue("falloff"),
-                        *params.getRawParameterValue("even_gain")
-                );
-                m.set_exciter(exciter_mode);
-                m.set_feedback_settings(*params.getRawParameterValue("fb_amt"), *params.getRawParameterValue("fb_ins"));
-                changed |= m.set_foldback_settings(foldback_mode,
-                                                   params.getRawParameterValue("foldback_point")->load());
-
-                if (changed) {
-                    m.update_mode_coefficients();
+        // the sources' own settings can be modulated too, taking effect from the next control period
+        const auto control_period = dsp::mod::ModEngine::min_control_period << param.control_rate->getIndex();
+        modulation.set_control_period(control_period);
+        // voices ticked sample by sample glide to coefficient updates over the period, as block rendered ones do
+        for (auto& m: modal_synths) {
+            m.set_glide_time(control_period);
+        }
+        modulation.lfo_1.set_params(modulated(target_idx.lfo_1_rate), static_cast<dsp::mod::LfoShape>(param.lfo_1_shape->getIndex()));
+        modulation.lfo_2.set_params(modulated(target_idx.lfo_2_rate), static_cast<dsp::mod::LfoShape>(param.lfo_2_shape->getIndex()));
+        modulation.envelope.set_adsr(modulated(target_idx.mod_attack), modulated(target_idx.mod_decay),
+                                     modulated(target_idx.mod_sustain), modulated(target_idx.mod_release));
+        modulation.random.set_params(modulated(target_idx.random_rate));
+
+        for (size_t t = 0; t < mod_targets.size(); t++) {
+            modulation.matrix.set_base(t, mod_targets[t]->convertTo0to1(mod_targets[t]->get()));
+        }
+        modulation.set_source(dsp::mod::ModEngine::Macro1, param.macro_control_1->get());
+        modulation.set_source(dsp::mod::ModEngine::Macro2, param.macro_control_2->get());
+        modulation.matrix.clear_routes();
+        macro_control_1.add_routes(modulation.matrix, dsp::mod::ModEngine::Macro1);
+        macro_control_2.add_routes(modulation.matrix, dsp::mod::ModEngine::Macro2);
+        mod_control.add_routes(modulation.matrix, dsp::mod::ModEngine::Lfo1);
+
+        // a preset switch jumps straight to the new settings, rather than ramping to them
+        const bool preset_switched = preset_pending.exchange(false);
+        if (preset_switched) {
+            const auto& snapshot = preset_snapshot.acquire();
+            for (size_t t = 0; t < mod_targets.size(); t++) {
+                if (const auto i = snapshot.find(target_ids[t])) {
+                    modulation.matrix.set_base(t, mod_targets[t]->convertTo0to1(snapshot.params[*i].value));
                 }
             }
+            modulation.matrix.skip_base_smoothing();
+            modulation.matrix.process(0);
+        }
 
+        // changes to the patch only mark the voices' coefficients as out of date, see below
+        if (params_changed.exchange(false) || preset_switched) {
+            apply_params();
+        }
+        if (preset_switched) {
+            for (size_t v = 0; v < modal_synths.size(); v++) {
+                modal_synths[v].update_mode_coefficients();
+                coefficients.updated(v);
+            }
+            perf.count(dsp::perf::Counter::CoefficientUpdates, static_cast<uint32_t>(modal_synths.size()));
         }
 
         juce::ScopedNoDenormals noDenormals;
@@ -188,20 +277,107 @@ namespace modal::plugin {
         for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i) {
             buffer.clear(i, 0, buffer.getNumSamples());
         }
-
-        for (int i = 0; i < buffer.getNumSamples(); i++) {
-            dsp::num out = 0;
+        perf.lap(dsp::perf::Stage::Params);
+
+        // sub-blocks end on control period boundaries, where the modulation runs,
+        // and a few out of date voices have their coefficients updated, gliding in over the next sub-block
+        int start = 0;
+        while (start < buffer.getNumSamples()) {
+            const auto n = std::min({dsp::block_size, modulation.samples_until_update(),
+                                     static_cast<size_t>(buffer.getNumSamples() - start)});
+            std::array<dsp::num, dsp::block_size> out {};
             for (auto& m: modal_synths) {
-                out += m.tick();
+                m.render(out.data(), n, &perf);
+            }
+            perf.skip_lap();
+
+            for (size_t i = 0; i < n; i++) {
+                using namespace dsp; // for _nm literal
+                const auto sample = static_cast<float>(out[i] * 0.1_nm);
+                for (int channel = 0; channel < totalNumOutputChannels; ++channel) {
+                    buffer.setSample(channel, start + static_cast<int>(i), sample);
+                }
             }
-            using namespace dsp; // for _nm literal
-            out *= 0.1_nm;
+            perf.lap(dsp::perf::Stage::Output);
 
-            for (int channel = 0; channel < totalNumOutputChannels; ++channel) {
-                buffer.setSample(channel, i, out);
+            const bool period_end = n == modulation.samples_until_update();
+            if (modulation.advance(n)) {
+                apply_params();
             }
+            if (period_end) {
+                const auto updated = coefficients.run([this](const size_t voice) {
+                    modal_synths[voice].update_mode_coefficients(true);
+                });
+                perf.count(dsp::perf::Counter::CoefficientUpdates, static_cast<uint32_t>(updated));
+            }
+            perf.lap(dsp::perf::Stage::Params);
+            start += static_cast<int>(n);
         }
 
+        size_t active_modes = 0;
+        for (size_t v = 0; v < modal_synths.size(); v++) {
+            if (controller.is_active(v)) {
+                active_modes += modal_synths[v].num_modes();
+            }
+        }
+        perf.set_active(controller.active_voices(), active_modes);
+        perf.end_block();
+    }
+
+    dsp::perf::Summary MiniProcessor::perf_summary() {
+        return perf.collect();
+    }
+
+    void MiniProcessor::start_note(const int note, const float velocity) {
+        params_changed = true;
+        // a voice updates its own coefficients on note on
+        if (const auto voice = controller.key_down(note, velocity)) {
+            coefficients.updated(*voice);
+            perf.count(dsp::perf::Counter::CoefficientUpdates);
+        } else {
+            perf.count(dsp::perf::Counter::NoteDrops);
+        }
+        modulation.note_on(note, velocity);
+    }
+
+    void MiniProcessor::stop_note(const int note) {
+        controller.key_up(note);
+        modulation.note_off(note);
+    }
+
+    void MiniProcessor::apply_params() {
+        auto exciter_mode = static_cast<dsp::synth::MiniModalExiterKind>(param.exciter->getIndex());
+        auto foldback_mode = static_cast<dsp::synth::MiniModalFoldbackKind>(param.foldback_mode->getIndex());
+        auto feedback_routing = static_cast<dsp::synth::MiniModalFeedbackRouting>(param.fb_route->getIndex());
+        auto attack_curve = static_cast<dsp::mod::EnvCurve>(param.attack_curve->getIndex());
+        auto release_curve = static_cast<dsp::mod::EnvCurve>(param.release_curve->getIndex());
+
+        bool changed = patch.set_params(
+                (size_t) param.modes->get(),
+                modulated(target_idx.detune),
+                modulated(target_idx.exponent),
+                modulated(target_idx.exciter_rate),
+                modulated(target_idx.decay),
+                modulated(target_idx.falloff),
+                modulated(target_idx.even_gain)
+        );
+        changed |= patch.set_foldback_settings(foldback_mode,
+                                               modulated(target_idx.foldback_point));
+
+        for (auto& m: modal_synths) {
+            m.set_env_params(
+                    modulated(target_idx.attack),
+                    modulated(target_idx.release)
+            );
+            m.set_env_curves(attack_curve, release_curve);
+            m.set_exciter(exciter_mode);
+            m.set_feedback_settings(modulated(target_idx.fb_amt), modulated(target_idx.fb_ins));
+            m.set_feedback_routing(feedback_routing);
+        }
+
+        if (changed) {
+            coefficients.invalidate();
+        }
     }
 
 //==============================================================================
@@ -215,16 +391,27 @@ namespace modal::plugin {
 
 //==============================================================================
     void MiniProcessor::getStateInformation(juce::MemoryBlock& destData) {
-        juce::ValueTree state {"MiniModalSettings"};
-        state.addChild(params.copyState(), -1, nullptr);
-        state.addChild(macro_control_1.dump_state(), -1, nullptr);
-        state.addChild(macro_control_2.dump_state(), -1, nullptr);
-
-        const std::unique_ptr<juce::XmlElement> xml(state.createXml());
-        copyXmlToBinary(*xml, destData);
+        dsp::preset::PatchState state;
+        ui::capture_params(*this, state);
+        macro_control_1.dump_state(state, 0);
+        macro_control_2.dump_state(state, 1);
+        mod_control.dump_state(state, 2);
+
+        std::vector<uint8_t> bytes;
+        dsp::preset::encode(state, bytes);
+        destData.replaceAll(bytes.data(), bytes.size());
     }
 
     void MiniProcessor::setStateInformation(const void* data, const int sizeInBytes) {
+        const std::span bytes {static_cast<const uint8_t*>(data), static_cast<size_t>(std::max(sizeInBytes, 0))};
+        if (dsp::preset::is_encoded(bytes)) {
+            if (dsp::preset::decode(bytes, state_scratch)) {
+                apply_state(state_scratch);
+            }
+            return;
+        }
+
+        // legacy XML states, from before the binary format, relying on the order of the children
         const std::unique_ptr<juce::XmlElement> xmlState(getXmlFromBinary(data, sizeInBytes));
 
         if (xmlState != nullptr) {
@@ -246,9 +433,52 @@ namespace modal::plugin {
                 const auto macro_state = state.getChild(2);
                 macro_control_2.load_state(macro_state);
             }
+
+            {
+                // missing from older states, which leaves every route unmapped
+                const auto mod_state = state.getChild(3);
+                mod_control.load_state(mod_state);
+            }
         }
     }
 
+    size_t MiniProcessor::target_index(const juce::String& id) const {
+        for (size_t t = 0; t < mod_targets.size(); t++) {
+            if (mod_targets[t]->getParameterID() == id) {
+                return t;
+            }
+        }
+        jassertfalse;
+        return 0;
+    }
+
+    float MiniProcessor::modulated(const size_t target) const {
+        return mod_targets[target]->convertFrom0to1(static_cast<float>(modulation.matrix.value(target)));
+    }
+
+    void MiniProcessor::apply_state(const dsp::preset::PatchState& state) {
+        ui::restore_params(*this, state);
+        macro_control_1.load_state(state, 0);
+        macro_control_2.load_state(state, 1);
+        mod_control.load_state(state, 2);
+        // published after the host parameters are set, so the audio thread never goes back to the old ones
+        preset_snapshot.publish(state);
+        preset_pending = true;
+    }
+
+    bool MiniProcessor::load_preset_library(const juce::File& file) {
+        current_preset = 0;
+        const bool loaded = presets.open(file.getFullPathName().toStdString());
+        updateHostDisplay(ChangeDetails{}.withProgramChanged(true));
+        return loaded;
+    }
+
+    juce::File MiniProcessor::default_preset_library() {
+        return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+                .getChildFile("MiniModal")
+                .getChildFile("Presets.mdlb");
+    }
+
     void MiniProcessor::valueTreePropertyChanged(juce::ValueTree& treeWhosePropertyHasChanged,
                                                              const juce::Identifier& property) {
         juce::ignoreUnused(treeWhosePropertyHasChanged, property);
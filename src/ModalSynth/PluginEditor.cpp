@@ -6,8 +6,7 @@
 namespace modal::plugin {
 //==============================================================================
     Editor::Editor(Processor& p, juce::AudioProcessorValueTreeState& pa) : AudioProcessorEditor(&p), processorRef(p), params{pa} {
-        juce::ignoreUnused(processorRef);
-        const int width = 800;
+        const int width = 1000;
         const int height = JUCEApplicationBase::isStandaloneApp() ? 700 : 600;
         const double ratio = static_cast<double>(width) / static_cast<double>(height);
         setSize(width, height);
@@ -24,10 +23,15 @@ namespace modal::plugin {
         sliders.setup(params);
         formant_controls.setup(params);
         exciter_controls.setup(params);
+        modulation_controls.setup(params);
+        const auto tab_colour = laf.findColour(juce::ResizableWindow::backgroundColourId);
+        modulation_tabs.addTab("Modulation", tab_colour, &modulation_controls, false);
+        modulation_tabs.addTab("Performance", tab_colour, &perf_display, false);
         addAndMakeVisible(controls);
         addAndMakeVisible(sliders);
         addAndMakeVisible(formant_controls);
         addAndMakeVisible(exciter_controls);
+        addAndMakeVisible(modulation_tabs);
 
         if (JUCEApplicationBase::isStandaloneApp()) {
             addAndMakeVisible(keyboard);
@@ -57,16 +61,17 @@ namespace modal::plugin {
         using Item = GridItem;
 
         grid.templateRows = {Track{Fr{200}}, Track{Fr{400}}};
-        grid.templateColumns = {Track{Fr{1}}, Track{Fr{1}}, Track{Fr{1}}};
+        grid.templateColumns = {Track{Fr{1}}, Track{Fr{1}}, Track{Fr{1}}, Track{Fr{1}}};
 
         grid.items = {
                 Item{controls}.withColumn({1, 4}),
+                Item{modulation_tabs}.withColumn({4, 5}).withRow({1, 3}),
                 Item{exciter_controls}, Item{sliders}, Item{formant_controls}
         };
 
         if (JUCEApplicationBase::isStandaloneApp()) {
             grid.templateRows.add(Track{Fr{100}});
-            grid.items.add(Item{keyboard}.withColumn({1, 4}).withRow({3, 3}));
+            grid.items.add(Item{keyboard}.withColumn({1, 5}).withRow({3, 3}));
         }
 
         grid.performLayout(getLocalBounds());
@@ -85,6 +90,9 @@ namespace modal::plugin {
         exponent.setup(plug_params, "exponent");
         falloff.setup(plug_params, "falloff");
         decay.setup(plug_params, "decay");
+        damping.setup(plug_params, "damping");
+        quality.setup(plug_params, "quality");
+        mpe.setup(plug_params, "mpe");
 
         addAndMakeVisible(foldback_mode);
         addAndMakeVisible(foldback_point);
@@ -93,6 +101,9 @@ namespace modal::plugin {
         addAndMakeVisible(exponent);
         addAndMakeVisible(falloff);
         addAndMakeVisible(decay);
+        addAndMakeVisible(damping);
+        addAndMakeVisible(quality);
+        addAndMakeVisible(mpe);
     }
 
     void Editor::Controls::paint(juce::Graphics& g) {
@@ -113,6 +124,9 @@ namespace modal::plugin {
                 FlexItem(exponent).withFlex(1),
                 FlexItem(falloff).withFlex(1),
                 FlexItem(decay).withFlex(1),
+                FlexItem(damping).withFlex(1),
+                FlexItem(quality).withFlex(1).withHeight(40).withAlignSelf(FlexItem::AlignSelf::center),
+                FlexItem(mpe).withFlex(1).withHeight(40).withAlignSelf(FlexItem::AlignSelf::center),
         };
 
         fb.performLayout(getLocalBounds().reduced(10));
@@ -171,6 +185,8 @@ namespace modal::plugin {
 
         attack.setup(plug_params, "attack");
         release.setup(plug_params, "release");
+        attack_curve.setup(plug_params, "attack_curve");
+        release_curve.setup(plug_params, "release_curve");
 
         l.setJustificationType(Justification::centred);
         l.setFont(Font{FontOptions{24}});
@@ -179,6 +195,8 @@ namespace modal::plugin {
         addAndMakeVisible(exciter_rate);
         addAndMakeVisible(attack);
         addAndMakeVisible(release);
+        addAndMakeVisible(attack_curve);
+        addAndMakeVisible(release_curve);
         addAndMakeVisible(l);
     }
 
@@ -193,13 +211,15 @@ namespace modal::plugin {
         using Fr = Grid::Fr;
         using Item = GridItem;
 
-        grid.templateRows = {Track{Fr{1}}, Track{Fr{4}}, Track{Fr{4}}};
+        grid.templateRows = {Track{Fr{1}}, Track{Fr{4}}, Track{Fr{4}}, Track{Fr{1}}};
         grid.templateColumns = {Track{Fr{1}}, Track{Fr{1}}};
 
         grid.items = {
                 Item{l}.withColumn({1, 3}),
                 Item{exciter_mode}.withHeight(40).withAlignSelf(GridItem::AlignSelf::center), Item{exciter_rate},
-                Item{attack}, Item{release}
+                Item{attack}, Item{release},
+                Item{attack_curve}.withHeight(30).withAlignSelf(GridItem::AlignSelf::center),
+                Item{release_curve}.withHeight(30).withAlignSelf(GridItem::AlignSelf::center)
         };
 
         grid.performLayout(getLocalBounds().reduced(10));
@@ -245,4 +265,49 @@ namespace modal::plugin {
 
         grid.performLayout(getLocalBounds().reduced(10));
     }
+
+    void Editor::ModulationControls::setup(AudioProcessorValueTreeState& plug_params) {
+        lfo_1_rate.setup(plug_params, "lfo_1_rate");
+        lfo_1_shape.setup(plug_params, "lfo_1_shape");
+        lfo_2_rate.setup(plug_params, "lfo_2_rate");
+        lfo_2_shape.setup(plug_params, "lfo_2_shape");
+        attack.setup(plug_params, "mod_attack");
+        decay.setup(plug_params, "mod_decay");
+        sustain.setup(plug_params, "mod_sustain");
+        release.setup(plug_params, "mod_release");
+        random_rate.setup(plug_params, "random_rate");
+        routes.setup();
+
+        addAndMakeVisible(lfo_1_rate);
+        addAndMakeVisible(lfo_1_shape);
+        addAndMakeVisible(lfo_2_rate);
+        addAndMakeVisible(lfo_2_shape);
+        addAndMakeVisible(attack);
+        addAndMakeVisible(decay);
+        addAndMakeVisible(sustain);
+        addAndMakeVisible(release);
+        addAndMakeVisible(random_rate);
+        addAndMakeVisible(routes);
+    }
+
+    void Editor::ModulationControls::resized() {
+        Grid grid;
+
+        using Track = Grid::TrackInfo;
+        using Fr = Grid::Fr;
+        using Item = GridItem;
+
+        grid.templateRows = {Track{Fr{2}}, Track{Fr{2}}, Track{Fr{2}}, Track{Fr{5}}};
+        grid.templateColumns = {Track{Fr{1}}, Track{Fr{1}}, Track{Fr{1}}, Track{Fr{1}}};
+
+        grid.items = {
+                Item{lfo_1_rate}, Item{lfo_1_shape}.withHeight(40).withAlignSelf(GridItem::AlignSelf::center),
+                Item{lfo_2_rate}, Item{lfo_2_shape}.withHeight(40).withAlignSelf(GridItem::AlignSelf::center),
+                Item{attack}, Item{decay}, Item{sustain}, Item{release},
+                Item{random_rate}, Item{}, Item{}, Item{},
+                Item{routes}.withColumn({1, 5})
+        };
+
+        grid.performLayout(getLocalBounds().reduced(10));
+    }
 }
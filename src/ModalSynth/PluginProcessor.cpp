@@ -2,8 +2,23 @@
 
 #include <ModalSynth/PluginProcessor.hpp>
 #include <ModalSynth/PluginEditor.hpp>
+#include <ui/PresetState.hpp>
 
 namespace modal::plugin {
+    namespace {
+        // the parameters of the engine's continuous settings, in the order of `ModalParams::continuous()`,
+        // with the ranges of `ModalParams::continuous_range()`
+        std::vector<juce::AudioParameterFloat*> continuous_params(const juce::AudioProcessorValueTreeState& params) {
+            std::vector<juce::AudioParameterFloat*> out;
+            for (const auto* id: {"detune", "exponent", "exciter_rate", "decay", "falloff", "dial1", "dial2",
+                                  "slider1", "slider2", "foldback_point", "attack", "release",
+                                  "formant_x", "formant_y", "formant_len", "formant_mix", "damping"}) {
+                out.push_back(dynamic_cast<juce::AudioParameterFloat*>(params.getParameter(id)));
+            }
+            return out;
+        }
+    }
+
 //==============================================================================
     Processor::Processor()
             : AudioProcessor(BusesProperties()
@@ -27,7 +42,13 @@ namespace modal::plugin {
             std::make_unique<juce::AudioParameterFloat>("exciter_rate", "Exciter Rate Divider", 1, 100, 4),
             std::make_unique<juce::AudioParameterFloat>("attack", "Attack", 0, 5, 0.5),
             std::make_unique<juce::AudioParameterFloat>("release", "Release", 0, 5, 0.5),
-            std::make_unique<juce::AudioParameterInt>("modes", "Mode Count", 1, 40, 40),
+            std::make_unique<juce::AudioParameterChoice>("attack_curve", "Attack Curve",
+                                                         juce::StringArray{"Linear", "Exponential"}, 0),
+            std::make_unique<juce::AudioParameterChoice>("release_curve", "Release Curve",
+                                                         juce::StringArray{"Linear", "Exponential"}, 0),
+            // patches of more than 40 modes, such as bells and gongs, play on large voices, so half the range is up to 128
+            std::make_unique<juce::AudioParameterFloat>("modes", "Mode Count",
+                                                        juce::NormalisableRange<float> {1, 2048, 1, 0.25f}, 40),
             std::make_unique<juce::AudioParameterFloat>("detune", "Mode Detune Linear", -0.06, 2, 0),
             std::make_unique<juce::AudioParameterFloat>("exponent", "Mode Detune Exponent", 0.1, 10, 1),
             std::make_unique<juce::AudioParameterFloat>("falloff", "Falloff Exponent", 0, 3, 1),
@@ -36,8 +57,42 @@ namespace modal::plugin {
             std::make_unique<juce::AudioParameterFloat>("formant_y", "Formant Y", 0, 1, 0.5),
             std::make_unique<juce::AudioParameterFloat>("formant_len", "Formant throat length", 0, 1, 0.5),
             std::make_unique<juce::AudioParameterFloat>("formant_mix", "Formant drywet mix", 0, 1, 0.5),
-    }}, controller{modal_synths} {
+            std::make_unique<juce::AudioParameterFloat>("damping", "Note-off damping", 0, 1, 0),
+            std::make_unique<juce::AudioParameterChoice>("quality", "Quality",
+                                                         juce::StringArray{"Eco", "Normal", "High"}, 1),
+            std::make_unique<juce::AudioParameterChoice>("mpe", "MPE", juce::StringArray{"MPE Off", "MPE"}, 0),
+            // modulation sources
+            std::make_unique<juce::AudioParameterFloat>("lfo_1_rate", "LFO 1 Rate", juce::NormalisableRange<float>{0.01f, 20.f, 0.f, 0.3f}, 1.f),
+            std::make_unique<juce::AudioParameterChoice>("lfo_1_shape", "LFO 1 Shape",
+                                                         juce::StringArray{"Sine", "Triangle", "Saw", "Square"}, 0),
+            std::make_unique<juce::AudioParameterFloat>("lfo_2_rate", "LFO 2 Rate", juce::NormalisableRange<float>{0.01f, 20.f, 0.f, 0.3f}, 0.25f),
+            std::make_unique<juce::AudioParameterChoice>("lfo_2_shape", "LFO 2 Shape",
+                                                         juce::StringArray{"Sine", "Triangle", "Saw", "Square"}, 1),
+            std::make_unique<juce::AudioParameterFloat>("mod_attack", "Mod Envelope Attack", juce::NormalisableRange<float>{0.001f, 5.f, 0.f, 0.4f}, 0.01f),
+            std::make_unique<juce::AudioParameterFloat>("mod_decay", "Mod Envelope Decay", juce::NormalisableRange<float>{0.001f, 5.f, 0.f, 0.4f}, 0.3f),
+            std::make_unique<juce::AudioParameterFloat>("mod_sustain", "Mod Envelope Sustain", 0, 1, 0.5),
+            std::make_unique<juce::AudioParameterFloat>("mod_release", "Mod Envelope Release", juce::NormalisableRange<float>{0.001f, 5.f, 0.f, 0.4f}, 0.5f),
+            std::make_unique<juce::AudioParameterFloat>("random_rate", "Random Rate", juce::NormalisableRange<float>{0.01f, 20.f, 0.f, 0.3f}, 2.f),
+    }}, mod_control { continuous_params(params),
+                      {"LFO 1", "LFO 2", "Envelope", "Random", "Mod Wheel", "Aftertouch", "Velocity", "Note"} } {
         params.state.addListener(this);
+        const auto choice = [this](const char* id) {
+            return dynamic_cast<juce::AudioParameterChoice*>(params.getParameter(id));
+        };
+        const auto raw = [this](const char* id) {
+            return params.getRawParameterValue(id);
+        };
+        param = {
+            choice("exciter"), choice("foldback_mode"), choice("quality"), choice("mpe"),
+            choice("lfo_1_shape"), choice("lfo_2_shape"), choice("attack_curve"), choice("release_curve"),
+            raw("modes"), raw("detune"), raw("exponent"), raw("exciter_rate"), raw("decay"), raw("falloff"),
+            raw("dial1"), raw("dial2"), raw("slider1"), raw("slider2"), raw("foldback_point"), raw("attack"), raw("release"),
+            raw("formant_x"), raw("formant_y"), raw("formant_len"), raw("formant_mix"), raw("damping"),
+            raw("lfo_1_rate"), raw("lfo_2_rate"), raw("mod_attack"), raw("mod_decay"), raw("mod_sustain"), raw("mod_release"),
+            raw("random_rate")
+        };
+        // pick the DSP kernels for this CPU at load, rather than on the first audio block
+        dsp::simd::kernels();
     }
 
     Processor::~Processor() = default;
@@ -99,9 +154,7 @@ namespace modal::plugin {
 
 //==============================================================================
     void Processor::prepareToPlay(double sampleRate, int samplesPerBlock) {
-        for (auto& m: modal_synths) {
-            m.set_sample_rate(static_cast<dsp::num>(sampleRate));
-        }
+        engine.set_sample_rate(static_cast<dsp::num>(sampleRate));
         juce::ignoreUnused(samplesPerBlock);
     }
 
@@ -135,63 +188,81 @@ namespace modal::plugin {
 
     void Processor::processBlock(juce::AudioBuffer<float>& buffer,
                                                  juce::MidiBuffer& midiMessages) {
+        const dsp::rt::ScopedRealtime realtime;
+
+        // bounces can take as long as they need, so play every mode at the offline quality
+        if (isNonRealtime()) {
+            engine.set_quality(dsp::synth::Quality::Offline);
+            engine.set_load_target(0);
+        } else {
+            engine.set_quality(static_cast<dsp::synth::Quality>(param.quality->getIndex()));
+            engine.set_load_target(realtime_load_target);
+        }
+
+        engine.set_mpe(param.mpe->getIndex() == 1);
 
-        keyboard_state.processNextMidiBuffer(midiMessages, 0, buffer.getNumSamples(), true);
+        // notes played on the on-screen keyboard start at the beginning of the block
+        keyboard.drain([this](const ui::KeyboardBridge::NoteEvent& e) {
+            if (e.on) {
+                engine.note_on(e.note, e.velocity);
+            } else {
+                engine.note_off(e.note);
+            }
+        });
 
         for (const auto& metadata: midiMessages) {
             auto m = metadata.getMessage();
+            keyboard.show(m);
+            const auto offset = static_cast<uint32_t>(std::max(metadata.samplePosition, 0));
+            // the engine numbers channels from 0, MPE's master channel of the lower zone
+            const auto channel = m.getChannel() - 1;
             if (m.isNoteOn()) {
-                params_changed = true;
-                controller.key_down(m.getNoteNumber(), m.getFloatVelocity());
+                engine.note_on(m.getNoteNumber(), m.getFloatVelocity(), offset, channel);
             } else if (m.isNoteOff()) {
-                controller.key_up(m.getNoteNumber());
+                engine.note_off(m.getNoteNumber(), offset, channel);
+            } else if (m.isPitchWheel()) {
+                engine.pitch_bend(channel, static_cast<float>(m.getPitchWheelValue() - 8192) / 8192, offset);
+            } else if (m.isChannelPressure()) {
+                engine.pressure(channel, static_cast<float>(m.getChannelPressureValue()) / 127, offset);
+            } else if (m.isControllerOfType(1)) {
+                engine.modulation().set_source(dsp::mod::ModEngine::ModWheel, static_cast<dsp::num>(m.getControllerValue()) / 127);
             }
         }
 
+        // the sources' settings and the routes take effect from the next control period
+        auto& modulation = engine.modulation();
+        modulation.lfo_1.set_params(param.lfo_1_rate->load(), static_cast<dsp::mod::LfoShape>(param.lfo_1_shape->getIndex()));
+        modulation.lfo_2.set_params(param.lfo_2_rate->load(), static_cast<dsp::mod::LfoShape>(param.lfo_2_shape->getIndex()));
+        modulation.envelope.set_adsr(param.mod_attack->load(), param.mod_decay->load(),
+                                     param.mod_sustain->load(), param.mod_release->load());
+        modulation.random.set_params(param.random_rate->load());
+        modulation.matrix.clear_routes();
+        mod_control.add_routes(modulation.matrix, dsp::mod::ModEngine::Lfo1);
+
         if (params_changed) {
             params_changed = false;
-            auto exciter_mode = static_cast<dsp::synth::ModalExiterKind>(dynamic_cast<juce::AudioParameterChoice*>(params.getParameter(
-                    "exciter"))->
-                    getIndex());
-            auto foldback_mode = static_cast<dsp::synth::ModalFoldbackKind>(
-                    dynamic_cast<juce::AudioParameterChoice*>(params.getParameter("foldback_mode"))->getIndex());
-
-            for (auto& m: modal_synths) {
-                m.set_env_params(
-                        *params.getRawParameterValue("attack"),
-                        *params.getRawParameterValue("release")
-                );
-                bool changed = m.set_params(
-                        (size_t) *params.getRawParameterValue("modes"),
-                        *params.getRawParameterValue("detune"),
-                        *params.getRawParameterValue("exponent"),
-                        *params.getRawParameterValue("exciter_rate"),
-                        *params.getRawParameterValue("decay"),
-                        *params.getRawParameterValue("falloff")
-                );
-                changed |= m.set_mode_freqs({
-                                                    params.getRawParameterValue("dial1")->load(),
-                                                    params.getRawParameterValue("dial2")->load()
-                });
-                changed |= m.set_mode_gains({
-                                                    params.getRawParameterValue("slider1")->load(),
-                                                    params.getRawParameterValue("slider2")->load()
-                });
-                m.set_exciter(exciter_mode);
-                changed |= m.set_foldback_settings(foldback_mode,
-                                                   params.getRawParameterValue("foldback_point")->load());
-                m.set_formant_params(
-                        params.getRawParameterValue("formant_x")->load(),
-                        params.getRawParameterValue("formant_y")->load(),
-                        params.getRawParameterValue("formant_len")->load(),
-                        params.getRawParameterValue("formant_mix")->load()
-                );
-
-                if (changed) {
-                    m.update_mode_coefficients();
-                }
-            }
-
+            engine.set_params({
+                .modes = static_cast<size_t>(param.modes->load()),
+                .inharmonicity = param.detune->load(),
+                .exponent = param.exponent->load(),
+                .exciter_rate = param.exciter_rate->load(),
+                .decay = param.decay->load(),
+                .falloff = param.falloff->load(),
+                .mode_freqs = {param.dial1->load(), param.dial2->load()},
+                .mode_gains = {param.slider1->load(), param.slider2->load()},
+                .foldback = static_cast<dsp::synth::ModalFoldbackKind>(param.foldback_mode->getIndex()),
+                .foldback_point = param.foldback_point->load(),
+                .exciter = static_cast<dsp::synth::ModalExiterKind>(param.exciter->getIndex()),
+                .attack = param.attack->load(),
+                .release = param.release->load(),
+                .attack_curve = static_cast<dsp::mod::EnvCurve>(param.attack_curve->getIndex()),
+                .release_curve = static_cast<dsp::mod::EnvCurve>(param.release_curve->getIndex()),
+                .formant_x = param.formant_x->load(),
+                .formant_y = param.formant_y->load(),
+                .formant_length = param.formant_len->load(),
+                .formant_mix = param.formant_mix->load(),
+                .damping = param.damping->load(),
+            });
         }
 
         juce::ScopedNoDenormals noDenormals;
@@ -202,19 +273,16 @@ namespace modal::plugin {
             buffer.clear(i, 0, buffer.getNumSamples());
         }
 
-        for (int i = 0; i < buffer.getNumSamples(); i++) {
-            dsp::num out = 0;
-            for (auto& m: modal_synths) {
-                out += m.tick();
-            }
-            using namespace dsp; // for _nm literal
-            out *= 0.1_nm;
-
-            for (int channel = 0; channel < totalNumOutputChannels; ++channel) {
-                buffer.setSample(channel, i, out);
+        if (totalNumOutputChannels > 0) {
+            engine.render(buffer.getWritePointer(0), static_cast<size_t>(buffer.getNumSamples()));
+            for (int channel = 1; channel < totalNumOutputChannels; ++channel) {
+                buffer.copyFrom(channel, 0, buffer, 0, 0, buffer.getNumSamples());
             }
         }
+    }
 
+    dsp::perf::Summary Processor::perf_summary() {
+        return engine.stats();
     }
 
 //==============================================================================
@@ -228,12 +296,27 @@ namespace modal::plugin {
 
 //==============================================================================
     void Processor::getStateInformation(juce::MemoryBlock& destData) {
-        const auto state = params.copyState();
-        const std::unique_ptr<juce::XmlElement> xml(state.createXml());
-        copyXmlToBinary(*xml, destData);
+        dsp::preset::PatchState state;
+        ui::capture_params(*this, state);
+        mod_control.dump_state(state, 0);
+        std::vector<uint8_t> bytes;
+        dsp::preset::encode(state, bytes);
+        destData.replaceAll(bytes.data(), bytes.size());
     }
 
     void Processor::setStateInformation(const void* data, const int sizeInBytes) {
+        const std::span bytes {static_cast<const uint8_t*>(data), static_cast<size_t>(std::max(sizeInBytes, 0))};
+        if (dsp::preset::is_encoded(bytes)) {
+            dsp::preset::PatchState state;
+            if (dsp::preset::decode(bytes, state)) {
+                ui::restore_params(*this, state);
+                // missing from older states, which leaves every route unmapped
+                mod_control.load_state(state, 0);
+            }
+            return;
+        }
+
+        // legacy XML states, from before the binary format
         const std::unique_ptr<juce::XmlElement> xmlState(getXmlFromBinary(data, sizeInBytes));
 
         if (xmlState != nullptr) {
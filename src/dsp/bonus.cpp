@@ -1,5 +1,6 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 
+#include <atomic>
 #include <cmath>
 #include <dsp/bonus.hpp>
 
@@ -19,4 +20,16 @@ namespace modal::dsp::bonus {
     num db2gain(num db) {
         return std::pow(10_nm, db * 0.05_nm);
     }
-}
\ No newline at end of file
+
+    std::uint32_t FastRng::next_seed() {
+        // hash a counter (the murmur3 finaliser), so that consecutive generators aren't correlated
+        static std::atomic<std::uint32_t> counter {0};
+        std::uint32_t h = counter.fetch_add(1, std::memory_order_relaxed) + 0x9e3779b9u;
+        h ^= h >> 16;
+        h *= 0x85ebca6bu;
+        h ^= h >> 13;
+        h *= 0xc2b2ae35u;
+        h ^= h >> 16;
+        return h;
+    }
+}
@@ -1,51 +1,157 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+
 #include <dsp/delay.hpp>
 
-modal::dsp::delay_line::delay_line(const num sr, const num mt): sample_rate{sr}, max_time {mt} {
-    resize_buffer();
-}
+namespace modal::dsp {
+    namespace {
+        // weights for the 4 samples at positions -1, 0, 1, 2 around a fractional position t in [0, 1)
+        std::array<num, 4> cubic_weights(const num t) {
+            const num t2 = t * t;
+            const num t3 = t2 * t;
+            return {
+                0.5_nm * (-t3 + 2 * t2 - t),
+                0.5_nm * (3 * t3 - 5 * t2 + 2),
+                0.5_nm * (-3 * t3 + 4 * t2 + t),
+                0.5_nm * (t3 - t2)
+            };
+        }
 
-void modal::dsp::delay_line::push_sample(num s) {
-    buffer[idx] = s;
-    idx = (idx + 1) % buffer.size();
-}
+        std::array<num, 4> lagrange_weights(const num t) {
+            const num d = t + 1; // position relative to the first of the 4 samples
+            return {
+                -(d - 1) * (d - 2) * (d - 3) / 6,
+                d * (d - 2) * (d - 3) / 2,
+                -d * (d - 1) * (d - 3) / 2,
+                d * (d - 1) * (d - 2) / 6
+            };
+        }
+    }
 
-modal::dsp::num modal::dsp::delay_line::fetch_sample_s(const num time_backwards) const {
-    const num samps_back = time_backwards * sample_rate;
-    const int idx_1 = static_cast<int>(samps_back);
-    const int idx_2 = idx_1 + 1;
-    const num frac = static_cast<num>(samps_back - static_cast<int>(samps_back));
+    delay_line::delay_line(const num sr, const num mt): sample_rate{sr}, max_time{mt} {
+        reserve(sr, mt);
+    }
 
-    return dsp::bonus::lerp(fetch_sample_sm(idx_1), fetch_sample_sm(idx_2), frac);
-}
+    void delay_line::reserve(const num max_sr, const num max_delay_time) {
+        const auto needed = static_cast<unsigned long>(std::ceil(max_sr * max_delay_time)) + interp_margin + 1;
+        const auto capacity = std::bit_ceil(needed);
+        if (capacity <= buffer.size()) {
+            return;
+        }
 
-modal::dsp::num modal::dsp::delay_line::fetch_sample_sm(const int samps_backwards) const {
-    long get_idx = static_cast<long>(idx) - samps_backwards;
-    if (get_idx < 0) {
-        get_idx += static_cast<long>(get_max_samples());
+        // unroll the ring so the newest samples keep their distance from the write position
+        std::vector<num> grown(capacity, 0);
+        for (unsigned long i = 1; i <= buffer.size(); i++) {
+            grown[capacity - i] = buffer[(write_idx - i) & mask];
+        }
+        buffer = std::move(grown);
+        mask = capacity - 1;
+        write_idx = 0;
     }
-    return buffer[static_cast<unsigned long>(get_idx)];
-}
 
-void modal::dsp::delay_line::set_sample_rate(const num sr) {
-    sample_rate = sr;
-    resize_buffer();
-}
+    void delay_line::push_sample(const num s) {
+        buffer[write_idx] = s;
+        write_idx = (write_idx + 1) & mask;
+    }
 
-void modal::dsp::delay_line::set_max_time(const num new_max_time) {
-    max_time = new_max_time;
-    resize_buffer();
-}
+    void delay_line::write_block(const num* in, const size_t n) {
+        size_t done = 0;
+        while (done < n) {
+            const auto run = std::min<size_t>(n - done, buffer.size() - write_idx);
+            std::copy_n(in + done, run, buffer.begin() + static_cast<long>(write_idx));
+            write_idx = (write_idx + run) & mask;
+            done += run;
+        }
+    }
 
-modal::dsp::num modal::dsp::delay_line::get_max_time() const {
-    return static_cast<num>(buffer.size()) / static_cast<num>(sample_rate);
-}
+    num delay_line::fetch_sample_s(const num time_backwards) const {
+        return fetch_sample(time_backwards * sample_rate, DelayInterpolation::Linear);
+    }
 
-unsigned long modal::dsp::delay_line::get_max_samples() const {
-    return buffer.size();
-}
+    num delay_line::fetch_sample(const num samps_backwards, const DelayInterpolation interp) const {
+        const auto whole = static_cast<int>(samps_backwards);
+        const num frac = samps_backwards - static_cast<num>(whole);
+
+        switch (interp) {
+            case DelayInterpolation::Linear:
+                return bonus::lerp(fetch_sample_sm(whole), fetch_sample_sm(whole + 1), frac);
+            case DelayInterpolation::Cubic:
+            case DelayInterpolation::Lagrange:
+            case DelayInterpolation::Allpass: {
+                const auto w = interp == DelayInterpolation::Cubic ? cubic_weights(frac) : lagrange_weights(frac);
+                return w[0] * fetch_sample_sm(whole - 1) + w[1] * fetch_sample_sm(whole)
+                     + w[2] * fetch_sample_sm(whole + 1) + w[3] * fetch_sample_sm(whole + 2);
+            }
+        }
+        return 0;
+    }
+
+    num delay_line::fetch_sample_allpass(const num samps_backwards, allpass_tap& tap) const {
+        // keep the fractional part in [0.5, 1.5), where the first order allpass's phase delay is most accurate
+        auto whole = static_cast<int>(samps_backwards - 0.5_nm);
+        const num frac = samps_backwards - static_cast<num>(whole);
+        const num eta = (1 - frac) / (1 + frac);
 
-void modal::dsp::delay_line::resize_buffer() {
-    buffer.resize(static_cast<unsigned long>(sample_rate * max_time), 0.0);
+        const num out = eta * fetch_sample_sm(whole) + fetch_sample_sm(whole + 1) - eta * tap.y_del1;
+        tap.y_del1 = out;
+        return out;
+    }
+
+    void delay_line::fetch_taps(const num* samps_backwards, num* out, const size_t count, const DelayInterpolation interp) const {
+        for (size_t i = 0; i < count; i++) {
+            out[i] = fetch_sample(samps_backwards[i], interp);
+        }
+    }
+
+    void delay_line::read_block(num* out, const size_t n, const num samps_backwards, const DelayInterpolation interp) const {
+        const auto whole = static_cast<int>(samps_backwards);
+        const num frac = samps_backwards - static_cast<num>(whole);
+
+        // the fractional part is the same for every sample, so the weights only need calculating once
+        switch (interp) {
+            case DelayInterpolation::Linear: {
+                for (size_t i = 0; i < n; i++) {
+                    const int k = whole - static_cast<int>(i);
+                    out[i] = bonus::lerp(fetch_sample_sm(k), fetch_sample_sm(k + 1), frac);
+                }
+                break;
+            }
+            case DelayInterpolation::Cubic:
+            case DelayInterpolation::Lagrange:
+            case DelayInterpolation::Allpass: {
+                const auto w = interp == DelayInterpolation::Cubic ? cubic_weights(frac) : lagrange_weights(frac);
+                for (size_t i = 0; i < n; i++) {
+                    const int k = whole - static_cast<int>(i);
+                    out[i] = w[0] * fetch_sample_sm(k - 1) + w[1] * fetch_sample_sm(k)
+                           + w[2] * fetch_sample_sm(k + 1) + w[3] * fetch_sample_sm(k + 2);
+                }
+                break;
+            }
+        }
+    }
+
+    void delay_line::set_sample_rate(const num sr) {
+        sample_rate = sr;
+    }
+
+    void delay_line::set_max_time(const num new_max_time) {
+        max_time = new_max_time;
+    }
+
+    void delay_line::clear() {
+        std::fill(buffer.begin(), buffer.end(), 0);
+    }
+
+    num delay_line::get_max_time() const {
+        return static_cast<num>(get_max_samples()) / sample_rate;
+    }
+
+    unsigned long delay_line::get_max_samples() const {
+        const auto requested = static_cast<unsigned long>(sample_rate * max_time);
+        return std::min(requested, buffer.size() - interp_margin - 1);
+    }
 }
@@ -1,5 +1,6 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 
+#include <algorithm>
 #include <cmath>
 
 #include <dsp/filters.hpp>
@@ -176,4 +177,30 @@ namespace modal::dsp::filters {
                 break;
         }
     }
+    num DecimationFilter::tick(num in) {
+        num out = in;
+        for (size_t i = 0; i < coeffs.size(); i++) {
+            const auto& c = coeffs[i];
+            auto& s = state[i];
+            const num y = c[0] * out + s[0];
+            s[0] = c[1] * out - c[3] * y + s[1];
+            s[1] = c[2] * out - c[4] * y;
+            out = y;
+        }
+        return out;
+    }
+
+    void DecimationFilter::set_factor(const size_t factor) {
+        // the Q of each section of a fourth order Butterworth filter
+        constexpr std::array<num, 2> qs = {0.5411961_nm, 1.3065630_nm};
+        // cut off at 90% of the decimated Nyquist frequency
+        const num fc = 0.45_nm / static_cast<num>(std::max<size_t>(factor, 1));
+        for (size_t i = 0; i < coeffs.size(); i++) {
+            RBJbiquad section;
+            section.set_sample_rate(1);
+            section.set_lpf(fc, qs[i]);
+            coeffs[i] = section.normalised_coeffs();
+        }
+        state = {};
+    }
 }
@@ -7,6 +7,14 @@ void modal::dsp::physical::FormantFilter::set_filters() {
     for (size_t i = 0; i < filters.size(); i++) {
         filters[i].set_bpf(Fcs[i], Qs[i]);
         // filters[i].set_notch(Fcs[i], BWs[i]);
+
+        const auto c = filters[i].normalised_coeffs();
+        bank.b0[i] = c[0];
+        bank.b1[i] = c[1];
+        bank.b2[i] = c[2];
+        bank.a1[i] = c[3];
+        bank.a2[i] = c[4];
+        bank.gain[i] = bonus::db2gain(gains[i]);
     }
 }
 
@@ -17,13 +25,17 @@ modal::dsp::num modal::dsp::physical::FormantFilter::tick(const num in) {
             num last = in;
             for (size_t i = 0; i < filters.size(); i++) {
                 last = filters[i].tick(last);
-                out += last * bonus::db2gain(gains[i]);
+                out += last * bank.gain[i];
             }
-        }
-        case FormantArch::Parallel: {
+            // has always fallen through into a parallel pass over the same filters
             for (size_t i = 0; i < filters.size(); i++) {
-                out += filters[i].tick(in) * bonus::db2gain(gains[i]);
+                out += filters[i].tick(in) * bank.gain[i];
             }
+            break;
+        }
+        case FormantArch::Parallel: {
+            out = simd::kernels().biquad_bank(bank, in);
+            break;
         }
     }
 
@@ -1,5 +1,9 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+
 #include <dsp/mod.hpp>
 
 namespace modal::dsp::mod {
@@ -41,12 +45,51 @@ namespace modal::dsp::mod {
         set_params(attack_time, release_time);
 	}
 
+	namespace {
+		// fills `out` with the next `n` values of `x += step`, from `x = start`
+		void arithmetic(num* out, const size_t n, const num start, const num step) {
+			for (size_t i = 0; i < n; i++) {
+				out[i] = start + static_cast<num>(i + 1) * step;
+			}
+		}
+
+		// fills `out` with the next `n` values of `x = target + (x - target) * coeff`, from `x = start`, at most `block_size`
+		void geometric(num* out, const size_t n, const num start, const num target, const num coeff) {
+			// powers of `coeff` by repeated doubling, so each pass is independent multiplies rather than a chain
+			std::array<num, block_size> powers;
+			powers[0] = coeff;
+			for (size_t len = 1; len < n; len *= 2) {
+				const num step = powers[len - 1];
+				const size_t count = std::min(len, n - len);
+				for (size_t i = 0; i < count; i++) {
+					powers[len + i] = powers[i] * step;
+				}
+			}
+			const num dist = start - target;
+			for (size_t i = 0; i < n; i++) {
+				out[i] = target + dist * powers[i];
+			}
+		}
+
+		// number of samples until a segment ends, at least 1, clamped to `limit`
+		size_t segment_length(const num steps, const size_t limit) {
+			if (!(steps < static_cast<num>(limit))) {
+				return limit;
+			}
+			return std::max<size_t>(1, static_cast<size_t>(std::ceil(steps)));
+		}
+	}
+
 	num AHREnv::tick() {
 		switch (state) {
 		case AHRState::Rest:
 			return 0;
 		case AHRState::Attack:
-			val += attack_inc;
+			if (attack_curve == EnvCurve::Exponential) {
+				val = 1 + attack_overshoot + (val - 1 - attack_overshoot) * attack_coeff;
+			} else {
+				val += attack_inc;
+			}
 			if (val >= 1) {
 				val = 1;
 				state = AHRState::Hold;
@@ -55,7 +98,11 @@ namespace modal::dsp::mod {
 		case AHRState::Hold:
 			break;
 		case AHRState::Release:
-			val -= release_inc;
+			if (release_curve == EnvCurve::Exponential) {
+				val = -release_overshoot + (val + release_overshoot) * release_coeff;
+			} else {
+				val -= release_inc;
+			}
 			if (val <= 0) {
 				val = 0;
 				state = AHRState::Rest;
@@ -65,6 +112,68 @@ namespace modal::dsp::mod {
 		return val;
 	}
 
+	void AHREnv::process_block(num* out, const size_t n) {
+		size_t i = 0;
+		while (i < n) {
+			const size_t left = std::min(n - i, block_size);
+			switch (state) {
+			case AHRState::Rest:
+				std::fill(out + i, out + n, 0_nm);
+				return;
+			case AHRState::Hold:
+				std::fill(out + i, out + n, val);
+				return;
+			case AHRState::Attack: {
+				const num target = 1 + attack_overshoot;
+				const bool exponential = attack_curve == EnvCurve::Exponential;
+				// solve the recurrence for the first sample at or past 1
+				const num steps = exponential ? std::log(attack_overshoot / (target - val)) / std::log(attack_coeff)
+				                              : (1 - val) / attack_inc;
+				const size_t len = segment_length(steps, left + 1);
+				const size_t count = std::min(len, left);
+				if (exponential) {
+					geometric(out + i, count, val, target, attack_coeff);
+				} else {
+					arithmetic(out + i, count, val, attack_inc);
+				}
+				for (size_t j = i; j < i + count; j++) {
+					out[j] = std::min(out[j], 1_nm);
+				}
+				val = out[i + count - 1];
+				if (len <= left) {
+					val = out[i + count - 1] = 1;
+					state = AHRState::Hold;
+				}
+				i += count;
+				break;
+			}
+			case AHRState::Release: {
+				const bool exponential = release_curve == EnvCurve::Exponential;
+				// solve the recurrence for the first sample at or below 0
+				const num steps = exponential ? std::log(release_overshoot / (val + release_overshoot)) / std::log(release_coeff)
+				                              : val / release_inc;
+				const size_t len = segment_length(steps, left + 1);
+				const size_t count = std::min(len, left);
+				if (exponential) {
+					geometric(out + i, count, val, -release_overshoot, release_coeff);
+				} else {
+					arithmetic(out + i, count, val, -release_inc);
+				}
+				for (size_t j = i; j < i + count; j++) {
+					out[j] = std::max(out[j], 0_nm);
+				}
+				val = out[i + count - 1];
+				if (len <= left) {
+					val = out[i + count - 1] = 0;
+					state = AHRState::Rest;
+				}
+				i += count;
+				break;
+			}
+			}
+		}
+	}
+
 	void AHREnv::on() {
 		state = AHRState::Attack;
 	}
@@ -83,10 +192,172 @@ namespace modal::dsp::mod {
         release_time = rel;
 		attack_inc = 1 / (atk * sample_rate);
 		release_inc = 1 / (rel * sample_rate);
+		// reach 1 from 0, or 0 from 1, in the same time as the linear segments
+		attack_coeff = std::exp(-std::log((1 + attack_overshoot) / attack_overshoot) / (atk * sample_rate));
+		release_coeff = std::exp(-std::log((1 + release_overshoot) / release_overshoot) / (rel * sample_rate));
+	}
+
+	void AHREnv::set_curves(const EnvCurve attack, const EnvCurve release) {
+		attack_curve = attack;
+		release_curve = release;
 	}
 
 	void AHREnv::set_sample_rate(num sr) {
 		sample_rate = sr;
         set_params(attack_time, release_time);
 	}
-}
\ No newline at end of file
+
+	num SmoothedValue::advance(const size_t samples) {
+		if (remaining > 0) {
+			const size_t k = std::min(samples, remaining);
+			remaining -= k;
+			current = remaining > 0 ? current + step * static_cast<num>(k) : target;
+		}
+		return current;
+	}
+
+	void SmoothedValue::set_target(const num value) {
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wfloat-equal"
+		if (value == target) {
+			return;
+		}
+#pragma GCC diagnostic pop
+		target = value;
+		if (length == 0) {
+			skip();
+			return;
+		}
+		remaining = length;
+		step = (target - current) / static_cast<num>(length);
+	}
+
+	void SmoothedValue::skip() {
+		current = target;
+		remaining = 0;
+	}
+
+	void SmoothedValue::set_time(const num seconds) {
+		time = seconds;
+		length = static_cast<size_t>(std::max(0_nm, std::round(time * sample_rate)));
+		if (length == 0) {
+			skip();
+		}
+	}
+
+	void SmoothedValue::set_sample_rate(const num sr) {
+		sample_rate = sr;
+		set_time(time);
+	}
+
+	num Lfo::advance(const size_t samples) {
+		phase += inc * static_cast<num>(samples);
+		phase -= std::floor(phase);
+		switch (shape) {
+		case LfoShape::Sine:
+			return 0.5_nm - 0.5_nm * std::cos(nums::tau * phase);
+		case LfoShape::Triangle:
+			return phase < 0.5_nm ? 2 * phase : 2 - 2 * phase;
+		case LfoShape::Saw:
+			return phase;
+		case LfoShape::Square:
+			return phase < 0.5_nm ? 1 : 0;
+		}
+		return 0;
+	}
+
+	void Lfo::set_params(const num rate, const LfoShape s) {
+		frequency = rate;
+		shape = s;
+		inc = frequency / sample_rate;
+	}
+
+	void Lfo::reset() {
+		phase = 0;
+	}
+
+	void Lfo::set_sample_rate(const num sr) {
+		sample_rate = sr;
+		set_params(frequency, shape);
+	}
+
+	num SegmentEnv::advance(const size_t samples) {
+		num remaining = static_cast<num>(samples) / sample_rate;
+		while (stage < count) {
+			// hold at the end of the sustain segment until released
+			if (held && stage == sustain_segment + 1) {
+				break;
+			}
+
+			const auto& seg = segments[stage];
+			const num left = seg.time - elapsed;
+			if (left > remaining) {
+				elapsed += remaining;
+				val = from + (seg.level - from) * (elapsed / seg.time);
+				break;
+			}
+			remaining -= std::max(left, 0_nm);
+			val = seg.level;
+			enter(stage + 1);
+		}
+		return val;
+	}
+
+	void SegmentEnv::on() {
+		held = true;
+		enter(0);
+	}
+
+	void SegmentEnv::off() {
+		held = false;
+		if (sustain_segment < count && stage <= sustain_segment) {
+			enter(sustain_segment + 1);
+		}
+	}
+
+	void SegmentEnv::reset() {
+		held = false;
+		val = 0;
+		stage = max_segments;
+	}
+
+	void SegmentEnv::set_segments(const std::span<const Segment> segs, const size_t sustain) {
+		count = std::min(segs.size(), max_segments);
+		std::copy_n(segs.begin(), count, segments.begin());
+		sustain_segment = sustain;
+	}
+
+	void SegmentEnv::set_adsr(const num attack, const num decay, const num sustain, const num release) {
+		const std::array<Segment, 3> adsr {{{1, attack}, {sustain, decay}, {0, release}}};
+		set_segments(adsr, 1);
+	}
+
+	void SegmentEnv::set_sample_rate(const num sr) {
+		sample_rate = sr;
+	}
+
+	void SegmentEnv::enter(const size_t s) {
+		stage = s;
+		from = val;
+		elapsed = 0;
+	}
+
+	num SampleAndHold::advance(const size_t samples) {
+		phase += inc * static_cast<num>(samples);
+		if (phase >= 1) {
+			phase -= std::floor(phase);
+			held = rng.uniform(0, 1);
+		}
+		return held;
+	}
+
+	void SampleAndHold::set_params(const num rate) {
+		frequency = rate;
+		inc = frequency / sample_rate;
+	}
+
+	void SampleAndHold::set_sample_rate(const num sr) {
+		sample_rate = sr;
+		set_params(frequency);
+	}
+}
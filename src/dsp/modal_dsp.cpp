@@ -0,0 +1,170 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <dsp/modal_dsp.h>
+
+#include <algorithm>
+#include <new>
+#include <span>
+
+#include <dsp/modal_engine.hpp>
+#include <dsp/preset.hpp>
+
+using namespace modal::dsp;
+
+struct modal_engine {
+    synth::ModalEngine engine;
+};
+
+namespace {
+    modal::dsp::num clamped(const float value, const float lo, const float hi) {
+        return static_cast<modal::dsp::num>(std::clamp(value, lo, hi));
+    }
+
+    // the ranges of the plugin's parameters
+    synth::ModalParams to_params(const modal_patch& patch) {
+        return {
+            .modes = std::clamp<size_t>(patch.modes, 1, synth::ModalEngine::max_patch_modes),
+            .inharmonicity = clamped(patch.inharmonicity, -0.06f, 2),
+            .exponent = clamped(patch.exponent, 0.1f, 10),
+            .exciter_rate = clamped(patch.exciter_rate, 1, 100),
+            .decay = clamped(patch.decay, 0.1f, 5),
+            .falloff = clamped(patch.falloff, 0, 3),
+            .mode_freqs = {clamped(patch.mode_freqs[0], 0, 1), clamped(patch.mode_freqs[1], 0, 1)},
+            .mode_gains = {clamped(patch.mode_gains[0], 0, 1), clamped(patch.mode_gains[1], 0, 1)},
+            .foldback = static_cast<synth::ModalFoldbackKind>(std::clamp(static_cast<int>(patch.foldback), 0, 2)),
+            .foldback_point = clamped(patch.foldback_point, 20, 20000),
+            .exciter = static_cast<synth::ModalExiterKind>(std::clamp(static_cast<int>(patch.exciter), 0, 4)),
+            .attack = clamped(patch.attack, 0, 5),
+            .release = clamped(patch.release, 0, 5),
+            .formant_x = clamped(patch.formant_x, 0, 1),
+            .formant_y = clamped(patch.formant_y, 0, 1),
+            .formant_length = clamped(patch.formant_length, 0, 1),
+            .formant_mix = clamped(patch.formant_mix, 0, 1),
+            .damping = clamped(patch.damping, 0, 1),
+        };
+    }
+
+    modal_patch to_patch(const synth::ModalParams& p) {
+        return {
+            static_cast<uint32_t>(p.modes),
+            static_cast<float>(p.inharmonicity),
+            static_cast<float>(p.exponent),
+            static_cast<float>(p.exciter_rate),
+            static_cast<float>(p.decay),
+            static_cast<float>(p.falloff),
+            {static_cast<float>(p.mode_freqs[0]), static_cast<float>(p.mode_freqs[1])},
+            {static_cast<float>(p.mode_gains[0]), static_cast<float>(p.mode_gains[1])},
+            static_cast<modal_foldback>(p.foldback),
+            static_cast<float>(p.foldback_point),
+            static_cast<modal_exciter>(p.exciter),
+            static_cast<float>(p.attack),
+            static_cast<float>(p.release),
+            static_cast<float>(p.formant_x),
+            static_cast<float>(p.formant_y),
+            static_cast<float>(p.formant_length),
+            static_cast<float>(p.formant_mix),
+            static_cast<float>(p.damping),
+        };
+    }
+}
+
+extern "C" {
+    modal_engine* modal_engine_create(const double sample_rate) {
+        // the engine allocates its large voices itself, which can throw past `nothrow`
+        modal_engine* e;
+        try {
+            e = new modal_engine;
+        } catch (const std::bad_alloc&) {
+            return nullptr;
+        }
+        e->engine.set_sample_rate(static_cast<modal::dsp::num>(sample_rate));
+        return e;
+    }
+
+    void modal_engine_destroy(modal_engine* engine) {
+        delete engine;
+    }
+
+    void modal_engine_set_sample_rate(modal_engine* engine, const double sample_rate) {
+        engine->engine.set_sample_rate(static_cast<modal::dsp::num>(sample_rate));
+    }
+
+    void modal_engine_set_load_target(modal_engine* engine, const double target) {
+        engine->engine.set_load_target(target);
+    }
+
+    void modal_engine_set_quality(modal_engine* engine, const modal_quality quality) {
+        engine->engine.set_quality(static_cast<synth::Quality>(std::clamp(static_cast<int>(quality), 0, 3)));
+    }
+
+    void modal_patch_defaults(modal_patch* patch) {
+        *patch = to_patch({});
+    }
+
+    void modal_engine_set_patch(modal_engine* engine, const modal_patch* patch) {
+        engine->engine.set_params(to_params(*patch));
+    }
+
+    void modal_engine_get_patch(const modal_engine* engine, modal_patch* patch) {
+        *patch = to_patch(engine->engine.params());
+    }
+
+    int modal_engine_load_state(modal_engine* engine, const void* data, const size_t size) {
+        preset::PatchState state;
+        if (!preset::decode({static_cast<const uint8_t*>(data), size}, state)) {
+            return 0;
+        }
+        engine->engine.set_params(synth::ModalParams::from_state(state));
+        return 1;
+    }
+
+    int modal_engine_note_on(modal_engine* engine, const int note, const float velocity, const uint32_t offset) {
+        return engine->engine.note_on(note, velocity, offset) ? 1 : 0;
+    }
+
+    int modal_engine_note_off(modal_engine* engine, const int note, const uint32_t offset) {
+        return engine->engine.note_off(note, offset) ? 1 : 0;
+    }
+
+    void modal_engine_set_mpe(modal_engine* engine, const int enabled, const float note_semitones, const float master_semitones) {
+        engine->engine.set_mpe(enabled != 0);
+        engine->engine.set_bend_ranges(note_semitones, master_semitones);
+    }
+
+    int modal_engine_channel_note_on(modal_engine* engine, const int channel, const int note, const float velocity,
+                                     const uint32_t offset) {
+        return engine->engine.note_on(note, velocity, offset, channel) ? 1 : 0;
+    }
+
+    int modal_engine_channel_note_off(modal_engine* engine, const int channel, const int note, const uint32_t offset) {
+        return engine->engine.note_off(note, offset, channel) ? 1 : 0;
+    }
+
+    int modal_engine_pitch_bend(modal_engine* engine, const int channel, const float amount, const uint32_t offset) {
+        return engine->engine.pitch_bend(channel, amount, offset) ? 1 : 0;
+    }
+
+    int modal_engine_pressure(modal_engine* engine, const int channel, const float amount, const uint32_t offset) {
+        return engine->engine.pressure(channel, amount, offset) ? 1 : 0;
+    }
+
+    void modal_engine_render(modal_engine* engine, float* out, const size_t samples) {
+        engine->engine.render(out, samples);
+    }
+
+    void modal_engine_stats(modal_engine* engine, modal_stats* stats) {
+        const auto s = engine->engine.stats();
+        *stats = {
+            s.blocks,
+            s.load,
+            s.mean_ns,
+            s.p99_ns,
+            s.peak_ns,
+            s.active_voices,
+            s.active_modes,
+            s.counters[static_cast<size_t>(perf::Counter::NoteDrops)],
+            s.counters[static_cast<size_t>(perf::Counter::CoefficientUpdates)],
+            engine->engine.mode_budget(),
+        };
+    }
+}
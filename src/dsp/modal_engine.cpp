@@ -0,0 +1,410 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <dsp/modal_engine.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <dsp/rtcheck.hpp>
+
+namespace modal::dsp::synth {
+    namespace {
+        // a continuous setting as a target of the modulation, between 0-1
+        modal::dsp::num normalise(const size_t index, const modal::dsp::num value) {
+            const auto range = ModalParams::continuous_range(index);
+            return std::clamp((value - range[0]) / (range[1] - range[0]), 0_nm, 1_nm);
+        }
+    }
+
+    ModalEngine::ModalEngine() {
+        // never started
+        started.fill(std::numeric_limits<uint64_t>::max());
+        for (auto& v: voices) {
+            v.configure([this](auto& voice) {
+                voice.set_patch(patch);
+                voice.set_sample_rate(rate);
+                voice.set_glide_time(control_period);
+            });
+        }
+        for (auto& s: smoothers) {
+            s.set_sample_rate(rate);
+            s.set_time(default_param_smoothing);
+        }
+        mod_engine.set_control_period(control_period);
+        set_params(requested);
+    }
+
+    void ModalEngine::set_sample_rate(const modal::dsp::num sr) {
+        rate = sr;
+        for (auto& v: voices) {
+            v.configure([sr](auto& voice) { voice.set_sample_rate(sr); });
+        }
+        for (auto& s: smoothers) {
+            s.set_sample_rate(sr);
+        }
+        mod_engine.set_sample_rate(sr);
+    }
+
+    void ModalEngine::set_params(const ModalParams& p) {
+        requested = p;
+        current.modes = p.modes;
+        current.foldback = p.foldback;
+        current.exciter = p.exciter;
+        current.attack_curve = p.attack_curve;
+        current.release_curve = p.release_curve;
+        // nothing can click with no voices sounding, so the first patch, say, is set at once
+        const bool jump = sounding_voices() == 0;
+        for (size_t i = 0; i < ModalParams::num_continuous; i++) {
+            smoothers[i].set_target(p.continuous(i));
+            if (jump) {
+                smoothers[i].skip();
+            }
+            mod_engine.matrix.set_base(i, normalise(i, smoothers[i].value()));
+            current.continuous(i) = modulated(i);
+        }
+        apply_params();
+    }
+
+    void ModalEngine::set_param_smoothing(const modal::dsp::num seconds) {
+        for (auto& s: smoothers) {
+            s.set_time(seconds);
+        }
+    }
+
+    void ModalEngine::smooth_params() {
+        bool changed = false;
+        for (size_t i = 0; i < ModalParams::num_continuous; i++) {
+            if (smoothers[i].smoothing()) {
+                mod_engine.matrix.set_base(i, normalise(i, smoothers[i].advance(control_period)));
+                changed = true;
+            }
+        }
+        // the modulation's control period is at most the engine's, so its latest values are read at the end of each
+        for (size_t left = control_period; left > 0;) {
+            const auto n = std::min(left, mod_engine.samples_until_update());
+            changed |= mod_engine.advance(n);
+            left -= n;
+        }
+        if (changed) {
+            for (size_t i = 0; i < ModalParams::num_continuous; i++) {
+                current.continuous(i) = modulated(i);
+            }
+            apply_params();
+        }
+    }
+
+    modal::dsp::num ModalEngine::modulated(const size_t index) const {
+        if (!mod_engine.matrix.modulated(index)) {
+            return smoothers[index].value();
+        }
+        const auto range = ModalParams::continuous_range(index);
+        return range[0] + mod_engine.matrix.value(index) * (range[1] - range[0]);
+    }
+
+    void ModalEngine::apply_params() {
+        // only marks the voices' coefficients as out of date, they're updated a few at a time while rendering
+        if (current.apply(patch)) {
+            coefficients.invalidate();
+        }
+        for (auto& v: voices) {
+            v.configure([this](auto& voice) { current.apply(voice); });
+        }
+    }
+
+    void ModalEngine::set_load_target(const double target) {
+        if (target <= 0) {
+            if (governed) {
+                governed = false;
+                limit_modes(mode_cap);
+            }
+            return;
+        }
+        governor.set_loads(target, 0.6 * target);
+        if (!governed) {
+            governed = true;
+            governor.reset();
+            // nothing is cut off until the voices' levels have been measured
+            for (auto& v: governed_voices) {
+                v.level = 1;
+            }
+            peaks.fill(0);
+        }
+    }
+
+    void ModalEngine::set_quality(const Quality q) {
+        if (q == tier) {
+            return;
+        }
+        tier = q;
+        const auto settings = quality_settings(q);
+        mode_cap = settings.max_modes;
+        control_period = settings.control_period;
+        until_control = std::min(until_control, control_period);
+        mod_engine.set_control_period(control_period);
+        for (auto& v: voices) {
+            v.configure([this, &settings](auto& voice) {
+                voice.set_glide_time(control_period);
+                voice.set_exciter_oversampling(settings.exciter_oversampling);
+            });
+        }
+        coefficients.set_voices_per_run(settings.voices_per_update);
+        // governed voices are capped when the budget is next shared out
+        if (!governed) {
+            limit_modes(mode_cap);
+        }
+    }
+
+    void ModalEngine::limit_modes(const size_t limit) {
+        for (auto& v: voices) {
+            if (v.set_mode_limit(limit, current.modes)) {
+                v.update_mode_coefficients();
+            }
+        }
+        budget.store(static_cast<uint32_t>(voice_count * limit), std::memory_order_relaxed);
+    }
+
+    void ModalEngine::set_mpe(const bool enabled) {
+        if (enabled == mpe_enabled) {
+            return;
+        }
+        mpe_enabled = enabled;
+        channel_bend.fill(0);
+        channel_pressure.fill(0);
+        for (size_t v = 0; v < voice_count; v++) {
+            retarget(v, controller.channel(v));
+        }
+    }
+
+    void ModalEngine::set_bend_ranges(const float note_semitones, const float master_semitones) {
+        note_bend_range = note_semitones;
+        master_bend_range = master_semitones;
+        for (size_t v = 0; v < voice_count; v++) {
+            retarget(v, controller.channel(v));
+        }
+    }
+
+    namespace {
+        uint8_t channel_index(const int channel) {
+            return static_cast<uint8_t>(std::clamp(channel, 0, ModalEngine::channel_count - 1));
+        }
+    }
+
+    bool ModalEngine::note_on(const int note, const float velocity, const uint32_t offset, const int channel) {
+        return queue({offset, EventKind::NoteOn, channel_index(channel), note, std::max(velocity, 0.0f)});
+    }
+
+    bool ModalEngine::note_off(const int note, const uint32_t offset, const int channel) {
+        return queue({offset, EventKind::NoteOff, channel_index(channel), note, 0});
+    }
+
+    bool ModalEngine::pitch_bend(const int channel, const float amount, const uint32_t offset) {
+        return queue({offset, EventKind::Bend, channel_index(channel), 0, std::clamp(amount, -1.0f, 1.0f)});
+    }
+
+    bool ModalEngine::pressure(const int channel, const float amount, const uint32_t offset) {
+        return queue({offset, EventKind::Pressure, channel_index(channel), 0, std::clamp(amount, 0.0f, 1.0f)});
+    }
+
+    bool ModalEngine::queue(const Event e) {
+        if (queued == events.size()) {
+            perf.count(perf::Counter::NoteDrops);
+            return false;
+        }
+        // usually queued in order, so this rarely moves anything
+        auto at = queued;
+        for (; at > 0 && events[at - 1].offset > e.offset; at--) {
+            events[at] = events[at - 1];
+        }
+        events[at] = e;
+        queued++;
+        return true;
+    }
+
+    void ModalEngine::play(const Event& e, const uint64_t time) {
+        const bool member = mpe_enabled && e.channel != 0;
+        switch (e.kind) {
+            case EventKind::NoteOff:
+                controller.key_up(e.note, e.channel);
+                mod_engine.note_off(e.note);
+                return;
+            case EventKind::Bend:
+                (member ? channel_bend[e.channel] : master_bend) = e.value;
+                break;
+            case EventKind::Pressure:
+                (member ? channel_pressure[e.channel] : master_pressure) = e.value;
+                mod_engine.set_source(mod::ModEngine::Aftertouch, e.value);
+                break;
+            case EventKind::NoteOn:
+                break;
+        }
+        if (e.kind != EventKind::NoteOn) {
+            if (member) {
+                controller.for_channel(e.channel, [this, &e](const size_t v) { retarget(v, e.channel); });
+            } else {
+                for (size_t v = 0; v < voice_count; v++) {
+                    retarget(v, controller.channel(v));
+                }
+            }
+            return;
+        }
+
+        if (const auto voice = controller.next_voice()) {
+            voices[*voice].choose(current.modes);
+            // the new note starts at its channel's bend and pressure, and is bent before its coefficients are computed
+            retarget(*voice, e.channel);
+            bend_now[*voice] = bend_target[*voice];
+            pressure_now[*voice] = pressure_target[*voice];
+            voices[*voice].bend(std::exp2(bend_now[*voice] / 12));
+            voices[*voice].set_pressure(pressure_now[*voice]);
+            // the new note gets its modes before it starts, as the voice only excites the modes it plays
+            if (governed) {
+                started[*voice] = time;
+                governed_voices[*voice].level = 0;
+                allocate_modes(time);
+            }
+        }
+        mod_engine.note_on(e.note, e.value);
+        // a voice updates its own coefficients on note on
+        if (const auto voice = controller.key_down(e.note, e.value, e.channel)) {
+            coefficients.updated(*voice);
+            perf.count(perf::Counter::CoefficientUpdates);
+        } else {
+            perf.count(perf::Counter::NoteDrops);
+        }
+    }
+
+    void ModalEngine::retarget(const size_t voice, const int channel) {
+        // released notes no longer following their channel keep their own bend, but still follow the master's without MPE
+        if (channel < 0 && mpe_enabled) {
+            return;
+        }
+        const bool member = mpe_enabled && channel > 0;
+        const auto c = static_cast<size_t>(channel);
+        bend_target[voice] = master_bend * master_bend_range + (member ? channel_bend[c] * note_bend_range : 0);
+        pressure_target[voice] = std::min(master_pressure + (member ? channel_pressure[c] : 0), 1.0f);
+    }
+
+    void ModalEngine::smooth_expression() {
+        const auto step = 1 - std::exp(-static_cast<modal::dsp::num>(control_period) / (expression_smoothing * rate));
+        // moves towards the target, until within a hundredth of a cent or a ten thousandth of full pressure,
+        // close enough to stop, snapping to it on the last step
+        const auto approach = [step](modal::dsp::num& now, const modal::dsp::num target) {
+            const auto diff = target - now;
+            if (std::abs(diff) < 1e-4_nm) {
+                return false;
+            }
+            now = std::abs(diff * (1 - step)) < 1e-4_nm ? target : now + diff * step;
+            return true;
+        };
+        for (size_t v = 0; v < voice_count; v++) {
+            if (approach(bend_now[v], bend_target[v])) {
+                voices[v].bend(std::exp2(bend_now[v] / 12));
+            }
+            if (approach(pressure_now[v], pressure_target[v])) {
+                voices[v].set_pressure(pressure_now[v]);
+            }
+        }
+    }
+
+    void ModalEngine::allocate_modes(const uint64_t time) {
+        for (size_t v = 0; v < voice_count; v++) {
+            auto& g = governed_voices[v];
+            g.age = started[v] > time ? std::numeric_limits<modal::dsp::num>::max()
+                                      : static_cast<modal::dsp::num>(time - started[v]) / rate;
+            g.held = controller.is_active(v);
+        }
+        std::array<size_t, voice_count> limits;
+        governor.allocate(governed_voices, std::min(current.modes, mode_cap), limits);
+        for (size_t v = 0; v < voice_count; v++) {
+            if (voices[v].set_mode_limit(limits[v], current.modes)) {
+                voices[v].update_mode_coefficients();
+            }
+        }
+    }
+
+    void ModalEngine::render(float* out, const size_t samples) {
+        const rt::ScopedRealtime realtime;
+        const auto begin = perf::Monitor::now();
+        perf.begin_block(samples, rate);
+
+        size_t next = 0;
+        for (size_t i = 0; i < samples;) {
+            for (; next < queued && events[next].offset <= i; next++) {
+                play(events[next], clock + i);
+            }
+            if (until_control == 0) {
+                smooth_params();
+                // playing voices glide to their new spectrum over the control period, rather than stepping
+                const auto updated = coefficients.run([this](const size_t voice) {
+                    voices[voice].update_mode_coefficients(true);
+                });
+                perf.count(perf::Counter::CoefficientUpdates, static_cast<uint32_t>(updated));
+                smooth_expression();
+                // released voices are damped until they die away, then stop being rendered until they're played again
+                for (size_t v = 0; v < voice_count; v++) {
+                    if (controller.is_sounding(v) && !controller.is_active(v)) {
+                        voices[v].damp(control_period);
+                        if (voices[v].silent()) {
+                            controller.finished(v);
+                        }
+                    }
+                }
+                if (governed) {
+                    // levels fall between peaks, so a voice keeps its place through the troughs of its waveform
+                    for (size_t v = 0; v < voice_count; v++) {
+                        governed_voices[v].level = std::max(peaks[v], governed_voices[v].level * 0.7_nm);
+                        peaks[v] = 0;
+                    }
+                    allocate_modes(clock + i);
+                }
+                until_control = control_period;
+            }
+            perf.lap(perf::Stage::Params);
+
+            // each voice times its own exciter, modes and formant filter
+            const size_t event_at = next < queued ? events[next].offset : samples;
+            const size_t end = std::min({samples, i + until_control, event_at, i + block_size});
+            const size_t n = end - i;
+            until_control -= n;
+            std::array<modal::dsp::num, block_size> mix;
+            std::fill_n(mix.begin(), n, 0_nm);
+            for (size_t v = 0; v < voice_count; v++) {
+                if (controller.is_sounding(v)) {
+                    const auto peak = voices[v].render(mix.data(), n, &perf);
+                    peaks[v] = std::max(peaks[v], peak);
+                }
+            }
+            perf.skip_lap();
+
+            for (size_t s = 0; s < n; s++) {
+                out[i + s] = static_cast<float>(mix[s] * 0.1_nm);
+            }
+            i = end;
+            perf.lap(perf::Stage::Output);
+        }
+
+        // notes queued past the end move to the next render
+        for (size_t e = next; e < queued; e++) {
+            events[e - next] = events[e];
+            events[e - next].offset -= static_cast<uint32_t>(samples);
+        }
+        queued -= next;
+        clock += samples;
+
+        if (governed && samples > 0) {
+            const auto elapsed = static_cast<double>(perf::Monitor::now() - begin);
+            governor.update(elapsed * static_cast<double>(rate) / (1e9 * static_cast<double>(samples)));
+            budget.store(static_cast<uint32_t>(std::min(governor.budget(), voice_count * mode_cap)), std::memory_order_relaxed);
+        }
+
+        size_t active_modes = 0;
+        for (size_t v = 0; v < voices.size(); v++) {
+            if (controller.is_active(v)) {
+                active_modes += voices[v].num_modes();
+            }
+        }
+        perf.set_active(controller.active_voices(), active_modes);
+        perf.end_block();
+    }
+}
@@ -0,0 +1,74 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <dsp/modal_params.hpp>
+
+#include <string_view>
+#include <type_traits>
+
+namespace modal::dsp::synth {
+    ModalParams ModalParams::from_state(const preset::PatchState& state) {
+        ModalParams p;
+        const auto read = [&state](const std::string_view id, auto& value) {
+            if (const auto index = state.find(preset::param_id(id))) {
+                value = static_cast<std::remove_reference_t<decltype(value)>>(state.params[*index].value);
+            }
+        };
+        const auto read_choice = [&state](const std::string_view id, auto& value) {
+            if (const auto index = state.find(preset::param_id(id))) {
+                value = static_cast<std::remove_reference_t<decltype(value)>>(static_cast<int>(state.params[*index].value));
+            }
+        };
+
+        // the plugin's parameter IDs
+        read("modes", p.modes);
+        read("detune", p.inharmonicity);
+        read("exponent", p.exponent);
+        read("exciter_rate", p.exciter_rate);
+        read("decay", p.decay);
+        read("falloff", p.falloff);
+        read("dial1", p.mode_freqs[0]);
+        read("dial2", p.mode_freqs[1]);
+        read("slider1", p.mode_gains[0]);
+        read("slider2", p.mode_gains[1]);
+        read_choice("foldback_mode", p.foldback);
+        read("foldback_point", p.foldback_point);
+        read_choice("exciter", p.exciter);
+        read("attack", p.attack);
+        read("release", p.release);
+        read_choice("attack_curve", p.attack_curve);
+        read_choice("release_curve", p.release_curve);
+        read("formant_x", p.formant_x);
+        read("formant_y", p.formant_y);
+        read("formant_len", p.formant_length);
+        read("formant_mix", p.formant_mix);
+        read("damping", p.damping);
+        return p;
+    }
+
+    num& ModalParams::continuous(const size_t index) {
+        const std::array<num*, num_continuous> settings {
+            &inharmonicity, &exponent, &exciter_rate, &decay, &falloff,
+            &mode_freqs[0], &mode_freqs[1], &mode_gains[0], &mode_gains[1], &foldback_point,
+            &attack, &release, &formant_x, &formant_y, &formant_length, &formant_mix, &damping
+        };
+        return *settings[index];
+    }
+
+    std::array<num, 2> ModalParams::continuous_range(const size_t index) {
+        // the ranges of the plugin's parameters, in the order of `continuous()`
+        constexpr std::array<std::array<num, 2>, num_continuous> ranges {{
+            {-0.06_nm, 2}, {0.1_nm, 10}, {1, 100}, {0.1_nm, 5}, {0, 3},
+            {0, 1}, {0, 1}, {0, 1}, {0, 1}, {20, 20000},
+            {0, 5}, {0, 5}, {0, 1}, {0, 1}, {0, 1}, {0, 1}, {0, 1}
+        }};
+        return ranges[index];
+    }
+
+    bool ModalParams::apply(ModalPatch& patch) const {
+        bool changed = patch.set_params(modes, inharmonicity, exponent, exciter_rate, decay, falloff);
+        changed |= patch.set_mode_freqs(mode_freqs);
+        changed |= patch.set_mode_gains(mode_gains);
+        changed |= patch.set_foldback_settings(foldback, foldback_point);
+        return changed;
+    }
+}
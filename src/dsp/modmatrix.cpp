@@ -0,0 +1,185 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <algorithm>
+#include <cmath>
+
+#include <dsp/bonus.hpp>
+#include <dsp/modmatrix.hpp>
+
+namespace modal::dsp::mod {
+    namespace {
+        // smoothed values closer than this to their goal snap to it, so `process()` settles and stops reporting changes
+        constexpr num settle_threshold = 1e-4_nm;
+    }
+
+    num apply_curve(const ModCurve curve, const num x) {
+        switch (curve) {
+        case ModCurve::Linear:
+            return x;
+        case ModCurve::Exponential:
+            return x * x;
+        case ModCurve::Logarithmic:
+            return 1 - (1 - x) * (1 - x);
+        case ModCurve::SCurve:
+            return x * x * (3 - 2 * x);
+        }
+        return x;
+    }
+
+    ModMatrix::ModMatrix(const size_t source_count, const size_t targets, const size_t route_limit):
+        sources(source_count), max_routes{route_limit},
+        base(targets), base_ramps(targets), goal(targets), smoothed(targets), amount(targets), values(targets), previous(targets),
+        routed(targets) {
+        routes.reserve(max_routes);
+    }
+
+    void ModMatrix::set_sample_rate(const num sr) {
+        sample_rate = sr;
+        for (auto& b : base_ramps) {
+            b.set_sample_rate(sr);
+        }
+    }
+
+    void ModMatrix::set_smoothing_time(const num seconds) {
+        smoothing_time = seconds;
+    }
+
+    void ModMatrix::set_base_smoothing_time(const num seconds) {
+        for (auto& b : base_ramps) {
+            b.set_time(seconds);
+        }
+    }
+
+    void ModMatrix::skip_base_smoothing() {
+        for (auto& b : base_ramps) {
+            b.skip();
+        }
+    }
+
+    void ModMatrix::set_source(const size_t source, const num value) {
+        sources[source] = value;
+    }
+
+    void ModMatrix::set_base(const size_t target, const num value) {
+        base_ramps[target].set_target(value);
+    }
+
+    void ModMatrix::clear_routes() {
+        routes.clear();
+    }
+
+    bool ModMatrix::add_route(const ModRoute& route) {
+        if (routes.size() >= max_routes || route.source >= sources.size() || route.target >= base.size()) {
+            return false;
+        }
+        routes.push_back(route);
+        return true;
+    }
+
+    bool ModMatrix::add_routes(const MacroMap& map, const size_t source) {
+        bool added = true;
+        for (const auto& slot : map.slots) {
+            if (slot.target != MacroSlot::unmapped) {
+                added &= add_route({source + slot.source, slot.target, slot.lo, slot.hi, slot.curve});
+            }
+        }
+        return added;
+    }
+
+    bool ModMatrix::process(const size_t samples) {
+        for (size_t t = 0; t < base.size(); t++) {
+            base[t] = base_ramps[t].advance(samples);
+        }
+
+        std::fill(goal.begin(), goal.end(), 0);
+        std::fill(routed.begin(), routed.end(), false);
+        for (const auto& r : routes) {
+            goal[r.target] += bonus::lerp(r.lo, r.hi, apply_curve(r.curve, sources[r.source])) - base[r.target];
+            routed[r.target] = true;
+        }
+
+        const num periods = smoothing_time * sample_rate;
+        const num coeff = periods > 0 ? std::exp(-static_cast<num>(samples) / periods) : 0;
+        const auto smooth = [coeff](num& x, const num to) {
+            x = to + coeff * (x - to);
+            if (std::abs(x - to) < settle_threshold) {
+                x = to;
+            }
+        };
+
+        previous = values;
+        bool changed = false;
+        for (size_t t = 0; t < values.size(); t++) {
+            if (routed[t]) {
+                const num to = std::clamp(base[t] + goal[t], 0_nm, 1_nm);
+                // a newly routed target fades in through `amount`, so can jump straight to its routed value
+                if (amount[t] > 0) {
+                    smooth(smoothed[t], to);
+                } else {
+                    smoothed[t] = to;
+                }
+            }
+            smooth(amount[t], routed[t] ? 1 : 0);
+
+            const num v = base[t] + amount[t] * (smoothed[t] - base[t]);
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wfloat-equal"
+            changed |= v != values[t];
+#pragma GCC diagnostic pop
+            values[t] = v;
+        }
+        return changed;
+    }
+
+    ModEngine::ModEngine(const size_t targets, const size_t max_routes): matrix{num_sources, targets, max_routes} {
+        envelope.set_adsr(0.01_nm, 0.3_nm, 0.5_nm, 0.5_nm);
+    }
+
+    void ModEngine::set_sample_rate(const num sr) {
+        lfo_1.set_sample_rate(sr);
+        lfo_2.set_sample_rate(sr);
+        envelope.set_sample_rate(sr);
+        random.set_sample_rate(sr);
+        matrix.set_sample_rate(sr);
+    }
+
+    void ModEngine::set_control_period(const size_t samples) {
+        period = std::clamp(samples, min_control_period, max_control_period);
+        elapsed = std::min(elapsed, period - 1);
+    }
+
+    void ModEngine::set_source(const Source source, const num value) {
+        matrix.set_source(source, value);
+    }
+
+    void ModEngine::note_on(const int note, const num velocity) {
+        matrix.set_source(Note, static_cast<num>(note) / 127);
+        matrix.set_source(Velocity, velocity);
+        held.set(static_cast<size_t>(std::clamp(note, 0, 127)));
+        envelope.on();
+    }
+
+    void ModEngine::note_off(const int note) {
+        const auto key = static_cast<size_t>(std::clamp(note, 0, 127));
+        if (held.test(key)) {
+            held.reset(key);
+            if (held.none()) {
+                envelope.off();
+            }
+        }
+    }
+
+    bool ModEngine::advance(const size_t samples) {
+        elapsed += samples;
+        if (elapsed < period) {
+            return false;
+        }
+        elapsed = 0;
+
+        matrix.set_source(Lfo1, lfo_1.advance(period));
+        matrix.set_source(Lfo2, lfo_2.advance(period));
+        matrix.set_source(Envelope, envelope.advance(period));
+        matrix.set_source(Random, random.advance(period));
+        return matrix.process(period);
+    }
+}
@@ -0,0 +1,93 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <algorithm>
+#include <chrono>
+
+#include <dsp/perf.hpp>
+
+namespace modal::dsp::perf {
+    Monitor::Monitor() : queue{std::make_unique<SpscRing<BlockStats, queue_size>>()}, history(window) {
+        sorted.reserve(window);
+    }
+
+    uint64_t Monitor::now() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    void Monitor::begin_block(const size_t samples, const num sample_rate) {
+        current = {};
+        current.samples = static_cast<uint32_t>(samples);
+        current.sample_rate = static_cast<float>(sample_rate);
+        block_start = lap_start = now();
+    }
+
+    void Monitor::lap(const Stage stage) {
+        const auto t = now();
+        add(stage, t - lap_start);
+        lap_start = t;
+    }
+
+    void Monitor::skip_lap() {
+        lap_start = now();
+    }
+
+    void Monitor::set_active(const size_t voices, const size_t modes) {
+        current.active_voices = static_cast<uint32_t>(voices);
+        current.active_modes = static_cast<uint32_t>(modes);
+    }
+
+    void Monitor::end_block() {
+        current.total_ns = now() - block_start;
+        queue->push(current);
+    }
+
+    Summary Monitor::collect() {
+        BlockStats block;
+        while (queue->pop(block)) {
+            history[history_next] = block;
+            history_next = (history_next + 1) % window;
+            history_count = std::min(history_count + 1, window);
+            for (size_t c = 0; c < num_counters; c++) {
+                totals[c] += block.counters[c];
+            }
+        }
+
+        Summary out;
+        out.counters = totals;
+        out.blocks = history_count;
+        if (history_count == 0) {
+            return out;
+        }
+
+        const auto& latest = history[(history_next + window - 1) % window];
+        out.active_voices = latest.active_voices;
+        out.active_modes = latest.active_modes;
+
+        double busy = 0, audio = 0;
+        std::array<double, num_stages> stages {};
+        sorted.clear();
+        for (size_t i = 0; i < history_count; i++) {
+            const auto& b = history[i];
+            busy += static_cast<double>(b.total_ns);
+            if (b.sample_rate > 0) {
+                audio += 1e9 * b.samples / b.sample_rate;
+            }
+            for (size_t s = 0; s < num_stages; s++) {
+                stages[s] += static_cast<double>(b.stage_ns[s]);
+            }
+            sorted.push_back(b.total_ns);
+        }
+
+        out.load = audio > 0 ? busy / audio : 0;
+        out.mean_ns = busy / static_cast<double>(history_count);
+        for (size_t s = 0; s < num_stages; s++) {
+            out.stage_share[s] = busy > 0 ? stages[s] / busy : 0;
+        }
+        const auto p99 = sorted.begin() + static_cast<std::ptrdiff_t>((history_count - 1) * 99 / 100);
+        std::nth_element(sorted.begin(), p99, sorted.end());
+        out.p99_ns = static_cast<double>(*p99);
+        out.peak_ns = static_cast<double>(*std::max_element(p99, sorted.end()));
+        return out;
+    }
+}
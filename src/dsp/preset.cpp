@@ -0,0 +1,341 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <dsp/preset.hpp>
+
+namespace modal::dsp::preset {
+    namespace {
+        constexpr std::array<uint8_t, 4> patch_magic {'M', 'D', 'L', 'P'};
+        constexpr std::array<uint8_t, 4> library_magic {'M', 'D', 'L', 'B'};
+        constexpr uint16_t library_version = 1;
+
+        constexpr size_t patch_header_size = 12;
+        constexpr size_t param_size = 8;
+        constexpr size_t slot_size = 14;
+        constexpr size_t library_header_size = 16;
+        constexpr size_t entry_size = 64;
+        constexpr size_t entry_name_size = PresetLibrary::max_name + 1;
+
+        void put_u8(std::vector<uint8_t>& out, const uint8_t v) {
+            out.push_back(v);
+        }
+
+        void put_u16(std::vector<uint8_t>& out, const uint16_t v) {
+            out.push_back(static_cast<uint8_t>(v));
+            out.push_back(static_cast<uint8_t>(v >> 8));
+        }
+
+        void put_u32(std::vector<uint8_t>& out, const uint32_t v) {
+            for (int shift = 0; shift < 32; shift += 8) {
+                out.push_back(static_cast<uint8_t>(v >> shift));
+            }
+        }
+
+        void put_f32(std::vector<uint8_t>& out, const float v) {
+            put_u32(out, std::bit_cast<uint32_t>(v));
+        }
+
+        // bounds checked little endian reader, sticks at failed once a read runs off the end
+        class Reader {
+         public:
+            explicit Reader(const std::span<const uint8_t> d) : data{d} {}
+
+            bool take(const size_t n) {
+                if (failed || data.size() - pos < n) {
+                    failed = true;
+                    return false;
+                }
+                pos += n;
+                return true;
+            }
+
+            uint8_t u8() {
+                return take(1) ? data[pos - 1] : 0;
+            }
+
+            uint16_t u16() {
+                if (!take(2)) {
+                    return 0;
+                }
+                return static_cast<uint16_t>(data[pos - 2] | data[pos - 1] << 8);
+            }
+
+            uint32_t u32() {
+                if (!take(4)) {
+                    return 0;
+                }
+                uint32_t v = 0;
+                for (size_t i = 0; i < 4; i++) {
+                    v |= static_cast<uint32_t>(data[pos - 4 + i]) << (8 * i);
+                }
+                return v;
+            }
+
+            float f32() {
+                return std::bit_cast<float>(u32());
+            }
+
+            bool failed = false;
+
+         private:
+            std::span<const uint8_t> data;
+            size_t pos = 0;
+        };
+
+        bool starts_with(const std::span<const uint8_t> data, const std::array<uint8_t, 4>& magic) {
+            return data.size() >= magic.size() && std::equal(magic.begin(), magic.end(), data.begin());
+        }
+    }
+
+    bool PatchState::set(const uint32_t id, const float value) {
+        if (const auto i = find(id)) {
+            params[*i].value = value;
+            return true;
+        }
+        if (num_params >= max_params) {
+            return false;
+        }
+        params[num_params++] = {id, value};
+        return true;
+    }
+
+    std::optional<size_t> PatchState::find(const uint32_t id) const {
+        for (size_t i = 0; i < num_params; i++) {
+            if (params[i].id == id) {
+                return i;
+            }
+        }
+        return std::nullopt;
+    }
+
+    void encode(const PatchState& state, std::vector<uint8_t>& out) {
+        out.insert(out.end(), patch_magic.begin(), patch_magic.end());
+        put_u16(out, format_version);
+        put_u16(out, static_cast<uint16_t>(state.num_params));
+        put_u16(out, static_cast<uint16_t>(state.num_macros));
+        put_u16(out, static_cast<uint16_t>(mod::MacroMap::max_slots));
+        for (size_t i = 0; i < state.num_params; i++) {
+            put_u32(out, state.params[i].id);
+            put_f32(out, state.params[i].value);
+        }
+        for (size_t m = 0; m < state.num_macros; m++) {
+            for (const auto& slot : state.macros[m].slots) {
+                put_u32(out, slot.target);
+                put_u8(out, slot.source);
+                put_u8(out, static_cast<uint8_t>(slot.curve));
+                put_f32(out, slot.lo);
+                put_f32(out, slot.hi);
+            }
+        }
+    }
+
+    bool is_encoded(const std::span<const uint8_t> data) {
+        return starts_with(data, patch_magic) && data.size() >= patch_header_size;
+    }
+
+    bool decode(const std::span<const uint8_t> data, PatchState& out) {
+        if (!is_encoded(data)) {
+            return false;
+        }
+        Reader in {data};
+        in.take(patch_magic.size());
+        const auto version = in.u16();
+        const auto num_params = in.u16();
+        const auto num_macros = in.u16();
+        const auto slots = in.u16();
+        if (version == 0 || version > format_version
+            || num_params > PatchState::max_params || num_macros > PatchState::max_macros) {
+            return false;
+        }
+
+        out.num_params = num_params;
+        for (size_t i = 0; i < num_params; i++) {
+            out.params[i].id = in.u32();
+            out.params[i].value = in.f32();
+        }
+
+        out.num_macros = num_macros;
+        out.macros = {};
+        for (size_t m = 0; m < num_macros; m++) {
+            for (size_t i = 0; i < slots; i++) {
+                mod::MacroSlot slot;
+                slot.target = in.u32();
+                slot.source = in.u8();
+                slot.curve = static_cast<mod::ModCurve>(std::min(in.u8(), static_cast<uint8_t>(mod::ModCurve::SCurve)));
+                slot.lo = in.f32();
+                slot.hi = in.f32();
+                if (slot.target >= num_params) {
+                    slot.target = mod::MacroSlot::unmapped;
+                }
+                if (i < mod::MacroMap::max_slots) {
+                    out.macros[m].slots[i] = slot;
+                }
+            }
+        }
+        return !in.failed;
+    }
+
+    PresetLibrary::~PresetLibrary() {
+        close();
+    }
+
+    PresetLibrary::PresetLibrary(PresetLibrary&& other) noexcept {
+        *this = std::move(other);
+    }
+
+    PresetLibrary& PresetLibrary::operator=(PresetLibrary&& other) noexcept {
+        if (this != &other) {
+            close();
+            data = std::exchange(other.data, nullptr);
+            length = std::exchange(other.length, 0);
+            count = std::exchange(other.count, 0);
+        }
+        return *this;
+    }
+
+    bool PresetLibrary::write(const std::string& path, const std::span<const Preset> presets) {
+        std::vector<uint8_t> out;
+        out.insert(out.end(), library_magic.begin(), library_magic.end());
+        put_u16(out, library_version);
+        put_u16(out, 0);
+        put_u32(out, static_cast<uint32_t>(presets.size()));
+        put_u32(out, 0);
+
+        // the index is filled in as each state is appended after it
+        const size_t index = out.size();
+        out.resize(index + presets.size() * entry_size);
+        for (size_t i = 0; i < presets.size(); i++) {
+            const size_t offset = out.size();
+            encode(presets[i].state, out);
+
+            std::vector<uint8_t> entry(entry_name_size);
+            const auto& name = presets[i].name;
+            std::copy_n(name.begin(), std::min(name.size(), max_name), entry.begin());
+            put_u32(entry, static_cast<uint32_t>(offset));
+            put_u32(entry, static_cast<uint32_t>(out.size() - offset));
+            std::copy(entry.begin(), entry.end(), out.begin() + static_cast<std::ptrdiff_t>(index + i * entry_size));
+        }
+
+        std::ofstream file {path, std::ios::binary | std::ios::trunc};
+        file.write(reinterpret_cast<const char*>(out.data()), static_cast<std::streamsize>(out.size()));
+        return file.good();
+    }
+
+    bool PresetLibrary::open(const std::string& path) {
+        close();
+
+#ifdef _WIN32
+        const HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                        FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        LARGE_INTEGER size;
+        const HANDLE map = GetFileSizeEx(file, &size) && size.QuadPart > 0
+                           ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+        CloseHandle(file);
+        if (map == nullptr) {
+            return false;
+        }
+        // the view keeps the mapping alive
+        const void* view = MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(map);
+        if (view == nullptr) {
+            return false;
+        }
+        data = static_cast<const uint8_t*>(view);
+        length = static_cast<size_t>(size.QuadPart);
+#else
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat info {};
+        void* view = fstat(fd, &info) == 0 && info.st_size > 0
+                     ? mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+        // the mapping stays valid after the file is closed
+        ::close(fd);
+        if (view == MAP_FAILED) {
+            return false;
+        }
+        data = static_cast<const uint8_t*>(view);
+        length = static_cast<size_t>(info.st_size);
+#endif
+
+        Reader in {{data, length}};
+        const bool is_library = starts_with({data, length}, library_magic);
+        in.take(library_magic.size());
+        const auto version = in.u16();
+        in.u16();
+        const auto entries = in.u32();
+        in.u32();
+        // 64 bit maths, so a corrupt count can't overflow the check
+        if (!is_library || in.failed || version == 0 || version > library_version
+            || library_header_size + static_cast<uint64_t>(entries) * entry_size > length) {
+            close();
+            return false;
+        }
+        count = entries;
+        return true;
+    }
+
+    void PresetLibrary::close() {
+        if (data != nullptr) {
+#ifdef _WIN32
+            UnmapViewOfFile(data);
+#else
+            munmap(const_cast<uint8_t*>(data), length);
+#endif
+        }
+        data = nullptr;
+        length = 0;
+        count = 0;
+    }
+
+    std::string_view PresetLibrary::name(const size_t index) const {
+        if (index >= count) {
+            return {};
+        }
+        const auto* entry = reinterpret_cast<const char*>(data + library_header_size + index * entry_size);
+        return {entry, strnlen(entry, entry_name_size)};
+    }
+
+    std::optional<size_t> PresetLibrary::find(const std::string_view preset_name) const {
+        for (size_t i = 0; i < count; i++) {
+            if (name(i) == preset_name) {
+                return i;
+            }
+        }
+        return std::nullopt;
+    }
+
+    bool PresetLibrary::load(const size_t index, PatchState& out) const {
+        if (index >= count) {
+            return false;
+        }
+        Reader in {{data + library_header_size + index * entry_size, entry_size}};
+        in.take(entry_name_size);
+        const uint64_t offset = in.u32();
+        const uint64_t size = in.u32();
+        if (offset + size > length) {
+            return false;
+        }
+        return decode({data + offset, static_cast<size_t>(size)}, out);
+    }
+}
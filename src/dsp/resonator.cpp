@@ -4,6 +4,11 @@
 #include "dsp/resonator.hpp"
 
 namespace modal::dsp::physical::filters {
+    std::complex<num> phasor_coeff(const num freq, const num decay, const num sample_rate) {
+        auto decayFactor = std::pow (0.001f, 1.0f / (decay * sample_rate));
+        auto osc_coeff = std::exp(nums::j * nums::tau * (freq / sample_rate));
+        return decayFactor * osc_coeff;
+    }
 
     void PhasorResonator::set_params(num freq, num amp, num decay) {
         // don't generate sound if we've above nyquist
@@ -18,9 +23,7 @@ namespace modal::dsp::physical::filters {
         t = decay;
         A = amp;
 
-        auto decayFactor = std::pow (0.001f, 1.0f / (t * sample_rate));
-        auto osc_coeff = std::exp(nums::j * nums::tau * (f / sample_rate));
-        filter_coeff = decayFactor * osc_coeff;
+        filter_coeff = phasor_coeff(f, t, sample_rate);
     }
 
     num PhasorResonator::tick(num in) {
@@ -0,0 +1,89 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <array>
+#include <atomic>
+#include <cstdio>
+
+#if __has_include(<execinfo.h>)
+#include <execinfo.h>
+#include <unistd.h>
+#define MODAL_RT_HAS_BACKTRACE 1
+#endif
+
+#include <dsp/rtcheck.hpp>
+
+namespace modal::dsp::rt {
+    namespace {
+        // violations after this many only count, so a violation in a loop doesn't bury the first stack traces
+        constexpr size_t max_reports = 8;
+        constexpr std::array<const char*, num_violations> violation_names {"allocation", "deallocation", "lock"};
+
+        // plain thread locals, so reading them from inside `malloc` can't allocate
+        thread_local unsigned depth = 0;
+        thread_local bool reporting = false;
+
+        std::array<std::atomic<size_t>, num_violations> counts {};
+        std::atomic<size_t> reports {0};
+        std::atomic_bool reporting_enabled {true};
+
+        void report(const Violation kind) {
+            std::fprintf(stderr, "realtime violation: %s inside a realtime scope\n",
+                         violation_names[static_cast<size_t>(kind)]);
+#ifdef MODAL_RT_HAS_BACKTRACE
+            std::array<void*, 64> frames {};
+            const int n = backtrace(frames.data(), static_cast<int>(frames.size()));
+            backtrace_symbols_fd(frames.data(), n, STDERR_FILENO);
+#endif
+            std::fflush(stderr);
+        }
+    }
+
+    ScopedRealtime::ScopedRealtime() {
+        depth++;
+    }
+
+    ScopedRealtime::~ScopedRealtime() {
+        depth--;
+    }
+
+    bool in_realtime() {
+        return depth > 0 && !reporting;
+    }
+
+    void check(const Violation kind) {
+        if (!in_realtime()) {
+            return;
+        }
+        counts[static_cast<size_t>(kind)].fetch_add(1, std::memory_order_relaxed);
+        if (reporting_enabled.load(std::memory_order_relaxed)
+            && reports.fetch_add(1, std::memory_order_relaxed) < max_reports) {
+            // anything the report itself allocates or locks is let through
+            reporting = true;
+            report(kind);
+            reporting = false;
+        }
+    }
+
+    size_t violations(const Violation kind) {
+        return counts[static_cast<size_t>(kind)].load(std::memory_order_relaxed);
+    }
+
+    size_t violations() {
+        size_t total = 0;
+        for (const auto& c : counts) {
+            total += c.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    void reset() {
+        for (auto& c : counts) {
+            c.store(0, std::memory_order_relaxed);
+        }
+        reports.store(0, std::memory_order_relaxed);
+    }
+
+    void set_reporting(const bool enabled) {
+        reporting_enabled.store(enabled, std::memory_order_relaxed);
+    }
+}
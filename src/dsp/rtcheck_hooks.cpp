@@ -0,0 +1,221 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// Replaces the global allocation functions, and on glibc `malloc` and `pthread_mutex_lock`,
+// with versions that report to `dsp::rt::check()` before doing their usual work.
+// Only linked into test executables, never into the plugins, where it would replace the host's allocator.
+
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <new>
+
+#if defined(__GLIBC__)
+#include <dlfcn.h>
+#include <pthread.h>
+#endif
+
+#include <dsp/rtcheck.hpp>
+
+namespace {
+    using modal::dsp::rt::Violation;
+    using modal::dsp::rt::check;
+}
+
+#if defined(__GLIBC__)
+// glibc's own allocator entry points, which the replacements below forward to
+extern "C" {
+    void* __libc_malloc(size_t size);
+    void* __libc_calloc(size_t count, size_t size);
+    void* __libc_realloc(void* ptr, size_t size);
+    void* __libc_memalign(size_t alignment, size_t size);
+    void __libc_free(void* ptr);
+}
+
+namespace {
+    void* raw_alloc(const size_t size) {
+        return __libc_malloc(size);
+    }
+
+    void* raw_aligned_alloc(const size_t alignment, const size_t size) {
+        return __libc_memalign(alignment, size);
+    }
+
+    void raw_free(void* ptr) {
+        __libc_free(ptr);
+    }
+
+    void raw_aligned_free(void* ptr) {
+        __libc_free(ptr);
+    }
+
+    using mutex_lock_fn = int (*)(pthread_mutex_t*);
+    std::atomic<mutex_lock_fn> next_mutex_lock {nullptr};
+}
+
+extern "C" {
+    void* malloc(const size_t size) noexcept {
+        check(Violation::Allocation);
+        return __libc_malloc(size);
+    }
+
+    void* calloc(const size_t count, const size_t size) noexcept {
+        check(Violation::Allocation);
+        return __libc_calloc(count, size);
+    }
+
+    void* realloc(void* ptr, const size_t size) noexcept {
+        check(Violation::Allocation);
+        return __libc_realloc(ptr, size);
+    }
+
+    void* memalign(const size_t alignment, const size_t size) noexcept {
+        check(Violation::Allocation);
+        return __libc_memalign(alignment, size);
+    }
+
+    void* aligned_alloc(const size_t alignment, const size_t size) noexcept {
+        check(Violation::Allocation);
+        return __libc_memalign(alignment, size);
+    }
+
+    int posix_memalign(void** out, const size_t alignment, const size_t size) noexcept {
+        check(Violation::Allocation);
+        if (alignment < sizeof(void*) || (alignment & (alignment - 1)) != 0) {
+            return EINVAL;
+        }
+        void* ptr = __libc_memalign(alignment, size);
+        if (ptr == nullptr) {
+            return ENOMEM;
+        }
+        *out = ptr;
+        return 0;
+    }
+
+    void free(void* ptr) noexcept {
+        if (ptr != nullptr) {
+            check(Violation::Deallocation);
+        }
+        __libc_free(ptr);
+    }
+
+    // std::mutex and juce::CriticalSection both lock through here
+    int pthread_mutex_lock(pthread_mutex_t* mutex) noexcept {
+        check(Violation::Lock);
+        auto next = next_mutex_lock.load(std::memory_order_acquire);
+        if (next == nullptr) {
+            next = reinterpret_cast<mutex_lock_fn>(dlsym(RTLD_NEXT, "pthread_mutex_lock"));
+            next_mutex_lock.store(next, std::memory_order_release);
+        }
+        return next(mutex);
+    }
+}
+#else
+namespace {
+    void* raw_alloc(const size_t size) {
+        return std::malloc(size);
+    }
+
+#if defined(_WIN32)
+    void* raw_aligned_alloc(const size_t alignment, const size_t size) {
+        return _aligned_malloc(size, alignment);
+    }
+
+    void raw_aligned_free(void* ptr) {
+        _aligned_free(ptr);
+    }
+#else
+    void* raw_aligned_alloc(const size_t alignment, const size_t size) {
+        // `aligned_alloc` wants a multiple of the alignment
+        return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+    }
+
+    void raw_aligned_free(void* ptr) {
+        std::free(ptr);
+    }
+#endif
+
+    void raw_free(void* ptr) {
+        std::free(ptr);
+    }
+}
+#endif
+
+namespace {
+    void* checked_new(const size_t size) {
+        check(Violation::Allocation);
+        if (void* ptr = raw_alloc(size > 0 ? size : 1)) {
+            return ptr;
+        }
+        throw std::bad_alloc{};
+    }
+
+    void* checked_new(const size_t size, const std::align_val_t alignment) {
+        check(Violation::Allocation);
+        if (void* ptr = raw_aligned_alloc(static_cast<size_t>(alignment), size > 0 ? size : 1)) {
+            return ptr;
+        }
+        throw std::bad_alloc{};
+    }
+
+    void checked_delete(void* ptr) {
+        if (ptr != nullptr) {
+            check(Violation::Deallocation);
+        }
+        raw_free(ptr);
+    }
+
+    void checked_delete(void* ptr, std::align_val_t) {
+        if (ptr != nullptr) {
+            check(Violation::Deallocation);
+        }
+        raw_aligned_free(ptr);
+    }
+}
+
+void* operator new(const size_t size) {
+    return checked_new(size);
+}
+
+void* operator new[](const size_t size) {
+    return checked_new(size);
+}
+
+void* operator new(const size_t size, const std::align_val_t alignment) {
+    return checked_new(size, alignment);
+}
+
+void* operator new[](const size_t size, const std::align_val_t alignment) {
+    return checked_new(size, alignment);
+}
+
+void operator delete(void* ptr) noexcept {
+    checked_delete(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    checked_delete(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    checked_delete(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+    checked_delete(ptr);
+}
+
+void operator delete(void* ptr, const std::align_val_t alignment) noexcept {
+    checked_delete(ptr, alignment);
+}
+
+void operator delete[](void* ptr, const std::align_val_t alignment) noexcept {
+    checked_delete(ptr, alignment);
+}
+
+void operator delete(void* ptr, size_t, const std::align_val_t alignment) noexcept {
+    checked_delete(ptr, alignment);
+}
+
+void operator delete[](void* ptr, size_t, const std::align_val_t alignment) noexcept {
+    checked_delete(ptr, alignment);
+}
@@ -0,0 +1,308 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+#include <dsp/simd.hpp>
+
+// each kernel body is written once as an always-inlined template, then wrapped in a function per instruction set
+// with the `target` attribute so the compiler vectorises each copy for that instruction set
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define MODAL_SIMD_X86 1
+#define MODAL_SIMD_TARGET(t) __attribute__((target(t)))
+#define MODAL_SIMD_INLINE [[gnu::always_inline]] inline
+#else
+#define MODAL_SIMD_X86 0
+#define MODAL_SIMD_INLINE inline
+#endif
+
+namespace modal::dsp::simd {
+    namespace {
+        // number of `num`s in a vector of the given width in bytes
+        template <size_t bytes>
+        constexpr size_t lanes = bytes / sizeof(num) > 0 ? bytes / sizeof(num) : 1;
+
+        template <size_t W>
+        MODAL_SIMD_INLINE num resonator_bank_impl(const num* __restrict coeff_re, const num* __restrict coeff_im,
+                                                  const num* __restrict amp, num* __restrict y_re,
+                                                  num* __restrict y_im, const size_t count, const num in) {
+            // W partial sums so the reduction can stay in vector registers
+            num acc[W] = {};
+            size_t i = 0;
+            for (; i + W <= count; i += W) {
+                for (size_t l = 0; l < W; l++) {
+                    const size_t k = i + l;
+                    const num re = amp[k] * in + coeff_re[k] * y_re[k] - coeff_im[k] * y_im[k];
+                    const num im = coeff_re[k] * y_im[k] + coeff_im[k] * y_re[k];
+                    y_re[k] = re;
+                    y_im[k] = im;
+                    acc[l] += im;
+                }
+            }
+            for (; i < count; i++) {
+                const num re = amp[i] * in + coeff_re[i] * y_re[i] - coeff_im[i] * y_im[i];
+                const num im = coeff_re[i] * y_im[i] + coeff_im[i] * y_re[i];
+                y_re[i] = re;
+                y_im[i] = im;
+                acc[0] += im;
+            }
+
+            num out = 0;
+            for (size_t l = 0; l < W; l++) {
+                out += acc[l];
+            }
+            return out;
+        }
+
+        MODAL_SIMD_INLINE num biquad_bank_impl(BiquadBank& b, const num in) {
+            constexpr num limit = std::numeric_limits<num>::max();
+            num y[BiquadBank::size];
+            for (size_t l = 0; l < BiquadBank::size; l++) {
+                num out = b.b0[l] * in + b.b1[l] * b.x1[l] + b.b2[l] * b.x2[l] - b.a1[l] * b.y1[l] - b.a2[l] * b.y2[l];
+                // branchless equivalent of the nan/inf check in filters::RBJbiquad::tick()
+                out = std::abs(out) <= limit ? out : 0;
+                b.x2[l] = b.x1[l];
+                b.x1[l] = in;
+                b.y2[l] = b.y1[l];
+                b.y1[l] = out;
+                y[l] = out * b.gain[l];
+            }
+            return (y[0] + y[1]) + (y[2] + y[3]);
+        }
+
+        template <size_t W>
+        MODAL_SIMD_INLINE void resonator_bank_block_impl(const num* __restrict coeff_re, const num* __restrict coeff_im,
+                                                         const num* __restrict amp, num* __restrict y_re,
+                                                         num* __restrict y_im, const size_t count,
+                                                         const num* __restrict in, num* __restrict out, const size_t n) {
+            // per-sample, per-lane partial sums, reduced once at the end of the block
+            alignas(64) num acc[block_size][W] = {};
+            size_t i = 0;
+            for (; i + W <= count; i += W) {
+                num cr[W], ci[W], a[W], re[W], im[W];
+                for (size_t l = 0; l < W; l++) {
+                    cr[l] = coeff_re[i + l];
+                    ci[l] = coeff_im[i + l];
+                    a[l] = amp[i + l];
+                    re[l] = y_re[i + l];
+                    im[l] = y_im[i + l];
+                }
+                for (size_t s = 0; s < n; s++) {
+                    for (size_t l = 0; l < W; l++) {
+                        const num new_re = a[l] * in[s] + cr[l] * re[l] - ci[l] * im[l];
+                        const num new_im = cr[l] * im[l] + ci[l] * re[l];
+                        re[l] = new_re;
+                        im[l] = new_im;
+                        acc[s][l] += new_im;
+                    }
+                }
+                for (size_t l = 0; l < W; l++) {
+                    y_re[i + l] = re[l];
+                    y_im[i + l] = im[l];
+                }
+            }
+            for (; i < count; i++) {
+                for (size_t s = 0; s < n; s++) {
+                    const num re = amp[i] * in[s] + coeff_re[i] * y_re[i] - coeff_im[i] * y_im[i];
+                    const num im = coeff_re[i] * y_im[i] + coeff_im[i] * y_re[i];
+                    y_re[i] = re;
+                    y_im[i] = im;
+                    acc[s][0] += im;
+                }
+            }
+
+            for (size_t s = 0; s < n; s++) {
+                num sum = 0;
+                for (size_t l = 0; l < W; l++) {
+                    sum += acc[s][l];
+                }
+                out[s] = sum;
+            }
+        }
+
+        template <size_t W>
+        MODAL_SIMD_INLINE void resonator_bank_block_glide_impl(num* __restrict coeff_re, num* __restrict coeff_im,
+                                                               num* __restrict amp, const num* __restrict target_re,
+                                                               const num* __restrict target_im,
+                                                               const num* __restrict target_amp,
+                                                               num* __restrict y_re, num* __restrict y_im,
+                                                               const size_t count, const num* __restrict in,
+                                                               num* __restrict out, const size_t n) {
+            // as resonator_bank_block_impl, with each coefficient stepped towards its target every sample
+            alignas(64) num acc[block_size][W] = {};
+            const num step = 1 / static_cast<num>(n);
+            size_t i = 0;
+            for (; i + W <= count; i += W) {
+                num cr[W], ci[W], a[W], dr[W], di[W], da[W], re[W], im[W];
+                for (size_t l = 0; l < W; l++) {
+                    cr[l] = coeff_re[i + l];
+                    ci[l] = coeff_im[i + l];
+                    a[l] = amp[i + l];
+                    dr[l] = (target_re[i + l] - cr[l]) * step;
+                    di[l] = (target_im[i + l] - ci[l]) * step;
+                    da[l] = (target_amp[i + l] - a[l]) * step;
+                    re[l] = y_re[i + l];
+                    im[l] = y_im[i + l];
+                }
+                for (size_t s = 0; s < n; s++) {
+                    for (size_t l = 0; l < W; l++) {
+                        cr[l] += dr[l];
+                        ci[l] += di[l];
+                        a[l] += da[l];
+                        const num new_re = a[l] * in[s] + cr[l] * re[l] - ci[l] * im[l];
+                        const num new_im = cr[l] * im[l] + ci[l] * re[l];
+                        re[l] = new_re;
+                        im[l] = new_im;
+                        acc[s][l] += new_im;
+                    }
+                }
+                for (size_t l = 0; l < W; l++) {
+                    y_re[i + l] = re[l];
+                    y_im[i + l] = im[l];
+                }
+            }
+            for (; i < count; i++) {
+                const num dr = (target_re[i] - coeff_re[i]) * step;
+                const num di = (target_im[i] - coeff_im[i]) * step;
+                const num da = (target_amp[i] - amp[i]) * step;
+                num cr = coeff_re[i], ci = coeff_im[i], a = amp[i];
+                for (size_t s = 0; s < n; s++) {
+                    cr += dr;
+                    ci += di;
+                    a += da;
+                    const num re = a * in[s] + cr * y_re[i] - ci * y_im[i];
+                    const num im = cr * y_im[i] + ci * y_re[i];
+                    y_re[i] = re;
+                    y_im[i] = im;
+                    acc[s][0] += im;
+                }
+            }
+
+            // land exactly on the targets, rather than wherever the accumulated steps ended up
+            for (size_t k = 0; k < count; k++) {
+                coeff_re[k] = target_re[k];
+                coeff_im[k] = target_im[k];
+                amp[k] = target_amp[k];
+            }
+
+            for (size_t s = 0; s < n; s++) {
+                num sum = 0;
+                for (size_t l = 0; l < W; l++) {
+                    sum += acc[s][l];
+                }
+                out[s] = sum;
+            }
+        }
+
+// defines a full set of kernels for one instruction set, with vectors `bytes` wide
+#define MODAL_SIMD_DEFINE_KERNELS(name, isa, attributes, bytes)                                                       \
+        attributes num resonator_bank_##name(const num* coeff_re, const num* coeff_im, const num* amp,               \
+                                             num* y_re, num* y_im, const size_t count, const num in) {               \
+            return resonator_bank_impl<lanes<bytes>>(coeff_re, coeff_im, amp, y_re, y_im, count, in);                \
+        }                                                                                                            \
+        attributes void resonator_bank_block_##name(const num* coeff_re, const num* coeff_im, const num* amp,        \
+                                                    num* y_re, num* y_im, const size_t count,                        \
+                                                    const num* in, num* out, const size_t n) {                       \
+            resonator_bank_block_impl<lanes<bytes>>(coeff_re, coeff_im, amp, y_re, y_im, count, in, out, n);         \
+        }                                                                                                            \
+        attributes void resonator_bank_block_glide_##name(num* coeff_re, num* coeff_im, num* amp,                    \
+                                                          const num* target_re, const num* target_im,                \
+                                                          const num* target_amp, num* y_re, num* y_im,               \
+                                                          const size_t count, const num* in, num* out,               \
+                                                          const size_t n) {                                          \
+            resonator_bank_block_glide_impl<lanes<bytes>>(coeff_re, coeff_im, amp, target_re, target_im, target_amp, \
+                                                          y_re, y_im, count, in, out, n);                            \
+        }                                                                                                            \
+        attributes num biquad_bank_##name(BiquadBank& bank, const num in) {                                          \
+            return biquad_bank_impl(bank, in);                                                                       \
+        }                                                                                                            \
+        constexpr Kernels name##_kernels {                                                                           \
+            isa, resonator_bank_##name, resonator_bank_block_##name, resonator_bank_block_glide_##name,              \
+            biquad_bank_##name                                                                                       \
+        };
+
+        MODAL_SIMD_DEFINE_KERNELS(generic, Isa::Generic, , 16)
+#if MODAL_SIMD_X86
+        MODAL_SIMD_DEFINE_KERNELS(sse2, Isa::SSE2, MODAL_SIMD_TARGET("sse2"), 16)
+        MODAL_SIMD_DEFINE_KERNELS(avx2, Isa::AVX2, MODAL_SIMD_TARGET("avx2,fma"), 32)
+        MODAL_SIMD_DEFINE_KERNELS(avx512, Isa::AVX512, MODAL_SIMD_TARGET("avx512f,avx512vl,avx512dq,avx2,fma"), 64)
+#endif
+
+        const Kernels& select_kernels() {
+            Isa isa = detect_isa();
+            if (const char* env = std::getenv("MODAL_SIMD")) {
+                // only allow overriding downwards, an unsupported instruction set would crash
+                if (const auto requested = isa_from_name(env); requested && *requested <= isa) {
+                    isa = *requested;
+                }
+            }
+            return kernels_for(isa);
+        }
+    }
+
+    const Kernels& kernels() {
+        static const Kernels& selected = select_kernels();
+        return selected;
+    }
+
+    const Kernels& kernels_for(const Isa isa) {
+        switch (isa) {
+#if MODAL_SIMD_X86
+            case Isa::SSE2:
+                return sse2_kernels;
+            case Isa::AVX2:
+                return avx2_kernels;
+            case Isa::AVX512:
+                return avx512_kernels;
+#else
+            case Isa::SSE2:
+            case Isa::AVX2:
+            case Isa::AVX512:
+#endif
+            case Isa::Generic:
+                break;
+        }
+        return generic_kernels;
+    }
+
+    Isa detect_isa() {
+#if MODAL_SIMD_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vl")
+            && __builtin_cpu_supports("avx512dq")) {
+            return Isa::AVX512;
+        }
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+            return Isa::AVX2;
+        }
+        if (__builtin_cpu_supports("sse2")) {
+            return Isa::SSE2;
+        }
+#endif
+        return Isa::Generic;
+    }
+
+    std::string_view isa_name(const Isa isa) {
+        switch (isa) {
+            case Isa::Generic:
+                return "generic";
+            case Isa::SSE2:
+                return "sse2";
+            case Isa::AVX2:
+                return "avx2";
+            case Isa::AVX512:
+                return "avx512";
+        }
+        return "unknown";
+    }
+
+    std::optional<Isa> isa_from_name(const std::string_view name) {
+        for (const auto isa : {Isa::Generic, Isa::SSE2, Isa::AVX2, Isa::AVX512}) {
+            if (name == isa_name(isa)) {
+                return isa;
+            }
+        }
+        return std::nullopt;
+    }
+}
@@ -0,0 +1,296 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numbers>
+
+#include <dsp/resonator.hpp>
+#include <dsp/spectral.hpp>
+
+namespace modal::dsp::spectral {
+    namespace {
+        constexpr long lobe_bins = SpectralModalBank::lobe_width / 2;
+        // window spectrum table covers offsets of +-(lobe_bins + 1) bins, at this many points per bin
+        constexpr long table_resolution = 64;
+        constexpr long table_half_width = (lobe_bins + 1) * table_resolution;
+
+        // sum of e^{-j theta n} for n in [-(n - 2) / 2, (n - 2) / 2], a Dirichlet kernel of length n - 1
+        double dirichlet(const double theta, const double n) {
+            const double denominator = std::sin(theta / 2);
+            if (std::abs(denominator) < 1e-12) {
+                return n - 1;
+            }
+            return std::sin((n - 1) * theta / 2) / denominator;
+        }
+
+        // std::complex's operator* checks for nan/inf, which stops the loops below vectorising
+        inline std::complex<num> mul(const std::complex<num> x, const std::complex<num> y) {
+            return {x.real() * y.real() - x.imag() * y.imag(), x.real() * y.imag() + x.imag() * y.real()};
+        }
+    }
+
+    FFT::FFT(const size_t points): n{points}, twiddles(points / 2), bit_reversed(points) {
+        for (size_t k = 0; k < n / 2; k++) {
+            twiddles[k] = std::polar(1.0_nm, -nums::tau * static_cast<num>(k) / static_cast<num>(n));
+        }
+
+        size_t bits = 0;
+        while ((size_t{1} << bits) < n) {
+            bits++;
+        }
+        for (size_t i = 0; i < n; i++) {
+            size_t r = 0;
+            for (size_t b = 0; b < bits; b++) {
+                r |= ((i >> b) & 1) << (bits - 1 - b);
+            }
+            bit_reversed[i] = r;
+        }
+    }
+
+    void FFT::forward(std::complex<num>* data) const {
+        transform(data, false);
+    }
+
+    void FFT::inverse(std::complex<num>* data) const {
+        transform(data, true);
+        const num scale = 1 / static_cast<num>(n);
+        for (size_t i = 0; i < n; i++) {
+            data[i] *= scale;
+        }
+    }
+
+    void FFT::transform(std::complex<num>* data, const bool invert) const {
+        for (size_t i = 0; i < n; i++) {
+            if (i < bit_reversed[i]) {
+                std::swap(data[i], data[bit_reversed[i]]);
+            }
+        }
+
+        // iterative radix-2 decimation in time, twiddle outermost so each is only loaded once per stage
+        for (size_t len = 2; len <= n; len *= 2) {
+            const size_t half = len / 2;
+            const size_t stride = n / len;
+            for (size_t k = 0; k < half; k++) {
+                const auto w = invert ? std::conj(twiddles[k * stride]) : twiddles[k * stride];
+                for (size_t start = k; start < n; start += len) {
+                    const auto odd = mul(w, data[start + half]);
+                    data[start + half] = data[start] - odd;
+                    data[start] += odd;
+                }
+            }
+        }
+    }
+
+    SpectralModalBank::SpectralModalBank(const size_t max_modes, const size_t hop_size):
+        hop{hop_size}, fft{2 * hop_size},
+        f(max_modes), t(max_modes), a(max_modes), amp(max_modes), radius(max_modes), hop_radius(max_modes),
+        coeff_re(max_modes), coeff_im(max_modes), hop_re(max_modes), hop_im(max_modes),
+        in_re(max_modes), in_im(max_modes), state_re(max_modes), state_im(max_modes), y_re(max_modes), y_im(max_modes),
+        nearest_bin(max_modes), lobe(max_modes * lobe_width),
+        in_block(hop_size), out_block(hop_size), overlap(hop_size), frame(2 * hop_size),
+        window_table(2 * table_half_width + 1) {
+        // spectrum of a periodic Hann window of the frame size, centred on 0 so that the spectrum is real
+        const auto n = static_cast<double>(fft.size());
+        const double bin_width = 2 * std::numbers::pi / n;
+        for (long i = -table_half_width; i <= table_half_width; i++) {
+            const double theta = static_cast<double>(i) / table_resolution * bin_width;
+            const double w = 0.5 * dirichlet(theta, n)
+                           + 0.25 * dirichlet(theta - bin_width, n)
+                           + 0.25 * dirichlet(theta + bin_width, n);
+            window_table[static_cast<size_t>(i + table_half_width)] = static_cast<num>(w);
+        }
+    }
+
+    num SpectralModalBank::window_spectrum(const num offset_bins) const {
+        const num at = offset_bins * table_resolution + table_half_width;
+        const auto i = std::clamp(static_cast<long>(at), 0L, 2 * table_half_width - 1);
+        const num frac = at - static_cast<num>(i);
+        const auto idx = static_cast<size_t>(i);
+        return window_table[idx] + frac * (window_table[idx + 1] - window_table[idx]);
+    }
+
+    void SpectralModalBank::set_sample_rate(const num sr) {
+        sample_rate = sr;
+        for (size_t i = 0; i < f.size(); i++) {
+            set_params(i, f[i], a[i], t[i]);
+        }
+    }
+
+    void SpectralModalBank::set_params(const size_t mode, const num freq, const num amplitude, const num decay) {
+        f[mode] = freq;
+        a[mode] = amplitude;
+        t[mode] = decay;
+        radius[mode] = std::abs(physical::filters::phasor_coeff(freq, decay, sample_rate));
+        hop_radius[mode] = std::pow(radius[mode], static_cast<num>(hop));
+        tune(mode);
+    }
+
+    void SpectralModalBank::bend(const num ratio, const size_t count) {
+        bend_ratio = ratio;
+        bend_pending = std::max(bend_pending, count);
+    }
+
+    void SpectralModalBank::damp(const num rate, const num tilt, const num step, const size_t count) {
+        for (size_t k = 0; k < count; k++) {
+            const auto r = radius[k];
+            // silenced modes have no coefficients to scale
+            if (r <= 0 || amp[k] <= 0) {
+                continue;
+            }
+            const auto loss = std::min(rate * (1 + tilt * (1 - coeff_re[k] / r)), 0.5_nm);
+            const auto scale = 1 - loss * step;
+            if (r * scale <= 1 - loss) {
+                continue;
+            }
+            // the hop is a power of two
+            auto hop_scale = scale;
+            for (size_t h = 1; h < hop; h *= 2) {
+                hop_scale *= hop_scale;
+            }
+            radius[k] = r * scale;
+            hop_radius[k] *= hop_scale;
+            coeff_re[k] *= scale;
+            coeff_im[k] *= scale;
+            hop_re[k] *= hop_scale;
+            hop_im[k] *= hop_scale;
+        }
+    }
+
+    void SpectralModalBank::tune(const size_t mode) {
+        const auto freq = f[mode] * bend_ratio;
+        const auto amplitude = a[mode];
+
+        // don't generate sound if we've above nyquist
+        if (freq > 0 && freq < sample_rate / 2) {
+            const num omega = nums::tau * freq / sample_rate;
+            const auto c = std::polar(radius[mode], omega);
+            const auto per_hop = std::polar(hop_radius[mode], omega * static_cast<num>(hop));
+            const auto in_rot = std::polar(amplitude, omega * static_cast<num>(hop - 1));
+            coeff_re[mode] = c.real();
+            coeff_im[mode] = c.imag();
+            hop_re[mode] = per_hop.real();
+            hop_im[mode] = per_hop.imag();
+            in_re[mode] = in_rot.real();
+            in_im[mode] = in_rot.imag();
+            amp[mode] = amplitude;
+            const num bin = omega / nums::tau * static_cast<num>(fft.size());
+            nearest_bin[mode] = static_cast<size_t>(bin + 0.5_nm);
+            for (size_t i = 0; i < lobe_width; i++) {
+                const auto b = static_cast<long>(nearest_bin[mode] + i) - lobe_bins;
+                lobe[mode * lobe_width + i] = window_spectrum(static_cast<num>(b) - bin);
+            }
+        } else {
+            coeff_re[mode] = coeff_im[mode] = 0;
+            hop_re[mode] = hop_im[mode] = 0;
+            in_re[mode] = in_im[mode] = 0;
+            amp[mode] = 0;
+            nearest_bin[mode] = 0;
+            std::fill_n(lobe.begin() + static_cast<long>(mode * lobe_width), lobe_width, 0);
+        }
+    }
+
+    void SpectralModalBank::ping(const size_t count) {
+        pending_ping = count;
+    }
+
+    num SpectralModalBank::tick(const num in, const size_t count) {
+        in_block[position] = in;
+        if (std::abs(in) > 0) {
+            input_silent = false;
+        }
+
+        const num out = out_block[position];
+        if (++position == hop) {
+            position = 0;
+            process_hop(count);
+        }
+        return out;
+    }
+
+    num SpectralModalBank::energy(const size_t count) const {
+        if (!input_silent) {
+            return std::numeric_limits<num>::infinity();
+        }
+        num sum = 0;
+        for (size_t k = 0; k < count; k++) {
+            sum += k < pending_ping ? amp[k] * amp[k] : state_re[k] * state_re[k] + state_im[k] * state_im[k];
+        }
+        return sum;
+    }
+
+    void SpectralModalBank::reset() {
+        std::fill(state_re.begin(), state_re.end(), 0);
+        std::fill(state_im.begin(), state_im.end(), 0);
+        std::fill(in_block.begin(), in_block.end(), 0);
+        std::fill(out_block.begin(), out_block.end(), 0);
+        std::fill(overlap.begin(), overlap.end(), 0);
+        position = 0;
+        pending_ping = 0;
+        input_silent = true;
+    }
+
+    void SpectralModalBank::process_hop(const size_t count) {
+        const size_t n = fft.size();
+
+        // bends since the last hop take effect from here on
+        for (size_t k = 0; k < bend_pending; k++) {
+            tune(k);
+        }
+        bend_pending = 0;
+
+        // advance every mode to the end of this hop
+        if (input_silent) {
+            for (size_t k = 0; k < count; k++) {
+                const num re = state_re[k] * hop_re[k] - state_im[k] * hop_im[k];
+                const num im = state_re[k] * hop_im[k] + state_im[k] * hop_re[k];
+                state_re[k] = re;
+                state_im[k] = im;
+            }
+        } else {
+            // sum of x[i] * c^(hop - 1 - i) over the hop, approximated by the input's spectrum at the nearest bin
+            std::fill(frame.begin(), frame.end(), 0);
+            std::copy(in_block.begin(), in_block.end(), frame.begin());
+            fft.forward(frame.data());
+            for (size_t k = 0; k < count; k++) {
+                const auto x = frame[nearest_bin[k]];
+                const num re = state_re[k] * hop_re[k] - state_im[k] * hop_im[k] + in_re[k] * x.real() - in_im[k] * x.imag();
+                const num im = state_re[k] * hop_im[k] + state_im[k] * hop_re[k] + in_re[k] * x.imag() + in_im[k] * x.real();
+                state_re[k] = re;
+                state_im[k] = im;
+            }
+        }
+        input_silent = true;
+
+        for (size_t k = 0; k < std::min(pending_ping, count); k++) {
+            state_re[k] = amp[k];
+            state_im[k] = 0;
+        }
+        pending_ping = 0;
+
+        // state a sample after the hop boundary, as the recursive bank would output
+        for (size_t k = 0; k < count; k++) {
+            y_re[k] = state_re[k] * coeff_re[k] - state_im[k] * coeff_im[k];
+            y_im[k] = state_re[k] * coeff_im[k] + state_im[k] * coeff_re[k];
+        }
+
+        // add each mode's windowed spectrum to the frame, centred on the hop boundary
+        std::fill(frame.begin(), frame.end(), 0);
+        const size_t mask = n - 1;
+        for (size_t k = 0; k < count; k++) {
+            const std::complex<num> y {y_re[k], y_im[k]};
+            const num* weights = lobe.data() + k * lobe_width;
+            const size_t first = nearest_bin[k] - lobe_bins;
+            for (size_t i = 0; i < lobe_width; i++) {
+                frame[(first + i) & mask] += y * weights[i];
+            }
+        }
+        fft.inverse(frame.data());
+
+        // the first half of the frame completes the hop that just ended, the second half overlaps the next
+        for (size_t i = 0; i < hop; i++) {
+            out_block[i] = overlap[i] + frame[n - hop + i].imag();
+            overlap[i] = frame[i].imag();
+        }
+    }
+}
@@ -0,0 +1,48 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <ui/KeyboardBridge.hpp>
+
+namespace modal::ui {
+    KeyboardBridge::KeyboardBridge() {
+        state.addListener(this);
+        startTimerHz(30);
+    }
+
+    KeyboardBridge::~KeyboardBridge() {
+        // stopped before `state` goes, processors can be destroyed off the message thread, where JUCE wants timers stopped
+        stopTimer();
+        state.removeListener(this);
+    }
+
+    void KeyboardBridge::show(const juce::MidiMessage& m) {
+        if (m.isNoteOnOrOff()) {
+            shown.push({static_cast<uint8_t>(m.getChannel()), static_cast<uint8_t>(m.getNoteNumber()),
+                        m.isNoteOn(), m.getFloatVelocity()});
+        }
+    }
+
+    void KeyboardBridge::handleNoteOn(juce::MidiKeyboardState*, const int channel, const int note, const float velocity) {
+        if (!showing) {
+            played.push({static_cast<uint8_t>(channel), static_cast<uint8_t>(note), true, velocity});
+        }
+    }
+
+    void KeyboardBridge::handleNoteOff(juce::MidiKeyboardState*, const int channel, const int note, const float velocity) {
+        if (!showing) {
+            played.push({static_cast<uint8_t>(channel), static_cast<uint8_t>(note), false, velocity});
+        }
+    }
+
+    void KeyboardBridge::timerCallback() {
+        showing = true;
+        NoteEvent e {};
+        while (shown.pop(e)) {
+            if (e.on) {
+                state.noteOn(e.channel, e.note, e.velocity);
+            } else {
+                state.noteOff(e.channel, e.note, e.velocity);
+            }
+        }
+        showing = false;
+    }
+}
@@ -1,38 +1,87 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 
 #include <ui/MacroController.hpp>
+#include <algorithm>
 #include <print>
 
-#include <dsp/bonus.hpp>
-
 namespace modal::ui {
-    MacroController::MacroController(const juce::AudioProcessor& processor) {
+    // does not bring across the convert lambda functions
+    template<typename I, typename O>
+    juce::NormalisableRange<O> convert_nr(const juce::NormalisableRange<I>& in) {
+        juce::NormalisableRange<O> out;
+        out.start = static_cast<O>(in.start);
+        out.end = static_cast<O>(in.end);
+        out.interval = static_cast<O>(in.interval);
+        out.skew = static_cast<O>(in.skew);
+        out.symmetricSkew = in.symmetricSkew;
+        return out;
+    }
+
+    MacroController::MacroController(const juce::AudioProcessor& processor, const juce::StringArray& source_names)
+        : MacroController(targets(processor), source_names) {}
+
+    MacroController::MacroController(const std::vector<juce::AudioParameterFloat*>& target_params,
+                                     const juce::StringArray& source_names)
+        : sources{source_names} {
+        for (const auto p : target_params) {
+            params.emplace_back(p->getParameterID(), p->getName(32), *p);
+        }
+
+        for (size_t i = 0; i < ui.settingses.size(); i++) {
+            auto& s = ui.settingses[i];
+            s.add_params();
+            s.source.addListener(this);
+            s.options.addListener(this);
+            s.curve.addListener(this);
+            s.lo.addListener(this);
+            s.hi.addListener(this);
+            update_widgets(i);
+        }
+    }
+
+    std::vector<juce::AudioParameterFloat*> MacroController::targets(const juce::AudioProcessor& processor) {
+        std::vector<juce::AudioParameterFloat*> out;
         for (const auto& p : processor.getParameters()) {
             auto p2 = dynamic_cast<juce::RangedAudioParameter*>(p);
             if (!p2->isMetaParameter() && typeid(*p2) == typeid(juce::AudioParameterFloat)) {
-                const auto p3 = dynamic_cast<juce::AudioParameterFloat*>(p);
-                const auto id = p2->getParameterID();
-                const auto name = p2->getName(32);
-                params.emplace_back(id, name, *p3);
+                out.push_back(dynamic_cast<juce::AudioParameterFloat*>(p));
             }
         }
+        return out;
+    }
 
-        for (auto& s : ui.settingses) {
-            s.add_params();
-        }
+    void MacroController::add_routes(modal::dsp::mod::ModMatrix& matrix, const size_t source) {
+        matrix.add_routes(published.acquire(), source);
     }
 
-    void MacroController::set_values(const modal::dsp::num n) const {
-        for (auto& s : ui.settingses) {
-            const auto param_i = static_cast<size_t>(s.options.getSelectedId());
-            if (param_i > 1) {
-                auto p = params[param_i - 2];
-                const auto lo = s.lo.getNormalisableRange().convertTo0to1(s.lo.getValue());
-                const auto hi = s.hi.getNormalisableRange().convertTo0to1(s.hi.getValue());
-                const auto new_unit = dsp::bonus::lerp(static_cast<dsp::num>(lo), static_cast<dsp::num>(hi), n);
-                // p.pm.beginChangeGesture(); // todo: this
-                p.pm.setValueNotifyingHost(new_unit);
-            }
+    void MacroController::update_slot(const size_t i) {
+        const auto& s = ui.settingses[i];
+        auto& slot = map.slots[i];
+        const auto param_i = s.options.getSelectedId();
+        slot.target = param_i > 1 ? static_cast<uint32_t>(param_i - 2) : dsp::mod::MacroSlot::unmapped;
+        slot.source = static_cast<uint8_t>(sources.isEmpty() ? 0 : std::max(s.source.getSelectedId(), 1) - 1);
+        slot.curve = static_cast<dsp::mod::ModCurve>(std::max(s.curve.getSelectedId(), 1) - 1);
+        slot.lo = static_cast<float>(s.lo.getNormalisableRange().convertTo0to1(s.lo.getValue()));
+        slot.hi = static_cast<float>(s.hi.getNormalisableRange().convertTo0to1(s.hi.getValue()));
+        published.publish(map);
+    }
+
+    void MacroController::update_widgets(const size_t i) {
+        auto& s = ui.settingses[i];
+        const auto& slot = map.slots[i];
+        const bool mapped = slot.target < params.size();
+
+        s.source.setSelectedId(static_cast<int>(slot.source) + 1, juce::dontSendNotification);
+        s.options.setSelectedId(mapped ? static_cast<int>(slot.target) + 2 : 1, juce::dontSendNotification);
+        s.curve.setSelectedId(static_cast<int>(slot.curve) + 1, juce::dontSendNotification);
+        s.lo.setEnabled(mapped);
+        s.hi.setEnabled(mapped);
+        if (mapped) {
+            const auto range = convert_nr<float, double>(params[slot.target].pm.getNormalisableRange());
+            s.lo.setNormalisableRange(range);
+            s.hi.setNormalisableRange(range);
+            s.lo.setValue(range.convertFrom0to1(slot.lo), juce::dontSendNotification);
+            s.hi.setValue(range.convertFrom0to1(slot.hi), juce::dontSendNotification);
         }
     }
 
@@ -42,28 +91,70 @@ namespace modal::ui {
 
     juce::ValueTree MacroController::dump_state() const {
         juce::ValueTree state{"MacroController"};
-        for (auto& s : ui.settingses) {
+        for (const auto& slot : map.slots) {
+            const bool mapped = slot.target < params.size();
             juce::ValueTree setting{"MacroControllerSetting"};
-            setting.setProperty("param_i", s.options.getSelectedId(), nullptr);
-            setting.setProperty("lo", s.lo.getValue(), nullptr);
-            setting.setProperty("hi", s.hi.getValue(), nullptr);
+            setting.setProperty("param_i", mapped ? static_cast<int>(slot.target) + 2 : 1, nullptr);
+            setting.setProperty("lo", mapped ? params[slot.target].pm.convertFrom0to1(slot.lo) : slot.lo, nullptr);
+            setting.setProperty("hi", mapped ? params[slot.target].pm.convertFrom0to1(slot.hi) : slot.hi, nullptr);
+            setting.setProperty("curve", static_cast<int>(slot.curve), nullptr);
+            setting.setProperty("source", static_cast<int>(slot.source), nullptr);
             state.addChild(setting, -1, nullptr);
         }
         return state;
     }
 
-    // todo: add error checking
+    // older states have fewer settings and no curves, missing ones are left unmapped and linear
     void MacroController::load_state(const juce::ValueTree& state) {
-        for (int i = 0; i < state.getNumChildren(); i++) {
-            auto& s = ui.settingses[i];
-            auto setting = state.getChild(i);
-            auto param_id = setting.getProperty("param_i").operator int();
-            auto lo_val = setting.getProperty("lo").operator double();
-            auto hi_val = setting.getProperty("hi").operator double();
-            s.options.setSelectedId(param_id, juce::sendNotificationSync); // see https://forum.juce.com/t/question-request-re-var/19445/2
-            s.lo.setValue(lo_val);
-            s.hi.setValue(hi_val);
+        for (size_t i = 0; i < map.slots.size(); i++) {
+            const auto setting = state.getChild(static_cast<int>(i));
+            const auto param_i = static_cast<int>(setting.getProperty("param_i", 1));
+            const auto curve = std::clamp(static_cast<int>(setting.getProperty("curve", 0)), 0,
+                                          static_cast<int>(dsp::mod::ModCurve::SCurve));
+            const auto source = std::clamp(static_cast<int>(setting.getProperty("source", 0)), 0,
+                                           std::max(sources.size() - 1, 0));
+
+            auto& slot = map.slots[i];
+            slot = {};
+            slot.curve = static_cast<dsp::mod::ModCurve>(curve);
+            slot.source = static_cast<uint8_t>(source);
+            if (param_i > 1 && static_cast<size_t>(param_i - 2) < params.size()) {
+                slot.target = static_cast<uint32_t>(param_i - 2);
+                const auto& pm = params[slot.target].pm;
+                slot.lo = pm.convertTo0to1(static_cast<float>(static_cast<double>(setting.getProperty("lo"))));
+                slot.hi = pm.convertTo0to1(static_cast<float>(static_cast<double>(setting.getProperty("hi"))));
+            }
+            update_widgets(i);
+        }
+        published.publish(map);
+    }
+
+    void MacroController::dump_state(dsp::preset::PatchState& state, const size_t macro) const {
+        auto& out = state.macros[macro];
+        out = map;
+        for (auto& slot : out.slots) {
+            const auto index = slot.target < params.size()
+                               ? state.find(dsp::preset::param_id(params[slot.target].id.toRawUTF8()))
+                               : std::nullopt;
+            slot.target = index ? static_cast<uint32_t>(*index) : dsp::mod::MacroSlot::unmapped;
         }
+        state.num_macros = std::max(state.num_macros, static_cast<uint32_t>(macro + 1));
+    }
+
+    void MacroController::load_state(const dsp::preset::PatchState& state, const size_t macro) {
+        map = macro < state.num_macros ? state.macros[macro] : dsp::mod::MacroMap{};
+        for (size_t i = 0; i < map.slots.size(); i++) {
+            auto& slot = map.slots[i];
+            const auto id = slot.target < state.num_params ? state.params[slot.target].id : 0;
+            const auto found = std::find_if(params.begin(), params.end(), [id](const ParamInfo& p) {
+                return dsp::preset::param_id(p.id.toRawUTF8()) == id;
+            });
+            slot.target = slot.target < state.num_params && found != params.end()
+                          ? static_cast<uint32_t>(found - params.begin()) : dsp::mod::MacroSlot::unmapped;
+            slot.source = static_cast<uint8_t>(std::clamp(static_cast<int>(slot.source), 0, std::max(sources.size() - 1, 0)));
+            update_widgets(i);
+        }
+        published.publish(map);
     }
 
     void MacroController::UI::setup() {
@@ -93,17 +184,31 @@ namespace modal::ui {
 
 
     void MacroController::MacroSettings::add_params() {
+        for (int i = 0; i < parent.sources.size(); i++) {
+            source.addItem(parent.sources[i], i + 1);
+        }
+        source.setSelectedId(1);
+
         options.addItem("<no mapping>", 1);
         for (size_t i = 0; i < parent.params.size(); i++) {
             const auto& pi = parent.params[i];
             options.addItem(pi.name, static_cast<int>(i) + 2);
         }
         options.setSelectedId(1);
+
+        curve.addItem("Linear", 1);
+        curve.addItem("Exponential", 2);
+        curve.addItem("Logarithmic", 3);
+        curve.addItem("S-Curve", 4);
+        curve.setSelectedId(1);
     }
 
     void MacroController::MacroSettings::setup() {
-        options.addListener(&parent);
+        if (!parent.sources.isEmpty()) {
+            addAndMakeVisible(source);
+        }
         addAndMakeVisible(options);
+        addAndMakeVisible(curve);
 
         lo.setComponentID("mod_low");
         lo.setSliderStyle(juce::Slider::RotaryHorizontalVerticalDrag);
@@ -123,46 +228,52 @@ namespace modal::ui {
         fb.alignContent = juce::FlexBox::AlignContent::stretch;
         fb.flexDirection = juce::FlexBox::Direction::row;
 
-        fb.items = {
+        if (!parent.sources.isEmpty()) {
+            fb.items.add(juce::FlexItem{source}.withFlex(1).withHeight(40).withAlignSelf(juce::FlexItem::AlignSelf::center));
+        }
+        fb.items.addArray({
             juce::FlexItem{options}.withFlex(1).withHeight(40).withAlignSelf(juce::FlexItem::AlignSelf::center),
+            juce::FlexItem{curve}.withFlex(1).withHeight(40).withAlignSelf(juce::FlexItem::AlignSelf::center),
             juce::FlexItem{lo}.withFlex(1),
             juce::FlexItem{hi}.withFlex(1)
-        };
+        });
 
         fb.performLayout(getLocalBounds());
     }
 
-    // does not bring across the convert lambda functions
-    template<typename I, typename O>
-    juce::NormalisableRange<O> convert_nr(const juce::NormalisableRange<I>& in) {
-        juce::NormalisableRange<O> out;
-        out.start = static_cast<O>(in.start);
-        out.end = static_cast<O>(in.end);
-        out.interval = static_cast<O>(in.interval);
-        out.skew = static_cast<O>(in.skew);
-        out.symmetricSkew = in.symmetricSkew;
-        return out;
-    }
-
     void MacroController::comboBoxChanged(juce::ComboBox* comboBoxThatHasChanged) {
-        const auto parent = comboBoxThatHasChanged->getParentComponent();
-        const auto combo_idx = static_cast<size_t>(comboBoxThatHasChanged->getSelectedId());
+        for (size_t i = 0; i < ui.settingses.size(); i++) {
+            auto& s = ui.settingses[i];
+            if (comboBoxThatHasChanged == &s.options) {
+                const auto combo_idx = static_cast<size_t>(s.options.getSelectedId());
+                if (combo_idx == 1) { // no mapping
+                    s.lo.setEnabled(false);
+                    s.hi.setEnabled(false);
+                } else {
+                    const auto param = params[combo_idx - 2];
+                    const auto range = convert_nr<float, double>(param.pm.getNormalisableRange());
 
-        const auto lo_slider = dynamic_cast<juce::Slider*>(parent->findChildWithID("mod_low"));
-        const auto hi_slider = dynamic_cast<juce::Slider*>(parent->findChildWithID("mod_high"));
+                    s.lo.setEnabled(true);
+                    s.hi.setEnabled(true);
 
-        if (combo_idx == 1) { // no mapping
-            lo_slider->setEnabled(false);
-            hi_slider->setEnabled(false);
-        } else {
-            const auto param = params[combo_idx - 2];
-            const auto range = convert_nr<float, double>(param.pm.getNormalisableRange());
+                    s.lo.setNormalisableRange(range);
+                    s.hi.setNormalisableRange(range);
+                }
+            }
 
-            lo_slider->setEnabled(true);
-            hi_slider->setEnabled(true);
+            if (comboBoxThatHasChanged == &s.source || comboBoxThatHasChanged == &s.options
+                || comboBoxThatHasChanged == &s.curve) {
+                update_slot(i);
+            }
+        }
+    }
 
-            lo_slider->setNormalisableRange(range);
-            hi_slider->setNormalisableRange(range);
+    void MacroController::sliderValueChanged(juce::Slider* sliderThatHasChanged) {
+        for (size_t i = 0; i < ui.settingses.size(); i++) {
+            const auto& s = ui.settingses[i];
+            if (sliderThatHasChanged == &s.lo || sliderThatHasChanged == &s.hi) {
+                update_slot(i);
+            }
         }
     }
 }
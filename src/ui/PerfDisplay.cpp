@@ -0,0 +1,53 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <ui/PerfDisplay.hpp>
+
+#include <dsp/simd.hpp>
+
+namespace modal::ui {
+    namespace {
+        constexpr std::array<const char*, dsp::perf::num_stages> stage_names {
+            "Parameters", "Exciter", "Modes", "Formant", "Output"
+        };
+
+        juce::String milliseconds(const double ns) {
+            return juce::String(ns / 1e6, 3) + " ms";
+        }
+    }
+
+    PerfDisplay::PerfDisplay(std::function<dsp::perf::Summary()> s) : source{std::move(s)} {}
+
+    void PerfDisplay::visibilityChanged() {
+        // the monitor queues blocks while hidden, the first summary after showing drains them
+        if (isVisible()) {
+            startTimerHz(5);
+        } else {
+            stopTimer();
+        }
+    }
+
+    void PerfDisplay::timerCallback() {
+        summary = source();
+        repaint();
+    }
+
+    void PerfDisplay::paint(juce::Graphics& g) {
+        juce::StringArray lines;
+        lines.add("DSP load: " + juce::String(summary.load * 100, 1) + "%");
+        lines.add("Block time: mean " + milliseconds(summary.mean_ns) + ", p99 " + milliseconds(summary.p99_ns)
+                  + ", peak " + milliseconds(summary.peak_ns));
+        for (size_t s = 0; s < dsp::perf::num_stages; s++) {
+            lines.add(juce::String(stage_names[s]) + ": " + juce::String(summary.stage_share[s] * 100, 1) + "%");
+        }
+        const auto isa = dsp::simd::isa_name(dsp::simd::kernels().isa);
+        lines.add("Kernels: " + juce::String(isa.data(), isa.size()));
+        lines.add("Voices: " + juce::String(summary.active_voices) + ", modes: " + juce::String(summary.active_modes));
+        using dsp::perf::Counter;
+        lines.add("Coefficient updates: " + juce::String(summary.counters[static_cast<size_t>(Counter::CoefficientUpdates)]));
+        lines.add("Note drops: " + juce::String(summary.counters[static_cast<size_t>(Counter::NoteDrops)]));
+
+        g.setColour(getLookAndFeel().findColour(juce::Label::textColourId));
+        g.setFont(juce::FontOptions{14});
+        g.drawMultiLineText(lines.joinIntoString("\n"), 10, 20, getWidth() - 20);
+    }
+}
@@ -0,0 +1,27 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <ui/PresetState.hpp>
+
+namespace modal::ui {
+    void capture_params(const juce::AudioProcessor& processor, dsp::preset::PatchState& state) {
+        state.num_params = 0;
+        for (const auto* p : processor.getParameters()) {
+            if (const auto* ranged = dynamic_cast<const juce::RangedAudioParameter*>(p)) {
+                const auto added = state.set(dsp::preset::param_id(ranged->getParameterID().toRawUTF8()),
+                                             ranged->convertFrom0to1(ranged->getValue()));
+                jassert(added); // raise `PatchState::max_params`
+                juce::ignoreUnused(added);
+            }
+        }
+    }
+
+    void restore_params(juce::AudioProcessor& processor, const dsp::preset::PatchState& state) {
+        for (auto* p : processor.getParameters()) {
+            if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(p)) {
+                const auto index = state.find(dsp::preset::param_id(ranged->getParameterID().toRawUTF8()));
+                ranged->setValueNotifyingHost(index ? ranged->convertTo0to1(state.params[*index].value)
+                                                    : ranged->getDefaultValue());
+            }
+        }
+    }
+}
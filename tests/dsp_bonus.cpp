@@ -1,8 +1,21 @@
 #include <dsp/bonus.hpp>
 
 #include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_floating_point.hpp>
+
+#include <cmath>
 
 TEST_CASE("Midi note to frequency (Hz)", "[dsp][midi2freq]") {
     using namespace modal::dsp::bonus;
     REQUIRE(midi2freq(69) == 440.f);
-}
\ No newline at end of file
+}
+
+TEST_CASE("Fast tanh approximation", "[dsp][fast_tanh]") {
+    using namespace modal::dsp;
+    using namespace modal::dsp::bonus;
+    for (num x = -6; x <= 6; x += 0.01_nm) {
+        REQUIRE_THAT(fast_tanh(x), Catch::Matchers::WithinAbs(std::tanh(x), 0.03));
+    }
+    REQUIRE(fast_tanh(0) == 0);
+    REQUIRE(fast_tanh(10) == 1);
+}
@@ -0,0 +1,205 @@
+#include <dsp/control.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <vector>
+
+using namespace modal::dsp;
+
+TEST_CASE("Coefficient scheduler coalesces changes and spreads updates", "[dsp][control]") {
+    CoefficientScheduler<8> scheduler {3};
+    std::vector<size_t> updated;
+    const auto run = [&] {
+        updated.clear();
+        return scheduler.run([&](const size_t v) { updated.push_back(v); });
+    };
+
+    REQUIRE_FALSE(scheduler.pending());
+    REQUIRE(run() == 0);
+
+    // many changes between runs cost one update per voice, a few voices per run
+    for (int i = 0; i < 10; i++) {
+        scheduler.invalidate();
+    }
+    scheduler.updated(1);
+    REQUIRE(run() == 3);
+    REQUIRE(updated == std::vector<size_t>{0, 2, 3});
+    REQUIRE(run() == 3);
+    REQUIRE(updated == std::vector<size_t>{4, 5, 6});
+    REQUIRE(scheduler.pending());
+    REQUIRE(run() == 1);
+    REQUIRE(updated == std::vector<size_t>{7});
+    REQUIRE_FALSE(scheduler.pending());
+    REQUIRE(run() == 0);
+
+    // under a change every run, every voice still gets its turn
+    std::vector<int> counts(8);
+    for (int i = 0; i < 8; i++) {
+        scheduler.invalidate();
+        run();
+        for (const auto v : updated) {
+            counts[v]++;
+        }
+    }
+    for (const auto c : counts) {
+        REQUIRE(c == 3);
+    }
+}
+
+namespace {
+    struct CountingVoice {
+        int ons = 0;
+
+        void on(num, num) {
+            ons++;
+        }
+
+        void off() {}
+    };
+}
+
+TEST_CASE("Poly controller reports the voice a note went to", "[dsp][control]") {
+    std::array<CountingVoice, 2> voices;
+    PolyController<CountingVoice, 2> controller {voices};
+
+    const auto first = controller.key_down(60, 1);
+    const auto second = controller.key_down(62, 1);
+    REQUIRE(first.has_value());
+    REQUIRE(second.has_value());
+    REQUIRE(*first != *second);
+    REQUIRE_FALSE(controller.key_down(64, 1).has_value());
+
+    controller.key_up(60);
+    REQUIRE(controller.key_down(64, 1) == first);
+    REQUIRE(voices[*first].ons == 2);
+}
+
+TEST_CASE("Poly controller predicts the voice of the next note", "[dsp][control]") {
+    std::array<CountingVoice, 2> voices;
+    PolyController<CountingVoice, 2> controller {voices};
+
+    const auto next = controller.next_voice();
+    REQUIRE(controller.key_down(60, 1) == next);
+    REQUIRE(controller.next_voice() != next);
+    controller.key_down(62, 1);
+    REQUIRE_FALSE(controller.next_voice().has_value());
+}
+
+TEST_CASE("Poly controller plays voices that have died away before ringing ones", "[dsp][control]") {
+    std::array<CountingVoice, 3> voices;
+    PolyController<CountingVoice, 3> controller {voices};
+    const auto a = *controller.key_down(60, 1);
+    const auto b = *controller.key_down(62, 1);
+    const auto c = *controller.key_down(64, 1);
+    controller.key_up(60);
+    controller.key_up(62);
+    controller.key_up(64);
+
+    // only released voices can finish
+    controller.key_down(65, 1);
+    const auto held = *controller.key_down(67, 1);
+    controller.finished(held);
+    REQUIRE(controller.is_sounding(held));
+    controller.key_up(65);
+    controller.key_up(67);
+
+    for (const auto v : {a, b, c}) {
+        REQUIRE(controller.is_sounding(v));
+    }
+    controller.finished(b);
+    REQUIRE_FALSE(controller.is_sounding(b));
+    REQUIRE(controller.next_voice() == b);
+    REQUIRE(controller.key_down(69, 1) == b);
+    REQUIRE(controller.is_sounding(b));
+}
+
+TEST_CASE("Mode governor shrinks under load and recovers with hysteresis", "[dsp][control]") {
+    GovernorSettings settings;
+    settings.recover_blocks = 4;
+    ModeGovernor<4> governor {10, settings};
+    REQUIRE(governor.budget() == 40);
+
+    governor.update(0.9);
+    REQUIRE(governor.budget() == 30);
+    for (int i = 0; i < 20; i++) {
+        governor.update(0.9);
+    }
+    // never below a few modes per voice
+    REQUIRE(governor.budget() == 16);
+
+    // between the recovery and target loads it holds
+    for (int i = 0; i < 20; i++) {
+        governor.update(0.5);
+    }
+    REQUIRE(governor.budget() == 16);
+
+    // below, it grows a step per few blocks, and a spike starts the count again
+    for (int i = 0; i < 3; i++) {
+        governor.update(0.1);
+    }
+    governor.update(0.5);
+    for (int i = 0; i < 3; i++) {
+        governor.update(0.1);
+    }
+    REQUIRE(governor.budget() == 16);
+    governor.update(0.1);
+    REQUIRE(governor.budget() == 18);
+    for (int i = 0; i < 100; i++) {
+        governor.update(0.1);
+    }
+    REQUIRE(governor.budget() == 40);
+}
+
+TEST_CASE("Mode governor serves new and loud voices first", "[dsp][control]") {
+    ModeGovernor<4> governor {10};
+    for (int i = 0; i < 4; i++) {
+        governor.update(0.9);
+    }
+    REQUIRE(governor.budget() == 16);
+
+    std::array<ModeGovernor<4>::Voice, 4> voices {{
+        {0.5_nm, 2, true},
+        // just started, so its level isn't known yet
+        {0, 0.01_nm, true},
+        {0.1_nm, 1, false},
+        // rung out
+        {1e-6_nm, 3, false},
+    }};
+    std::array<size_t, 4> limits {};
+    governor.allocate(voices, 10, limits);
+    REQUIRE(limits == std::array<size_t, 4> {4, 8, 4, 0});
+
+    // a patch with few modes leaves some of the budget unused
+    governor.allocate(voices, 3, limits);
+    REQUIRE(limits == std::array<size_t, 4> {3, 3, 3, 0});
+
+    governor.reset();
+    governor.allocate(voices, 10, limits);
+    REQUIRE(limits == std::array<size_t, 4> {10, 10, 10, 0});
+}
+
+TEST_CASE("Poly controller follows the channels notes were played on", "[dsp][control]") {
+    std::array<CountingVoice, 3> voices;
+    PolyController<CountingVoice, 3> controller {voices};
+    const auto following = [&](const int channel) {
+        std::vector<size_t> found;
+        controller.for_channel(channel, [&](const size_t v) { found.push_back(v); });
+        return found;
+    };
+
+    const auto first = controller.key_down(60, 1, 1);
+    const auto second = controller.key_down(60, 1, 2);
+    REQUIRE(following(1) == std::vector<size_t> {*first});
+    REQUIRE(controller.channel(*second) == 2);
+
+    // the same note on another channel is another note
+    controller.key_up(60, 2);
+    REQUIRE(controller.is_active(*first));
+    REQUIRE_FALSE(controller.is_active(*second));
+
+    // a released voice follows its channel until another note is played on it
+    REQUIRE(following(2) == std::vector<size_t> {*second});
+    const auto third = controller.key_down(64, 1, 2);
+    REQUIRE(following(2) == std::vector<size_t> {*third});
+    REQUIRE(controller.channel(*second) == -1);
+}
@@ -0,0 +1,92 @@
+#include <dsp/delay.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_floating_point.hpp>
+
+#include <array>
+
+using namespace modal::dsp;
+using Catch::Matchers::WithinAbs;
+
+TEST_CASE("Delay line capacity is a power of two", "[dsp][delay]") {
+    const delay_line d {48000, 0.1_nm};
+    REQUIRE(d.get_capacity() >= 4800);
+    REQUIRE((d.get_capacity() & (d.get_capacity() - 1)) == 0);
+    REQUIRE(d.get_max_samples() == 4800);
+}
+
+TEST_CASE("Delay line changing sample rate does not reallocate", "[dsp][delay]") {
+    delay_line d {48000, 0.1_nm};
+    const auto capacity = d.get_capacity();
+    d.set_sample_rate(192000);
+    REQUIRE(d.get_capacity() == capacity);
+    REQUIRE(d.get_max_samples() < capacity);
+
+    d.reserve(192000, 0.1_nm);
+    REQUIRE(d.get_capacity() >= 19200);
+}
+
+TEST_CASE("Delay line reads whole sample delays", "[dsp][delay]") {
+    delay_line d {48000, 0.01_nm};
+    for (int i = 0; i < 1000; i++) {
+        // reading before writing gives exactly the requested delay
+        if (i >= 10) {
+            REQUIRE(d.fetch_sample_sm(10) == static_cast<num>(i - 10));
+        }
+        d.push_sample(static_cast<num>(i));
+    }
+}
+
+TEST_CASE("Delay line interpolators are exact on a ramp", "[dsp][delay]") {
+    delay_line d {48000, 0.01_nm};
+    for (int i = 0; i < 100; i++) {
+        d.push_sample(static_cast<num>(i));
+    }
+    // the next sample would be 100, so a delay of x reads 100 - x
+    for (const auto interp : {DelayInterpolation::Linear, DelayInterpolation::Cubic, DelayInterpolation::Lagrange}) {
+        REQUIRE_THAT(d.fetch_sample(10.25_nm, interp), WithinAbs(89.75, 1e-3));
+        REQUIRE_THAT(d.fetch_sample(3.5_nm, interp), WithinAbs(96.5, 1e-3));
+    }
+
+    const std::array<num, 3> taps {2, 7.5_nm, 20.125_nm};
+    std::array<num, 3> out {};
+    d.fetch_taps(taps.data(), out.data(), taps.size(), DelayInterpolation::Lagrange);
+    for (size_t i = 0; i < taps.size(); i++) {
+        REQUIRE_THAT(out[i], WithinAbs(100 - taps[i], 1e-3));
+    }
+}
+
+TEST_CASE("Delay line block I/O matches per-sample I/O", "[dsp][delay]") {
+    delay_line per_sample {48000, 0.01_nm};
+    delay_line block {48000, 0.01_nm};
+    constexpr size_t n = 32;
+    constexpr num delay = 40.5_nm;
+
+    for (int b = 0; b < 50; b++) {
+        std::array<num, n> in {}, expected {}, out {};
+        for (size_t i = 0; i < n; i++) {
+            in[i] = static_cast<num>((b * 37 + static_cast<int>(i) * 11) % 17) - 8;
+        }
+        for (size_t i = 0; i < n; i++) {
+            expected[i] = per_sample.fetch_sample(delay, DelayInterpolation::Cubic);
+            per_sample.push_sample(in[i]);
+        }
+        block.read_block(out.data(), n, delay, DelayInterpolation::Cubic);
+        block.write_block(in.data(), n);
+        for (size_t i = 0; i < n; i++) {
+            REQUIRE_THAT(out[i], WithinAbs(expected[i], 1e-4));
+        }
+    }
+}
+
+TEST_CASE("Delay line allpass interpolation delays a slow sine", "[dsp][delay]") {
+    delay_line d {48000, 0.01_nm};
+    delay_line::allpass_tap tap;
+    num out = 0;
+    for (int i = 0; i < 2000; i++) {
+        d.push_sample(std::sin(static_cast<num>(i) * 0.01_nm));
+        out = d.fetch_sample_allpass(5.3_nm, tap);
+    }
+    // after the push, a delay of 5.3 from the write position is 4.3 samples behind the newest sample
+    REQUIRE_THAT(out, WithinAbs(std::sin((1999 - 4.3_nm) * 0.01_nm), 1e-3));
+}
@@ -0,0 +1,431 @@
+#include <dsp/modal_dsp.h>
+#include <dsp/modal_engine.hpp>
+#include <dsp/preset.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_floating_point.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+using namespace modal::dsp;
+
+namespace {
+    std::vector<float> render(synth::ModalEngine& engine, const size_t samples) {
+        std::vector<float> out(samples, 1e9f);
+        engine.render(out.data(), samples);
+        return out;
+    }
+
+    bool silent(const std::vector<float>& out, const size_t from, const size_t to) {
+        return std::all_of(out.begin() + static_cast<std::ptrdiff_t>(from), out.begin() + static_cast<std::ptrdiff_t>(to),
+                           [](const float s) { return s == 0; });
+    }
+}
+
+TEST_CASE("Engine notes start on their sample", "[dsp][engine]") {
+    auto engine = std::make_unique<synth::ModalEngine>();
+    REQUIRE(engine->note_on(60, 1, 100));
+    const auto out = render(*engine, 256);
+    REQUIRE(silent(out, 0, 100));
+    REQUIRE_FALSE(silent(out, 100, 104));
+
+    // notes past the end of a render carry over to the next
+    auto later = std::make_unique<synth::ModalEngine>();
+    REQUIRE(later->note_on(60, 1, 300));
+    REQUIRE(silent(render(*later, 256), 0, 256));
+    const auto next = render(*later, 256);
+    REQUIRE(silent(next, 0, 44));
+    REQUIRE_FALSE(silent(next, 44, 48));
+}
+
+TEST_CASE("Engine renders the same however it's split into blocks", "[dsp][engine]") {
+    auto whole = std::make_unique<synth::ModalEngine>();
+    auto split = std::make_unique<synth::ModalEngine>();
+    synth::ModalParams params;
+    params.exciter = synth::ModalExiterKind::Square;
+    params.attack = 0.01_nm;
+    params.release = 0.01_nm;
+    whole->set_params(params);
+    split->set_params(params);
+
+    for (auto* e: {whole.get(), split.get()}) {
+        e->note_on(48, 0.5f, 10);
+        e->note_on(55, 1, 700);
+        e->note_off(48, 1500);
+    }
+    const auto expected = render(*whole, 2048);
+    std::vector<float> got;
+    for (const size_t n: {1, 31, 500, 16, 1500}) {
+        const auto out = render(*split, n);
+        got.insert(got.end(), out.begin(), out.end());
+    }
+    REQUIRE(got == expected);
+}
+
+TEST_CASE("Engine counts voices and drops notes when full", "[dsp][engine]") {
+    auto engine = std::make_unique<synth::ModalEngine>();
+    for (int note = 0; note < 20; note++) {
+        engine->note_on(40 + note, 1);
+    }
+    render(*engine, 64);
+    auto stats = engine->stats();
+    REQUIRE(stats.blocks == 1);
+    REQUIRE(stats.active_voices == synth::ModalEngine::voice_count);
+    REQUIRE(stats.active_modes == synth::ModalEngine::voice_count * 40);
+    REQUIRE(stats.counters[static_cast<size_t>(perf::Counter::NoteDrops)] == 4);
+    // every stage of the voices is timed
+    for (size_t stage = 0; stage < perf::num_stages; stage++) {
+        REQUIRE(stats.stage_share[stage] > 0);
+    }
+
+    for (int note = 0; note < 20; note++) {
+        engine->note_off(40 + note);
+    }
+    render(*engine, 64);
+    stats = engine->stats();
+    REQUIRE(stats.active_voices == 0);
+
+    // a full queue drops the rest
+    for (size_t i = 0; i < synth::ModalEngine::max_events; i++) {
+        REQUIRE(engine->note_off(60, 10000));
+    }
+    REQUIRE_FALSE(engine->note_on(60, 1, 10000));
+}
+
+TEST_CASE("The C API plays the engine", "[dsp][engine]") {
+    modal_engine* engine = modal_engine_create(48000);
+    REQUIRE(engine != nullptr);
+
+    modal_patch patch;
+    modal_patch_defaults(&patch);
+    REQUIRE(patch.modes == 40);
+    patch.modes = 5000;
+    patch.exciter = MODAL_EXCITER_NOISE;
+    modal_engine_set_patch(engine, &patch);
+    modal_engine_get_patch(engine, &patch);
+    REQUIRE(patch.modes == synth::ModalEngine::max_patch_modes);
+    REQUIRE(patch.exciter == MODAL_EXCITER_NOISE);
+
+    // states saved by the plugin
+    preset::PatchState state;
+    state.set(preset::param_id("modes"), 12);
+    state.set(preset::param_id("foldback_mode"), 1);
+    std::vector<uint8_t> bytes;
+    preset::encode(state, bytes);
+    REQUIRE(modal_engine_load_state(engine, bytes.data(), bytes.size()) == 1);
+    REQUIRE(modal_engine_load_state(engine, bytes.data(), 3) == 0);
+    modal_engine_get_patch(engine, &patch);
+    REQUIRE(patch.modes == 12);
+    REQUIRE(patch.foldback == MODAL_FOLDBACK_UNDERTONES);
+    REQUIRE(patch.exciter == MODAL_EXCITER_IMPULSE);
+
+    REQUIRE(modal_engine_note_on(engine, 69, 1, 5) == 1);
+    std::vector<float> out(512);
+    modal_engine_render(engine, out.data(), out.size());
+    REQUIRE(out[0] == 0);
+    REQUIRE(std::any_of(out.begin(), out.end(), [](const float s) { return std::abs(s) > 1e-3f; }));
+
+    modal_stats stats;
+    modal_engine_stats(engine, &stats);
+    REQUIRE(stats.blocks == 1);
+    REQUIRE(stats.active_voices == 1);
+    REQUIRE(stats.active_modes == 12);
+    REQUIRE(stats.note_drops == 0);
+    modal_engine_destroy(engine);
+}
+
+TEST_CASE("Voices limited to fewer modes play the patch's first modes", "[dsp][engine]") {
+    synth::ModalPatch full, few;
+    full.set_params(40, 0.1_nm, 1, 4, 1, 0.5_nm);
+    few.set_params(12, 0.1_nm, 1, 4, 1, 0.5_nm);
+    auto limited = std::make_unique<synth::ModalSynth<40>>();
+    auto reference = std::make_unique<synth::ModalSynth<40>>();
+    limited->set_patch(full);
+    reference->set_patch(few);
+    limited->set_exciter(synth::ModalExiterKind::Impulse);
+    reference->set_exciter(synth::ModalExiterKind::Impulse);
+
+    REQUIRE_FALSE(limited->set_mode_limit(12));
+    limited->on(220, 1);
+    reference->on(220, 1);
+    REQUIRE(limited->num_modes() == 12);
+    for (int i = 0; i < 1000; i++) {
+        REQUIRE(limited->tick() == reference->tick());
+    }
+
+    // modes brought back start silent, so an impulse voice sounds the same
+    limited->set_mode_limit(40);
+    REQUIRE(limited->num_modes() == 40);
+    for (int i = 0; i < 1000; i++) {
+        REQUIRE(limited->tick() == reference->tick());
+    }
+}
+
+TEST_CASE("Engine governor bounds the modes played under load", "[dsp][engine]") {
+    auto engine = std::make_unique<synth::ModalEngine>();
+    constexpr size_t all_modes = synth::ModalEngine::voice_count * synth::ModalEngine::max_modes;
+    REQUIRE(engine->mode_budget() == all_modes);
+
+    // no render can meet this, so the budget shrinks to its least
+    engine->set_load_target(1e-9);
+    for (int note = 0; note < 16; note++) {
+        engine->note_on(40 + note, 1, static_cast<uint32_t>(note * 64));
+    }
+    for (int i = 0; i < 40; i++) {
+        render(*engine, 64);
+    }
+    const auto least = engine->mode_budget();
+    REQUIRE(least < all_modes / 4);
+    auto stats = engine->stats();
+    REQUIRE(stats.active_voices == 16);
+    REQUIRE(stats.active_modes <= least);
+    REQUIRE(stats.active_modes >= synth::ModalEngine::voice_count);
+
+    // turned off, every voice plays every mode again
+    engine->set_load_target(0);
+    render(*engine, 64);
+    REQUIRE(engine->mode_budget() == all_modes);
+    stats = engine->stats();
+    REQUIRE(stats.active_modes == all_modes);
+}
+
+TEST_CASE("Engine quality tiers cap modes and spread patch changes", "[dsp][engine]") {
+    auto engine = std::make_unique<synth::ModalEngine>();
+    REQUIRE(engine->quality() == synth::Quality::Normal);
+    for (int note = 0; note < 16; note++) {
+        engine->note_on(40 + note, 1);
+    }
+
+    engine->set_quality(synth::Quality::Eco);
+    render(*engine, 64);
+    REQUIRE(engine->mode_budget() == synth::ModalEngine::voice_count * 20);
+    REQUIRE(engine->stats().active_modes == synth::ModalEngine::voice_count * 20);
+
+    // offline, a patch change reaches every voice at the next control period
+    engine->set_quality(synth::Quality::Offline);
+    synth::ModalParams params;
+    params.modes = 12;
+    engine->set_params(params);
+    render(*engine, 16);
+    REQUIRE(engine->mode_budget() == synth::ModalEngine::voice_count * synth::ModalEngine::max_modes);
+    REQUIRE(engine->stats().active_modes == synth::ModalEngine::voice_count * 12);
+
+    // normal, only a few voices a control period
+    engine->set_quality(synth::Quality::Normal);
+    params.modes = 30;
+    engine->set_params(params);
+    render(*engine, 16);
+    const auto spread = engine->stats().active_modes;
+    REQUIRE(spread > synth::ModalEngine::voice_count * 12);
+    REQUIRE(spread < synth::ModalEngine::voice_count * 30);
+}
+
+TEST_CASE("Engine quality tiers with every mode sound the same for a fixed patch", "[dsp][engine]") {
+    std::vector<float> expected;
+    for (const auto q: {synth::Quality::Normal, synth::Quality::High, synth::Quality::Offline}) {
+        auto engine = std::make_unique<synth::ModalEngine>();
+        engine->set_quality(q);
+        engine->note_on(48, 0.5f, 10);
+        engine->note_on(55, 1, 700);
+        engine->note_off(48, 1500);
+        const auto out = render(*engine, 2048);
+        if (expected.empty()) {
+            expected = out;
+        }
+        REQUIRE(out == expected);
+    }
+}
+
+TEST_CASE("Engine oversamples continuous exciters offline, at the same level", "[dsp][engine]") {
+    const auto rms = [](const std::vector<float>& out) {
+        double sum = 0;
+        for (const auto s: out) {
+            sum += static_cast<double>(s) * static_cast<double>(s);
+        }
+        return std::sqrt(sum / static_cast<double>(out.size()));
+    };
+    for (const auto exciter: {synth::ModalExiterKind::Impulses, synth::ModalExiterKind::Square}) {
+        std::vector<float> outs[2];
+        for (const auto q: {synth::Quality::High, synth::Quality::Offline}) {
+            auto engine = std::make_unique<synth::ModalEngine>();
+            engine->set_quality(q);
+            synth::ModalParams params;
+            params.exciter = exciter;
+            params.exciter_rate = 1;
+            engine->set_params(params);
+            engine->note_on(96, 1);
+            outs[q == synth::Quality::Offline] = render(*engine, 4096);
+        }
+        REQUIRE(outs[0] != outs[1]);
+        const auto ratio = rms(outs[1]) / rms(outs[0]);
+        REQUIRE(ratio > 0.7);
+        REQUIRE(ratio < 1.4);
+    }
+}
+
+TEST_CASE("Engine bends notes per channel with MPE, and every note without", "[dsp][engine]") {
+    using Catch::Matchers::WithinAbs;
+    const auto play = [](const bool mpe, const std::array<int, 2> notes, const int bent_channel, const float bend) {
+        auto engine = std::make_unique<synth::ModalEngine>();
+        engine->set_mpe(mpe);
+        if (bent_channel >= 0) {
+            engine->pitch_bend(bent_channel, bend);
+        }
+        engine->note_on(notes[0], 1, 0, 1);
+        engine->note_on(notes[1], 1, 0, 2);
+        return render(*engine, 2048);
+    };
+    const auto close = [](const std::vector<float>& got, const std::vector<float>& expected) {
+        for (size_t s = 0; s < got.size(); s++) {
+            REQUIRE_THAT(got[s], WithinAbs(expected[s], 1e-3));
+        }
+    };
+
+    // a member channel's bend only reaches its own note, by up to 48 semitones
+    close(play(true, {60, 67}, 1, 2.0f / 48), play(true, {62, 67}, -1, 0));
+    REQUIRE(play(true, {60, 67}, 3, 1) == play(true, {60, 67}, -1, 0));
+
+    // without MPE, any channel bends every note by up to 2 semitones
+    close(play(false, {60, 67}, 3, 1), play(false, {62, 69}, -1, 0));
+}
+
+TEST_CASE("Engine slides a held note's pitch", "[dsp][engine]") {
+    // one mode rings as a sine, whose pitch is easy to count
+    auto engine = std::make_unique<synth::ModalEngine>();
+    synth::ModalParams params;
+    params.modes = 1;
+    params.decay = 5;
+    engine->set_params(params);
+    engine->set_mpe(true);
+    const auto crossings = [](const std::vector<float>& out) {
+        size_t n = 0;
+        for (size_t s = 1; s < out.size(); s++) {
+            n += (out[s - 1] < 0) != (out[s] < 0);
+        }
+        return n;
+    };
+
+    engine->note_on(69, 1, 0, 1);
+    render(*engine, 256);
+    // 440Hz over a tenth of a second
+    REQUIRE(crossings(render(*engine, 4800)) == 88);
+
+    // an octave up in 16 steps, on another note's channel first
+    engine->pitch_bend(2, 0.25f);
+    for (int step = 1; step <= 16; step++) {
+        engine->pitch_bend(1, static_cast<float>(step) / 64, static_cast<uint32_t>(step * 64));
+    }
+    render(*engine, 4800);
+    REQUIRE(crossings(render(*engine, 4800)) == 176);
+}
+
+TEST_CASE("Engine damps released voices and frees them once silent", "[dsp][engine]") {
+    // samples after note off until the voice has died away
+    const auto ring_out = [](const float damping, const size_t modes = 40) {
+        auto engine = std::make_unique<synth::ModalEngine>();
+        synth::ModalParams params;
+        params.modes = modes;
+        params.damping = damping;
+        engine->set_params(params);
+        engine->note_on(57, 1);
+        render(*engine, 4800);
+        REQUIRE(engine->sounding_voices() == 1);
+        engine->note_off(57);
+        size_t samples = 0;
+        for (; engine->sounding_voices() > 0 && samples < 10 * 48000; samples += 480) {
+            render(*engine, 480);
+        }
+        REQUIRE(engine->sounding_voices() == 0);
+        // silent voices aren't rendered
+        const auto out = render(*engine, 480);
+        REQUIRE(silent(out, 0, out.size()));
+        return samples;
+    };
+
+    const auto undamped = ring_out(0);
+    const auto damped = ring_out(1);
+    REQUIRE(undamped > 48000);
+    REQUIRE(damped < 48000 / 4);
+    REQUIRE(ring_out(0.5f) < undamped);
+
+    // large voices' spectral backend is damped alike
+    REQUIRE(ring_out(0, 1000) > 48000);
+    REQUIRE(ring_out(1, 1000) < 48000 / 4);
+}
+
+TEST_CASE("Engine ramps patch changes while voices sound", "[dsp][engine]") {
+    // coefficient updates for a change of decay made while a note rings
+    const auto updates = [](const modal::dsp::num smoothing) {
+        auto engine = std::make_unique<synth::ModalEngine>();
+        engine->set_param_smoothing(smoothing);
+        synth::ModalParams params;
+        engine->set_params(params);
+        engine->note_on(57, 1);
+        render(*engine, 480);
+        const auto count = [&] {
+            return engine->stats().counters[static_cast<size_t>(perf::Counter::CoefficientUpdates)];
+        };
+        const auto before = count();
+
+        params.decay = 2;
+        engine->set_params(params);
+        REQUIRE(engine->params().decay == params.decay);
+        render(*engine, 4800);
+        const auto after = count();
+        // the ramp is over, nothing changes any more
+        render(*engine, 4800);
+        REQUIRE(count() == after);
+        return after - before;
+    };
+
+    const auto jumped = updates(0);
+    REQUIRE(jumped > 0);
+    REQUIRE(updates(synth::ModalEngine::default_param_smoothing) > jumped);
+}
+
+TEST_CASE("Engine modulates its continuous settings", "[dsp][engine]") {
+    synth::ModalParams params;
+    size_t formant_mix = 0;
+    while (&params.continuous(formant_mix) != &params.formant_mix) {
+        formant_mix++;
+    }
+    const auto play = [formant_mix](const mod::ModEngine::Source source, const num lo, const num hi) {
+        auto engine = std::make_unique<synth::ModalEngine>();
+        auto& modulation = engine->modulation();
+        modulation.lfo_1.set_params(20, mod::LfoShape::Square);
+        REQUIRE(modulation.matrix.add_route({source, formant_mix, lo, hi}));
+        engine->note_on(48, 1);
+        return render(*engine, 4096);
+    };
+    const auto unmodulated = [] {
+        auto engine = std::make_unique<synth::ModalEngine>();
+        engine->note_on(48, 1);
+        return render(*engine, 4096);
+    }();
+
+    REQUIRE(play(mod::ModEngine::Lfo1, 0, 1) != unmodulated);
+    // a route to the setting's own value leaves it as it was
+    REQUIRE(play(mod::ModEngine::Velocity, 0.5_nm, 0.5_nm) == unmodulated);
+}
+
+TEST_CASE("Engine plays patches of more modes than its voices on large voices", "[dsp][engine]") {
+    auto engine = std::make_unique<synth::ModalEngine>();
+    synth::ModalParams params;
+    params.modes = 1000;
+    engine->set_params(params);
+    engine->note_on(48, 1);
+    const auto out = render(*engine, 4800);
+    REQUIRE(engine->stats().active_modes == 1000);
+    // the spectral backend sounds a hop late
+    REQUIRE(silent(out, 0, 64));
+    REQUIRE(!silent(out, 0, out.size()));
+
+    // Eco gives the large voice half of its 2048 modes, which is more than the patch has
+    engine->set_quality(synth::Quality::Eco);
+    render(*engine, 64);
+    REQUIRE(engine->stats().active_modes == 1000);
+}
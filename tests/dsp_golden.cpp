@@ -0,0 +1,152 @@
+#include <dsp/bonus.hpp>
+#include <dsp/modal_synth.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "golden/golden.hpp"
+#include "golden/reference.hpp"
+
+using namespace modal::dsp;
+namespace golden = modal::golden;
+
+namespace {
+    // largest differences allowed from the reference: of the stored samples, relative to their peak,
+    // and of the spectrum bands and envelope windows in dB, ignoring anything over `floor_db` below the loudest
+    struct Tolerance {
+        double samples, bands_db, envelope_db;
+    };
+
+    constexpr double floor_db = 60;
+    constexpr double unchecked = std::numeric_limits<double>::infinity();
+
+    // per exciter, numbered as `synth::ModalExiterKind`
+    constexpr std::array<Tolerance, golden::exciter_count> tolerances = std::is_same_v<num, float>
+        ? std::array<Tolerance, golden::exciter_count> {{
+            {1e-3, 0.05, 0.05},
+            {1e-3, 0.05, 0.05},
+            // rounding can move an impulse by a sample, which shows in the quieter bands
+            {1e-3, 2.5, 0.5},
+            {2e-3, 0.25, 0.25},
+            // the sweep's phase drifts from the reference in single precision, so after the start it's only alike on average
+            {5e-2, unchecked, unchecked},
+        }}
+        : std::array<Tolerance, golden::exciter_count> {{
+            {1e-6, 0.01, 0.01},
+            {1e-6, 0.01, 0.01},
+            {1e-6, 0.01, 0.01},
+            {1e-6, 0.01, 0.01},
+            {1e-6, 0.01, 0.01},
+        }};
+
+    struct Errors {
+        double samples = 0, bands = 0, envelope = 0;
+    };
+
+    double max_db_error(const std::vector<float>& got, const std::vector<float>& want) {
+        const auto loudest = *std::max_element(want.begin(), want.end());
+        double error = 0;
+        for (size_t i = 0; i < want.size(); i++) {
+            if (want[i] > loudest - floor_db) {
+                error = std::max(error, static_cast<double>(std::abs(got[i] - want[i])));
+            }
+        }
+        return error;
+    }
+
+    Errors compare(const golden::Summary& got, const golden::Summary& want) {
+        Errors e;
+        float peak = 0;
+        for (size_t i = 0; i < want.samples.size(); i++) {
+            peak = std::max(peak, std::abs(want.samples[i]));
+            e.samples = std::max(e.samples, static_cast<double>(std::abs(got.samples[i] - want.samples[i])));
+        }
+        e.samples /= std::max(peak, 1e-6f);
+        e.bands = max_db_error(got.bands, want.bands);
+        e.envelope = max_db_error(got.envelope, want.envelope);
+        return e;
+    }
+
+    // plays the case on the plugin's voice, as `golden::render_reference()`
+    std::vector<double> render(const golden::Case& c, const num detune_cents = 0) {
+        const auto& p = golden::patches[c.patch];
+        synth::ModalPatch patch;
+        patch.set_params(p.modes, static_cast<num>(p.inharmonicity), static_cast<num>(p.exponent),
+                         static_cast<num>(p.exciter_rate), static_cast<num>(p.decay), static_cast<num>(p.falloff));
+        patch.set_foldback_settings(static_cast<synth::ModalFoldbackKind>(c.foldback), static_cast<num>(golden::foldback_point));
+        patch.set_mode_freqs({static_cast<num>(p.mode_freqs[0]), static_cast<num>(p.mode_freqs[1])});
+        patch.set_mode_gains({static_cast<num>(p.mode_gains[0]), static_cast<num>(p.mode_gains[1])});
+
+        auto voice = std::make_unique<synth::ModalSynth<40>>();
+        voice->set_patch(patch);
+        voice->set_sample_rate(static_cast<num>(golden::sample_rate));
+        voice->set_env_params(static_cast<num>(p.attack), static_cast<num>(p.release));
+        voice->set_env_curves(p.exponential_attack ? mod::EnvCurve::Exponential : mod::EnvCurve::Linear,
+                              p.exponential_release ? mod::EnvCurve::Exponential : mod::EnvCurve::Linear);
+        voice->set_exciter(static_cast<synth::ModalExiterKind>(c.exciter));
+        voice->set_formant_params(static_cast<num>(p.formant_x), static_cast<num>(p.formant_y),
+                                  static_cast<num>(p.formant_length), static_cast<num>(p.formant_mix));
+        voice->seed_noise(golden::noise_seed);
+
+        voice->on(bonus::add_cents(bonus::midi2freq(static_cast<num>(c.note)), detune_cents), static_cast<num>(golden::velocity));
+        std::vector<double> out(golden::render_length);
+        for (size_t i = 0; i < out.size(); i++) {
+            if (i == golden::note_off_at) {
+                voice->off();
+            }
+            out[i] = voice->tick();
+        }
+        return out;
+    }
+}
+
+TEST_CASE("Voices match the golden renders", "[dsp][golden]") {
+    const auto stored = golden::read(MODAL_GOLDEN_FILE);
+    REQUIRE(stored);
+
+    const auto cases = golden::cases();
+    for (size_t i = 0; i < cases.size(); i++) {
+        const auto e = compare(golden::summarise(render(cases[i])), (*stored)[i]);
+        const auto& tolerance = tolerances[static_cast<size_t>(cases[i].exciter)];
+        INFO(cases[i].name());
+        REQUIRE(e.samples <= tolerance.samples);
+        REQUIRE(e.bands <= tolerance.bands_db);
+        REQUIRE(e.envelope <= tolerance.envelope_db);
+    }
+}
+
+TEST_CASE("The reference implementation reproduces the golden renders", "[dsp][golden]") {
+    const auto stored = golden::read(MODAL_GOLDEN_FILE);
+    REQUIRE(stored);
+
+    // only a few, as the reference is slow, and only differences in the maths library can make these differ
+    const auto cases = golden::cases();
+    for (size_t i = 0; i < cases.size(); i += 7) {
+        const auto e = compare(golden::summarise(golden::render_reference(cases[i])), (*stored)[i]);
+        INFO(cases[i].name());
+        REQUIRE(e.samples <= 1e-6);
+        REQUIRE(e.bands <= 1e-3);
+        REQUIRE(e.envelope <= 1e-3);
+    }
+}
+
+TEST_CASE("Golden comparisons catch small changes", "[dsp][golden]") {
+    const auto stored = golden::read(MODAL_GOLDEN_FILE);
+    REQUIRE(stored);
+
+    // 5 cents flat is about the smallest tuning change anyone would hear
+    const auto cases = golden::cases();
+    for (size_t i = 0; i < cases.size(); i += 11) {
+        const auto e = compare(golden::summarise(render(cases[i], -5)), (*stored)[i]);
+        const auto& tolerance = tolerances[static_cast<size_t>(cases[i].exciter)];
+        INFO(cases[i].name());
+        REQUIRE((e.samples > tolerance.samples || e.bands > tolerance.bands_db || e.envelope > tolerance.envelope_db));
+    }
+}
@@ -0,0 +1,57 @@
+#include <dsp/modal_synth.hpp>
+#include <dsp/mini_modal_synth.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cmath>
+#include <iostream>
+
+using namespace modal::dsp;
+
+namespace {
+    // as used by the plugins
+    constexpr size_t plugin_modes = 40;
+    constexpr size_t plugin_voices = 16;
+
+    using Voice = synth::ModalSynth<plugin_modes>;
+    using MiniVoice = synth::MiniModalSynth<plugin_modes>;
+
+    // voices are stored in arrays, so each one should start on its own cache line
+    static_assert(alignof(Voice) == 64);
+    static_assert(sizeof(Voice) % 64 == 0);
+    static_assert(alignof(MiniVoice) == 64);
+    static_assert(sizeof(MiniVoice) % 64 == 0);
+
+    // budgets for a 40 mode voice, so growth shows up as a build failure rather than a slowdown
+    // (including the coefficient glide targets, which are only touched while gliding after a control-rate change)
+    static_assert(sizeof(Voice) <= 64 * 45 * sizeof(num) / sizeof(float));
+    static_assert(sizeof(MiniVoice) <= 64 * 37 * sizeof(num) / sizeof(float));
+}
+
+TEST_CASE("Voice and instance sizes", "[dsp][layout]") {
+    const auto report = [](const char* name, const size_t voice, const size_t patch) {
+        std::cout << name << ": " << voice << " bytes per voice, "
+                  << plugin_voices * voice + patch << " bytes per instance ("
+                  << plugin_voices << " voices + " << patch << " byte patch)\n";
+    };
+    report("ModalSynth<40>", sizeof(Voice), sizeof(synth::ModalPatch));
+    report("MiniModalSynth<40>", sizeof(MiniVoice), sizeof(synth::MiniModalPatch));
+
+    REQUIRE(sizeof(bonus::FastRng) <= 8);
+}
+
+TEST_CASE("Fast random numbers are uniform and independent per generator", "[dsp][layout]") {
+    bonus::FastRng a, b;
+    REQUIRE(a.next() != b.next());
+
+    bonus::FastRng rng {1234};
+    double sum = 0;
+    constexpr int count = 100000;
+    for (int i = 0; i < count; i++) {
+        const auto x = rng.uniform(-1, 1);
+        REQUIRE(x >= -1);
+        REQUIRE(x < 1);
+        sum += x;
+    }
+    REQUIRE(std::abs(sum / count) < 0.01);
+}
@@ -0,0 +1,106 @@
+#include <dsp/lockfree.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <thread>
+
+using namespace modal::dsp;
+
+namespace {
+    struct Snapshot {
+        std::array<int, 16> values;
+    };
+}
+
+TEST_CASE("Triple buffer hands over the latest value", "[dsp][lockfree]") {
+    TripleBuffer<int> buffer {1};
+    REQUIRE(buffer.acquire() == 1);
+    REQUIRE(buffer.acquire() == 1);
+
+    buffer.publish(2);
+    buffer.publish(3);
+    REQUIRE(buffer.acquire() == 3);
+    REQUIRE(buffer.acquire() == 3);
+
+    buffer.publish(4);
+    REQUIRE(buffer.acquire() == 4);
+}
+
+TEST_CASE("Triple buffer reader only sees whole snapshots", "[dsp][lockfree]") {
+    TripleBuffer<Snapshot> buffer {};
+    constexpr int count = 100000;
+    std::atomic_bool done = false;
+
+    std::thread writer {[&] {
+        for (int i = 1; i <= count; i++) {
+            Snapshot s {};
+            s.values.fill(i);
+            buffer.publish(s);
+        }
+        done = true;
+    }};
+
+    int last = 0;
+    bool torn = false, backwards = false;
+    while (!done || last != count) {
+        const auto& s = buffer.acquire();
+        for (const auto v : s.values) {
+            torn |= v != s.values[0];
+        }
+        backwards |= s.values[0] < last;
+        last = s.values[0];
+    }
+    writer.join();
+
+    REQUIRE_FALSE(torn);
+    REQUIRE_FALSE(backwards);
+}
+
+TEST_CASE("SPSC ring queues values in order and drops when full", "[dsp][lockfree]") {
+    auto ring = std::make_unique<SpscRing<int, 4>>();
+    int out = 0;
+    REQUIRE_FALSE(ring->pop(out));
+    for (int i = 0; i < 4; i++) {
+        REQUIRE(ring->push(i));
+    }
+    REQUIRE_FALSE(ring->push(4));
+    REQUIRE(ring->pop(out));
+    REQUIRE(out == 0);
+    REQUIRE(ring->push(5));
+    for (const int expected : {1, 2, 3, 5}) {
+        REQUIRE(ring->pop(out));
+        REQUIRE(out == expected);
+    }
+    REQUIRE_FALSE(ring->pop(out));
+
+    // across threads, every value arrives once and in order
+    auto shared = std::make_unique<SpscRing<Snapshot, 64>>();
+    constexpr int count = 100000;
+    std::thread writer {[&] {
+        for (int i = 0; i < count; i++) {
+            Snapshot s {};
+            s.values.fill(i);
+            while (!shared->push(s)) {
+                std::this_thread::yield();
+            }
+        }
+    }};
+    int next = 0;
+    bool intact = true;
+    while (next < count) {
+        Snapshot s {};
+        if (shared->pop(s)) {
+            for (const auto v : s.values) {
+                intact &= v == next;
+            }
+            next++;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    writer.join();
+    REQUIRE(intact);
+}
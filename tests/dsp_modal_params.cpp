@@ -0,0 +1,45 @@
+#include <dsp/modal_params.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace modal::dsp;
+
+TEST_CASE("Modal params are read from saved states", "[dsp][preset]") {
+    preset::PatchState state;
+    state.set(preset::param_id("modes"), 24);
+    state.set(preset::param_id("detune"), 0.25f);
+    state.set(preset::param_id("slider2"), 0.5f);
+    state.set(preset::param_id("foldback_mode"), 2);
+    state.set(preset::param_id("exciter"), 3);
+    state.set(preset::param_id("formant_len"), 0.75f);
+    state.set(preset::param_id("release_curve"), 1);
+
+    const auto p = synth::ModalParams::from_state(state);
+    REQUIRE(p.modes == 24);
+    REQUIRE(p.inharmonicity == 0.25_nm);
+    REQUIRE(p.mode_gains[1] == 0.5_nm);
+    REQUIRE(p.foldback == synth::ModalFoldbackKind::Foldback);
+    REQUIRE(p.exciter == synth::ModalExiterKind::Square);
+    REQUIRE(p.formant_length == 0.75_nm);
+    REQUIRE(p.release_curve == mod::EnvCurve::Exponential);
+
+    // everything else keeps the plugin's defaults
+    const synth::ModalParams defaults;
+    REQUIRE(p.decay == defaults.decay);
+    REQUIRE(p.mode_freqs == defaults.mode_freqs);
+    REQUIRE(p.attack == defaults.attack);
+    REQUIRE(p.attack_curve == defaults.attack_curve);
+}
+
+TEST_CASE("Modal params only ask for coefficient updates when the spectrum changes", "[dsp]") {
+    synth::ModalPatch patch;
+    synth::ModalParams p;
+    REQUIRE(p.apply(patch));
+    REQUIRE_FALSE(p.apply(patch));
+
+    p.attack = 2;
+    REQUIRE_FALSE(p.apply(patch));
+    p.decay = 2;
+    REQUIRE(p.apply(patch));
+    REQUIRE(patch.decay == 2);
+}
@@ -0,0 +1,280 @@
+#include <dsp/modmatrix.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_floating_point.hpp>
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+using namespace modal::dsp;
+
+TEST_CASE("Mod matrix passes base values through unsmoothed", "[dsp][mod]") {
+    using Catch::Matchers::WithinAbs;
+    mod::ModMatrix matrix {2, 3, 4};
+    matrix.set_sample_rate(48000);
+
+    matrix.set_base(1, 0.25_nm);
+    REQUIRE(matrix.process(256));
+    REQUIRE_THAT(matrix.value(1), WithinAbs(0.25, 1e-6));
+    REQUIRE_THAT(matrix.value(0), WithinAbs(0, 1e-6));
+
+    // nothing moving, so nothing to update
+    REQUIRE_FALSE(matrix.process(256));
+}
+
+TEST_CASE("Mod matrix routes sources to smoothed offsets that settle", "[dsp][mod]") {
+    using Catch::Matchers::WithinAbs;
+    mod::ModMatrix matrix {2, 3, 4};
+    matrix.set_sample_rate(48000);
+    matrix.set_base(2, 0.5_nm);
+    matrix.process(256);
+
+    REQUIRE(matrix.add_route({0, 2, 0.2_nm, 0.6_nm}));
+    matrix.set_source(0, 1);
+    REQUIRE(matrix.process(256));
+    // smoothed, so partway from the base to the routed value
+    REQUIRE(matrix.value(2) > 0.5_nm);
+    REQUIRE(matrix.value(2) < 0.6_nm);
+
+    size_t blocks = 0;
+    while (matrix.process(256)) {
+        REQUIRE(++blocks < 1000);
+    }
+    REQUIRE_THAT(matrix.value(2), WithinAbs(0.6, 1e-3));
+
+    // base moves don't disturb the modulated value, and removing the route returns to the base
+    matrix.set_base(2, 0.1_nm);
+    matrix.process(256);
+    REQUIRE_THAT(matrix.value(2), WithinAbs(0.6, 1e-3));
+    matrix.clear_routes();
+    while (matrix.process(256)) {}
+    REQUIRE_THAT(matrix.value(2), WithinAbs(0.1, 1e-3));
+}
+
+TEST_CASE("Mod matrix rejects routes out of range or past capacity", "[dsp][mod]") {
+    mod::ModMatrix matrix {1, 2, 1};
+    REQUIRE_FALSE(matrix.add_route({1, 0, 0, 1}));
+    REQUIRE_FALSE(matrix.add_route({0, 2, 0, 1}));
+    REQUIRE(matrix.add_route({0, 1, 0, 1}));
+    REQUIRE_FALSE(matrix.add_route({0, 0, 0, 1}));
+}
+
+TEST_CASE("Mod matrix applies macro maps and their curves", "[dsp][mod]") {
+    using Catch::Matchers::WithinAbs;
+    REQUIRE_THAT(mod::apply_curve(mod::ModCurve::Exponential, 0.5_nm), WithinAbs(0.25, 1e-6));
+    REQUIRE_THAT(mod::apply_curve(mod::ModCurve::Logarithmic, 0.5_nm), WithinAbs(0.75, 1e-6));
+    REQUIRE_THAT(mod::apply_curve(mod::ModCurve::SCurve, 0.5_nm), WithinAbs(0.5, 1e-6));
+    for (const auto curve : {mod::ModCurve::Linear, mod::ModCurve::Exponential, mod::ModCurve::Logarithmic, mod::ModCurve::SCurve}) {
+        REQUIRE_THAT(mod::apply_curve(curve, 0), WithinAbs(0, 1e-6));
+        REQUIRE_THAT(mod::apply_curve(curve, 1), WithinAbs(1, 1e-6));
+    }
+
+    mod::MacroMap map;
+    map.slots[0] = {.target = 1, .curve = mod::ModCurve::Exponential, .lo = 0, .hi = 1};
+    map.slots[3] = {.target = 2, .curve = mod::ModCurve::Linear, .lo = 1, .hi = 0};
+
+    mod::ModMatrix matrix {1, 3, mod::MacroMap::max_slots};
+    matrix.set_smoothing_time(0);
+    REQUIRE(matrix.add_routes(map, 0));
+    matrix.set_source(0, 0.5_nm);
+    matrix.process(32);
+    REQUIRE_THAT(matrix.value(0), WithinAbs(0, 1e-6));
+    REQUIRE_THAT(matrix.value(1), WithinAbs(0.25, 1e-6));
+    REQUIRE_THAT(matrix.value(2), WithinAbs(0.5, 1e-6));
+}
+
+TEST_CASE("LFO shapes cycle at their rate", "[dsp][mod]") {
+    using Catch::Matchers::WithinAbs;
+    mod::Lfo lfo;
+    lfo.set_sample_rate(48000);
+    lfo.set_params(1, mod::LfoShape::Triangle);
+    REQUIRE_THAT(lfo.advance(12000), WithinAbs(0.5, 1e-4));
+    REQUIRE_THAT(lfo.advance(12000), WithinAbs(1, 1e-4));
+    REQUIRE_THAT(lfo.advance(24000), WithinAbs(0, 1e-4));
+
+    lfo.reset();
+    lfo.set_params(2, mod::LfoShape::Sine);
+    REQUIRE_THAT(lfo.advance(6000), WithinAbs(0.5, 1e-4));
+    REQUIRE_THAT(lfo.advance(6000), WithinAbs(1, 1e-4));
+
+    lfo.set_params(2, mod::LfoShape::Square);
+    REQUIRE_THAT(lfo.advance(6000), WithinAbs(0, 1e-6));
+    REQUIRE_THAT(lfo.advance(12000), WithinAbs(1, 1e-6));
+}
+
+TEST_CASE("Segment envelope runs ADSR stages across control periods", "[dsp][mod]") {
+    using Catch::Matchers::WithinAbs;
+    mod::SegmentEnv env;
+    env.set_sample_rate(1000);
+    env.set_adsr(0.1_nm, 0.1_nm, 0.5_nm, 0.2_nm);
+
+    REQUIRE_THAT(env.advance(32), WithinAbs(0, 1e-6));
+    env.on();
+    REQUIRE_THAT(env.advance(50), WithinAbs(0.5, 1e-4));
+    // crosses from the attack into the decay within one period
+    REQUIRE_THAT(env.advance(100), WithinAbs(0.75, 1e-4));
+    // holds at the sustain level
+    REQUIRE_THAT(env.advance(1000), WithinAbs(0.5, 1e-4));
+    env.off();
+    REQUIRE_THAT(env.advance(100), WithinAbs(0.25, 1e-4));
+    REQUIRE_THAT(env.advance(1000), WithinAbs(0, 1e-6));
+
+    // released during the attack, so releases from where it got to
+    env.on();
+    env.advance(50);
+    env.off();
+    REQUIRE_THAT(env.advance(100), WithinAbs(0.25, 1e-4));
+}
+
+TEST_CASE("Sample and hold picks new values at its rate", "[dsp][mod]") {
+    mod::SampleAndHold sh;
+    sh.set_sample_rate(48000);
+    sh.set_params(10);
+    const auto first = sh.advance(4800);
+    REQUIRE(first >= 0);
+    REQUIRE(first < 1);
+    REQUIRE(sh.advance(2400) == first);
+    REQUIRE(sh.advance(2400) != first);
+}
+
+TEST_CASE("Mod engine runs once per control period and ramps between them", "[dsp][mod]") {
+    using Catch::Matchers::WithinAbs;
+    mod::ModEngine engine {1, 4};
+    engine.set_sample_rate(48000);
+    engine.matrix.set_smoothing_time(0);
+    engine.set_control_period(1000);
+    REQUIRE(engine.control_period() == mod::ModEngine::max_control_period);
+    engine.set_control_period(16);
+    REQUIRE(engine.samples_until_update() == 16);
+
+    mod::MacroMap map;
+    map.slots[0] = {.target = 0, .source = mod::ModEngine::Velocity - mod::ModEngine::Lfo1, .lo = 0, .hi = 1};
+    REQUIRE(engine.matrix.add_routes(map, mod::ModEngine::Lfo1));
+    engine.note_on(60, 0.8_nm);
+
+    REQUIRE_FALSE(engine.advance(10));
+    REQUIRE(engine.samples_until_update() == 6);
+    REQUIRE(engine.advance(6));
+    REQUIRE_THAT(engine.matrix.value(0), WithinAbs(0.8, 1e-6));
+    const auto ramp = engine.matrix.ramp(0, engine.control_period());
+    REQUIRE_THAT(ramp.start, WithinAbs(0, 1e-6));
+    REQUIRE_THAT(ramp.start + ramp.step * 16, WithinAbs(0.8, 1e-5));
+    REQUIRE_FALSE(engine.advance(16));
+}
+
+TEST_CASE("Mod engine releases its envelope once every held key is released", "[dsp][mod]") {
+    using Catch::Matchers::WithinAbs;
+    mod::ModEngine engine {1, 4};
+    engine.set_sample_rate(48000);
+    engine.matrix.set_smoothing_time(0);
+    mod::MacroMap map;
+    map.slots[0] = {.target = 0, .source = 0, .lo = 0, .hi = 1};
+    REQUIRE(engine.matrix.add_routes(map, mod::ModEngine::Envelope));
+    const auto run = [&](const size_t samples) {
+        for (size_t done = 0; done < samples; done += engine.control_period()) {
+            engine.advance(engine.control_period());
+        }
+        return engine.matrix.value(0);
+    };
+
+    // the envelope sustains while either key is held, however often one is struck
+    engine.note_on(60, 1);
+    engine.note_on(64, 1);
+    engine.note_on(60, 1);
+    REQUIRE_THAT(run(48000), WithinAbs(0.5, 1e-3));
+    engine.note_off(60);
+    REQUIRE_THAT(run(48000), WithinAbs(0.5, 1e-3));
+    // releasing a key that isn't held does nothing
+    engine.note_off(72);
+    REQUIRE_THAT(run(48000), WithinAbs(0.5, 1e-3));
+    engine.note_off(64);
+    REQUIRE_THAT(run(96000), WithinAbs(0, 1e-3));
+}
+
+TEST_CASE("AHR envelope blocks match per-sample ticks", "[dsp][mod]") {
+    using Catch::Matchers::WithinAbs;
+    for (const auto curve : {mod::EnvCurve::Linear, mod::EnvCurve::Exponential}) {
+        mod::AHREnv block, ticked;
+        for (auto* e : {&block, &ticked}) {
+            e->set_sample_rate(48000);
+            e->set_params(0.01_nm, 0.05_nm);
+            e->set_curves(curve, curve);
+        }
+
+        // odd block sizes, so segments end part way through blocks, with a release before the attack has finished
+        const auto run = [&](const size_t length, const size_t chunk) {
+            std::array<num, block_size> out {};
+            for (size_t done = 0; done < length; done += chunk) {
+                const size_t n = std::min(chunk, length - done);
+                block.process_block(out.data(), n);
+                for (size_t i = 0; i < n; i++) {
+                    REQUIRE_THAT(out[i], WithinAbs(ticked.tick(), 1e-4));
+                }
+            }
+        };
+        block.on();
+        ticked.on();
+        run(300, 7);
+        block.off();
+        ticked.off();
+        run(200, 13);
+        block.on();
+        ticked.on();
+        run(1000, 29);
+        block.off();
+        ticked.off();
+        run(3000, 32);
+
+        // both shapes take the set times
+        std::array<num, 1> last {};
+        block.process_block(last.data(), 1);
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wfloat-equal"
+        REQUIRE(last[0] == 0);
+        block.on();
+        std::vector<num> attack(482);
+        block.process_block(attack.data(), attack.size());
+        REQUIRE(attack[477] < 1);
+        REQUIRE(attack[481] == 1);
+#pragma GCC diagnostic pop
+        if (curve == mod::EnvCurve::Exponential) {
+            REQUIRE(attack[239] > 0.6);
+        }
+    }
+}
+
+TEST_CASE("Smoothed values ramp to each new target", "[dsp][mod]") {
+    using Catch::Matchers::WithinAbs;
+    mod::SmoothedValue value;
+    value.set_sample_rate(1000);
+    value.set_time(0.1_nm);
+    value.set_target(1);
+    REQUIRE(value.smoothing());
+    REQUIRE_THAT(value.advance(50), WithinAbs(0.5, 1e-5));
+
+    // a new target restarts the ramp from where it got to
+    value.set_target(0);
+    REQUIRE_THAT(value.advance(50), WithinAbs(0.25, 1e-5));
+    REQUIRE_THAT(value.advance(1000), WithinAbs(0, 1e-6));
+    REQUIRE_FALSE(value.smoothing());
+
+    value.set_time(0);
+    value.set_target(0.75_nm);
+    REQUIRE_THAT(value.value(), WithinAbs(0.75, 1e-6));
+
+    // smoothed bases in a matrix
+    mod::ModMatrix matrix {1, 1, 1};
+    matrix.set_sample_rate(1000);
+    matrix.set_base_smoothing_time(0.1_nm);
+    matrix.set_base(0, 0.5_nm);
+    matrix.skip_base_smoothing();
+    REQUIRE(matrix.process(32));
+    REQUIRE_THAT(matrix.value(0), WithinAbs(0.5, 1e-6));
+    matrix.set_base(0, 1);
+    REQUIRE(matrix.process(50));
+    REQUIRE_THAT(matrix.value(0), WithinAbs(0.75, 1e-5));
+    REQUIRE(matrix.process(50));
+    REQUIRE_THAT(matrix.value(0), WithinAbs(1, 1e-6));
+    REQUIRE_FALSE(matrix.process(50));
+}
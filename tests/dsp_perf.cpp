@@ -0,0 +1,67 @@
+#include <dsp/perf.hpp>
+#include <dsp/mini_modal_synth.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <array>
+#include <memory>
+
+using namespace modal::dsp;
+
+TEST_CASE("Perf monitor summarises timed blocks", "[dsp][perf]") {
+    perf::Monitor monitor;
+    REQUIRE(monitor.collect().blocks == 0);
+
+    synth::MiniModalPatch patch;
+    auto voices = std::make_unique<std::array<synth::MiniModalSynth<40>, 4>>();
+    for (auto& v : *voices) {
+        v.set_patch(patch);
+        v.set_sample_rate(48000);
+        v.set_env_params(0.01_nm, 0.1_nm);
+        v.set_feedback_routing(synth::MiniModalFeedbackRouting::Delayed);
+        v.on(220, 1);
+    }
+
+    for (int block = 0; block < 100; block++) {
+        monitor.begin_block(block_size, 48000);
+        monitor.count(perf::Counter::CoefficientUpdates, 2);
+        monitor.lap(perf::Stage::Params);
+        std::array<num, block_size> out {};
+        for (auto& v : *voices) {
+            v.render(out.data(), block_size, &monitor);
+        }
+        monitor.skip_lap();
+        monitor.set_active(voices->size(), voices->size() * 40);
+        monitor.end_block();
+    }
+
+    const auto summary = monitor.collect();
+    REQUIRE(summary.blocks == 100);
+    REQUIRE(summary.load > 0);
+    REQUIRE(summary.mean_ns > 0);
+    REQUIRE(summary.mean_ns <= summary.peak_ns);
+    REQUIRE(summary.p99_ns <= summary.peak_ns);
+    REQUIRE(summary.active_voices == 4);
+    REQUIRE(summary.active_modes == 160);
+    REQUIRE(summary.counters[static_cast<size_t>(perf::Counter::CoefficientUpdates)] == 200);
+
+    // the voices timed their own stages, and every stage fits within the blocks
+    double shares = 0;
+    for (const auto s : summary.stage_share) {
+        shares += s;
+    }
+    REQUIRE(summary.stage_share[static_cast<size_t>(perf::Stage::Exciter)] > 0);
+    REQUIRE(summary.stage_share[static_cast<size_t>(perf::Stage::Modes)] > 0);
+    REQUIRE(shares <= 1.0001);
+
+    // counters keep their totals once blocks leave the window, and blocks past a full queue are dropped
+    for (size_t block = 0; block < perf::Monitor::queue_size + 10; block++) {
+        monitor.begin_block(block_size, 48000);
+        monitor.count(perf::Counter::NoteDrops);
+        monitor.end_block();
+    }
+    const auto later = monitor.collect();
+    REQUIRE(later.blocks == perf::Monitor::window);
+    REQUIRE(later.counters[static_cast<size_t>(perf::Counter::CoefficientUpdates)] == 200);
+    REQUIRE(later.counters[static_cast<size_t>(perf::Counter::NoteDrops)] == perf::Monitor::queue_size);
+}
@@ -0,0 +1,114 @@
+#include <dsp/preset.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+using namespace modal::dsp;
+
+namespace {
+    preset::PatchState example_state(const float offset) {
+        preset::PatchState state;
+        state.set(preset::param_id("decay"), 2.5f + offset);
+        state.set(preset::param_id("modes"), 24);
+        state.set(preset::param_id("exciter"), 1);
+        state.num_macros = 2;
+        state.macros[1].slots[2] = {.target = 0, .source = 3, .curve = mod::ModCurve::SCurve, .lo = 0.25f, .hi = 0.75f};
+        return state;
+    }
+}
+
+TEST_CASE("Patch states round trip through the binary format", "[dsp][preset]") {
+    const auto state = example_state(0);
+    std::vector<uint8_t> bytes;
+    preset::encode(state, bytes);
+    REQUIRE(preset::is_encoded(bytes));
+
+    preset::PatchState decoded;
+    REQUIRE(preset::decode(bytes, decoded));
+    REQUIRE(decoded.num_params == 3);
+    const auto decay = decoded.find(preset::param_id("decay"));
+    REQUIRE(decay.has_value());
+    REQUIRE(decoded.params[*decay].value == 2.5f);
+    REQUIRE_FALSE(decoded.find(preset::param_id("missing")).has_value());
+    REQUIRE(decoded.num_macros == 2);
+    const auto& slot = decoded.macros[1].slots[2];
+    REQUIRE(slot.target == 0);
+    REQUIRE(slot.source == 3);
+    REQUIRE(slot.curve == mod::ModCurve::SCurve);
+    REQUIRE(slot.hi == 0.75f);
+    REQUIRE(decoded.macros[0].slots[0].target == mod::MacroSlot::unmapped);
+
+    // truncated, from the future, or not a state at all
+    REQUIRE_FALSE(preset::decode(std::span{bytes}.first(bytes.size() - 1), decoded));
+    auto future = bytes;
+    future[4] = preset::format_version + 1;
+    REQUIRE_FALSE(preset::decode(future, decoded));
+    const std::vector<uint8_t> xml {'<', '?', 'x', 'm', 'l', ' ', 'v', 'e', 'r', 's', 'i', 'o', 'n'};
+    REQUIRE_FALSE(preset::is_encoded(xml));
+    REQUIRE_FALSE(preset::decode(xml, decoded));
+}
+
+TEST_CASE("Patch states with other macro sizes are migrated", "[dsp][preset]") {
+    // one parameter and one macro of two slots, the second pointing past the parameters
+    const std::vector<uint8_t> bytes {
+        'M', 'D', 'L', 'P', 1, 0, 1, 0, 1, 0, 2, 0,
+        1, 0, 0, 0, 0, 0, 128, 63,
+        0, 0, 0, 0, 2, 1, 0, 0, 0, 0, 0, 0, 128, 63,
+        5, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 128, 63,
+    };
+    preset::PatchState state;
+    REQUIRE(preset::decode(bytes, state));
+    REQUIRE(state.params[0].value == 1.0f);
+    REQUIRE(state.macros[0].slots[0].target == 0);
+    REQUIRE(state.macros[0].slots[0].source == 2);
+    REQUIRE(state.macros[0].slots[0].curve == mod::ModCurve::Exponential);
+    REQUIRE(state.macros[0].slots[1].target == mod::MacroSlot::unmapped);
+    REQUIRE(state.macros[0].slots[3].target == mod::MacroSlot::unmapped);
+}
+
+TEST_CASE("Preset library maps names and states from one file", "[dsp][preset]") {
+    const auto path = (std::filesystem::temp_directory_path() / "modal_preset_library_test.mdlb").string();
+    std::vector<preset::Preset> presets(1000);
+    for (size_t i = 0; i < presets.size(); i++) {
+        presets[i] = {"Preset " + std::to_string(i), example_state(static_cast<float>(i))};
+    }
+    presets[1].name = std::string(100, 'x');
+    REQUIRE(preset::PresetLibrary::write(path, presets));
+
+    preset::PresetLibrary library;
+    REQUIRE(library.open(path));
+    REQUIRE(library.size() == 1000);
+    REQUIRE(library.name(0) == "Preset 0");
+    REQUIRE(library.name(1).size() == preset::PresetLibrary::max_name);
+    REQUIRE(library.name(1000).empty());
+
+    const auto index = library.find("Preset 765");
+    REQUIRE(index == 765u);
+    REQUIRE_FALSE(library.find("Preset 1000").has_value());
+    auto state = std::make_unique<preset::PatchState>();
+    REQUIRE(library.load(*index, *state));
+    REQUIRE(state->params[*state->find(preset::param_id("decay"))].value == 767.5f);
+    REQUIRE_FALSE(library.load(1000, *state));
+
+    // moving keeps the mapping, closing empties the library
+    preset::PresetLibrary moved = std::move(library);
+    REQUIRE(library.size() == 0);
+    REQUIRE(moved.name(2) == "Preset 2");
+    moved.close();
+    REQUIRE(moved.size() == 0);
+
+    // anything else isn't a library
+    REQUIRE_FALSE(library.open(path + ".missing"));
+    {
+        std::vector<uint8_t> bytes;
+        preset::encode(presets[0].state, bytes);
+        std::ofstream {path, std::ios::binary}.write(reinterpret_cast<const char*>(bytes.data()),
+                                                      static_cast<std::streamsize>(bytes.size()));
+    }
+    REQUIRE_FALSE(library.open(path));
+    std::filesystem::remove(path);
+}
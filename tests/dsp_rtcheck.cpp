@@ -0,0 +1,163 @@
+#include <dsp/rtcheck.hpp>
+#include <dsp/control.hpp>
+#include <dsp/mini_modal_synth.hpp>
+#include <dsp/modal_synth.hpp>
+#include <dsp/modmatrix.hpp>
+#include <dsp/perf.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+
+using namespace modal::dsp;
+
+namespace {
+    // stores through a volatile, so the allocations below can't be optimised away
+    void* volatile sink = nullptr;
+}
+
+TEST_CASE("Realtime checks catch allocations and locks inside a realtime scope", "[dsp][rtcheck]") {
+    rt::set_reporting(false);
+    rt::reset();
+
+    // outside a scope anything goes
+    sink = ::operator new(16);
+    ::operator delete(sink);
+    REQUIRE(rt::violations() == 0);
+
+    {
+        rt::ScopedRealtime realtime;
+        REQUIRE(rt::in_realtime());
+        sink = ::operator new(16);
+        ::operator delete(sink);
+    }
+    REQUIRE_FALSE(rt::in_realtime());
+    REQUIRE(rt::violations(rt::Violation::Allocation) == 1);
+    REQUIRE(rt::violations(rt::Violation::Deallocation) == 1);
+
+#if defined(__GLIBC__)
+    std::mutex mutex;
+    {
+        rt::ScopedRealtime realtime;
+        sink = std::malloc(16);
+        std::free(sink);
+        const std::lock_guard lock {mutex};
+    }
+    REQUIRE(rt::violations(rt::Violation::Allocation) == 2);
+    REQUIRE(rt::violations(rt::Violation::Deallocation) == 2);
+    REQUIRE(rt::violations(rt::Violation::Lock) == 1);
+#endif
+
+    rt::reset();
+    REQUIRE(rt::violations() == 0);
+    rt::set_reporting(true);
+}
+
+TEST_CASE("Voices, modulation and monitoring neither allocate nor lock", "[dsp][rtcheck]") {
+    constexpr size_t voice_count = 8;
+    synth::MiniModalPatch patch;
+    auto voices = std::make_unique<std::array<synth::MiniModalSynth<40>, voice_count>>();
+    PolyController<synth::MiniModalSynth<40>, voice_count> controller {*voices};
+    CoefficientScheduler<voice_count> coefficients {2};
+    mod::ModEngine modulation {4, 8};
+    perf::Monitor monitor;
+    for (auto& v : *voices) {
+        v.set_patch(patch);
+        v.set_sample_rate(48000);
+        v.set_env_params(0.01_nm, 0.1_nm);
+    }
+    modulation.set_sample_rate(48000);
+    modulation.matrix.set_base_smoothing_time(0.05_nm);
+
+    rt::reset();
+    int note = 36;
+    for (int block = 0; block < 200; block++) {
+        rt::ScopedRealtime realtime;
+        monitor.begin_block(block_size, 48000);
+
+        // a note storm, with feedback routing and patch changes mid-note
+        for (int i = 0; i < 3; i++) {
+            if (const auto voice = controller.key_down(note, 1)) {
+                coefficients.updated(*voice);
+            } else {
+                monitor.count(perf::Counter::NoteDrops);
+            }
+            modulation.note_on(note, 1);
+            controller.key_up(note - 12);
+            modulation.note_off(note - 12);
+            note = note < 96 ? note + 1 : 36;
+        }
+        for (auto& v : *voices) {
+            v.set_feedback_routing(block % 2 == 0 ? synth::MiniModalFeedbackRouting::Delayed
+                                                  : synth::MiniModalFeedbackRouting::Immediate);
+            v.set_feedback_settings(0.01_nm, 1);
+        }
+        if (patch.set_params(static_cast<size_t>(10 + block % 30), 0.01_nm * static_cast<num>(block % 5), 1, 4, 1, 1, 1)) {
+            coefficients.invalidate();
+        }
+
+        modulation.matrix.set_base(0, static_cast<num>(block % 10) / 10);
+        modulation.matrix.clear_routes();
+        modulation.matrix.add_route({mod::ModEngine::Lfo1, 1, 0, 1, mod::ModCurve::SCurve});
+        monitor.lap(perf::Stage::Params);
+
+        std::array<num, block_size> out {};
+        for (auto& v : *voices) {
+            v.render(out.data(), block_size, &monitor);
+        }
+        modulation.advance(block_size);
+        coefficients.run([&](const size_t v) { (*voices)[v].update_mode_coefficients(true); });
+
+        monitor.set_active(controller.active_voices(), 0);
+        monitor.end_block();
+    }
+    REQUIRE(rt::violations() == 0);
+    REQUIRE(monitor.collect().blocks == 200);
+}
+
+TEST_CASE("Per-sample voices neither allocate nor lock", "[dsp][rtcheck]") {
+    constexpr size_t voice_count = 4;
+    synth::ModalPatch patch;
+    auto voices = std::make_unique<std::array<synth::ModalSynth<40>, voice_count>>();
+    PolyController<synth::ModalSynth<40>, voice_count> controller {*voices};
+    for (auto& v : *voices) {
+        v.set_patch(patch);
+        v.set_sample_rate(48000);
+        v.set_env_params(0.01_nm, 0.1_nm);
+    }
+
+    rt::reset();
+    int note = 48;
+    // asserting allocates, so wait until after the blocks
+    bool finite = true;
+    for (int block = 0; block < 100; block++) {
+        rt::ScopedRealtime realtime;
+        controller.key_down(note, 1);
+        controller.key_up(note - 7);
+        note = note < 84 ? note + 1 : 48;
+
+        bool changed = patch.set_params(static_cast<size_t>(5 + block % 35), 0.01_nm * static_cast<num>(block % 3), 1, 4, 1, 1);
+        changed |= patch.set_mode_freqs({0.5_nm, static_cast<num>(block % 4) / 4});
+        for (auto& v : *voices) {
+            v.set_exciter(static_cast<synth::ModalExiterKind>(block % 5));
+            v.set_formant_params(static_cast<num>(block % 7) / 7, 0.5_nm, 0.5_nm, 0.5_nm);
+            if (changed) {
+                v.update_mode_coefficients();
+            }
+        }
+
+        num out = 0;
+        for (size_t i = 0; i < block_size; i++) {
+            for (auto& v : *voices) {
+                out += v.tick();
+            }
+        }
+        finite &= std::isfinite(out);
+    }
+    REQUIRE(rt::violations() == 0);
+    REQUIRE(finite);
+}
@@ -0,0 +1,229 @@
+#include <dsp/simd.hpp>
+#include <dsp/resonator.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_floating_point.hpp>
+
+#include <array>
+
+using namespace modal::dsp;
+
+TEST_CASE("Instruction set names round trip", "[dsp][simd]") {
+    for (const auto isa : {simd::Isa::Generic, simd::Isa::SSE2, simd::Isa::AVX2, simd::Isa::AVX512}) {
+        REQUIRE(simd::isa_from_name(simd::isa_name(isa)) == isa);
+    }
+    REQUIRE_FALSE(simd::isa_from_name("neon").has_value());
+}
+
+TEST_CASE("Selected kernels are supported by the CPU", "[dsp][simd]") {
+    REQUIRE(simd::kernels().isa <= simd::detect_isa());
+}
+
+TEST_CASE("Resonator bank kernels match a single resonator", "[dsp][simd][resonator]") {
+    using Catch::Matchers::WithinAbs;
+    constexpr size_t count = 37; // deliberately not a multiple of any vector width
+
+    std::array<physical::filters::PhasorResonator, count> reference;
+    std::array<num, count> re {}, im {}, amp {};
+    for (size_t i = 0; i < count; i++) {
+        const auto freq = 110_nm * static_cast<num>(i + 1);
+        const auto gain = 1_nm / static_cast<num>(i + 1);
+        reference[i].set_params(freq, gain, 0.5_nm);
+        const auto c = physical::filters::phasor_coeff(freq, 0.5_nm, 48000);
+        re[i] = c.real();
+        im[i] = c.imag();
+        amp[i] = gain;
+    }
+
+    for (auto isa = simd::Isa::Generic; isa <= simd::detect_isa(); isa = static_cast<simd::Isa>(static_cast<int>(isa) + 1)) {
+        const auto& k = simd::kernels_for(isa);
+        auto ref = reference;
+        std::array<num, count> y_re {}, y_im {};
+        for (int n = 0; n < 256; n++) {
+            const num in = n == 0 ? 1 : 0;
+            num expected = 0;
+            for (auto& r : ref) {
+                expected += r.tick(in);
+            }
+            REQUIRE_THAT(k.resonator_bank(re.data(), im.data(), amp.data(), y_re.data(), y_im.data(), count, in),
+                         WithinAbs(expected, 1e-4));
+        }
+    }
+}
+
+TEST_CASE("Block resonator bank kernels match the per-sample kernel", "[dsp][simd][resonator]") {
+    using Catch::Matchers::WithinAbs;
+    constexpr size_t count = 40;
+
+    std::array<num, count> re {}, im {}, amp {};
+    for (size_t i = 0; i < count; i++) {
+        const auto c = physical::filters::phasor_coeff(200_nm * static_cast<num>(i + 1), 0.3_nm, 48000);
+        re[i] = c.real();
+        im[i] = c.imag();
+        amp[i] = 1_nm / static_cast<num>(i + 1);
+    }
+
+    for (auto isa = simd::Isa::Generic; isa <= simd::detect_isa(); isa = static_cast<simd::Isa>(static_cast<int>(isa) + 1)) {
+        const auto& k = simd::kernels_for(isa);
+        std::array<num, count> sample_re {}, sample_im {}, block_re {}, block_im {};
+        for (int b = 0; b < 8; b++) {
+            std::array<num, block_size> in {}, out {};
+            for (size_t i = 0; i < block_size; i++) {
+                in[i] = (b * block_size + i) % 7 == 0 ? 1_nm : 0_nm;
+            }
+            k.resonator_bank_block(re.data(), im.data(), amp.data(), block_re.data(), block_im.data(), count,
+                                   in.data(), out.data(), block_size);
+            for (size_t i = 0; i < block_size; i++) {
+                const auto expected = k.resonator_bank(re.data(), im.data(), amp.data(),
+                                                       sample_re.data(), sample_im.data(), count, in[i]);
+                REQUIRE_THAT(out[i], WithinAbs(expected, 1e-4));
+            }
+        }
+    }
+}
+
+TEST_CASE("Gliding block kernels step the coefficients linearly to their targets", "[dsp][simd][resonator]") {
+    using Catch::Matchers::WithinAbs;
+    constexpr size_t count = 37;
+    constexpr size_t n = 24;
+
+    std::array<num, count> from_re {}, from_im {}, from_amp {}, to_re {}, to_im {}, to_amp {};
+    for (size_t i = 0; i < count; i++) {
+        const auto a = physical::filters::phasor_coeff(150_nm * static_cast<num>(i + 1), 0.3_nm, 48000);
+        const auto b = physical::filters::phasor_coeff(180_nm * static_cast<num>(i + 1), 0.6_nm, 48000);
+        from_re[i] = a.real();
+        from_im[i] = a.imag();
+        from_amp[i] = 1;
+        to_re[i] = b.real();
+        to_im[i] = b.imag();
+        to_amp[i] = 0.5_nm;
+    }
+
+    std::array<num, n> in {};
+    in[0] = 1;
+    in[10] = -0.5_nm;
+
+    // per-sample kernel, with the coefficients moved by hand
+    std::array<num, count> ref_re {}, ref_im {};
+    std::array<num, n> expected {};
+    for (size_t s = 0; s < n; s++) {
+        const num t = static_cast<num>(s + 1) / static_cast<num>(n);
+        std::array<num, count> cr {}, ci {}, ca {};
+        for (size_t i = 0; i < count; i++) {
+            cr[i] = from_re[i] + (to_re[i] - from_re[i]) * t;
+            ci[i] = from_im[i] + (to_im[i] - from_im[i]) * t;
+            ca[i] = from_amp[i] + (to_amp[i] - from_amp[i]) * t;
+        }
+        expected[s] = simd::kernels_for(simd::Isa::Generic).resonator_bank(cr.data(), ci.data(), ca.data(),
+                                                                          ref_re.data(), ref_im.data(), count, in[s]);
+    }
+
+    for (auto isa = simd::Isa::Generic; isa <= simd::detect_isa(); isa = static_cast<simd::Isa>(static_cast<int>(isa) + 1)) {
+        const auto& k = simd::kernels_for(isa);
+        auto re = from_re, im = from_im, amp = from_amp;
+        std::array<num, count> y_re {}, y_im {};
+        std::array<num, n> out {};
+        k.resonator_bank_block_glide(re.data(), im.data(), amp.data(), to_re.data(), to_im.data(), to_amp.data(),
+                                     y_re.data(), y_im.data(), count, in.data(), out.data(), n);
+        for (size_t s = 0; s < n; s++) {
+            REQUIRE_THAT(out[s], WithinAbs(expected[s], 1e-4));
+        }
+        REQUIRE(re == to_re);
+        REQUIRE(im == to_im);
+        REQUIRE(amp == to_amp);
+    }
+}
+
+TEST_CASE("Resonator banks glide per sample in tick() as they do per block", "[dsp][simd][resonator]") {
+    using Catch::Matchers::WithinAbs;
+    constexpr size_t count = 40;
+    constexpr size_t n = 24;
+    const auto set = [](auto& bank, const num ratio, const bool glide) {
+        for (size_t i = 0; i < count; i++) {
+            const auto freq = 150_nm * static_cast<num>(i + 1) * ratio;
+            if (glide) {
+                bank.glide_params(i, freq, 1 / static_cast<num>(i + 1), 0.4_nm);
+            } else {
+                bank.set_params(i, freq, 1, 0.3_nm);
+            }
+        }
+    };
+
+    physical::filters::PhasorResonatorBank<count> blocks, ticks;
+    ticks.set_glide_length(n);
+    std::array<num, n> in {}, expected {};
+    in[0] = 1;
+    for (auto* bank : {&blocks, &ticks}) {
+        set(*bank, 1, false);
+    }
+    blocks.process_block(in.data(), expected.data(), n, count);
+    for (size_t s = 0; s < n; s++) {
+        REQUIRE_THAT(ticks.tick(in[s], count), WithinAbs(expected[s], 1e-4));
+    }
+
+    // both reach the new coefficients by the end of the glide, without stepping to them at its start
+    for (auto* bank : {&blocks, &ticks}) {
+        set(*bank, 1.2_nm, true);
+    }
+    blocks.process_block(in.data(), expected.data(), n, count);
+    for (size_t s = 0; s < n; s++) {
+        REQUIRE_THAT(ticks.tick(in[s], count), WithinAbs(expected[s], 1e-4));
+    }
+    std::array<num, n> silence {};
+    blocks.process_block(silence.data(), expected.data(), n, count);
+    for (size_t s = 0; s < n; s++) {
+        REQUIRE_THAT(ticks.tick(0, count), WithinAbs(expected[s], 1e-4));
+    }
+}
+
+TEST_CASE("Bent resonator banks ring like banks set to the bent frequencies", "[dsp][simd][resonator]") {
+    using Catch::Matchers::WithinAbs;
+    constexpr size_t count = 40;
+    const auto set = [](auto& bank, const num ratio) {
+        for (size_t i = 0; i < count; i++) {
+            // the highest modes cross Nyquist as the bank is bent
+            bank.set_params(i, 570_nm * static_cast<num>(i + 1) * ratio, 1 / static_cast<num>(i + 1), 0.3_nm);
+        }
+    };
+    const auto ring = [](auto& bank) {
+        std::array<num, 2000> out {};
+        for (size_t s = 0; s < out.size(); s++) {
+            out[s] = bank.tick(s == 0 ? 1 : 0, count);
+        }
+        return out;
+    };
+
+    physical::filters::PhasorResonatorBank<count> bent, reference;
+    set(bent, 1);
+    // in small steps, like a bend followed every control period, then in jumps
+    for (const num ratio : {1.1_nm, 0.8_nm, 1.5_nm}) {
+        for (int step = 1; step <= 100; step++) {
+            bent.bend(1 + (ratio - 1) * static_cast<num>(step) / 100, count);
+        }
+        bent.silence(0, count);
+        set(reference, ratio);
+        const auto expected = ring(reference);
+        const auto got = ring(bent);
+        for (size_t s = 0; s < got.size(); s++) {
+            REQUIRE_THAT(got[s], WithinAbs(expected[s], 1e-3));
+        }
+
+        bent.bend(0.5_nm, count);
+        bent.bend(ratio, count);
+        bent.silence(0, count);
+        const auto jumped = ring(bent);
+        for (size_t s = 0; s < jumped.size(); s++) {
+            REQUIRE_THAT(jumped[s], WithinAbs(expected[s], 1e-3));
+        }
+        bent.bend(1, count);
+        reference.silence(0, count);
+    }
+
+    // modes set while bent are set bent
+    bent.bend(1.5_nm, count);
+    set(bent, 1);
+    bent.silence(0, count);
+    physical::filters::PhasorResonatorBank<count> direct;
+    set(direct, 1.5_nm);
+    REQUIRE(ring(bent) == ring(direct));
+}
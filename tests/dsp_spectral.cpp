@@ -0,0 +1,192 @@
+#include <dsp/spectral.hpp>
+#include <dsp/resonator.hpp>
+#include <dsp/modal_synth.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_floating_point.hpp>
+
+#include <cmath>
+#include <complex>
+#include <memory>
+#include <numbers>
+#include <vector>
+
+using namespace modal::dsp;
+
+TEST_CASE("FFT matches a direct DFT and inverts", "[dsp][spectral]") {
+    using Catch::Matchers::WithinAbs;
+    constexpr size_t n = 64;
+    const spectral::FFT fft {n};
+
+    std::vector<std::complex<num>> x(n);
+    for (size_t i = 0; i < n; i++) {
+        x[i] = {std::sin(0.3_nm * static_cast<num>(i)), static_cast<num>(i % 5) * 0.1_nm};
+    }
+
+    auto transformed = x;
+    fft.forward(transformed.data());
+    for (size_t b = 0; b < n; b++) {
+        std::complex<double> expected;
+        for (size_t i = 0; i < n; i++) {
+            expected += std::complex<double>(x[i]) * std::polar(1.0, -2 * std::numbers::pi * static_cast<double>(b * i) / n);
+        }
+        REQUIRE_THAT(transformed[b].real(), WithinAbs(expected.real(), 1e-3));
+        REQUIRE_THAT(transformed[b].imag(), WithinAbs(expected.imag(), 1e-3));
+    }
+
+    fft.inverse(transformed.data());
+    for (size_t i = 0; i < n; i++) {
+        REQUIRE_THAT(transformed[i].real(), WithinAbs(x[i].real(), 1e-5));
+        REQUIRE_THAT(transformed[i].imag(), WithinAbs(x[i].imag(), 1e-5));
+    }
+}
+
+TEST_CASE("Spectral bank rings like the recursive bank", "[dsp][spectral]") {
+    constexpr size_t count = 200;
+    constexpr size_t hop = spectral::SpectralModalBank::default_hop;
+    auto reference = std::make_unique<physical::filters::PhasorResonatorBank<count>>();
+    spectral::SpectralModalBank bank {count};
+    for (size_t i = 0; i < count; i++) {
+        const auto freq = 97_nm * static_cast<num>(i + 1) * (1 + 0.001_nm * static_cast<num>(i));
+        const auto gain = 1_nm / static_cast<num>(i + 1);
+        reference->set_params(i, freq, gain, 0.8_nm);
+        bank.set_params(i, freq, gain, 0.8_nm);
+    }
+
+    // pinged just after a hop boundary, so it sounds from the next frame, two hops late
+    reference->ping(count);
+    bank.ping(count);
+    constexpr size_t length = 48000;
+    std::vector<num> expected(length), actual(length);
+    for (size_t i = 0; i < length; i++) {
+        expected[i] = reference->tick(0, count);
+        actual[i] = bank.tick(0, count);
+    }
+
+    double error = 0, energy = 0;
+    for (size_t i = hop; i + 2 * hop < length; i++) {
+        const double diff = actual[i + 2 * hop] - expected[i];
+        error += diff * diff;
+        energy += expected[i] * expected[i];
+    }
+    // about -30dB of error, from the truncated window spectrum and the crossfaded decay
+    REQUIRE(error / energy < 1e-3);
+
+    // an impulse input only rings each mode from its nearest bin, so compare levels rather than samples
+    bank.reset();
+    double driven = 0;
+    for (size_t i = 0; i < length; i++) {
+        const auto s = bank.tick(i == 37 ? 1_nm : 0_nm, count);
+        driven += s * s;
+    }
+    REQUIRE(driven / energy > 0.8);
+    REQUIRE(driven / energy < 1.25);
+}
+
+TEST_CASE("Spectral bank bends in place like a bank set to the bent frequencies", "[dsp][spectral]") {
+    using Catch::Matchers::WithinAbs;
+    constexpr size_t count = 100;
+    constexpr size_t hop = spectral::SpectralModalBank::default_hop;
+    spectral::SpectralModalBank bent {count}, set {count};
+    const auto freq = [](const size_t i) { return 110_nm * static_cast<num>(i + 1); };
+    for (size_t i = 0; i < count; i++) {
+        bent.set_params(i, freq(i), 0.01_nm, 1);
+        set.set_params(i, freq(i), 0.01_nm, 1);
+    }
+    bent.ping(count);
+    set.ping(count);
+    for (size_t s = 0; s < 4 * hop; s++) {
+        REQUIRE(bent.tick(0, count) == set.tick(0, count));
+    }
+
+    // a fifth up, taking effect at the next hop, as the bank set again does
+    bent.bend(1.5_nm, count);
+    for (size_t i = 0; i < count; i++) {
+        set.set_params(i, freq(i) * 1.5_nm, 0.01_nm, 1);
+    }
+    for (size_t s = 0; s < 8 * hop; s++) {
+        REQUIRE_THAT(bent.tick(0, count), WithinAbs(set.tick(0, count), 1e-5));
+    }
+}
+
+TEST_CASE("Modal synth switches to the spectral backend above the threshold", "[dsp][spectral][synth]") {
+    synth::ModalPatch patch;
+    auto synth = std::make_unique<synth::ModalSynth<1024>>();
+    synth->set_patch(patch);
+    synth->set_sample_rate(48000);
+    synth->set_exciter(synth::ModalExiterKind::Impulse);
+
+    const auto render = [&](const size_t modes) {
+        patch.set_params(modes, 0, 1, 20, 1, 1);
+        synth->update_mode_coefficients();
+        synth->on(55, 1);
+        double energy = 0;
+        for (size_t i = 0; i < 24000; i++) {
+            const auto s = synth->tick();
+            REQUIRE(std::isfinite(s));
+            energy += s * s;
+        }
+        return energy;
+    };
+
+    REQUIRE(synth->spectral_threshold() < 1024);
+    const auto spectral_energy = render(1024);
+    REQUIRE(synth->uses_spectral_backend());
+    REQUIRE(spectral_energy > 0);
+
+    REQUIRE(synth->set_spectral_threshold(1024));
+    synth->update_mode_coefficients();
+    REQUIRE_FALSE(synth->uses_spectral_backend());
+    const auto recursive_energy = render(1024);
+    REQUIRE(spectral_energy / recursive_energy > 0.9);
+    REQUIRE(spectral_energy / recursive_energy < 1.1);
+}
+
+TEST_CASE("Modal synth on the spectral backend falls silent once rung out", "[dsp][spectral][synth]") {
+    synth::ModalPatch patch;
+    auto synth = std::make_unique<synth::ModalSynth<1024>>();
+    synth->set_patch(patch);
+    synth->set_sample_rate(48000);
+    synth->set_exciter(synth::ModalExiterKind::Impulse);
+    patch.set_params(512, 0, 1, 20, 0.2_nm, 1);
+    synth->update_mode_coefficients();
+    REQUIRE(synth->uses_spectral_backend());
+
+    synth->on(55, 1);
+    synth->off();
+    // the ping only reaches the modes at the next hop, it isn't silent before
+    REQUIRE_FALSE(synth->silent());
+    size_t samples = 0;
+    for (; !synth->silent() && samples < 10 * 48000; samples++) {
+        synth->tick();
+    }
+    REQUIRE(samples > spectral::SpectralModalBank::default_hop);
+    REQUIRE(samples < 10 * 48000);
+}
+
+TEST_CASE("Large voice plays thousands of modes on the spectral backend", "[dsp][spectral][synth]") {
+    synth::ModalPatch patch;
+    auto synth = std::make_unique<synth::LargeModalSynth>();
+    synth->set_patch(patch);
+    synth->set_sample_rate(48000);
+    synth->set_exciter(synth::ModalExiterKind::Impulse);
+    patch.set_params(2000, 0.01_nm, 1, 20, 1, 0.5_nm);
+
+    synth->on(65, 1);
+    REQUIRE(synth->num_modes() == 2000);
+    REQUIRE(synth->uses_spectral_backend());
+    REQUIRE(synth->latency() == spectral::SpectralModalBank::default_hop);
+    double energy = 0;
+    for (size_t i = 0; i < 4800; i++) {
+        const auto s = synth->tick();
+        REQUIRE(std::isfinite(s));
+        energy += s * s;
+    }
+    REQUIRE(energy > 0);
+
+    // or on the recursive bank, without the delay, below the threshold
+    REQUIRE(synth->set_spectral_threshold(synth::LargeModalSynth::max_modes));
+    synth->update_mode_coefficients();
+    REQUIRE_FALSE(synth->uses_spectral_backend());
+    REQUIRE(synth->latency() == 0);
+}
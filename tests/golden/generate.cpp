@@ -0,0 +1,27 @@
+// Writes the golden renders from the reference implementation.
+// Only needs running when the matrix or the reference changes, commit the file it writes.
+//
+// usage: ModalSynthGolden [path], defaults to tests/golden/modal_synth.golden in the source tree
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "golden.hpp"
+#include "reference.hpp"
+
+int main(const int argc, char** argv) {
+    using namespace modal::golden;
+    const std::string path = argc > 1 ? argv[1] : MODAL_GOLDEN_FILE;
+
+    std::vector<Summary> summaries;
+    for (const auto& c: cases()) {
+        summaries.push_back(summarise(render_reference(c)));
+    }
+    if (!write(path, summaries)) {
+        std::fprintf(stderr, "couldn't write %s\n", path.c_str());
+        return 1;
+    }
+    std::printf("wrote %zu renders to %s\n", summaries.size(), path.c_str());
+    return 0;
+}
@@ -0,0 +1,153 @@
+#include "golden.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <cstring>
+#include <numbers>
+
+namespace modal::golden {
+    namespace {
+        constexpr char magic[4] = {'M', 'G', 'L', 'D'};
+        // bump when the matrix, the render or the summary changes, so stale files are rejected
+        constexpr std::uint32_t version = 1;
+
+        constexpr const char* exciter_names[] = {"impulse", "noise", "impulses", "square", "chirp"};
+        constexpr const char* foldback_names[] = {"nyquist", "undertones", "foldback"};
+
+        // plain radix-2 FFT, in place, kept separate from `spectral::FFT` so the comparison doesn't depend on the code being tested
+        void fft(std::vector<std::complex<double>>& x) {
+            const size_t n = x.size();
+            for (size_t i = 1, j = 0; i < n; i++) {
+                size_t bit = n >> 1;
+                for (; j & bit; bit >>= 1) {
+                    j ^= bit;
+                }
+                j ^= bit;
+                if (i < j) {
+                    std::swap(x[i], x[j]);
+                }
+            }
+            for (size_t len = 2; len <= n; len <<= 1) {
+                const auto w = std::polar(1.0, -2 * std::numbers::pi / static_cast<double>(len));
+                for (size_t i = 0; i < n; i += len) {
+                    std::complex<double> wk = 1;
+                    for (size_t k = 0; k < len / 2; k++) {
+                        const auto even = x[i + k];
+                        const auto odd = x[i + k + len / 2] * wk;
+                        x[i + k] = even + odd;
+                        x[i + k + len / 2] = even - odd;
+                        wk *= w;
+                    }
+                }
+            }
+        }
+
+        float db(const double power) {
+            return static_cast<float>(10 * std::log10(power + 1e-30));
+        }
+
+        size_t values_per_summary() {
+            return sample_count + band_count + envelope_count;
+        }
+    }
+
+    std::string Case::name() const {
+        return std::string{patches[patch].name} + ", note " + std::to_string(note) + ", "
+               + exciter_names[exciter] + ", " + foldback_names[foldback];
+    }
+
+    std::vector<Case> cases() {
+        std::vector<Case> all;
+        for (size_t p = 0; p < patches.size(); p++) {
+            for (const int note: notes) {
+                for (int e = 0; e < exciter_count; e++) {
+                    for (int f = 0; f < foldback_count; f++) {
+                        all.push_back({p, note, e, f});
+                    }
+                }
+            }
+        }
+        return all;
+    }
+
+    Summary summarise(const std::vector<double>& render) {
+        Summary s;
+        s.samples.assign(render.begin(), render.begin() + sample_count);
+
+        std::vector<std::complex<double>> spectrum(fft_size);
+        for (size_t i = 0; i < fft_size; i++) {
+            const double hann = 0.5 - 0.5 * std::cos(2 * std::numbers::pi * static_cast<double>(i) / fft_size);
+            spectrum[i] = render[i] * hann;
+        }
+        fft(spectrum);
+        const double bin_width = sample_rate / fft_size;
+        for (size_t b = 0; b < band_count; b++) {
+            const double lo = lowest_band * std::pow(highest_band / lowest_band, static_cast<double>(b) / band_count);
+            const double hi = lowest_band * std::pow(highest_band / lowest_band, static_cast<double>(b + 1) / band_count);
+            double power = 0;
+            for (auto k = static_cast<size_t>(std::ceil(lo / bin_width)); static_cast<double>(k) * bin_width < hi; k++) {
+                power += std::norm(spectrum[k]);
+            }
+            s.bands.push_back(db(power));
+        }
+
+        for (size_t w = 0; w < envelope_count; w++) {
+            double sum = 0;
+            for (size_t i = w * envelope_window; i < (w + 1) * envelope_window; i++) {
+                sum += render[i] * render[i];
+            }
+            s.envelope.push_back(db(sum / envelope_window));
+        }
+        return s;
+    }
+
+    bool write(const std::string& path, const std::vector<Summary>& summaries) {
+        FILE* f = std::fopen(path.c_str(), "wb");
+        if (f == nullptr) {
+            return false;
+        }
+        const std::uint32_t header[] = {version, static_cast<std::uint32_t>(summaries.size()),
+                                        static_cast<std::uint32_t>(values_per_summary())};
+        bool ok = std::fwrite(magic, sizeof(magic), 1, f) == 1 && std::fwrite(header, sizeof(header), 1, f) == 1;
+        for (const auto& s: summaries) {
+            for (const auto* part: {&s.samples, &s.bands, &s.envelope}) {
+                ok = ok && std::fwrite(part->data(), sizeof(float), part->size(), f) == part->size();
+            }
+        }
+        return std::fclose(f) == 0 && ok;
+    }
+
+    std::optional<std::vector<Summary>> read(const std::string& path) {
+        FILE* f = std::fopen(path.c_str(), "rb");
+        if (f == nullptr) {
+            return std::nullopt;
+        }
+        char file_magic[4];
+        std::uint32_t header[3];
+        const auto expected = cases().size();
+        if (std::fread(file_magic, sizeof(file_magic), 1, f) != 1 || std::memcmp(file_magic, magic, sizeof(magic)) != 0
+            || std::fread(header, sizeof(header), 1, f) != 1
+            || header[0] != version || header[1] != expected || header[2] != values_per_summary()) {
+            std::fclose(f);
+            return std::nullopt;
+        }
+
+        std::vector<Summary> summaries(expected);
+        bool ok = true;
+        for (auto& s: summaries) {
+            s.samples.resize(sample_count);
+            s.bands.resize(band_count);
+            s.envelope.resize(envelope_count);
+            for (auto* part: {&s.samples, &s.bands, &s.envelope}) {
+                ok = ok && std::fread(part->data(), sizeof(float), part->size(), f) == part->size();
+            }
+        }
+        std::fclose(f);
+        if (!ok) {
+            return std::nullopt;
+        }
+        return summaries;
+    }
+}
@@ -0,0 +1,92 @@
+// Golden renders: the matrix of voices rendered, and the summary of each render that's stored and compared.
+// Doesn't depend on `MODAL_NUM_TYPE`, everything here is in double precision.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace modal::golden {
+    constexpr double sample_rate = 48000;
+    /// Length of each render, in samples
+    constexpr size_t render_length = 24000;
+    /// Sample the note is released on
+    constexpr size_t note_off_at = 14400;
+    constexpr double velocity = 0.8;
+    constexpr double foldback_point = 1600;
+    /// Seed of the noise exciter, so noise renders are reproducible
+    constexpr std::uint32_t noise_seed = 0x2545f491;
+
+    /// Number of samples at the start of each render stored exactly
+    constexpr size_t sample_count = 1024;
+    /// Size of the FFT over the start of each render that the spectrum bands are taken from
+    constexpr size_t fft_size = 8192;
+    /// Number of log-spaced bands the spectrum is summarised in, from `lowest_band` to `highest_band` Hz
+    constexpr size_t band_count = 40;
+    constexpr double lowest_band = 40;
+    constexpr double highest_band = 20000;
+    /// Length of the windows the decay envelope is measured over
+    constexpr size_t envelope_window = 512;
+    constexpr size_t envelope_count = render_length / envelope_window;
+
+    /// Patch settings of a voice in the matrix, as set on `synth::ModalSynth`
+    struct Patch {
+        const char* name;
+        size_t modes;
+        double inharmonicity, exponent, exciter_rate, decay, falloff;
+        std::array<double, 2> mode_freqs, mode_gains;
+        double formant_x, formant_y, formant_length, formant_mix;
+        double attack, release;
+        bool exponential_attack, exponential_release;
+    };
+
+    constexpr std::array<Patch, 3> patches {{
+        {"harmonic", 40, 0, 1, 20, 1, 1, {1, 1}, {1, 1}, 0.5, 0.5, 0.5, 0, 0.01, 0.1, false, false},
+        {"bell", 24, 0.3, 1.2, 4, 2, 0.6, {0.8, 1.3}, {0.7, 0.4}, 0.3, 0.7, 0.6, 0.5, 0.05, 0.2, true, true},
+        {"vowel", 40, 0.02, 0.9, 8, 0.5, 1.5, {1, 1}, {1, 0.5}, 0.8, 0.2, 0.9, 1, 0.002, 0.05, false, true},
+    }};
+    constexpr std::array<int, 3> notes {36, 60, 84};
+    /// Number of exciters and foldback modes, numbered as `synth::ModalExiterKind` and `synth::ModalFoldbackKind`
+    constexpr int exciter_count = 5;
+    constexpr int foldback_count = 3;
+
+    /// One render in the matrix
+    struct Case {
+        size_t patch;
+        int note;
+        int exciter;
+        int foldback;
+
+        [[nodiscard]] std::string name() const;
+    };
+
+    /// Every combination of patch, note, exciter and foldback mode, in the order they're stored
+    std::vector<Case> cases();
+
+    /// What's stored of a render, and compared
+    struct Summary {
+        /// The first `sample_count` samples
+        std::vector<float> samples;
+        /// Power of each band of the spectrum of the first `fft_size` samples, Hann windowed, in dB
+        std::vector<float> bands;
+        /// RMS level of each `envelope_window` samples, in dB
+        std::vector<float> envelope;
+    };
+
+    /// Summarises a render of `render_length` samples
+    Summary summarise(const std::vector<double>& render);
+
+    /** @brief Writes summaries to a file, in the order of `cases()`.
+     *
+     * The file is little-endian 32-bit floats after a small header, so is only portable between little-endian machines.
+     * @return If the file was written
+     */
+    bool write(const std::string& path, const std::vector<Summary>& summaries);
+
+    /// Reads summaries written by `write()`, or nothing if the file is missing or doesn't match the current matrix
+    std::optional<std::vector<Summary>> read(const std::string& path);
+}
@@ -0,0 +1,231 @@
+#include "reference.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <numbers>
+
+namespace modal::golden {
+    namespace {
+        constexpr double tau = 2 * std::numbers::pi;
+
+        struct Mode {
+            std::complex<double> coeff;
+            double amp = 0;
+            std::complex<double> y;
+        };
+
+        // every 2nd and every 3rd mode is scaled by one of a pair of factors, as `synth::ModalControls`
+        double mode_factor(const size_t i, const std::array<double, 2>& factors) {
+            double factor = 1;
+            if (i % 2 == 1) {
+                factor *= factors[0];
+            }
+            if (i % 3 == 2) {
+                factor *= factors[1];
+            }
+            return factor;
+        }
+
+        std::vector<Mode> modes_for(const Patch& p, const double freq, const int foldback) {
+            std::vector<Mode> modes(std::min<size_t>(p.modes, 40));
+            for (size_t i = 0; i < modes.size(); i++) {
+                const auto k = static_cast<double>(i);
+                const double overtone = (k + 1) * (1 + k * p.inharmonicity * mode_factor(i, p.mode_freqs));
+                double mode_freq = foldback == 1 ? freq / std::pow(overtone, p.exponent) : freq * std::pow(overtone, p.exponent);
+                if (foldback == 2 && mode_freq > foldback_point) {
+                    mode_freq = 2 * foldback_point - mode_freq;
+                }
+                const double amp = 2 / std::pow(k + 1, p.falloff) * mode_factor(i, p.mode_gains);
+                const double decay = amp * p.decay;
+
+                // modes outside (0, Nyquist) are silent
+                if (mode_freq > 0 && mode_freq < sample_rate / 2) {
+                    // decays by 60dB over the decay time
+                    const double radius = std::pow(0.001, 1 / (decay * sample_rate));
+                    modes[i].coeff = std::polar(radius, tau * mode_freq / sample_rate);
+                    modes[i].amp = amp;
+                }
+            }
+            return modes;
+        }
+
+        // band-pass with constant 0dB peak gain, from the Audio EQ Cookbook, in direct form 1
+        struct BandPass {
+            double b0, b2, a1, a2;
+            double x1 = 0, x2 = 0, y1 = 0, y2 = 0;
+
+            BandPass(const double fc, const double octaves) {
+                const double w0 = tau * fc / sample_rate;
+                const double alpha = std::sin(w0) * std::sinh(std::numbers::ln2 / 2 * octaves * w0 / std::sin(w0));
+                const double a0 = 1 + alpha;
+                b0 = alpha / a0;
+                b2 = -alpha / a0;
+                a1 = -2 * std::cos(w0) / a0;
+                a2 = (1 - alpha) / a0;
+            }
+
+            double tick(const double in) {
+                const double out = b0 * in + b2 * x2 - a1 * y1 - a2 * y2;
+                x2 = x1;
+                x1 = in;
+                y2 = y1;
+                y1 = out;
+                return out;
+            }
+        };
+
+        // the four formants of `physical::FormantFilter::set_vowel()`, in parallel
+        std::array<BandPass, 4> formants_for(const Patch& p) {
+            const double throat = 1 + 0.5 * p.formant_length;
+            return {{
+                {(270 + 390 * p.formant_x) * throat, 0.1},
+                {(840 + 1450 * p.formant_y) * throat, 0.1},
+                {(1690 + 1320 * 0.5) * throat, 0.1},
+                {3500 * p.formant_length, 0.1},
+            }};
+        }
+
+        // attack-hold-release envelope, each segment linear or an exponential approach to a target past its end
+        struct Envelope {
+            enum { Rest, Attack, Hold, Release } state = Rest;
+            double value = 0;
+            double attack, release;
+            bool exponential_attack, exponential_release;
+
+            explicit Envelope(const Patch& p) : attack{p.attack * sample_rate}, release{p.release * sample_rate},
+                                                exponential_attack{p.exponential_attack},
+                                                exponential_release{p.exponential_release} {}
+
+            double tick() {
+                if (state == Attack) {
+                    if (exponential_attack) {
+                        // from 0, reaches 1 after `attack` samples heading for 1.3
+                        value = 1.3 - (1.3 - value) * std::exp(-std::log(1.3 / 0.3) / attack);
+                    } else {
+                        value += 1 / attack;
+                    }
+                    if (value >= 1) {
+                        value = 1;
+                        state = Hold;
+                    }
+                } else if (state == Release) {
+                    if (exponential_release) {
+                        // from 1, reaches 0 after `release` samples heading for -0.001
+                        value = (value + 0.001) * std::exp(-std::log(1.001 / 0.001) / release) - 0.001;
+                    } else {
+                        value -= 1 / release;
+                    }
+                    if (value <= 0) {
+                        value = 0;
+                        state = Rest;
+                    }
+                }
+                return value;
+            }
+        };
+
+        // phase in [0, 1) advancing by a fixed increment, wrapping past 1
+        struct Phase {
+            double phase = 0;
+            double inc = 0;
+
+            void tick() {
+                phase += inc;
+                if (phase > 1) {
+                    phase -= 1;
+                }
+            }
+        };
+
+        // saw with a polynomial band-limited step at the wrap
+        double blep_saw(const double phase, const double inc) {
+            double blep = 0;
+            if (phase > 1 - inc) {
+                const double t = (phase - 1) / inc;
+                blep = t * t + 2 * t + 1;
+            } else if (phase < inc) {
+                const double t = phase / inc;
+                blep = 2 * t - t * t - 1;
+            }
+            return 2 * phase - 1 - blep;
+        }
+
+        double blep_square(const double phase, const double inc) {
+            const double shifted = phase + 0.5 > 1 ? phase - 0.5 : phase + 0.5;
+            return blep_saw(phase, inc) - blep_saw(shifted, inc);
+        }
+
+        // 32-bit xorshift, as `bonus::FastRng`
+        struct Noise {
+            std::uint32_t state;
+
+            double tick() {
+                state ^= state << 13;
+                state ^= state >> 17;
+                state ^= state << 5;
+                return -0.05 + 0.1 * static_cast<double>(state >> 8) / 16777216.0;
+            }
+        };
+    }
+
+    std::vector<double> render_reference(const Case& c) {
+        const auto& p = patches[c.patch];
+        const double freq = 440 * std::exp2((c.note - 69) / 12.0);
+        auto modes = modes_for(p, freq, c.foldback);
+        auto formants = formants_for(p);
+        Envelope env {p};
+        Noise noise {noise_seed};
+        Phase osc {0, freq / p.exciter_rate / sample_rate};
+        Phase chirp_rate {0, freq / p.exciter_rate / sample_rate};
+        Phase chirp;
+
+        // the impulse exciter strikes the modes once, the others are gated by the envelope
+        const bool impulse = c.exciter == 0;
+        if (impulse) {
+            for (auto& m: modes) {
+                m.y = m.amp;
+            }
+        } else {
+            env.state = Envelope::Attack;
+        }
+
+        std::vector<double> out(render_length);
+        for (size_t i = 0; i < render_length; i++) {
+            if (i == note_off_at && !impulse) {
+                env.state = Envelope::Release;
+            }
+
+            osc.tick();
+            chirp_rate.tick();
+            // sweeps from 20Hz to 20kHz
+            chirp.inc = (20 + 19980 * chirp_rate.phase) / sample_rate;
+            chirp.tick();
+
+            double excitation = 0;
+            switch (c.exciter) {
+                case 1: excitation = noise.tick(); break;
+                case 2: excitation = osc.phase <= osc.inc ? 0.6 : 0; break;
+                case 3: excitation = 0.2 * blep_square(osc.phase, osc.inc); break;
+                case 4: excitation = 0.2 * std::sin(tau * chirp.phase); break;
+                default: break;
+            }
+            excitation *= env.tick();
+
+            double modes_out = 0;
+            for (auto& m: modes) {
+                m.y = m.amp * excitation + m.coeff * m.y;
+                modes_out += m.y.imag();
+            }
+            double formant_out = 0;
+            for (auto& f: formants) {
+                formant_out += f.tick(modes_out);
+            }
+
+            out[i] = (modes_out + p.formant_mix * (formant_out - modes_out)) * velocity * velocity;
+        }
+        return out;
+    }
+}
@@ -0,0 +1,14 @@
+// Slow, double precision reference of `synth::ModalSynth`, that the golden renders are made with.
+// Written to be obviously correct rather than fast: one complex number per mode, the filters as written in the cookbook,
+// and nothing shared with the plugin's DSP, so optimising that can't change what it's checked against.
+
+#pragma once
+
+#include <vector>
+
+#include "golden.hpp"
+
+namespace modal::golden {
+    /// Renders `render_length` samples of one voice, playing the note from the start and releasing it at `note_off_at`
+    std::vector<double> render_reference(const Case& c);
+}
@@ -0,0 +1,114 @@
+// Drives a plugin's processor like a host would, failing on any allocation or lock inside `processBlock()`.
+// Built once per plugin, each build linked with that plugin's shared code and the realtime check hooks.
+
+#include <juce_audio_processors/juce_audio_processors.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <dsp/rtcheck.hpp>
+
+#include <memory>
+#include <random>
+
+// the processor of whichever plugin this suite is linked with
+juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter();
+
+using namespace modal::dsp;
+
+namespace {
+    constexpr double sample_rate = 48000;
+    constexpr int max_block = 512;
+
+    struct Host {
+        juce::ScopedJuceInitialiser_GUI juce_init;
+        std::unique_ptr<juce::AudioProcessor> processor {createPluginFilter()};
+        juce::AudioBuffer<float> buffer {2, max_block};
+        juce::MidiBuffer midi;
+        std::mt19937 rng {1234};
+        // length of the next block
+        int samples = max_block;
+
+        Host() {
+            processor->setPlayConfigDetails(0, 2, sample_rate, max_block);
+            processor->prepareToPlay(sample_rate, max_block);
+            midi.ensureSize(4096);
+            rt::reset();
+        }
+
+        ~Host() {
+            processor->releaseResources();
+        }
+
+        int random(const int lo, const int hi) {
+            return std::uniform_int_distribution{lo, hi}(rng);
+        }
+
+        // odd sizes included, so sub-blocks and control periods land everywhere
+        void process() {
+            buffer.setSize(2, samples, false, false, true);
+            processor->processBlock(buffer, midi);
+            midi.clear();
+            samples = random(1, max_block);
+        }
+
+        // more notes than voices, so notes are dropped, with controllers and pitch bend mixed in
+        void add_note_storm(const int notes) {
+            for (int i = 0; i < notes; i++) {
+                const int note = random(24, 108);
+                const int time = random(0, samples - 1);
+                midi.addEvent(juce::MidiMessage::noteOn(1, note, static_cast<juce::uint8>(random(1, 127))), time);
+                midi.addEvent(juce::MidiMessage::noteOff(1, random(24, 108)), time);
+            }
+            midi.addEvent(juce::MidiMessage::controllerEvent(1, 1, random(0, 127)), 0);
+            midi.addEvent(juce::MidiMessage::channelPressureChange(1, random(0, 127)), 0);
+            midi.addEvent(juce::MidiMessage::pitchWheel(1, random(0, 16383)), 0);
+        }
+
+        void automate(const int changes) {
+            const auto& params = processor->getParameters();
+            for (int i = 0; i < changes; i++) {
+                auto* p = params[random(0, params.size() - 1)];
+                p->setValueNotifyingHost(std::uniform_real_distribution<float>{0, 1}(rng));
+            }
+        }
+    };
+}
+
+TEST_CASE("Processor blocks under note storms neither allocate nor lock", "[plugin][rtcheck]") {
+    Host host;
+    for (int block = 0; block < 2000; block++) {
+        host.add_note_storm(block % 50 == 0 ? 40 : 3);
+        host.process();
+    }
+    REQUIRE(rt::violations(rt::Violation::Allocation) == 0);
+    REQUIRE(rt::violations(rt::Violation::Deallocation) == 0);
+    REQUIRE(rt::violations(rt::Violation::Lock) == 0);
+}
+
+TEST_CASE("Processor blocks under automation neither allocate nor lock", "[plugin][rtcheck]") {
+    Host host;
+    for (int block = 0; block < 2000; block++) {
+        host.automate(block % 20 == 0 ? 20 : 2);
+        host.add_note_storm(1);
+        host.process();
+    }
+    REQUIRE(rt::violations() == 0);
+}
+
+TEST_CASE("Processor blocks after state and program changes neither allocate nor lock", "[plugin][rtcheck]") {
+    Host host;
+    juce::MemoryBlock state;
+    host.processor->getStateInformation(state);
+    for (int block = 0; block < 500; block++) {
+        if (block % 25 == 0) {
+            host.automate(10);
+            host.processor->setStateInformation(state.getData(), static_cast<int>(state.getSize()));
+        }
+        if (block % 40 == 0) {
+            host.processor->setCurrentProgram(host.random(0, host.processor->getNumPrograms() - 1));
+        }
+        host.add_note_storm(2);
+        host.process();
+    }
+    REQUIRE(rt::violations() == 0);
+}
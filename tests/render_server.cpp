@@ -0,0 +1,111 @@
+#include "../server/client.hpp"
+#include "../server/server.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace modal::server;
+
+TEST_CASE("Ring readers see whole blocks, or find them overwritten", "[server]") {
+    constexpr uint32_t block_size = 32, slots = 4;
+    std::vector<std::byte> memory(Ring::bytes(block_size, slots) + 64);
+    auto* aligned = reinterpret_cast<void*>((reinterpret_cast<uintptr_t>(memory.data()) + 63) / 64 * 64);
+    Ring writer {aligned};
+    writer.init(48000, block_size, slots, 1);
+    const Ring reader {aligned};
+
+    REQUIRE(reader.written() == 0);
+    REQUIRE(reader.read(0) == nullptr);
+    for (uint64_t block = 0; block < 6; block++) {
+        std::fill_n(writer.begin_write(), block_size, static_cast<float>(block));
+        // not readable while it's written
+        REQUIRE(reader.read(block) == nullptr);
+        writer.end_write();
+    }
+    REQUIRE(reader.written() == 6);
+    REQUIRE(reader.read(1) == nullptr);
+    for (uint64_t block = 2; block < 6; block++) {
+        const float* samples = reader.read(block);
+        REQUIRE(samples != nullptr);
+        REQUIRE(std::all_of(samples, samples + block_size, [&](const float s) { return s == static_cast<float>(block); }));
+        REQUIRE(reader.still_valid(block));
+    }
+
+    // overwritten while being read
+    const float* samples = reader.read(2);
+    writer.begin_write();
+    REQUIRE(samples != nullptr);
+    REQUIRE_FALSE(reader.still_valid(2));
+}
+
+TEST_CASE("Server streams notes from every client to every client", "[server]") {
+    Settings settings;
+    settings.socket_path = "/tmp/modal-synth-test-" + std::to_string(getpid()) + ".sock";
+    settings.block_size = 64;
+    settings.slots = 256;
+    settings.lead = 2;
+    settings.max_clients = 2;
+
+    auto server = std::make_unique<Server>(settings);
+    std::string error;
+    REQUIRE(server->open(error));
+    std::atomic<bool> stop {false};
+    std::thread running {[&] { server->run(stop); }};
+
+    Client first, second, turned_away;
+    REQUIRE(first.connect(settings.socket_path, error));
+    REQUIRE(second.connect(settings.socket_path, error));
+    REQUIRE(first.info().block_size == 64);
+    REQUIRE(first.info().sample_rate == 48000);
+
+    // far enough ahead to be on time on a busy machine
+    const uint64_t time = first.next_time() + 20 * settings.block_size + 7;
+    REQUIRE(second.note_on(time, 60, 1));
+    REQUIRE(first.set_param(time, "modes", 4));
+
+    const uint64_t first_block = time / settings.block_size, last_block = first_block + 4;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (first.written() <= last_block && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    REQUIRE(first.written() > last_block);
+    REQUIRE(server->engine_stats().active_modes == 4);
+    REQUIRE_FALSE(turned_away.connect(settings.socket_path, error));
+
+    // both clients read the same blocks, silent until the note's sample
+    std::vector<float> a(settings.block_size), b(settings.block_size);
+    std::vector<float> played;
+    for (uint64_t block = first_block - 1; block <= last_block; block++) {
+        REQUIRE(first.read(block, a.data()) == Client::ReadResult::Ok);
+        REQUIRE(second.read(block, b.data()) == Client::ReadResult::Ok);
+        REQUIRE(a == b);
+        played.insert(played.end(), a.begin(), a.end());
+    }
+    REQUIRE(first.read(first.written() + 1, a.data()) == Client::ReadResult::NotYet);
+    const size_t onset = time - (first_block - 1) * settings.block_size;
+    REQUIRE(std::all_of(played.begin(), played.begin() + static_cast<std::ptrdiff_t>(onset), [](const float s) { return s == 0; }));
+    REQUIRE(std::any_of(played.begin() + static_cast<std::ptrdiff_t>(onset), played.end(), [](const float s) { return std::abs(s) > 1e-4f; }));
+
+    // late events play at the start of the next block
+    const auto written = first.written();
+    REQUIRE(first.note_off(0, 60));
+    while (first.written() < written + 2 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+
+    stop = true;
+    running.join();
+    REQUIRE(server->stats().clients == 2);
+    REQUIRE(server->stats().late_events == 1);
+    REQUIRE(server->stats().dropped_events == 0);
+    REQUIRE(server->engine_stats().active_voices == 0);
+}
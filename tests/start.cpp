@@ -1,10 +1,28 @@
-#include "catch2/benchmark/catch_benchmark.hpp"
-
 static unsigned int factorial(const unsigned int n) {
     return n > 1 ? factorial(n - 1) * n : 1;
 }
 
 #include <catch2/catch_test_macros.hpp>
+#include <catch2/reporters/catch_reporter_event_listener.hpp>
+#include <catch2/reporters/catch_reporter_registrars.hpp>
+
+#include <iostream>
+
+#include <dsp/simd.hpp>
+
+// reports which kernels were picked, so benchmark results can be compared like for like
+class KernelPathListener final : public Catch::EventListenerBase {
+ public:
+    using EventListenerBase::EventListenerBase;
+
+    void testRunStarting(Catch::TestRunInfo const&) override {
+        using namespace modal::dsp::simd;
+        std::cout << "DSP kernels: " << isa_name(kernels().isa)
+                  << " (detected " << isa_name(detect_isa()) << ")" << std::endl;
+    }
+};
+
+CATCH_REGISTER_LISTENER(KernelPathListener)
 
 TEST_CASE("Factorials are computed", "[factorial]") {
     REQUIRE(factorial(0) == 1);
@@ -12,9 +30,4 @@ TEST_CASE("Factorials are computed", "[factorial]") {
     REQUIRE(factorial(2) == 2);
     REQUIRE(factorial(3) == 6);
     REQUIRE(factorial(10) == 3628800);
-    BENCHMARK("Fibonacci 20") {
-        return factorial(20);
-    };
-
-
-}
\ No newline at end of file
+}